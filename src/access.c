@@ -0,0 +1,120 @@
+#include <stdlib.h>
+#include <stdatomic.h>
+#include "access.h"
+#include "plan_catalog.h"
+
+#define PAGE_SIZE (1 << ACCESS_PAGE_BITS)
+#define PAGE_MASK (PAGE_SIZE - 1)
+
+static _Atomic(atomic_uchar *) pages[ACCESS_MAX_PAGES];
+
+// Versions of the member table and plan catalog the statuses match
+static int synced = 0;
+static unsigned long synced_members = 0;
+static unsigned long synced_catalog = 0;
+
+// Highest ID that may have a status set
+static int highest_id = -1;
+
+static atomic_uchar *status_slot(int member_id, int create) {
+    int page = member_id >> ACCESS_PAGE_BITS;
+    if (member_id < 0 || page >= ACCESS_MAX_PAGES) {
+        return NULL;
+    }
+
+    // Only the syncing thread creates pages, readers just see them appear
+    atomic_uchar *statuses = atomic_load(&pages[page]);
+    if (!statuses && create) {
+        statuses = calloc(PAGE_SIZE, sizeof(atomic_uchar));
+        if (!statuses) {
+            return NULL;
+        }
+        atomic_store(&pages[page], statuses);
+    }
+    return statuses ? &statuses[member_id & PAGE_MASK] : NULL;
+}
+
+static void store_status(int member_id, unsigned char status) {
+    atomic_uchar *slot = status_slot(member_id, status != 0);
+    if (slot && atomic_load_explicit(slot, memory_order_relaxed) != status) {
+        atomic_store_explicit(slot, status, memory_order_release);
+    }
+}
+
+static unsigned char status_of(const Member *member, const Table *plans) {
+    unsigned char status = ACCESS_MEMBER;
+
+    if (member->id_current_plan != -1) {
+        status |= ACCESS_ACTIVE;
+        // A plan that was deleted grants no area
+        const Plan *plan = plan_find(plans, member->id_current_plan);
+        if (plan) {
+            status |= (unsigned char)(plan->areas & ACCESS_AREA_MASK);
+        }
+    }
+    return status;
+}
+
+void access_sync(const Table *members) {
+    const PlanCatalog *catalog = plan_catalog_enter();
+
+    if (synced && members->version == synced_members && catalog->version == synced_catalog) {
+        plan_catalog_exit();
+        return;
+    }
+
+    // Work out every status first, then store only the ones that changed,
+    // so a check running meanwhile never sees a member briefly refused
+    int last = members->max_id > highest_id ? members->max_id : highest_id;
+    unsigned char *fresh = calloc((size_t)last + 2, 1);
+    if (!fresh) {
+        plan_catalog_exit();
+        return;  // Keep the old statuses and try again next time
+    }
+
+    for (int i = 0; i < members->count; i++) {
+        if (table_is_live(members, i)) {
+            const Member *member = member_at(members, i);
+            if (member->id_member >= 0 && member->id_member <= last) {
+                fresh[member->id_member] = status_of(member, &catalog->plans);
+            }
+        }
+    }
+    for (int id = 0; id <= last; id++) {
+        store_status(id, fresh[id]);
+    }
+
+    highest_id = members->max_id;
+    synced_members = members->version;
+    synced_catalog = catalog->version;
+    synced = 1;
+
+    plan_catalog_exit();
+    free(fresh);
+}
+
+void access_track(const Table *members, int member_id) {
+    const PlanCatalog *catalog = plan_catalog_enter();
+
+    // Only this member's change since the last sync: update just its status.
+    // Anything more means a change made elsewhere and needs a rebuild.
+    if (!synced || synced_members + 1 != members->version || catalog->version != synced_catalog) {
+        plan_catalog_exit();
+        access_sync(members);
+        return;
+    }
+
+    const Member *member = member_find(members, member_id);
+    store_status(member_id, member ? status_of(member, &catalog->plans) : 0);
+    if (member_id > highest_id) {
+        highest_id = member_id;
+    }
+    synced_members = members->version;
+
+    plan_catalog_exit();
+}
+
+unsigned char access_status(int member_id) {
+    atomic_uchar *slot = status_slot(member_id, 0);
+    return slot ? atomic_load_explicit(slot, memory_order_acquire) : 0;
+}
@@ -0,0 +1,36 @@
+#ifndef ACCESS_H
+#define ACCESS_H
+
+#include "member.h"
+
+// Access status of every member, one byte per member ID, so checking a
+// badge reads a single byte and never touches the member or plan tables.
+// IDs are kept in pages of 4096, allocated on first use.
+#define ACCESS_PAGE_BITS 12
+#define ACCESS_MAX_PAGES 16384
+
+// Bits of a status byte; the low bits are the PLAN_AREA_* the plan grants
+#define ACCESS_MEMBER    0x80   // the member exists
+#define ACCESS_ACTIVE    0x40   // the member has a subscription
+#define ACCESS_AREA_MASK 0x3F
+
+// Function declarations
+
+// Make the statuses match the member table and the published plans. Only
+// rebuilds (O(members)) if either changed without access_track(), e.g. after
+// loading, a plan edit, expiry, or a refresh from another process.
+// Call from one thread at a time; checks may run meanwhile.
+void access_sync(const Table *members);
+
+// Update the status of one member after changing (or deleting) it
+void access_track(const Table *members, int member_id);
+
+// Status byte of a member (0 for unknown IDs). Lock-free, any thread.
+unsigned char access_status(int member_id);
+
+// Returns 1 if the member's subscription gives access to one of areas
+static inline int access_allows(unsigned char status, unsigned areas) {
+    return (status & ACCESS_ACTIVE) && (status & areas & ACCESS_AREA_MASK);
+}
+
+#endif
@@ -1,10 +1,66 @@
 #include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
+#include <time.h>
 #include "admin.h"
+#include "autosave.h"
+#include "shared_tables.h"
+#include "plan_catalog.h"
+#include "subscriptions.h"
+#include "access.h"
+#include "billing.h"
+#include "checkin.h"
+#include "loans.h"
+#include "maintenance.h"
+#include "history.h"
+#include "import.h"
+#include "export.h"
+#include "branches.h"
+#include "replication.h"
+#include "hot_reload.h"
+#include "audit.h"
+#include "popularity.h"
+#include "member_archive.h"
+#include "password.h"
+#include "username_filter.h"
 #include "utils.h"
 
+// Read the admin username and password hash, creating the file with the
+// default password if there is none. Returns 1 if successful.
+static int load_admin_credentials(char *username, int username_size, char *hash, int hash_size) {
+    FILE *f = fopen(ADMIN_FILE, "r");
+    if (f) {
+        char line[256];
+        int ok = fgets(line, sizeof(line), f) != NULL;
+        fclose(f);
+        char *separator = ok ? strchr(line, '|') : NULL;
+        if (!separator) {
+            printf("\nError: %s is damaged.\n", ADMIN_FILE);
+            return 0;
+        }
+        *separator = '\0';
+        char *stored = separator + 1;
+        stored[strcspn(stored, "\r\n")] = '\0';
+        snprintf(username, username_size, "%.*s", username_size - 1, line);
+        snprintf(hash, hash_size, "%s", stored);
+        return 1;
+    }
+
+    snprintf(username, username_size, "%s", ADMIN_USERNAME);
+    if (!password_hash(ADMIN_DEFAULT_PASSWORD, hash, hash_size)) {
+        return 0;
+    }
+    char line[256];
+    int length = snprintf(line, sizeof(line), "%s|%s\n", username, hash);
+    if (!write_file_atomically(ADMIN_FILE, line, length)) {
+        printf("\nWarning: Cannot write %s.\n", ADMIN_FILE);
+    }
+    return 1;
+}
+
 int admin_login() {
-    char username[50], password[50];
+    char username[50], password[PASSWORD_INPUT_SIZE];
+    char admin_username[50], admin_hash[PASSWORD_HASH_SIZE];
     
     print_header("ADMIN LOGIN");
     printf("Enter Admin Username: ");
@@ -13,13 +69,15 @@ int admin_login() {
     printf("Enter Admin Password: ");
     get_string_input(password, sizeof(password));
     
-    // Check if username matches
-    int username_correct = strcmp(username, ADMIN_USERNAME);
-    // Check if password matches
-    int password_correct = strcmp(password, ADMIN_PASSWORD);
+    if (!load_admin_credentials(admin_username, sizeof(admin_username), admin_hash, sizeof(admin_hash))) {
+        return 0;
+    }
+    
+    // The password is checked even for a wrong username, so both take as long
+    int password_correct = password_check(password, admin_hash);
+    int username_correct = strcmp(username, admin_username) == 0;
     
-    // Both must be 0 (meaning they match)
-    if (username_correct == 0 && password_correct == 0) {
+    if (username_correct && password_correct) {
         printf("\n[SUCCESS] Login successful! Welcome Admin!\n");
         return 1;
     }
@@ -28,58 +86,148 @@ int admin_login() {
     return 0;
 }
 
-void admin_manage_plans(Plan plans[], int *count) {
+void admin_change_password() {
+    char password[PASSWORD_INPUT_SIZE], confirm[PASSWORD_INPUT_SIZE];
+    char username[50], hash[PASSWORD_HASH_SIZE];
+    
+    if (!load_admin_credentials(username, sizeof(username), hash, sizeof(hash))) {
+        return;
+    }
+    
+    printf("\nEnter New Admin Password: ");
+    get_string_input(password, sizeof(password));
+    if (strlen(password) == 0) {
+        printf("Password cannot be empty!\n");
+        return;
+    }
+    printf("Confirm Password: ");
+    get_string_input(confirm, sizeof(confirm));
+    if (strcmp(password, confirm) != 0) {
+        printf("\nError: Passwords do not match!\n");
+        return;
+    }
+    
+    PasswordRequest request;
+    password_hash_async(&request, password, NULL, NULL);
+    if (!password_wait(&request)) {
+        printf("\nError: Not enough memory to hash the password.\n");
+        return;
+    }
+    char line[256];
+    int length = snprintf(line, sizeof(line), "%s|%s\n", username, request.hash);
+    if (!write_file_atomically(ADMIN_FILE, line, length)) {
+        printf("\nError: Cannot write %s.\n", ADMIN_FILE);
+        return;
+    }
+    audit_record(AUDIT_ADMIN, AUDIT_ADMIN_PASSWORD, 0, NULL);
+    printf("\n[SUCCESS] Admin password changed.\n");
+}
+
+void admin_manage_plans(Table *plans, const Table *members) {
     int choice;
     
     do {
+        // Show changes made by other running copies of the app, and by
+        // other programs to the plans and equipment files
+        shared_tables_refresh();
+        hot_reload_apply();
+        
         print_header("PLAN MANAGEMENT");
         printf("1 - Add New Plan\n");
         printf("2 - View All Plans\n");
         printf("3 - Modify Plan\n");
         printf("4 - Delete Plan\n");
+        printf("5 - Plan Popularity (top plans and trends)\n");
         printf("0 - Back to Admin Menu\n");
         print_separator();
         printf("Your choice: ");
         choice = get_int_input();
         
         switch (choice) {
-            case 1:
-                add_plan_interactive(plans, count);
-                save_plans_to_file(plans, *count);
+            case 1: {
+                // Typed first: other copies of the app are not kept waiting
+                Plan new_plan;
+                ask_new_plan(&new_plan);
+                
+                shared_tables_begin_edit();
+                int id = add_plan(plans, &new_plan);
+                if (id) {
+                    audit_record(AUDIT_ADMIN, AUDIT_PLAN_ADD, id, new_plan.name);
+                }
+                shared_tables_end_edit();
+                if (id) {
+                    plan_catalog_publish(plans);
+                    autosave_table(plans);
+                }
                 pause_screen();
                 break;
+            }
                 
             case 2:
-                display_plans(plans, *count);
+                display_plans(plans);
                 pause_screen();
                 break;
                 
             case 3: {
-                display_plans(plans, *count);
-                if (*count > 0) {
+                display_plans(plans);
+                int modified = 0;
+                if (plans->live_count > 0) {
                     printf("\nEnter Plan ID to modify: ");
                     int id = get_int_input();
-                    if (modify_plan(plans, *count, id)) {
-                        save_plans_to_file(plans, *count);
+                    const Plan *plan = plan_find(plans, id);
+                    if (!plan) {
+                        printf("\nError: Plan with ID %d not found.\n", id);
+                    } else {
+                        Plan changes;
+                        ask_plan_changes(plan, &changes);
+                        
+                        shared_tables_begin_edit();
+                        modified = apply_plan_changes(plans, &changes);
+                        if (modified) {
+                            audit_record(AUDIT_ADMIN, AUDIT_PLAN_MODIFY, id, plan_find(plans, id)->name);
+                        }
+                        shared_tables_end_edit();
                     }
                 }
+                if (modified) {
+                    // The edit was made on the admin's copy; members switch to it in one step
+                    plan_catalog_publish(plans);
+                    autosave_table(plans);
+                }
                 pause_screen();
                 break;
             }
             
             case 4: {
-                display_plans(plans, *count);
-                if (*count > 0) {
+                display_plans(plans);
+                int deleted = 0;
+                if (plans->live_count > 0) {
                     printf("\nEnter Plan ID to delete: ");
                     int id = get_int_input();
-                    if (delete_plan(plans, count, id)) {
-                        save_plans_to_file(plans, *count);
+                    
+                    shared_tables_begin_edit();
+                    const Plan *plan = plan_find(plans, id);
+                    char name[sizeof(plan->name)];
+                    snprintf(name, sizeof(name), "%s", plan ? plan->name : "");
+                    deleted = delete_plan(plans, id);
+                    if (deleted) {
+                        audit_record(AUDIT_ADMIN, AUDIT_PLAN_DELETE, id, name);
                     }
+                    shared_tables_end_edit();
+                }
+                if (deleted) {
+                    plan_catalog_publish(plans);
+                    autosave_table(plans);
                 }
                 pause_screen();
                 break;
             }
             
+            case 5:
+                popularity_display(plans, members);
+                pause_screen();
+                break;
+            
             case 0:
                 break;
                 
@@ -91,52 +239,147 @@ void admin_manage_plans(Plan plans[], int *count) {
     } while (choice != 0);
 }
 
-void admin_manage_equipment(Equipment equipment[], int *count) {
+void admin_manage_equipment(Table *equipment, const Table *loans) {
     int choice;
     
     do {
+        // Show changes made by other running copies of the app, and by
+        // other programs to the plans and equipment files
+        shared_tables_refresh();
+        hot_reload_apply();
+        maintenance_sync(equipment);
+        
         print_header("EQUIPMENT MANAGEMENT");
+        MaintenanceDue *overdue;
+        int overdue_count = maintenance_due_before(time(NULL), &overdue);
+        if (overdue_count > 0) {
+            printf("Equipment overdue for service: %d\n\n", overdue_count);
+        }
+        free(overdue);
+        
         printf("1 - Add New Equipment\n");
         printf("2 - View All Equipment\n");
         printf("3 - Modify Equipment\n");
         printf("4 - Delete Equipment\n");
+        printf("5 - View Availability\n");
+        printf("6 - Maintenance (Due / Record Service)\n");
         printf("0 - Back to Admin Menu\n");
         print_separator();
         printf("Your choice: ");
         choice = get_int_input();
         
         switch (choice) {
-            case 1:
-                add_equipment_interactive(equipment, count);
-                save_equipment_to_file(equipment, *count);
+            case 1: {
+                // Typed first: other copies of the app are not kept waiting
+                Equipment new_equipment;
+                ask_new_equipment(&new_equipment);
+                
+                shared_tables_begin_edit();
+                int id = add_equipment(equipment, &new_equipment);
+                if (id) {
+                    maintenance_track(equipment, id);
+                    audit_record(AUDIT_ADMIN, AUDIT_EQUIPMENT_ADD, id, new_equipment.name);
+                }
+                shared_tables_end_edit();
+                if (id) {
+                    autosave_table(equipment);
+                }
                 pause_screen();
                 break;
+            }
                 
             case 2:
-                display_equipment(equipment, *count);
+                display_equipment(equipment);
                 pause_screen();
                 break;
                 
             case 3: {
-                display_equipment(equipment, *count);
-                if (*count > 0) {
+                display_equipment(equipment);
+                int modified = 0;
+                if (equipment->live_count > 0) {
                     printf("\nEnter Equipment ID to modify: ");
                     int id = get_int_input();
-                    if (modify_equipment(equipment, *count, id)) {
-                        save_equipment_to_file(equipment, *count);
+                    const Equipment *item = equipment_find(equipment, id);
+                    if (!item) {
+                        printf("\nError: Equipment with ID %d not found.\n", id);
+                    } else {
+                        Equipment changes;
+                        ask_equipment_changes(item, &changes);
+                        
+                        shared_tables_begin_edit();
+                        modified = apply_equipment_changes(equipment, &changes);
+                        maintenance_track(equipment, id);
+                        if (modified) {
+                            audit_record(AUDIT_ADMIN, AUDIT_EQUIPMENT_MODIFY, id,
+                                         equipment_find(equipment, id)->name);
+                        }
+                        shared_tables_end_edit();
                     }
                 }
+                if (modified) {
+                    autosave_table(equipment);
+                }
                 pause_screen();
                 break;
             }
             
             case 4: {
-                display_equipment(equipment, *count);
-                if (*count > 0) {
+                display_equipment(equipment);
+                int deleted = 0;
+                if (equipment->live_count > 0) {
                     printf("\nEnter Equipment ID to delete: ");
                     int id = get_int_input();
-                    if (delete_equipment(equipment, count, id)) {
-                        save_equipment_to_file(equipment, *count);
+                    
+                    shared_tables_begin_edit();
+                    const Equipment *item = equipment_find(equipment, id);
+                    char name[sizeof(item->name)];
+                    snprintf(name, sizeof(name), "%s", item ? item->name : "");
+                    deleted = delete_equipment(equipment, id);
+                    maintenance_track(equipment, id);
+                    if (deleted) {
+                        audit_record(AUDIT_ADMIN, AUDIT_EQUIPMENT_DELETE, id, name);
+                    }
+                    shared_tables_end_edit();
+                }
+                if (deleted) {
+                    autosave_table(equipment);
+                }
+                pause_screen();
+                break;
+            }
+            
+            case 5:
+                equipment_stock_sync(equipment, loans);
+                display_equipment_availability(equipment);
+                pause_screen();
+                break;
+            
+            case 6: {
+                printf("\nShow service due within how many days (0 = overdue only)? ");
+                int days = get_int_input();
+                if (days < 0) {
+                    printf("\nPlease enter 0 or more days.\n");
+                    pause_screen();
+                    break;
+                }
+                if (maintenance_display_due(equipment, days) == 0) {
+                    pause_screen();
+                    break;
+                }
+                
+                printf("Enter Equipment ID serviced (or 0 to go back): ");
+                int id = get_int_input();
+                if (id != 0) {
+                    shared_tables_begin_edit();
+                    int serviced = maintenance_record_service(equipment, id);
+                    shared_tables_end_edit();
+                    if (serviced) {
+                        audit_record(AUDIT_ADMIN, AUDIT_EQUIPMENT_SERVICE, id,
+                                     equipment_find(equipment, id)->name);
+                        printf("\nService recorded. Its checkout count starts again.\n");
+                        autosave_table(equipment);
+                    } else {
+                        printf("\nError: Equipment with ID %d not found.\n", id);
                     }
                 }
                 pause_screen();
@@ -154,14 +397,24 @@ void admin_manage_equipment(Equipment equipment[], int *count) {
     } while (choice != 0);
 }
 
-void admin_manage_members(Member members[], int *count) {
+void admin_manage_members(Table *members, Table *loans, ClassSchedule *schedule) {
     int choice;
     
     do {
+        // Show changes made by other running copies of the app, and by
+        // other programs to the plans and equipment files
+        shared_tables_refresh();
+        hot_reload_apply();
+        
         print_header("MEMBER MANAGEMENT");
         printf("1 - View All Members\n");
         printf("2 - Search Member by Username\n");
         printf("3 - Delete Member\n");
+        printf("4 - Subscriptions Ending Soon\n");
+        printf("5 - Subscription History of a Member\n");
+        printf("6 - Churn Report\n");
+        printf("7 - Import Members from CSV\n");
+        printf("8 - Member Archive (all members ever registered)\n");
         printf("0 - Back to Admin Menu\n");
         print_separator();
         printf("Your choice: ");
@@ -169,20 +422,25 @@ void admin_manage_members(Member members[], int *count) {
         
         switch (choice) {
             case 1:
-                if (*count == 0) {
+                if (members->live_count == 0) {
                     printf("\nNo members registered.\n");
                 } else {
                     printf("\n--- All Members ---\n");
-                    printf("Total Members: %d\n\n", *count);
-                    for (int i = 0; i < *count; i++) {
-                        printf("Member %d:\n", i + 1);
-                        printf("  ID: %d\n", members[i].id_member);
-                        printf("  Name: %s\n", members[i].name);
-                        printf("  Username: %s\n", members[i].username);
-                        if (members[i].id_current_plan == -1) {
+                    printf("Total Members: %d\n\n", members->live_count);
+                    int number = 0;
+                    for (int i = 0; i < members->count; i++) {
+                        if (!table_is_live(members, i)) {
+                            continue;
+                        }
+                        Member *member = member_at(members, i);
+                        printf("Member %d:\n", ++number);
+                        printf("  ID: %d\n", member->id_member);
+                        printf("  Name: %s\n", member->name);
+                        printf("  Username: %s\n", member->username);
+                        if (member->id_current_plan == -1) {
                             printf("  Subscription: None\n");
                         } else {
-                            printf("  Subscription: Plan ID %d\n", members[i].id_current_plan);
+                            printf("  Subscription: Plan ID %d\n", member->id_current_plan);
                         }
                         printf("\n");
                     }
@@ -195,45 +453,110 @@ void admin_manage_members(Member members[], int *count) {
                 char username[50];
                 get_string_input(username, sizeof(username));
                 
-                int index = find_member_by_username(members, *count, username);
+                int index = find_member_by_username(members, username);
                 if (index == -1) {
                     printf("\nMember not found.\n");
                 } else {
                     printf("\n--- Member Found ---\n");
-                    display_member_profile(&members[index]);
+                    display_member_profile(member_at(members, index));
                 }
                 pause_screen();
                 break;
             }
             
             case 3: {
-                if (*count == 0) {
+                int deleted = 0;
+                if (members->live_count == 0) {
                     printf("\nNo members to delete.\n");
                 } else {
                     printf("\nEnter username to delete: ");
                     char username[50];
                     get_string_input(username, sizeof(username));
                     
-                    int index = find_member_by_username(members, *count, username);
+                    shared_tables_begin_edit();
+                    int index = find_member_by_username(members, username);
                     if (index == -1) {
                         printf("\nMember not found.\n");
                     } else {
+                        Member *member = member_at(members, index);
                         printf("\nDeleting member: %s (%s)\n", 
-                               members[index].name, members[index].username);
+                               member->name, member->username);
+                        
+                        // The archive keeps deleted members
+                        member_archive_keep(member);
                         
-                        // Shift remaining members
-                        for (int i = index; i < *count - 1; i++) {
-                            members[i] = members[i + 1];
+                        int member_id = member->id_member;
+                        if (member->id_current_plan != -1) {
+                            history_record(member_id, HISTORY_DELETE, member->id_current_plan, time(NULL));
+                        }
+                        username_index_release(member->username);
+                        table_remove(members, member_id);
+                        username_filter_track(members, username, 0);
+                        audit_record(AUDIT_ADMIN, AUDIT_MEMBER_DELETE, member_id, username);
+                        subscriptions_track(members, member_id);
+                        access_track(members, member_id);
+                        popularity_track(members, member_id);
+                        deleted = 1;
+                        
+                        // Their equipment goes back into stock
+                        int returned = loan_return_all(loans, member_id);
+                        if (returned > 0) {
+                            printf("%d equipment loan(s) returned.\n", returned);
+                            autosave_table(loans);
+                        }
+                        
+                        // Their seats go to the waitlists
+                        int cancelled = class_cancel_member(schedule, member_id);
+                        if (cancelled > 0) {
+                            printf("%d class booking(s) cancelled.\n", cancelled);
+                            autosave_table(&schedule->bookings);
                         }
-                        (*count)--;
                         
                         printf("Member deleted successfully!\n");
                     }
+                    shared_tables_end_edit();
                 }
+                if (deleted) {
+                    autosave_table(members);
+                }
+                pause_screen();
+                break;
+            }
+            
+            case 4: {
+                printf("\nShow subscriptions ending within how many days? ");
+                int days = get_int_input();
+                if (days < 0) {
+                    printf("\nPlease enter 0 or more days.\n");
+                } else {
+                    subscriptions_display_expiring(members, days);
+                }
+                pause_screen();
+                break;
+            }
+            
+            case 5: {
+                printf("\nEnter Member ID: ");
+                int member_id = get_int_input();
+                history_display_timeline(member_id);
                 pause_screen();
                 break;
             }
             
+            case 6:
+                history_display_churn();
+                pause_screen();
+                break;
+            
+            case 7:
+                import_members_interactive(members);
+                pause_screen();
+                break;
+            
+            case 8:
+                member_archive_interactive(members);
+                break;
+            
             case 0:
                 break;
                 
@@ -245,16 +568,217 @@ void admin_manage_members(Member members[], int *count) {
     } while (choice != 0);
 }
 
-void display_admin_menu(Member members[], int *member_count,
-                       Plan plans[], int *plan_count,
-                       Equipment equipment[], int *equipment_count) {
+void admin_manage_classes(ClassSchedule *schedule, const Table *plans) {
     int choice;
     
     do {
+        // Show classes and bookings changed by other running copies of the app
+        shared_tables_refresh();
+        class_schedule_sync(schedule);
+        
+        print_header("CLASS MANAGEMENT");
+        printf("1 - Add New Class\n");
+        printf("2 - View Schedule\n");
+        printf("3 - Delete Class\n");
+        printf("4 - Open New Week (clear all bookings)\n");
+        printf("0 - Back to Admin Menu\n");
+        print_separator();
+        printf("Your choice: ");
+        choice = get_int_input();
+        
+        switch (choice) {
+            case 1: {
+                GymClass gym_class;
+                memset(&gym_class, 0, sizeof(gym_class));
+                
+                printf("\n--- Add New Class ---\n");
+                printf("Class Name: ");
+                get_string_input(gym_class.name, sizeof(gym_class.name));
+                
+                display_plans(plans);
+                printf("Plan ID (members need this plan's areas): ");
+                gym_class.id_plan = get_int_input();
+                
+                printf("Day (1 = Monday ... 7 = Sunday): ");
+                gym_class.weekday = get_int_input() - 1;
+                
+                printf("Start Hour (0-23): ");
+                int hour = get_int_input();
+                printf("Start Minute (0 or 30): ");
+                int minute = get_int_input();
+                printf("Length in Minutes (30, 60, 90...): ");
+                int length = get_int_input();
+                printf("Capacity: ");
+                gym_class.capacity = get_int_input();
+                
+                gym_class.start_slot = hour * 2 + minute / CLASS_SLOT_MINUTES;
+                gym_class.slot_count = length / CLASS_SLOT_MINUTES;
+                
+                if (!plan_find(plans, gym_class.id_plan)) {
+                    printf("\nError: Invalid Plan ID!\n");
+                } else if (hour < 0 || hour > 23 || (minute != 0 && minute != CLASS_SLOT_MINUTES) ||
+                           length % CLASS_SLOT_MINUTES != 0) {
+                    printf("\nError: Classes start and last whole half hours.\n");
+                } else {
+                    shared_tables_begin_edit();
+                    int id = class_add(schedule, &gym_class);
+                    if (id != 0) {
+                        audit_record(AUDIT_ADMIN, AUDIT_CLASS_ADD, id, gym_class.name);
+                    }
+                    shared_tables_end_edit();
+                    if (id == 0) {
+                        printf("\nError: Invalid day, length or capacity (classes end by midnight).\n");
+                    } else {
+                        printf("\nClass added successfully! (ID: %d)\n", id);
+                        autosave_table(&schedule->classes);
+                    }
+                }
+                pause_screen();
+                break;
+            }
+            
+            case 2:
+                display_class_schedule(schedule);
+                pause_screen();
+                break;
+                
+            case 3: {
+                display_class_schedule(schedule);
+                if (schedule->classes.live_count > 0) {
+                    printf("Enter Class ID to delete: ");
+                    int id = get_int_input();
+                    shared_tables_begin_edit();
+                    int deleted = class_delete(schedule, id);
+                    if (deleted) {
+                        audit_record(AUDIT_ADMIN, AUDIT_CLASS_DELETE, id, NULL);
+                    }
+                    shared_tables_end_edit();
+                    if (deleted) {
+                        printf("\nClass deleted successfully, with its bookings.\n");
+                        autosave_table(&schedule->classes);
+                        autosave_table(&schedule->bookings);
+                    } else {
+                        printf("\nError: Class with ID %d not found.\n", id);
+                    }
+                }
+                pause_screen();
+                break;
+            }
+            
+            case 4: {
+                printf("\nThis removes every booking and waitlist. Type 1 to confirm: ");
+                if (get_int_input() == 1) {
+                    shared_tables_begin_edit();
+                    class_open_week(schedule);
+                    audit_record(AUDIT_ADMIN, AUDIT_CLASS_NEW_WEEK, 0, NULL);
+                    shared_tables_end_edit();
+                    autosave_table(&schedule->bookings);
+                    printf("\nThe new week is open for booking.\n");
+                }
+                pause_screen();
+                break;
+            }
+            
+            case 0:
+                break;
+                
+            default:
+                printf("\nInvalid choice. Try again.\n");
+                pause_screen();
+        }
+        
+    } while (choice != 0);
+}
+
+void admin_manage_branches() {
+    int choice;
+    
+    // Outside a branch the username index is only opened for this menu
+    int opened = get_current_branch()[0] == '\0' &&
+                 username_index_start(USERNAME_INDEX_FILE, BRANCHES_ROOT, BRANCHES_FILE) >= 0;
+    
+    do {
+        print_header("BRANCHES");
+        if (get_current_branch()[0] != '\0') {
+            printf("Current branch: %s\n\n", get_current_branch());
+        }
+        printf("1 - Branch Report (one or all branches)\n");
+        printf("2 - Find a Member in All Branches\n");
+        printf("3 - Add Branch\n");
+        printf("0 - Back to Admin Menu\n");
+        print_separator();
+        printf("Your choice: ");
+        choice = get_int_input();
+        
+        switch (choice) {
+            case 1: {
+                char name[BRANCH_NAME_SIZE];
+                printf("\nBranch name (or press Enter for all branches): ");
+                get_string_input(name, sizeof(name));
+                branches_display_report(name);
+                pause_screen();
+                break;
+            }
+            
+            case 2: {
+                char username[50];
+                printf("\nEnter username to search: ");
+                get_string_input(username, sizeof(username));
+                branches_display_member(username);
+                pause_screen();
+                break;
+            }
+            
+            case 3: {
+                char name[BRANCH_NAME_SIZE];
+                printf("\nNew branch name (letters, digits, '-' and '_'): ");
+                get_string_input(name, sizeof(name));
+                if (branch_create(BRANCHES_ROOT, BRANCHES_FILE, name)) {
+                    printf("\n[SUCCESS] Branch '%s' is ready. Run it with: gym_app --branch %s\n", name, name);
+                } else {
+                    printf("\nError: Invalid branch name.\n");
+                }
+                pause_screen();
+                break;
+            }
+            
+            case 0:
+                break;
+                
+            default:
+                printf("\nInvalid choice. Try again.\n");
+                pause_screen();
+        }
+        
+    } while (choice != 0);
+    
+    if (opened) {
+        username_index_stop();
+    }
+}
+
+void display_admin_menu(Table *members, Table *plans, Table *equipment, Table *loans,
+                        ClassSchedule *schedule) {
+    int choice;
+    
+    do {
+        // Show changes made by other running copies of the app, and by
+        // other programs to the plans and equipment files
+        shared_tables_refresh();
+        hot_reload_apply();
+        
         print_header("ADMIN MENU");
+        printf("Members in the gym right now: %d\n\n", checkin_occupancy());
         printf("1 - Manage Plans\n");
         printf("2 - Manage Equipment\n");
         printf("3 - Manage Members\n");
+        printf("4 - Run Monthly Billing\n");
+        printf("5 - Manage Classes\n");
+        printf("6 - Export Data (CSV / JSON Lines)\n");
+        printf("7 - Branches\n");
+        printf("8 - Replication Status\n");
+        printf("9 - Change Admin Password\n");
+        printf("10 - Audit Log (who changed what)\n");
         printf("0 - Logout\n");
         print_separator();
         printf("Your choice: ");
@@ -262,15 +786,50 @@ void display_admin_menu(Member members[], int *member_count,
         
         switch (choice) {
             case 1:
-                admin_manage_plans(plans, plan_count);
+                admin_manage_plans(plans, members);
                 break;
                 
             case 2:
-                admin_manage_equipment(equipment, equipment_count);
+                admin_manage_equipment(equipment, loans);
                 break;
                 
             case 3:
-                admin_manage_members(members, member_count);
+                admin_manage_members(members, loans, schedule);
+                break;
+                
+            case 4:
+                billing_run_interactive(members);
+                pause_screen();
+                break;
+                
+            case 5:
+                admin_manage_classes(schedule, plans);
+                break;
+                
+            case 6:
+                // Only reads this copy's tables: no edit lock while the admin types
+                shared_tables_refresh();
+                export_interactive(members, plans, equipment);
+                pause_screen();
+                break;
+                
+            case 7:
+                admin_manage_branches();
+                break;
+                
+            case 8:
+                replication_display_status();
+                pause_screen();
+                break;
+                
+            case 9:
+                admin_change_password();
+                pause_screen();
+                break;
+                
+            case 10:
+                audit_interactive(members);
+                pause_screen();
                 break;
                 
             case 0:
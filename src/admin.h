@@ -4,28 +4,41 @@
 #include "plans.h"
 #include "equipment.h"
 #include "member.h"
+#include "classes.h"
 
-// Admin credentials (hardcoded)
+// Admin credentials: the username and a password hash, one line
+//   username|hash
+// The file is created with the default password the first time the admin
+// logs in, and rewritten by Change Admin Password.
+#define ADMIN_FILE "data/admin.txt"
 #define ADMIN_USERNAME "admin"
-#define ADMIN_PASSWORD "admin123"
+#define ADMIN_DEFAULT_PASSWORD "admin123"
 
 // Function declarations
 
 // Admin login (returns 1 if successful, 0 if failed)
 int admin_login();
 
+// Admin screen: set a new admin password
+void admin_change_password();
+
 // Display main admin menu and handle operations
-void display_admin_menu(Member members[], int *member_count,
-                       Plan plans[], int *plan_count,
-                       Equipment equipment[], int *equipment_count);
+void display_admin_menu(Table *members, Table *plans, Table *equipment, Table *loans,
+                        ClassSchedule *schedule);
 
-// Plan management submenu
-void admin_manage_plans(Plan plans[], int *count);
+// Plan management submenu (with the plans' popularity among members)
+void admin_manage_plans(Table *plans, const Table *members);
 
 // Equipment management submenu
-void admin_manage_equipment(Equipment equipment[], int *count);
+void admin_manage_equipment(Table *equipment, const Table *loans);
 
 // Member management submenu
-void admin_manage_members(Member members[], int *count);
+void admin_manage_members(Table *members, Table *loans, ClassSchedule *schedule);
+
+// Group class management submenu
+void admin_manage_classes(ClassSchedule *schedule, const Table *plans);
+
+// Branches submenu: reports over one or all branches, member search, new branches
+void admin_manage_branches();
 
 #endif
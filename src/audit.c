@@ -0,0 +1,368 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime, nanosleep, localtime_r
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "audit.h"
+#include "event_ring.h"
+#include "member.h"
+#include "utils.h"
+
+// Events written to the log in one go
+#define WRITE_BATCH 256
+
+// Records read at a time by a query
+#define READ_CHUNK 4096
+
+static EventRing ring;
+static pthread_t writer_thread;
+static FILE *log_file = NULL;
+static char log_path[256] = AUDIT_FILE;
+static atomic_int running = 0;
+static atomic_int stopping = 0;
+
+// Threads between their running check and the end of their push: the ring
+// is only freed once there are none
+static atomic_int producers = 0;
+
+// Events queued, and events written and flushed to the file
+static atomic_llong queued = 0;
+static atomic_llong written = 0;
+
+static const char *action_names[AUDIT_ACTION_COUNT] = {
+    [AUDIT_PLAN_ADD]          = "Plan added",
+    [AUDIT_PLAN_MODIFY]       = "Plan modified",
+    [AUDIT_PLAN_DELETE]       = "Plan deleted",
+    [AUDIT_EQUIPMENT_ADD]     = "Equipment added",
+    [AUDIT_EQUIPMENT_MODIFY]  = "Equipment modified",
+    [AUDIT_EQUIPMENT_DELETE]  = "Equipment deleted",
+    [AUDIT_EQUIPMENT_SERVICE] = "Service recorded",
+    [AUDIT_MEMBER_SIGNUP]     = "Account created",
+    [AUDIT_MEMBER_DELETE]     = "Member deleted",
+    [AUDIT_MEMBER_IMPORT]     = "Members imported",
+    [AUDIT_SUBSCRIBE]         = "Subscribed",
+    [AUDIT_LOAN_CHECKOUT]     = "Equipment checked out",
+    [AUDIT_LOAN_RETURN]       = "Equipment returned",
+    [AUDIT_CLASS_ADD]         = "Class added",
+    [AUDIT_CLASS_DELETE]      = "Class deleted",
+    [AUDIT_CLASS_NEW_WEEK]    = "New class week opened",
+    [AUDIT_CLASS_BOOK]        = "Class booked",
+    [AUDIT_CLASS_CANCEL]      = "Booking cancelled",
+    [AUDIT_BILLING_RUN]       = "Billing run",
+    [AUDIT_ADMIN_PASSWORD]    = "Admin password changed",
+    [AUDIT_FILE_RELOAD]       = "Data file changed",
+};
+
+static long long now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+static void *writer_main(void *arg) {
+    (void)arg;
+    AuditRecord batch[WRITE_BATCH];
+    long long unflushed = 0;
+
+    while (1) {
+        int count = 0;
+        while (count < WRITE_BATCH && event_ring_pop(&ring, &batch[count])) {
+            count++;
+        }
+
+        if (count > 0) {
+            fwrite(batch, sizeof(AuditRecord), count, log_file);
+            unflushed += count;
+        }
+        if (count == WRITE_BATCH) {
+            continue;  // More is waiting
+        }
+
+        if (unflushed > 0) {
+            fflush(log_file);
+            atomic_fetch_add(&written, unflushed);
+            unflushed = 0;
+        }
+        if (count == 0) {
+            if (atomic_load(&stopping)) {
+                break;
+            }
+            // Idle: check again in a millisecond
+            struct timespec pause = { 0, 1000000 };
+            nanosleep(&pause, NULL);
+        }
+    }
+    return NULL;
+}
+
+int audit_start() {
+    if (atomic_load(&running)) {
+        return 1;
+    }
+
+    data_file_path(AUDIT_FILE, log_path, sizeof(log_path));
+    log_file = fopen(log_path, "ab");
+    if (!log_file) {
+        printf("Warning: Cannot open %s, changes will not be audited.\n", log_path);
+        return 0;
+    }
+    if (!event_ring_init(&ring, AUDIT_RING_SIZE, sizeof(AuditRecord))) {
+        fclose(log_file);
+        log_file = NULL;
+        return 0;
+    }
+
+    atomic_store(&queued, 0);
+    atomic_store(&written, 0);
+    atomic_store(&stopping, 0);
+    if (pthread_create(&writer_thread, NULL, writer_main, NULL) != 0) {
+        event_ring_free(&ring);
+        fclose(log_file);
+        log_file = NULL;
+        printf("Warning: Audit log writer unavailable, changes will not be audited.\n");
+        return 0;
+    }
+
+    atomic_store(&running, 1);
+    return 1;
+}
+
+void audit_stop() {
+    if (!atomic_load(&running)) {
+        return;
+    }
+
+    // No new events; the ones already being pushed still reach the writer
+    atomic_store(&running, 0);
+    while (atomic_load(&producers) > 0) {
+        sched_yield();
+    }
+    atomic_store(&stopping, 1);
+    pthread_join(writer_thread, NULL);
+
+    fclose(log_file);
+    log_file = NULL;
+    event_ring_free(&ring);
+}
+
+void audit_record(int actor, int action, int target, const char *detail) {
+    atomic_fetch_add(&producers, 1);
+    if (!atomic_load(&running)) {
+        atomic_fetch_sub(&producers, 1);
+        return;
+    }
+
+    AuditRecord record;
+    memset(&record, 0, sizeof(record));
+    record.time_ms = now_ms();
+    record.actor = actor;
+    record.target = target;
+    record.action = (unsigned short)action;
+    if (detail) {
+        size_t length = strlen(detail);
+        if (length >= sizeof(record.detail)) {
+            length = sizeof(record.detail) - 1;
+        }
+        memcpy(record.detail, detail, length);
+    }
+
+    // Only waits if the writer is AUDIT_RING_SIZE events behind
+    while (!event_ring_push(&ring, &record)) {
+        sched_yield();
+    }
+    atomic_fetch_add_explicit(&queued, 1, memory_order_relaxed);
+    atomic_fetch_sub(&producers, 1);
+}
+
+void audit_flush() {
+    long long target = atomic_load(&queued);
+    while (atomic_load(&running) && atomic_load(&written) < target) {
+        struct timespec pause = { 0, 1000000 };
+        nanosleep(&pause, NULL);
+    }
+}
+
+int audit_query(long long from_ms, long long to_ms, int actor, AuditRecord **events) {
+    *events = NULL;
+    if (!atomic_load(&running)) {
+        data_file_path(AUDIT_FILE, log_path, sizeof(log_path));
+    }
+    FILE *f = fopen(log_path, "rb");
+    if (!f) {
+        return -1;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long total = ftell(f) / (long)sizeof(AuditRecord);
+
+    // Records are in time order, give or take AUDIT_ORDER_SLACK_MS:
+    // binary search the first one that may be in the range
+    long low = 0, high = total;
+    AuditRecord record;
+    while (low < high) {
+        long middle = low + (high - low) / 2;
+        fseek(f, middle * (long)sizeof(AuditRecord), SEEK_SET);
+        if (fread(&record, sizeof(record), 1, f) != 1) {
+            break;
+        }
+        if (record.time_ms < from_ms - AUDIT_ORDER_SLACK_MS) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    AuditRecord *chunk = malloc(READ_CHUNK * sizeof(AuditRecord));
+    AuditRecord *found = NULL;
+    int count = 0, capacity = 0, past_end = 0;
+    if (!chunk) {
+        fclose(f);
+        return -1;
+    }
+
+    fseek(f, low * (long)sizeof(AuditRecord), SEEK_SET);
+    size_t read;
+    while (!past_end && (read = fread(chunk, sizeof(AuditRecord), READ_CHUNK, f)) > 0) {
+        for (size_t i = 0; i < read; i++) {
+            const AuditRecord *event = &chunk[i];
+            if (event->time_ms > to_ms + AUDIT_ORDER_SLACK_MS) {
+                past_end = 1;
+                break;
+            }
+            if (event->time_ms < from_ms || event->time_ms > to_ms ||
+                (actor != AUDIT_ANYONE && event->actor != actor)) {
+                continue;
+            }
+            if (count == capacity) {
+                int grown = capacity ? capacity * 2 : 64;
+                AuditRecord *bigger = realloc(found, grown * sizeof(AuditRecord));
+                if (!bigger) {
+                    past_end = 1;  // Out of memory: return what was found
+                    break;
+                }
+                found = bigger;
+                capacity = grown;
+            }
+            found[count++] = *event;
+        }
+    }
+
+    free(chunk);
+    fclose(f);
+    *events = found;
+    return count;
+}
+
+const char *audit_action_text(int action) {
+    if (action <= 0 || action >= AUDIT_ACTION_COUNT || !action_names[action]) {
+        return "Unknown action";
+    }
+    return action_names[action];
+}
+
+// "YYYY-MM-DD" as the local midnight starting that day (ms), -1 if invalid
+static long long parse_date(const char *text) {
+    int year, month, day;
+    char extra;
+    if (sscanf(text, "%d-%d-%d%c", &year, &month, &day, &extra) != 3 ||
+        month < 1 || month > 12 || day < 1 || day > 31) {
+        return -1;
+    }
+    struct tm date;
+    memset(&date, 0, sizeof(date));
+    date.tm_year = year - 1900;
+    date.tm_mon = month - 1;
+    date.tm_mday = day;
+    date.tm_isdst = -1;
+    time_t t = mktime(&date);
+    return t == (time_t)-1 ? -1 : (long long)t * 1000;
+}
+
+static void actor_text(const Table *members, int actor, char *out, int size) {
+    if (actor == AUDIT_ADMIN) {
+        snprintf(out, size, "admin");
+    } else if (actor == AUDIT_OUTSIDE) {
+        snprintf(out, size, "other program");
+    } else {
+        const Member *member = member_find(members, actor);
+        if (member) {
+            snprintf(out, size, "member %d (%s)", actor, member->username);
+        } else {
+            snprintf(out, size, "member %d", actor);
+        }
+    }
+}
+
+void audit_interactive(const Table *members) {
+    char text[32];
+    long long from_ms = 0, to_ms = now_ms();
+
+    printf("\nFrom date (YYYY-MM-DD, or press Enter for the start of the log): ");
+    get_string_input(text, sizeof(text));
+    if (text[0] != '\0' && (from_ms = parse_date(text)) < 0) {
+        printf("\nError: Invalid date.\n");
+        return;
+    }
+
+    printf("To date (YYYY-MM-DD, or press Enter for today): ");
+    get_string_input(text, sizeof(text));
+    if (text[0] != '\0') {
+        long long day = parse_date(text);
+        if (day < 0) {
+            printf("\nError: Invalid date.\n");
+            return;
+        }
+        to_ms = day + 24LL * 3600 * 1000 - 1;  // The whole day
+    }
+
+    printf("Member ID (0 = admin, -1 = other programs, or press Enter for everyone): ");
+    get_string_input(text, sizeof(text));
+    int actor = text[0] == '\0' ? AUDIT_ANYONE : atoi(text);
+
+    // Include what was just done
+    audit_flush();
+
+    AuditRecord *events;
+    int count = audit_query(from_ms, to_ms, actor, &events);
+    if (count < 0) {
+        printf("\nNo audit log yet.\n");
+        return;
+    }
+
+    print_header("AUDIT LOG");
+    if (count == 0) {
+        printf("No changes recorded in this range.\n");
+    }
+    int first = count > AUDIT_DISPLAY_MAX ? count - AUDIT_DISPLAY_MAX : 0;
+    if (first > 0) {
+        printf("%d changes found, the latest %d are shown.\n\n", count, AUDIT_DISPLAY_MAX);
+    }
+    for (int i = first; i < count; i++) {
+        const AuditRecord *event = &events[i];
+        char when[32] = "?";
+        time_t seconds = (time_t)(event->time_ms / 1000);
+        struct tm local;
+        if (localtime_r(&seconds, &local)) {
+            strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", &local);
+        }
+        char who[80];
+        actor_text(members, event->actor, who, sizeof(who));
+
+        printf("%s | %-24s | %-22s", when, who, audit_action_text(event->action));
+        if (event->target != 0) {
+            printf(" | ID %d", event->target);
+        }
+        if (event->detail[0] != '\0') {
+            printf(" | %s", event->detail);
+        }
+        printf("\n");
+    }
+    if (count > 0) {
+        printf("\nTotal: %d change(s)\n", count);
+    }
+    free(events);
+}
@@ -0,0 +1,88 @@
+#ifndef AUDIT_H
+#define AUDIT_H
+
+#include "table.h"
+
+#define AUDIT_FILE "data/audit.log"
+
+// Events waiting for the log writer; recording only blocks if it is full
+#define AUDIT_RING_SIZE 65536
+
+// Who made a change: a member ID (1 and up), or one of these
+#define AUDIT_ADMIN    0
+#define AUDIT_OUTSIDE -1      // another program, through the data files
+#define AUDIT_ANYONE  -2      // queries: every actor
+
+// Actions
+#define AUDIT_PLAN_ADD           1
+#define AUDIT_PLAN_MODIFY        2
+#define AUDIT_PLAN_DELETE        3
+#define AUDIT_EQUIPMENT_ADD      4
+#define AUDIT_EQUIPMENT_MODIFY   5
+#define AUDIT_EQUIPMENT_DELETE   6
+#define AUDIT_EQUIPMENT_SERVICE  7
+#define AUDIT_MEMBER_SIGNUP      8
+#define AUDIT_MEMBER_DELETE      9
+#define AUDIT_MEMBER_IMPORT     10
+#define AUDIT_SUBSCRIBE         11
+#define AUDIT_LOAN_CHECKOUT     12
+#define AUDIT_LOAN_RETURN       13
+#define AUDIT_CLASS_ADD         14
+#define AUDIT_CLASS_DELETE      15
+#define AUDIT_CLASS_NEW_WEEK    16
+#define AUDIT_CLASS_BOOK        17
+#define AUDIT_CLASS_CANCEL      18
+#define AUDIT_BILLING_RUN       19
+#define AUDIT_ADMIN_PASSWORD    20
+#define AUDIT_FILE_RELOAD       21
+#define AUDIT_ACTION_COUNT      22
+
+// Records before and after a time that may have been written out of
+// order, when several threads record at once (milliseconds)
+#define AUDIT_ORDER_SLACK_MS 1000
+
+// Most events the audit screen lists (the latest ones)
+#define AUDIT_DISPLAY_MAX 500
+
+#define AUDIT_DETAIL_SIZE 44
+
+// One record of the binary log (64 bytes, appended in time order)
+typedef struct {
+    long long time_ms;        // milliseconds since 1970
+    int actor;                // member ID, AUDIT_ADMIN or AUDIT_OUTSIDE
+    int target;               // ID of the plan, member, loan... changed (0 if none)
+    unsigned short action;    // AUDIT_*
+    unsigned short reserved;
+    char detail[AUDIT_DETAIL_SIZE];  // e.g. the plan name or username, cut to fit
+} AuditRecord;
+
+// Function declarations
+
+// Start the log writer thread (returns 1 if successful, 0 if the log
+// cannot be opened: changes are then not recorded)
+int audit_start();
+
+// Write every pending event and stop the log writer. Events recorded by
+// other threads meanwhile are either written or ignored; the queue is only
+// freed once no thread is adding to it.
+void audit_stop();
+
+// Record a change (any thread): the event is queued for the log writer
+// without taking a lock. Does nothing when the writer is not running.
+void audit_record(int actor, int action, int target, const char *detail);
+
+// Wait until the events recorded so far are in the log file
+void audit_flush();
+
+// Events from from_ms to to_ms (inclusive) by actor (or AUDIT_ANYONE),
+// oldest first, in a malloc'd array. Returns the number found, or -1 if
+// the log cannot be read.
+int audit_query(long long from_ms, long long to_ms, int actor, AuditRecord **events);
+
+// Name of an action, e.g. "Plan deleted"
+const char *audit_action_text(int action);
+
+// Admin screen: list the events of a date range, for everyone or one actor
+void audit_interactive(const Table *members);
+
+#endif
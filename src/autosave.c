@@ -0,0 +1,349 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime, pthread_cond_timedwait
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "autosave.h"
+#include "batch_save.h"
+#include "replication.h"
+
+// Shared state between the UI thread and the saver thread (protected by lock)
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake = PTHREAD_COND_INITIALIZER;   // signaled when there is work
+static pthread_cond_t idle = PTHREAD_COND_INITIALIZER;   // signaled when a write finished
+static pthread_t saver_thread;
+
+static int running = 0;
+static int stopping = 0;
+static int flush_requested = 0;
+static int writing = 0;
+static int dirty = 0;  // number of tables with a pending copy
+
+// One data file the saver knows about
+typedef struct SaveSlot {
+    char path[256];
+    Table pending;   // latest copy waiting to be written
+    Table writing;   // copy the saver is writing, so the lock is not held during disk I/O
+    Table saved;     // copy last written to the file
+    int has_saved;
+    unsigned long pending_version;  // table version each copy was taken at
+    unsigned long writing_version;
+    int queued;      // 1 if pending holds changes not written yet
+
+    // The live table and the thread that edits it; only that thread copies it
+    Table *source;
+    pthread_t owner;
+    int requested;                  // a save was asked for, the table is not copied yet
+    unsigned long handed_version;   // version last copied for saving (0: none)
+    unsigned long saved_version;    // version last written to the file
+    int saved_ready;                // saved_version not passed back to the table yet
+    int failing;                    // the last write failed
+    struct SaveSlot *next;
+} SaveSlot;
+
+// Slots are never moved or freed while running, the saver keeps pointers into them
+static SaveSlot *slots = NULL;
+
+static void coalesce_wait() {
+    // Wait a short moment so a burst of changes is written only once.
+    // A flush or stop request cuts the wait short.
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += (long)AUTOSAVE_COALESCE_MS * 1000000L;
+    deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+    deadline.tv_nsec %= 1000000000L;
+
+    while (!flush_requested && !stopping) {
+        if (pthread_cond_timedwait(&wake, &lock, &deadline) != 0) {
+            break;  // Timed out
+        }
+    }
+}
+
+static void *saver_main(void *arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&lock);
+
+    while (1) {
+        // Sleep until something changes
+        while (dirty == 0 && !stopping) {
+            pthread_cond_wait(&wake, &lock);
+        }
+
+        if (dirty == 0 && stopping) {
+            break;
+        }
+
+        coalesce_wait();
+
+        // Take the latest copies (a swap, no copying) and release the lock
+        // before touching the disk
+        // (at most BATCH_MAX_TABLES tables per round, the rest follow in the next one)
+        SaveSlot *batch_slots[BATCH_MAX_TABLES];
+        Table *batch[BATCH_MAX_TABLES];
+        int batch_count = 0;
+
+        for (SaveSlot *slot = slots; slot && batch_count < BATCH_MAX_TABLES; slot = slot->next) {
+            if (slot->queued) {
+                Table swap = slot->writing;
+                slot->writing = slot->pending;
+                slot->pending = swap;
+                slot->writing_version = slot->pending_version;
+                slot->queued = 0;
+                dirty--;
+                batch_slots[batch_count] = slot;
+                batch[batch_count++] = &slot->writing;
+            }
+        }
+
+        writing = 1;
+        pthread_mutex_unlock(&lock);
+
+        // All changed tables go to disk together (one io_uring submission on Linux)
+        int failed = batch_save_tables(batch, batch_count);
+
+        pthread_mutex_lock(&lock);
+        for (int i = 0; i < batch_count; i++) {
+            SaveSlot *slot = batch_slots[i];
+            if (!(failed & (1 << i))) {
+                // Kept as what the file now holds; the old one is reused
+                Table swap = slot->saved;
+                slot->saved = slot->writing;
+                slot->writing = swap;
+                slot->has_saved = 1;
+                slot->saved_version = slot->writing_version;
+                slot->saved_ready = 1;
+                slot->failing = 0;
+                continue;
+            }
+
+            if (!slot->failing) {
+                printf("\nError: Cannot save %s.\n", slot->writing.path);
+                slot->failing = 1;
+            }
+            if (slot->queued) {
+                continue;  // A newer copy is already waiting
+            }
+            if (!stopping && !flush_requested) {
+                // Write the same copy again after the coalescing delay
+                Table swap = slot->pending;
+                slot->pending = slot->writing;
+                slot->writing = swap;
+                slot->pending_version = slot->writing_version;
+                slot->queued = 1;
+                dirty++;
+            } else {
+                // No waiting for the disk now: the table stays unsaved, so
+                // its thread hands it over again with its next save
+                slot->handed_version = 0;
+                slot->requested = 1;
+            }
+        }
+        writing = 0;
+        pthread_cond_broadcast(&idle);
+    }
+
+    pthread_mutex_unlock(&lock);
+    return NULL;
+}
+
+static SaveSlot *find_slot(const char *path) {
+    for (SaveSlot *slot = slots; slot; slot = slot->next) {
+        if (strcmp(slot->path, path) == 0) {
+            return slot;
+        }
+    }
+
+    // First save of this file: add a slot
+    SaveSlot *slot = calloc(1, sizeof(SaveSlot));
+    if (!slot) {
+        return NULL;
+    }
+    snprintf(slot->path, sizeof(slot->path), "%s", path);
+    slot->next = slots;
+    slots = slot;
+    return slot;
+}
+
+int autosave_start() {
+    pthread_mutex_lock(&lock);
+
+    if (running) {
+        pthread_mutex_unlock(&lock);
+        return 1;
+    }
+
+    stopping = 0;
+    if (pthread_create(&saver_thread, NULL, saver_main, NULL) != 0) {
+        pthread_mutex_unlock(&lock);
+        printf("Warning: Background saving unavailable, saving directly instead.\n");
+        return 0;
+    }
+
+    running = 1;
+    pthread_mutex_unlock(&lock);
+    return 1;
+}
+
+// Copy the table for the saver (lock held, called by the table's thread)
+static void hand_over(SaveSlot *slot) {
+    Table *t = slot->source;
+    if (!table_copy(&slot->pending, t)) {
+        printf("\nError: Not enough memory to save %s.\n", t->path);
+        return;  // Still requested: tried again at the next save
+    }
+    slot->pending_version = t->version;
+    slot->handed_version = t->version;
+    slot->requested = 0;
+
+    if (!slot->queued) {
+        slot->queued = 1;
+        dirty++;
+    }
+    pthread_cond_signal(&wake);
+}
+
+// Tell the table which version is in its file (lock held, table's thread)
+static void pass_back(SaveSlot *slot) {
+    if (slot->saved_ready) {
+        slot->source->saved_version = slot->saved_version;
+        slot->saved_ready = 0;
+    }
+}
+
+static int owned_by_caller(const SaveSlot *slot) {
+    return slot->source && pthread_equal(slot->owner, pthread_self());
+}
+
+void autosave_table(Table *t) {
+    // Changes go to the standby (if any) before they are saved
+    replication_publish(t);
+
+    if (!table_is_dirty(t)) {
+        return;
+    }
+
+    pthread_mutex_lock(&lock);
+
+    SaveSlot *slot = running ? find_slot(t->path) : NULL;
+
+    if (!slot) {
+        // No saver thread: write right away
+        pthread_mutex_unlock(&lock);
+        if (!table_write(t, t->path)) {
+            printf("\nError: Cannot save %s.\n", t->path);
+            return;
+        }
+        t->saved_version = t->version;
+        return;
+    }
+
+    // Only noted here: the table is copied once, when this thread is done
+    // changing it (autosave_poll), however many changes were made
+    slot->source = t;
+    slot->owner = pthread_self();
+    pass_back(slot);
+    if (table_is_dirty(t) && t->version != slot->handed_version) {
+        slot->requested = 1;
+    }
+
+    pthread_mutex_unlock(&lock);
+}
+
+void autosave_poll() {
+    pthread_mutex_lock(&lock);
+
+    if (running) {
+        for (SaveSlot *slot = slots; slot; slot = slot->next) {
+            if (owned_by_caller(slot)) {
+                pass_back(slot);
+                if (slot->requested) {
+                    hand_over(slot);
+                }
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&lock);
+}
+
+int autosave_copy_saved(const char *path, Table *out) {
+    pthread_mutex_lock(&lock);
+
+    int copied = 0;
+    for (SaveSlot *slot = slots; slot; slot = slot->next) {
+        if (strcmp(slot->path, path) == 0) {
+            copied = slot->has_saved && table_copy(out, &slot->saved);
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&lock);
+    return copied;
+}
+
+void autosave_flush() {
+    pthread_mutex_lock(&lock);
+
+    if (running) {
+        for (SaveSlot *slot = slots; slot; slot = slot->next) {
+            if (owned_by_caller(slot) && slot->requested) {
+                hand_over(slot);
+            }
+        }
+
+        // Skip the coalescing delay and wait until nothing is left to write
+        flush_requested = 1;
+        pthread_cond_signal(&wake);
+        while (dirty != 0 || writing) {
+            pthread_cond_wait(&idle, &lock);
+        }
+        flush_requested = 0;
+
+        for (SaveSlot *slot = slots; slot; slot = slot->next) {
+            if (owned_by_caller(slot)) {
+                pass_back(slot);
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&lock);
+}
+
+void autosave_stop() {
+    pthread_mutex_lock(&lock);
+
+    if (!running) {
+        pthread_mutex_unlock(&lock);
+        return;
+    }
+
+    // Every thread is done editing: hand over what is still unsaved, the
+    // saver writes it before it exits
+    for (SaveSlot *slot = slots; slot; slot = slot->next) {
+        if (slot->requested) {
+            hand_over(slot);
+        }
+    }
+    stopping = 1;
+    pthread_cond_signal(&wake);
+    pthread_mutex_unlock(&lock);
+
+    pthread_join(saver_thread, NULL);
+
+    pthread_mutex_lock(&lock);
+    for (SaveSlot *slot = slots; slot; slot = slot->next) {
+        if (slot->source) {
+            pass_back(slot);
+            if (table_is_dirty(slot->source)) {
+                printf("\nError: The last changes to %s could not be saved.\n", slot->source->path);
+            }
+        }
+    }
+    running = 0;
+    stopping = 0;
+    pthread_mutex_unlock(&lock);
+}
@@ -0,0 +1,41 @@
+#ifndef AUTOSAVE_H
+#define AUTOSAVE_H
+
+#include "table.h"
+
+// How long the saver waits for more changes before writing (milliseconds).
+// A burst of edits inside this window ends up as a single file write.
+#define AUTOSAVE_COALESCE_MS 200
+
+// Function declarations
+
+// Start the background save thread (returns 1 if successful, 0 if failed).
+// If it is not running, autosave_table() saves synchronously.
+int autosave_start();
+
+// Ask for a save of the table to its data file if it changed since it was
+// last saved. Cheap: the table is copied for the saver once, at the next
+// autosave_poll() of the same thread, however many saves were asked for.
+// The table only counts as saved (table_is_dirty) once the write succeeded;
+// a failed write is retried. Changes are also sent to a standby (see
+// replication.h).
+void autosave_table(Table *t);
+
+// Hand the tables this thread asked to save over to the saver. Called by
+// each thread that edits tables when it is done for now: the UI thread
+// before it waits for input, the standby before it waits for the primary.
+void autosave_poll();
+
+// Copy into out (an initialized table) what this process last wrote to
+// the file at path. Returns 0 if it wrote nothing there yet (or out of
+// memory).
+int autosave_copy_saved(const char *path, Table *out);
+
+// Wait until every change this thread asked to save has been written to disk
+void autosave_flush();
+
+// Write everything still unsaved and stop the background thread. Other
+// threads must have stopped editing tables by then.
+void autosave_stop();
+
+#endif
@@ -0,0 +1,394 @@
+#define _GNU_SOURCE  // syscall()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "batch_save.h"
+#include "utils.h"
+
+// io_uring is optional: Linux only, and can be turned off with -DGYM_NO_IO_URING
+#if defined(__linux__) && !defined(GYM_NO_IO_URING)
+#define HAVE_IO_URING 1
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+// Steps of one table save, submitted as a linked chain
+#define STEP_WRITE  0
+#define STEP_FSYNC  1
+#define STEP_CLOSE  2
+#define STEP_RENAME 3
+#define STEP_COUNT  4
+
+static pthread_mutex_t batch_lock = PTHREAD_MUTEX_INITIALIZER;
+static int selected_backend = BATCH_BACKEND_IO_URING;
+
+#ifdef HAVE_IO_URING
+
+#define RING_ENTRIES (BATCH_MAX_TABLES * STEP_COUNT)
+
+// Larger tables are left to the synchronous path (one write must fit in 32 bits)
+#define RING_MAX_WRITE (1u << 30)
+
+// How long to wait for the requests already taken by the kernel when the
+// ring fails, before their buffers are given up for good (milliseconds)
+#define RING_DRAIN_MS 10000
+
+// Our view of the kernel's submission and completion rings
+typedef struct {
+    int fd;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    struct io_uring_sqe *sqes;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+} Ring;
+
+static Ring ring;
+static int ring_state = 0;  // 0 = not tried yet, 1 = ready, -1 = unavailable
+
+static int ring_supports_ops(int fd) {
+    // Ask the kernel which operations it knows (rename needs Linux 5.11)
+    size_t probe_size = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe *probe = calloc(1, probe_size);
+
+    if (!probe) {
+        return 0;
+    }
+
+    int ok = syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256) >= 0;
+    int needed[] = { IORING_OP_WRITE, IORING_OP_FSYNC, IORING_OP_CLOSE, IORING_OP_RENAMEAT };
+
+    for (int i = 0; ok && i < 4; i++) {
+        if (needed[i] > probe->last_op || !(probe->ops[needed[i]].flags & IO_URING_OP_SUPPORTED)) {
+            ok = 0;
+        }
+    }
+
+    free(probe);
+    return ok;
+}
+
+static int ring_setup() {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    int fd = syscall(__NR_io_uring_setup, RING_ENTRIES, &params);
+    if (fd < 0) {
+        return 0;
+    }
+
+    if (!ring_supports_ops(fd)) {
+        close(fd);
+        return 0;
+    }
+
+    size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    int single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+
+    if (single_mmap) {
+        // Both rings share one mapping on newer kernels
+        if (cq_size > sq_size) {
+            sq_size = cq_size;
+        }
+        cq_size = sq_size;
+    }
+
+    char *sq_ptr = mmap(NULL, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, IORING_OFF_SQ_RING);
+    if (sq_ptr == MAP_FAILED) {
+        close(fd);
+        return 0;
+    }
+
+    char *cq_ptr = sq_ptr;
+    if (!single_mmap) {
+        cq_ptr = mmap(NULL, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, IORING_OFF_CQ_RING);
+        if (cq_ptr == MAP_FAILED) {
+            munmap(sq_ptr, sq_size);
+            close(fd);
+            return 0;
+        }
+    }
+
+    void *sqes = mmap(NULL, params.sq_entries * sizeof(struct io_uring_sqe),
+                      PROT_READ | PROT_WRITE, MAP_SHARED, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        if (!single_mmap) {
+            munmap(cq_ptr, cq_size);
+        }
+        munmap(sq_ptr, sq_size);
+        close(fd);
+        return 0;
+    }
+
+    ring.fd = fd;
+    ring.sq_head = (unsigned *)(sq_ptr + params.sq_off.head);
+    ring.sq_tail = (unsigned *)(sq_ptr + params.sq_off.tail);
+    ring.sq_mask = (unsigned *)(sq_ptr + params.sq_off.ring_mask);
+    ring.sq_array = (unsigned *)(sq_ptr + params.sq_off.array);
+    ring.sqes = sqes;
+    ring.cq_head = (unsigned *)(cq_ptr + params.cq_off.head);
+    ring.cq_tail = (unsigned *)(cq_ptr + params.cq_off.tail);
+    ring.cq_mask = (unsigned *)(cq_ptr + params.cq_off.ring_mask);
+    ring.cqes = (struct io_uring_cqe *)(cq_ptr + params.cq_off.cqes);
+    return 1;
+}
+
+static int ring_ready() {
+    if (ring_state == 0) {
+        ring_state = ring_setup() ? 1 : -1;
+    }
+    return ring_state == 1;
+}
+
+static struct io_uring_sqe *ring_next_sqe(unsigned *tail) {
+    // Only this thread (under batch_lock) fills the submission ring
+    unsigned index = *tail & *ring.sq_mask;
+    struct io_uring_sqe *sqe = &ring.sqes[index];
+
+    memset(sqe, 0, sizeof(*sqe));
+    ring.sq_array[index] = index;
+    (*tail)++;
+    return sqe;
+}
+
+// Take the completions posted so far, noting the tables whose step failed
+static unsigned ring_reap(const size_t length[], int close_done[], int *retry) {
+    unsigned reaped = 0;
+    unsigned head = *ring.cq_head;
+    unsigned cq_tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+
+    while (head != cq_tail) {
+        struct io_uring_cqe *cqe = &ring.cqes[head & *ring.cq_mask];
+        int t = (int)(cqe->user_data / STEP_COUNT);
+        int step = (int)(cqe->user_data % STEP_COUNT);
+        int expected = (step == STEP_WRITE) ? (int)length[t] : 0;
+
+        if (step == STEP_CLOSE && cqe->res != -ECANCELED) {
+            close_done[t] = 1;
+        }
+        if (cqe->res != expected) {
+            *retry |= 1 << t;
+        }
+
+        head++;
+        reaped++;
+    }
+
+    __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+    return reaped;
+}
+
+// Returns the tables that still have to be written by the synchronous path.
+// in_flight gets the tables whose requests the kernel may still be working
+// on: their data must not be freed (nor their files written again).
+static int uring_write_files(int tables, int count, char *data[], size_t length[], const char *paths[],
+                             int *in_flight) {
+    // The kernel reads the paths while the requests run, so they live here
+    static char tmp_paths[BATCH_MAX_TABLES][300];
+    static char final_paths[BATCH_MAX_TABLES][256];
+    int fds[BATCH_MAX_TABLES];
+    int retry = 0;
+    unsigned submitted = 0;
+    unsigned tail = *ring.sq_tail;
+    unsigned first = tail;
+    *in_flight = 0;
+
+    for (int t = 0; t < count; t++) {
+        fds[t] = -1;
+
+        if (!(tables & (1 << t))) {
+            continue;
+        }
+
+        if (length[t] > RING_MAX_WRITE) {
+            retry |= 1 << t;
+            continue;
+        }
+
+        // The temporary file is opened here so every later step can use its descriptor
+        snprintf(tmp_paths[t], sizeof(tmp_paths[t]), "%s.tmp", paths[t]);
+        snprintf(final_paths[t], sizeof(final_paths[t]), "%s", paths[t]);
+        fds[t] = open(tmp_paths[t], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+        if (fds[t] < 0) {
+            retry |= 1 << t;
+            continue;
+        }
+
+        // write -> fsync -> close -> rename, each step only runs if the previous one succeeded
+        struct io_uring_sqe *sqe = ring_next_sqe(&tail);
+        sqe->opcode = IORING_OP_WRITE;
+        sqe->fd = fds[t];
+        sqe->addr = (unsigned long)data[t];
+        sqe->len = (unsigned)length[t];
+        sqe->off = 0;
+        sqe->flags = IOSQE_IO_LINK;
+        sqe->user_data = t * STEP_COUNT + STEP_WRITE;
+
+        sqe = ring_next_sqe(&tail);
+        sqe->opcode = IORING_OP_FSYNC;
+        sqe->fd = fds[t];
+        sqe->flags = IOSQE_IO_LINK;
+        sqe->user_data = t * STEP_COUNT + STEP_FSYNC;
+
+        sqe = ring_next_sqe(&tail);
+        sqe->opcode = IORING_OP_CLOSE;
+        sqe->fd = fds[t];
+        sqe->flags = IOSQE_IO_LINK;
+        sqe->user_data = t * STEP_COUNT + STEP_CLOSE;
+
+        sqe = ring_next_sqe(&tail);
+        sqe->opcode = IORING_OP_RENAMEAT;
+        sqe->fd = AT_FDCWD;
+        sqe->addr = (unsigned long)tmp_paths[t];
+        sqe->len = AT_FDCWD;
+        sqe->addr2 = (unsigned long)final_paths[t];
+        sqe->user_data = t * STEP_COUNT + STEP_RENAME;
+
+        submitted += STEP_COUNT;
+    }
+
+    if (submitted == 0) {
+        return retry;
+    }
+
+    // Publish the new entries, then submit and wait for all of them in one call
+    __atomic_store_n(ring.sq_tail, tail, __ATOMIC_RELEASE);
+
+    unsigned completed = 0;
+    int close_done[BATCH_MAX_TABLES] = { 0 };
+    int to_submit = submitted;
+
+    while (completed < submitted) {
+        int ret = syscall(__NR_io_uring_enter, ring.fd, to_submit, submitted - completed,
+                          IORING_ENTER_GETEVENTS, NULL, 0);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        to_submit = 0;
+        completed += ring_reap(length, close_done, &retry);
+    }
+
+    if (completed < submitted) {
+        // The kernel stopped answering: give up on this ring and use the sync
+        // path, but only once the requests it already took have finished
+        // (the others never run: the ring is not entered again)
+        ring_state = -1;
+        retry = tables;
+        unsigned taken = __atomic_load_n(ring.sq_head, __ATOMIC_ACQUIRE) - first;
+        struct timespec pause = { 0, 1000000 };  // 1 ms
+        for (int waited = 0; completed < taken && waited < RING_DRAIN_MS; waited++) {
+            nanosleep(&pause, NULL);
+            completed += ring_reap(length, close_done, &retry);
+        }
+        if (completed < taken) {
+            // Still running: leave their descriptors and buffers alone
+            for (int t = 0; t < count; t++) {
+                if (fds[t] >= 0) {
+                    *in_flight |= 1 << t;
+                }
+            }
+            return retry & ~*in_flight;
+        }
+    }
+
+    for (int t = 0; t < count; t++) {
+        if (fds[t] >= 0 && !close_done[t]) {
+            close(fds[t]);  // The chain was cut before its close step
+        }
+        if (fds[t] >= 0 && (retry & (1 << t))) {
+            remove(tmp_paths[t]);
+        }
+    }
+
+    return retry;
+}
+
+#endif
+
+int batch_save_tables(Table *tables[], int count) {
+    const char *paths[BATCH_MAX_TABLES];
+    char *data[BATCH_MAX_TABLES];
+    size_t length[BATCH_MAX_TABLES];
+    int failed = 0;
+
+    if (count > BATCH_MAX_TABLES) {
+        count = BATCH_MAX_TABLES;
+    }
+
+    // Format every table in memory first; the disk work is then one batch
+    for (int t = 0; t < count; t++) {
+        paths[t] = tables[t]->path;
+        length[t] = 0;
+        data[t] = table_format(tables[t], &length[t]);
+        if (!data[t]) {
+            failed |= 1 << t;  // Out of memory
+        }
+    }
+
+    int pending = ((1 << count) - 1) & ~failed;
+    int in_flight = 0;  // still used by the kernel: not freed
+
+    pthread_mutex_lock(&batch_lock);
+
+#ifdef HAVE_IO_URING
+    if (selected_backend == BATCH_BACKEND_IO_URING && pending != 0 && ring_ready()) {
+        // Tables that failed in the ring get a second chance below
+        pending = uring_write_files(pending, count, data, length, paths, &in_flight);
+        failed |= in_flight;
+    }
+#endif
+
+    for (int t = 0; t < count; t++) {
+        if ((pending & (1 << t)) && !write_file_atomically(paths[t], data[t], length[t])) {
+            failed |= 1 << t;
+        }
+    }
+
+    pthread_mutex_unlock(&batch_lock);
+
+    for (int t = 0; t < count; t++) {
+        if (!(in_flight & (1 << t))) {
+            free(data[t]);
+        }
+    }
+
+    return failed;
+}
+
+int batch_save_set_backend(int backend) {
+    pthread_mutex_lock(&batch_lock);
+
+    selected_backend = BATCH_BACKEND_SYNC;
+#ifdef HAVE_IO_URING
+    if (backend == BATCH_BACKEND_IO_URING && ring_ready()) {
+        selected_backend = BATCH_BACKEND_IO_URING;
+    }
+#else
+    (void)backend;
+#endif
+
+    int result = selected_backend;
+    pthread_mutex_unlock(&batch_lock);
+    return result;
+}
+
+const char *batch_save_backend_name() {
+    int backend = batch_save_set_backend(selected_backend);
+    return backend == BATCH_BACKEND_IO_URING ? "io_uring" : "synchronous";
+}
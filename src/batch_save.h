@@ -0,0 +1,29 @@
+#ifndef BATCH_SAVE_H
+#define BATCH_SAVE_H
+
+#include "table.h"
+
+// Most tables in one batch (the result is a bit mask)
+#define BATCH_MAX_TABLES 16
+
+// How the batch is written to disk
+#define BATCH_BACKEND_SYNC     0   // write_file_atomically() for each table
+#define BATCH_BACKEND_IO_URING 1   // one io_uring submission for all tables (Linux only)
+
+// Function declarations
+
+// Save up to BATCH_MAX_TABLES tables, each to its own path.
+// With io_uring, the write/fsync/close/rename steps of every table are
+// submitted together; tables that fail there are retried synchronously.
+// Returns a mask of the tables that could not be saved (bit i = tables[i],
+// 0 if everything was saved).
+int batch_save_tables(Table *tables[], int count);
+
+// Choose the backend (returns the backend actually in use, since
+// io_uring falls back to BATCH_BACKEND_SYNC when it is unavailable)
+int batch_save_set_backend(int backend);
+
+// Name of the backend in use, for messages and benchmarks
+const char *batch_save_backend_name();
+
+#endif
@@ -0,0 +1,295 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime, fileno, fsync
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+#include "billing.h"
+#include "plan_catalog.h"
+#include "subscriptions.h"
+#include "audit.h"
+#include "utils.h"
+
+// Longest invoice line: period, invoice number, ids, texts and amount
+#define INVOICE_MAX_LINE (8 + 24 + 12 + 50 + 100 + 12 + 50 + MONEY_MAX_TEXT + 8)
+
+// Chunks that may be formatted ahead of the writer, per worker
+#define CHUNKS_AHEAD 4
+
+typedef struct {
+    char *data;
+    size_t length;
+    int invoices;
+    int skipped;
+    Money total;
+    int done;
+} Chunk;
+
+typedef struct {
+    const Table *members;
+    const Table *plans;
+    const char *period;
+    Chunk *chunks;
+    int chunk_count;
+    int next_chunk;     // next chunk a worker takes
+    int written;        // chunks already written by the caller
+    int window;         // most chunks formatted but not written yet
+    int failed;         // out of memory in a worker
+    pthread_mutex_t lock;
+    pthread_cond_t chunk_done;
+    pthread_cond_t space;
+} BillingRun;
+
+static void bill_chunk(BillingRun *run, int index) {
+    Chunk *chunk = &run->chunks[index];
+    int first = index * BILLING_CHUNK_MEMBERS;
+    int last = first + BILLING_CHUNK_MEMBERS;
+    if (last > run->members->count) {
+        last = run->members->count;
+    }
+
+    chunk->data = malloc((size_t)(last - first) * INVOICE_MAX_LINE + 1);
+    if (!chunk->data) {
+        run->failed = 1;
+        return;
+    }
+
+    char *out = chunk->data;
+    for (int i = first; i < last; i++) {
+        if (!table_is_live(run->members, i)) {
+            continue;
+        }
+
+        const Member *member = member_at(run->members, i);
+        if (member->id_current_plan == -1) {
+            continue;
+        }
+
+        const Plan *plan = plan_find(run->plans, member->id_current_plan);
+        if (!plan) {
+            chunk->skipped++;
+            continue;
+        }
+
+        // period|invoice|member_id|username|name|plan_id|plan|amount
+        char amount[MONEY_MAX_TEXT];
+        money_format(plan->price, amount);
+
+        out += sprintf(out, "%s|INV-%s-%06d|%d|%s|%s|%d|%s|%s\n",
+                       run->period, run->period, member->id_member,
+                       member->id_member, member->username, member->name,
+                       plan->id_plan, plan->name, amount);
+        chunk->invoices++;
+        chunk->total += plan->price;
+    }
+
+    chunk->length = out - chunk->data;
+}
+
+static void *billing_worker(void *arg) {
+    BillingRun *run = arg;
+
+    pthread_mutex_lock(&run->lock);
+    while (1) {
+        // Do not run too far ahead of the writer, to bound memory use
+        while (run->next_chunk < run->chunk_count &&
+               run->next_chunk >= run->written + run->window) {
+            pthread_cond_wait(&run->space, &run->lock);
+        }
+        if (run->next_chunk >= run->chunk_count) {
+            break;
+        }
+
+        int index = run->next_chunk++;
+        pthread_mutex_unlock(&run->lock);
+
+        bill_chunk(run, index);
+
+        pthread_mutex_lock(&run->lock);
+        run->chunks[index].done = 1;
+        pthread_cond_broadcast(&run->chunk_done);
+    }
+    pthread_mutex_unlock(&run->lock);
+    return NULL;
+}
+
+int billing_default_threads() {
+    return online_cpu_count(BILLING_MAX_THREADS);
+}
+
+int billing_run(const Table *members, const Table *plans, const char *period,
+                const char *path, int threads, BillingSummary *summary) {
+    memset(summary, 0, sizeof(BillingSummary));
+
+    if (threads < 1) {
+        threads = 1;
+    }
+    if (threads > BILLING_MAX_THREADS) {
+        threads = BILLING_MAX_THREADS;
+    }
+
+    BillingRun run;
+    memset(&run, 0, sizeof(run));
+    run.members = members;
+    run.plans = plans;
+    run.period = period;
+    run.chunk_count = (members->count + BILLING_CHUNK_MEMBERS - 1) / BILLING_CHUNK_MEMBERS;
+    run.window = threads * CHUNKS_AHEAD;
+    run.chunks = calloc(run.chunk_count > 0 ? run.chunk_count : 1, sizeof(Chunk));
+    if (!run.chunks) {
+        return 0;
+    }
+
+    char tmp_path[300];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE *f = fopen(tmp_path, "wb");
+    if (!f) {
+        free(run.chunks);
+        return 0;
+    }
+
+    pthread_mutex_init(&run.lock, NULL);
+    pthread_cond_init(&run.chunk_done, NULL);
+    pthread_cond_init(&run.space, NULL);
+
+    pthread_t workers[BILLING_MAX_THREADS];
+    int started = 0;
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&workers[started], NULL, billing_worker, &run) == 0) {
+            started++;
+        }
+    }
+    if (started == 0) {
+        billing_worker(&run);  // No threads available: format everything here
+    }
+
+    fprintf(f, "# period|invoice|member_id|username|name|plan_id|plan|amount\n");
+    int ok = 1;
+
+    // Chunk totals, added up exactly at the end
+    Money *chunk_totals = calloc(run.chunk_count > 0 ? run.chunk_count : 1, sizeof(Money));
+    if (!chunk_totals) {
+        ok = 0;
+    }
+
+    // Write the chunks in order as soon as each one is ready
+    for (int c = 0; c < run.chunk_count; c++) {
+        pthread_mutex_lock(&run.lock);
+        while (!run.chunks[c].done) {
+            pthread_cond_wait(&run.chunk_done, &run.lock);
+        }
+        pthread_mutex_unlock(&run.lock);
+
+        Chunk *chunk = &run.chunks[c];
+        if (!chunk->data || fwrite(chunk->data, 1, chunk->length, f) != chunk->length) {
+            ok = 0;
+        }
+        summary->invoices += chunk->invoices;
+        summary->skipped += chunk->skipped;
+        if (chunk_totals) {
+            chunk_totals[c] = chunk->total;
+        }
+        free(chunk->data);
+        chunk->data = NULL;
+
+        pthread_mutex_lock(&run.lock);
+        run.written++;
+        pthread_cond_broadcast(&run.space);
+        pthread_mutex_unlock(&run.lock);
+    }
+
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    if (chunk_totals) {
+        summary->total = money_sum(chunk_totals, run.chunk_count);
+        free(chunk_totals);
+    }
+
+    char total[MONEY_MAX_TEXT];
+    money_format(summary->total, total);
+    fprintf(f, "TOTAL|%s|%d|%s\n", period, summary->invoices, total);
+
+    if (fflush(f) != 0) {
+        ok = 0;
+    }
+#ifndef _WIN32
+    if (fsync(fileno(f)) != 0) {
+        ok = 0;
+    }
+#endif
+    if (fclose(f) != 0) {
+        ok = 0;
+    }
+
+#ifdef _WIN32
+    remove(path);  // rename() does not replace existing files on Windows
+#endif
+    if (!ok || run.failed || rename(tmp_path, path) != 0) {
+        remove(tmp_path);
+        ok = 0;
+    }
+
+    pthread_cond_destroy(&run.space);
+    pthread_cond_destroy(&run.chunk_done);
+    pthread_mutex_destroy(&run.lock);
+    free(run.chunks);
+    return ok;
+}
+
+void billing_run_interactive(Table *members) {
+    print_header("MONTHLY BILLING");
+
+    // Lapsed subscriptions are not billed
+    subscriptions_expire_due(members);
+
+    char period[16];
+    time_t now = time(NULL);
+    struct tm *date = localtime(&now);
+    if (!date || strftime(period, sizeof(period), "%Y-%m", date) == 0) {
+        printf("\nError: Cannot read the current date.\n");
+        return;
+    }
+
+    char name[64], path[256];
+    snprintf(name, sizeof(name), "data/invoices_%s.txt", period);
+    data_file_path(name, path, sizeof(path));
+    int threads = billing_default_threads();
+
+    printf("Billing period: %s\n", period);
+    printf("Worker threads: %d\n", threads);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    // The run only reads, so it works on the published plans without locks
+    BillingSummary summary;
+    const PlanCatalog *catalog = plan_catalog_enter();
+    int ok = billing_run(members, &catalog->plans, period, path, threads, &summary);
+    plan_catalog_exit();
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double ms = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1000000.0;
+
+    if (!ok) {
+        printf("\nError: Cannot write %s.\n", path);
+        return;
+    }
+
+    char total[MONEY_MAX_TEXT];
+    money_format(summary.total, total);
+    char detail[AUDIT_DETAIL_SIZE];
+    snprintf(detail, sizeof(detail), "%.7s: %d invoices", period, summary.invoices);
+    audit_record(AUDIT_ADMIN, AUDIT_BILLING_RUN, 0, detail);
+    printf("\n[SUCCESS] %d invoice(s) written to %s\n", summary.invoices, path);
+    printf("Total billed: %s DT\n", total);
+    if (summary.skipped > 0) {
+        printf("Skipped: %d subscription(s) to deleted plans\n", summary.skipped);
+    }
+    printf("Time: %.1f ms\n", ms);
+}
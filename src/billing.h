@@ -0,0 +1,40 @@
+#ifndef BILLING_H
+#define BILLING_H
+
+#include "member.h"
+#include "plans.h"
+#include "money.h"
+
+// Members handled as one unit of work; the output is always cut at the
+// same places, so it does not depend on the number of threads
+#define BILLING_CHUNK_MEMBERS 16384
+
+// Most worker threads for one run
+#define BILLING_MAX_THREADS 64
+
+// Totals of one billing run
+typedef struct {
+    int invoices;          // active subscriptions billed
+    int skipped;           // subscriptions to a plan that no longer exists
+    Money total;           // sum of all invoices
+} BillingSummary;
+
+// Function declarations
+
+// Bill every active subscription for period ("YYYY-MM"): one invoice line
+// per member, in member table order, streamed to path through a temporary
+// file. The member table is split into chunks that threads worker threads
+// format in parallel while the calling thread writes them out in order,
+// so the file is byte-identical for any thread count.
+// members and plans must not change during the run.
+// Returns 1 if successful, 0 if the file could not be written.
+int billing_run(const Table *members, const Table *plans, const char *period,
+                const char *path, int threads, BillingSummary *summary);
+
+// Number of worker threads to use by default (online CPUs, at least 1)
+int billing_default_threads();
+
+// Admin screen: bill the current month into data/invoices_YYYY-MM.txt
+void billing_run_interactive(Table *members);
+
+#endif
@@ -0,0 +1,610 @@
+#define _POSIX_C_SOURCE 200809L  // fileno
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "branches.h"
+
+// Longest username, as Member.username
+#define INDEX_USERNAME_SIZE 50
+
+// Longest log line: "+username|branch|member_id\n"
+#define INDEX_MAX_LINE (INDEX_USERNAME_SIZE + BRANCH_NAME_SIZE + 16)
+
+// One username of the index
+typedef struct {
+    char username[INDEX_USERNAME_SIZE];
+    unsigned hash;
+    int branch;            // position in branch_names, -1 once released
+    int member_id;
+} IndexEntry;
+
+static FILE *index_file = NULL;
+static long long indexed_end = 0;      // bytes of the log applied so far
+
+static IndexEntry *entries = NULL;
+static int entry_count = 0;
+static int entry_capacity = 0;
+static int *slots = NULL;              // hash of username -> entry + 1 (0 = empty)
+static int slot_capacity = 0;          // power of two
+
+static char branch_names[BRANCH_MAX][BRANCH_NAME_SIZE];
+static int branch_count = 0;
+
+int branch_name_valid(const char *name) {
+    int length = (int)strlen(name);
+    if (length == 0 || length >= BRANCH_NAME_SIZE) {
+        return 0;
+    }
+    for (int i = 0; i < length; i++) {
+        char c = name[i];
+        if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+              c == '-' || c == '_')) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int branches_list(const char *list_path, char names[][BRANCH_NAME_SIZE], int max) {
+    FILE *f = fopen(list_path, "r");
+    if (!f) {
+        return 0;
+    }
+
+    char line[128];
+    int count = 0;
+    while (count < max && fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (branch_name_valid(line)) {
+            strcpy(names[count++], line);
+        }
+    }
+    fclose(f);
+    return count;
+}
+
+int branch_exists(const char *list_path, const char *name) {
+    char names[BRANCH_MAX][BRANCH_NAME_SIZE];
+    int count = branches_list(list_path, names, BRANCH_MAX);
+    for (int i = 0; i < count; i++) {
+        if (strcmp(names[i], name) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Copy a small file unless the target already exists
+static void copy_if_missing(const char *from, const char *to) {
+    FILE *target = fopen(to, "rb");
+    if (target) {
+        fclose(target);
+        return;
+    }
+    FILE *source = fopen(from, "rb");
+    if (!source) {
+        return;
+    }
+    target = fopen(to, "wb");
+    if (target) {
+        char buffer[4096];
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), source)) > 0) {
+            fwrite(buffer, 1, n, target);
+        }
+        fclose(target);
+    }
+    fclose(source);
+}
+
+int branch_create(const char *root, const char *list_path, const char *name) {
+    if (!branch_name_valid(name)) {
+        return 0;
+    }
+
+    char dir[256];
+    snprintf(dir, sizeof(dir), "%s/%s", root, name);
+#ifdef _WIN32
+    _mkdir(dir);
+#else
+    mkdir(dir, 0755);
+#endif
+
+    // A new branch starts with the plans of the main data folder
+    char from[256], to[300];
+    snprintf(from, sizeof(from), "%s/plans.txt", root);
+    snprintf(to, sizeof(to), "%s/plans.txt", dir);
+    copy_if_missing(from, to);
+
+    if (branch_exists(list_path, name)) {
+        return 1;
+    }
+    char names[BRANCH_MAX][BRANCH_NAME_SIZE];
+    if (branches_list(list_path, names, BRANCH_MAX) == BRANCH_MAX) {
+        return 0;
+    }
+
+    FILE *f = fopen(list_path, "a");
+    if (!f) {
+        return 0;
+    }
+    fprintf(f, "%s\n", name);
+    return fclose(f) == 0;
+}
+
+// Load one branch's tables (missing files leave a table empty)
+static void load_branch(Branch *branch, const char *root, const char *name) {
+    char path[256];
+    snprintf(branch->name, sizeof(branch->name), "%s", name);
+
+    member_table_init(&branch->members);
+    snprintf(path, sizeof(path), "%s/%s/members.txt", root, name);
+    table_load(&branch->members, path);
+
+    plan_table_init(&branch->plans);
+    snprintf(path, sizeof(path), "%s/%s/plans.txt", root, name);
+    table_load(&branch->plans, path);
+
+    equipment_table_init(&branch->equipment);
+    snprintf(path, sizeof(path), "%s/%s/equipment.txt", root, name);
+    table_load(&branch->equipment, path);
+}
+
+static void free_branch(Branch *branch) {
+    table_free(&branch->members);
+    table_free(&branch->plans);
+    table_free(&branch->equipment);
+}
+
+// Work shared by the loading threads: each takes the next branch
+typedef struct {
+    const char *root;
+    const char (*names)[BRANCH_NAME_SIZE];
+    int count;
+    atomic_int next;
+    BranchVisitor visit;
+    void *arg;
+} BranchWork;
+
+static void *branch_worker(void *arg) {
+    BranchWork *work = arg;
+    int i;
+    while ((i = atomic_fetch_add(&work->next, 1)) < work->count) {
+        Branch branch;
+        load_branch(&branch, work->root, work->names[i]);
+        work->visit(&branch, i, work->arg);
+        free_branch(&branch);
+    }
+    return NULL;
+}
+
+int branches_for_each(const char *root, const char names[][BRANCH_NAME_SIZE], int count,
+                      int threads, BranchVisitor visit, void *arg) {
+    BranchWork work;
+    work.root = root;
+    work.names = names;
+    work.count = count;
+    atomic_init(&work.next, 0);
+    work.visit = visit;
+    work.arg = arg;
+
+    if (threads > count) {
+        threads = count;
+    }
+    if (threads > BRANCH_MAX_THREADS) {
+        threads = BRANCH_MAX_THREADS;
+    }
+
+    // The calling thread works too; if a thread cannot start, the others take its share
+    pthread_t workers[BRANCH_MAX_THREADS];
+    int started[BRANCH_MAX_THREADS];
+    for (int t = 1; t < threads; t++) {
+        started[t] = pthread_create(&workers[t], NULL, branch_worker, &work) == 0;
+    }
+    branch_worker(&work);
+    for (int t = 1; t < threads; t++) {
+        if (started[t]) {
+            pthread_join(workers[t], NULL);
+        }
+    }
+    return count;
+}
+
+// ---- Username index ----
+
+static unsigned hash_username(const char *username) {
+    // FNV-1a
+    unsigned hash = 2166136261u;
+    for (const unsigned char *c = (const unsigned char *)username; *c; c++) {
+        hash = (hash ^ *c) * 16777619u;
+    }
+    return hash;
+}
+
+// Entry of a username, -1 if it was never in the index
+static int find_entry(const char *username, unsigned hash) {
+    if (slot_capacity == 0) {
+        return -1;
+    }
+    unsigned mask = (unsigned)slot_capacity - 1;
+    for (unsigned s = hash & mask; slots[s] != 0; s = (s + 1) & mask) {
+        IndexEntry *entry = &entries[slots[s] - 1];
+        if (entry->hash == hash && strcmp(entry->username, username) == 0) {
+            return slots[s] - 1;
+        }
+    }
+    return -1;
+}
+
+static int grow_index() {
+    if (entry_count == entry_capacity) {
+        int capacity = entry_capacity > 0 ? entry_capacity * 2 : 1024;
+        IndexEntry *grown = realloc(entries, sizeof(IndexEntry) * capacity);
+        if (!grown) {
+            return 0;
+        }
+        entries = grown;
+        entry_capacity = capacity;
+    }
+
+    // Keep the slots at most half full
+    if ((entry_count + 1) * 2 > slot_capacity) {
+        int capacity = slot_capacity > 0 ? slot_capacity * 2 : 2048;
+        int *grown = calloc(capacity, sizeof(int));
+        if (!grown) {
+            return 0;
+        }
+        unsigned mask = (unsigned)capacity - 1;
+        for (int e = 0; e < entry_count; e++) {
+            unsigned s = entries[e].hash & mask;
+            while (grown[s] != 0) {
+                s = (s + 1) & mask;
+            }
+            grown[s] = e + 1;
+        }
+        free(slots);
+        slots = grown;
+        slot_capacity = capacity;
+    }
+    return 1;
+}
+
+static int branch_number(const char *name) {
+    for (int b = 0; b < branch_count; b++) {
+        if (strcmp(branch_names[b], name) == 0) {
+            return b;
+        }
+    }
+    if (branch_count == BRANCH_MAX) {
+        return -1;
+    }
+    snprintf(branch_names[branch_count], BRANCH_NAME_SIZE, "%s", name);
+    return branch_count++;
+}
+
+// Record that username belongs to member_id of branch (-1: released)
+static void set_entry(const char *username, int branch, int member_id) {
+    unsigned hash = hash_username(username);
+    int e = find_entry(username, hash);
+
+    if (e < 0) {
+        if (branch < 0 || !grow_index()) {
+            return;
+        }
+        e = entry_count++;
+        snprintf(entries[e].username, INDEX_USERNAME_SIZE, "%s", username);
+        entries[e].hash = hash;
+        unsigned mask = (unsigned)slot_capacity - 1;
+        unsigned s = hash & mask;
+        while (slots[s] != 0) {
+            s = (s + 1) & mask;
+        }
+        slots[s] = e + 1;
+    }
+    entries[e].branch = branch;
+    entries[e].member_id = member_id;
+}
+
+// Apply one log line (without '\n')
+static void apply_line(char *line) {
+    if (line[0] == '-') {
+        set_entry(line + 1, -1, 0);
+        return;
+    }
+    if (line[0] != '+') {
+        return;
+    }
+
+    // Split from the right: the username itself may hold a '|'
+    char *id_bar = strrchr(line, '|');
+    if (!id_bar || id_bar == line) {
+        return;
+    }
+    *id_bar = '\0';
+    char *branch_bar = strrchr(line, '|');
+    if (!branch_bar) {
+        return;
+    }
+    *branch_bar = '\0';
+
+    int branch = branch_number(branch_bar + 1);
+    if (branch >= 0) {
+        set_entry(line + 1, branch, atoi(id_bar + 1));
+    }
+}
+
+// Apply the complete lines appended since the last call
+static void catch_up() {
+    fflush(index_file);
+    fseek(index_file, (long)indexed_end, SEEK_SET);
+
+    char line[INDEX_MAX_LINE];
+    while (fgets(line, sizeof(line), index_file)) {
+        size_t length = strlen(line);
+        if (length == 0 || line[length - 1] != '\n') {
+            break;  // Still being written
+        }
+        indexed_end += (long long)length;
+        line[length - 1] = '\0';
+        apply_line(line);
+    }
+    clearerr(index_file);
+}
+
+static void lock_index() {
+#ifndef _WIN32
+    struct flock lock = { .l_type = F_WRLCK, .l_whence = SEEK_SET };
+    fcntl(fileno(index_file), F_SETLKW, &lock);
+#endif
+}
+
+static void unlock_index() {
+#ifndef _WIN32
+    struct flock lock = { .l_type = F_UNLCK, .l_whence = SEEK_SET };
+    fcntl(fileno(index_file), F_SETLK, &lock);
+#endif
+}
+
+static void append_line(const char *username, const char *branch, int member_id) {
+    fseek(index_file, 0, SEEK_END);
+    if (branch) {
+        fprintf(index_file, "+%s|%s|%d\n", username, branch, member_id);
+    } else {
+        fprintf(index_file, "-%s\n", username);
+    }
+    fflush(index_file);
+}
+
+// Write every listed branch's usernames into the empty log
+static void build_index(const char *root, const char *list_path) {
+    char names[BRANCH_MAX][BRANCH_NAME_SIZE];
+    int count = branches_list(list_path, names, BRANCH_MAX);
+    int conflicts = 0;
+
+    for (int b = 0; b < count; b++) {
+        Branch branch;
+        load_branch(&branch, root, names[b]);
+        int number = branch_number(names[b]);
+        for (int i = 0; i < branch.members.count; i++) {
+            if (!table_is_live(&branch.members, i)) {
+                continue;
+            }
+            const Member *member = member_at(&branch.members, i);
+            int e = find_entry(member->username, hash_username(member->username));
+            if (e >= 0 && entries[e].branch >= 0) {
+                conflicts++;  // The first branch keeps the name
+                continue;
+            }
+            set_entry(member->username, number, member->id_member);
+            fprintf(index_file, "+%s|%s|%d\n", member->username, names[b], member->id_member);
+        }
+        free_branch(&branch);
+    }
+    fflush(index_file);
+    indexed_end = ftell(index_file);
+
+    if (conflicts > 0) {
+        printf("Warning: %d username(s) are used in more than one branch; the first branch keeps each.\n",
+               conflicts);
+    }
+}
+
+int username_index_start(const char *path, const char *root, const char *list_path) {
+    if (index_file) {
+        username_index_stop();
+    }
+
+    index_file = fopen(path, "ab+");
+    if (!index_file) {
+        return -1;
+    }
+    indexed_end = 0;
+
+    lock_index();
+    fseek(index_file, 0, SEEK_END);
+    if (ftell(index_file) == 0) {
+        build_index(root, list_path);
+    } else {
+        catch_up();
+    }
+    unlock_index();
+
+    int live = 0;
+    for (int e = 0; e < entry_count; e++) {
+        live += entries[e].branch >= 0;
+    }
+    return live;
+}
+
+void username_index_stop() {
+    if (index_file) {
+        fclose(index_file);
+        index_file = NULL;
+    }
+    free(entries);
+    free(slots);
+    entries = NULL;
+    slots = NULL;
+    entry_count = entry_capacity = slot_capacity = 0;
+    branch_count = 0;
+}
+
+int username_index_lookup(const char *username, char *branch, int size, int *member_id) {
+    if (!index_file) {
+        return 0;
+    }
+    catch_up();
+
+    int e = find_entry(username, hash_username(username));
+    if (e < 0 || entries[e].branch < 0) {
+        return 0;
+    }
+    snprintf(branch, size, "%s", branch_names[entries[e].branch]);
+    *member_id = entries[e].member_id;
+    return 1;
+}
+
+int username_index_claim(const char *username, const char *branch, int member_id) {
+    if (!index_file) {
+        return 1;
+    }
+
+    lock_index();
+    catch_up();
+    int e = find_entry(username, hash_username(username));
+    int free_name = e < 0 || entries[e].branch < 0;
+    if (free_name) {
+        append_line(username, branch, member_id);
+        catch_up();
+    }
+    unlock_index();
+    return free_name;
+}
+
+void username_index_release(const char *username) {
+    if (!index_file) {
+        return;
+    }
+
+    lock_index();
+    catch_up();
+    int e = find_entry(username, hash_username(username));
+    if (e >= 0 && entries[e].branch >= 0) {
+        append_line(username, NULL, 0);
+        catch_up();
+    }
+    unlock_index();
+}
+
+// ---- Admin views ----
+
+typedef struct {
+    int members;
+    int subscribed;
+    int plans;
+    int equipment_units;
+} BranchTotals;
+
+static void count_branch(const Branch *branch, int index, void *arg) {
+    BranchTotals *totals = (BranchTotals *)arg + index;
+
+    totals->members = branch->members.live_count;
+    totals->plans = branch->plans.live_count;
+    for (int i = 0; i < branch->members.count; i++) {
+        if (table_is_live(&branch->members, i) &&
+            member_at(&branch->members, i)->id_current_plan != -1) {
+            totals->subscribed++;
+        }
+    }
+    for (int i = 0; i < branch->equipment.count; i++) {
+        if (table_is_live(&branch->equipment, i)) {
+            totals->equipment_units += equipment_at(&branch->equipment, i)->quantity;
+        }
+    }
+}
+
+void branches_display_report(const char *branch) {
+    char names[BRANCH_MAX][BRANCH_NAME_SIZE];
+    int count;
+
+    if (branch && branch[0] != '\0') {
+        count = branches_list(BRANCHES_FILE, names, BRANCH_MAX);
+        int found = 0;
+        for (int i = 0; i < count && !found; i++) {
+            found = strcmp(names[i], branch) == 0;
+        }
+        if (!found) {
+            printf("\nNo branch named '%s'.\n", branch);
+            return;
+        }
+        strcpy(names[0], branch);
+        count = 1;
+    } else {
+        count = branches_list(BRANCHES_FILE, names, BRANCH_MAX);
+    }
+    if (count == 0) {
+        printf("\nNo branches yet (start the app with --branch <name> to create one).\n");
+        return;
+    }
+
+    BranchTotals *totals = calloc(count, sizeof(BranchTotals));
+    if (!totals) {
+        printf("\nError: Not enough memory.\n");
+        return;
+    }
+    branches_for_each(BRANCHES_ROOT, (const char (*)[BRANCH_NAME_SIZE])names, count,
+                      online_cpu_count(BRANCH_MAX_THREADS), count_branch, totals);
+
+    BranchTotals sum = {0, 0, 0, 0};
+    printf("\n%-20s %10s %12s %6s %10s\n", "Branch", "Members", "Subscribed", "Plans", "Equipment");
+    for (int i = 0; i < count; i++) {
+        printf("%-20s %10d %12d %6d %10d\n", names[i], totals[i].members, totals[i].subscribed,
+               totals[i].plans, totals[i].equipment_units);
+        sum.members += totals[i].members;
+        sum.subscribed += totals[i].subscribed;
+        sum.plans += totals[i].plans;
+        sum.equipment_units += totals[i].equipment_units;
+    }
+    if (count > 1) {
+        printf("%-20s %10d %12d %6d %10d\n", "All branches", sum.members, sum.subscribed,
+               sum.plans, sum.equipment_units);
+    }
+    free(totals);
+}
+
+void branches_display_member(const char *username) {
+    char branch[BRANCH_NAME_SIZE];
+    int member_id;
+
+    if (!username_index_lookup(username, branch, sizeof(branch), &member_id)) {
+        printf("\nNo member named '%s' in any branch.\n", username);
+        return;
+    }
+
+    // Only the branch that has the member is read
+    Table members;
+    char path[256];
+    member_table_init(&members);
+    snprintf(path, sizeof(path), "%s/%s/members.txt", BRANCHES_ROOT, branch);
+    table_load(&members, path);
+
+    printf("\nBranch: %s\n", branch);
+    const Member *member = member_find(&members, member_id);
+    if (member) {
+        display_member_profile(member);
+    } else {
+        printf("Member ID %d (not saved to the branch's file yet).\n", member_id);
+    }
+    table_free(&members);
+}
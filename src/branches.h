@@ -0,0 +1,85 @@
+#ifndef BRANCHES_H
+#define BRANCHES_H
+
+#include "member.h"
+#include "plans.h"
+#include "equipment.h"
+#include "utils.h"
+
+// Each branch keeps its own data files in data/<branch>/ (the app runs on
+// one branch with --branch <name>). The branches are listed in
+// BRANCHES_FILE, one name per line.
+#define BRANCHES_ROOT "data"
+#define BRANCHES_FILE "data/branches.txt"
+
+// Most branches, and most threads loading them at once
+#define BRANCH_MAX 256
+#define BRANCH_MAX_THREADS 64
+
+// Usernames are unique across all branches. The username index is a log of
+// "+username|branch|member_id" and "-username" lines shared by every
+// branch, so a sign-up is checked without loading other branches' members.
+#define USERNAME_INDEX_FILE "data/usernames.log"
+
+// One branch with its tables loaded
+typedef struct {
+    char name[BRANCH_NAME_SIZE];
+    Table members;
+    Table plans;
+    Table equipment;
+} Branch;
+
+// Called from the worker thread that loaded the branch; index is the
+// branch's position in the list given to branches_for_each()
+typedef void (*BranchVisitor)(const Branch *branch, int index, void *arg);
+
+// Function declarations
+
+// 1 if name can be a branch: letters, digits, '-' and '_', at most 31 characters
+int branch_name_valid(const char *name);
+
+// Read the branch names listed in list_path (at most max). Returns how many.
+int branches_list(const char *list_path, char names[][BRANCH_NAME_SIZE], int max);
+
+// Returns 1 if name is one of the branches listed in list_path
+int branch_exists(const char *list_path, const char *name);
+
+// Create the folder root/<name>/ (with a copy of root/plans.txt if it has
+// no plans yet) and add name to the list if it is not there yet.
+// Returns 1 if the branch exists now, 0 if name is not valid or the list
+// cannot be written.
+int branch_create(const char *root, const char *list_path, const char *name);
+
+// Load the members, plans and equipment of each branch from root/<name>/,
+// up to threads branches at a time, and call visit for each one before its
+// tables are freed. Returns the number of branches visited.
+int branches_for_each(const char *root, const char names[][BRANCH_NAME_SIZE], int count,
+                      int threads, BranchVisitor visit, void *arg);
+
+// Open the username index. If the log does not exist yet it is built from
+// the members files of the branches in list_path (one branch in memory at
+// a time). Returns the number of usernames, -1 on error.
+int username_index_start(const char *path, const char *root, const char *list_path);
+
+// Close the username index
+void username_index_stop();
+
+// Find a username in any branch: copies the branch name and sets the
+// member ID. Returns 1 if found.
+int username_index_lookup(const char *username, char *branch, int size, int *member_id);
+
+// Take a username for a member of branch. Lines written by other running
+// copies are read first, under a file lock, so two branches cannot take
+// the same name. Returns 1 if taken, 0 if another member has it.
+// Without an open index every username is accepted.
+int username_index_claim(const char *username, const char *branch, int member_id);
+
+// Give a username back (its member was deleted)
+void username_index_release(const char *username);
+
+// Admin views: totals of one branch (or all when branch is empty), and
+// where a username is registered
+void branches_display_report(const char *branch);
+void branches_display_member(const char *username);
+
+#endif
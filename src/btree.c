@@ -0,0 +1,604 @@
+#define _POSIX_C_SOURCE 200809L  // fseeko
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "btree.h"
+
+#ifdef _WIN32
+#define file_seek _fseeki64
+#else
+#define file_seek fseeko
+#endif
+
+#define BTREE_MAGIC "GYMBTRE1"
+
+// Every node page starts with: is_leaf (u16), key count (u16), link (u32).
+// The link is the next leaf for a leaf, and the first child for an inner
+// page. Entries follow: key + value in leaves, key + child (u32) in inner
+// pages, where the child holds the keys >= its key.
+#define NODE_HEADER 8
+
+// Results of an insert into a subtree
+#define INSERT_ERROR    0
+#define INSERT_DONE     1
+#define INSERT_SPLIT    2
+
+// Page number of a cache frame holding no page
+#define NO_PAGE 0xffffffffu
+
+struct BTreeFrame {
+    unsigned page;             // page held by this frame
+    int pins;                  // >0 while a caller uses the page
+    int dirty;                 // 1 if it must be written back
+    int prev;                  // LRU list neighbours (-1 at the ends)
+    int next;
+    int hash_next;             // next frame in the same bucket (-1 = none)
+    unsigned char *data;
+};
+
+// ===== Page cache =====
+
+static unsigned bucket_of(const BTree *t, unsigned page) {
+    return (page * 2654435761u) & (unsigned)(t->bucket_count - 1);
+}
+
+static void lru_unlink(BTree *t, int f) {
+    BTreeFrame *frame = &t->frames[f];
+    if (frame->prev >= 0) {
+        t->frames[frame->prev].next = frame->next;
+    } else {
+        t->lru_head = frame->next;
+    }
+    if (frame->next >= 0) {
+        t->frames[frame->next].prev = frame->prev;
+    } else {
+        t->lru_tail = frame->prev;
+    }
+    frame->prev = frame->next = -1;
+}
+
+static void lru_push_front(BTree *t, int f) {
+    BTreeFrame *frame = &t->frames[f];
+    frame->prev = -1;
+    frame->next = t->lru_head;
+    if (t->lru_head >= 0) {
+        t->frames[t->lru_head].prev = f;
+    }
+    t->lru_head = f;
+    if (t->lru_tail < 0) {
+        t->lru_tail = f;
+    }
+}
+
+static void hash_remove(BTree *t, int f) {
+    int *bucket = &t->buckets[bucket_of(t, t->frames[f].page)];
+    if (*bucket == f + 1) {
+        *bucket = t->frames[f].hash_next + 1;
+        return;
+    }
+    int g = *bucket - 1;
+    while (t->frames[g].hash_next != f) {
+        g = t->frames[g].hash_next;
+    }
+    t->frames[g].hash_next = t->frames[f].hash_next;
+}
+
+static int write_page(BTree *t, unsigned page, const unsigned char *data) {
+    if (file_seek(t->file, (long long)page * BTREE_PAGE_SIZE, SEEK_SET) != 0 ||
+        fwrite(data, 1, BTREE_PAGE_SIZE, t->file) != BTREE_PAGE_SIZE) {
+        return 0;
+    }
+    t->page_writes++;
+    return 1;
+}
+
+static int read_page(BTree *t, unsigned page, unsigned char *data) {
+    if (file_seek(t->file, (long long)page * BTREE_PAGE_SIZE, SEEK_SET) != 0 ||
+        fread(data, 1, BTREE_PAGE_SIZE, t->file) != BTREE_PAGE_SIZE) {
+        return 0;
+    }
+    t->page_reads++;
+    return 1;
+}
+
+// Pin a page in the cache, reading it unless it is a new page (fresh),
+// which starts zeroed. Returns the frame, -1 on error.
+static int fetch(BTree *t, unsigned page, int fresh) {
+    for (int f = t->buckets[bucket_of(t, page)] - 1; f >= 0; f = t->frames[f].hash_next) {
+        if (t->frames[f].page == page) {
+            t->cache_hits++;
+            t->frames[f].pins++;
+            lru_unlink(t, f);
+            lru_push_front(t, f);
+            return f;
+        }
+    }
+
+    // Take a free frame, or evict the least recently used unpinned one
+    int f;
+    if (t->frames_used < t->frame_count) {
+        f = t->frames_used++;
+    } else {
+        for (f = t->lru_tail; f >= 0 && t->frames[f].pins > 0; f = t->frames[f].prev) {
+        }
+        if (f < 0) {
+            return -1;
+        }
+        BTreeFrame *victim = &t->frames[f];
+        if (victim->dirty && !write_page(t, victim->page, victim->data)) {
+            return -1;
+        }
+        hash_remove(t, f);
+        lru_unlink(t, f);
+    }
+
+    BTreeFrame *frame = &t->frames[f];
+    int ok = 1;
+    if (fresh) {
+        memset(frame->data, 0, BTREE_PAGE_SIZE);
+    } else if (!read_page(t, page, frame->data)) {
+        // Keep the frame, holding no page, for the next fetch
+        page = NO_PAGE;
+        ok = 0;
+    }
+    frame->page = page;
+    frame->pins = ok;
+    frame->dirty = fresh;
+    int *bucket = &t->buckets[bucket_of(t, page)];
+    frame->hash_next = *bucket - 1;
+    *bucket = f + 1;
+    lru_push_front(t, f);
+    return ok ? f : -1;
+}
+
+static void unpin(BTree *t, int f) {
+    t->frames[f].pins--;
+}
+
+static unsigned char *frame_data(BTree *t, int f) {
+    return t->frames[f].data;
+}
+
+static void mark_dirty(BTree *t, int f) {
+    t->frames[f].dirty = 1;
+}
+
+// ===== Node layout =====
+
+static unsigned read_u32(const unsigned char *p) {
+    unsigned v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static void write_u32(unsigned char *p, unsigned v) {
+    memcpy(p, &v, sizeof(v));
+}
+
+static int node_is_leaf(const unsigned char *node) {
+    return node[0];
+}
+
+static int node_count(const unsigned char *node) {
+    return node[2] | node[3] << 8;
+}
+
+static void set_node_count(unsigned char *node, int count) {
+    node[2] = (unsigned char)(count & 0xff);
+    node[3] = (unsigned char)(count >> 8);
+}
+
+static unsigned node_link(const unsigned char *node) {
+    return read_u32(node + 4);
+}
+
+static size_t entry_size(const BTree *t, const unsigned char *node) {
+    return (size_t)t->key_size + (node_is_leaf(node) ? (size_t)t->value_size : sizeof(unsigned));
+}
+
+static unsigned char *entry(const BTree *t, unsigned char *node, int i) {
+    return node + NODE_HEADER + (size_t)i * entry_size(t, node);
+}
+
+static unsigned inner_child(const BTree *t, unsigned char *node, int i) {
+    // Child to the left of key i (i = 0 is the link)
+    return i == 0 ? node_link(node) : read_u32(entry(t, node, i - 1) + t->key_size);
+}
+
+static int compare_keys(const BTree *t, const unsigned char *a, const unsigned char *b) {
+    if (t->key_type == BTREE_KEY_INT) {
+        int x, y;
+        memcpy(&x, a, sizeof(int));
+        memcpy(&y, b, sizeof(int));
+        return (x > y) - (x < y);
+    }
+    return strncmp((const char *)a, (const char *)b, t->key_size);
+}
+
+// First entry with a key >= key
+static int lower_bound(const BTree *t, unsigned char *node, const unsigned char *key) {
+    int low = 0, high = node_count(node);
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (compare_keys(t, entry(t, node, mid), key) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// Number of separator keys <= key, i.e. which child to follow
+static int child_index(const BTree *t, unsigned char *node, const unsigned char *key) {
+    int low = 0, high = node_count(node);
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (compare_keys(t, entry(t, node, mid), key) <= 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+static void make_key(const BTree *t, const void *key, unsigned char *out) {
+    memset(out, 0, t->key_size);
+    if (t->key_type == BTREE_KEY_INT) {
+        memcpy(out, key, sizeof(int));
+    } else {
+        size_t length = strlen((const char *)key);
+        memcpy(out, key, length < (size_t)t->key_size ? length : (size_t)t->key_size - 1);
+    }
+}
+
+// ===== Header =====
+
+static void write_header(BTree *t, unsigned char *page) {
+    memset(page, 0, BTREE_PAGE_SIZE);
+    memcpy(page, BTREE_MAGIC, 8);
+    unsigned fields[7] = { (unsigned)t->key_type, (unsigned)t->key_size, (unsigned)t->value_size,
+                           t->root, t->page_count, (unsigned)t->height, 0 };
+    memcpy(page + 8, fields, sizeof(fields));
+    memcpy(page + 8 + sizeof(fields), &t->count, sizeof(t->count));
+}
+
+static int read_header(BTree *t, const unsigned char *page) {
+    unsigned fields[7];
+    memcpy(fields, page + 8, sizeof(fields));
+    if (memcmp(page, BTREE_MAGIC, 8) != 0 || fields[0] != (unsigned)t->key_type ||
+        fields[1] != (unsigned)t->key_size || fields[2] != (unsigned)t->value_size) {
+        return 0;
+    }
+    t->root = fields[3];
+    t->page_count = fields[4];
+    t->height = (int)fields[5];
+    memcpy(&t->count, page + 8 + sizeof(fields), sizeof(t->count));
+    return t->root > 0 && t->root < t->page_count && t->height > 0;
+}
+
+// ===== Open / close =====
+
+int btree_open(BTree *t, const char *path, int key_type, int key_size, int value_size, int cache_pages) {
+    memset(t, 0, sizeof(BTree));
+    if (key_size < (int)sizeof(int) || key_size > BTREE_MAX_KEY || value_size < 1 ||
+        value_size > BTREE_MAX_VALUE) {
+        return 0;
+    }
+    t->key_type = key_type;
+    t->key_size = key_size;
+    t->value_size = value_size;
+    t->leaf_capacity = (BTREE_PAGE_SIZE - NODE_HEADER) / (key_size + value_size);
+    t->inner_capacity = (BTREE_PAGE_SIZE - NODE_HEADER) / (key_size + (int)sizeof(unsigned));
+
+    t->frame_count = cache_pages < BTREE_MIN_CACHE_PAGES ? BTREE_MIN_CACHE_PAGES : cache_pages;
+    t->bucket_count = 1;
+    while (t->bucket_count < t->frame_count * 2) {
+        t->bucket_count *= 2;
+    }
+    t->frames = calloc(t->frame_count, sizeof(BTreeFrame));
+    t->buckets = calloc(t->bucket_count, sizeof(int));
+    unsigned char *pool = malloc((size_t)(t->frame_count + 2) * BTREE_PAGE_SIZE);
+    if (!t->frames || !t->buckets || !pool) {
+        free(t->frames);
+        free(t->buckets);
+        free(pool);
+        memset(t, 0, sizeof(BTree));
+        return 0;
+    }
+    for (int f = 0; f < t->frame_count; f++) {
+        t->frames[f].data = pool + (size_t)f * BTREE_PAGE_SIZE;
+        t->frames[f].prev = t->frames[f].next = t->frames[f].hash_next = -1;
+    }
+    t->scratch = pool + (size_t)t->frame_count * BTREE_PAGE_SIZE;
+    t->lru_head = t->lru_tail = -1;
+
+    unsigned char *header = t->scratch;
+    t->file = fopen(path, "r+b");
+    if (t->file) {
+        if (fread(header, 1, BTREE_PAGE_SIZE, t->file) != BTREE_PAGE_SIZE || !read_header(t, header)) {
+            btree_close(t);
+            return 0;
+        }
+        return 1;
+    }
+
+    // New tree: the header and an empty root leaf
+    t->file = fopen(path, "w+b");
+    if (!t->file) {
+        btree_close(t);
+        return 0;
+    }
+    t->root = 1;
+    t->page_count = 2;
+    t->height = 1;
+    t->header_dirty = 1;
+    int f = fetch(t, t->root, 1);
+    frame_data(t, f)[0] = 1;
+    unpin(t, f);
+    return btree_flush(t);
+}
+
+int btree_flush(BTree *t) {
+    int ok = 1;
+    for (int f = 0; f < t->frames_used; f++) {
+        BTreeFrame *frame = &t->frames[f];
+        if (frame->dirty) {
+            if (write_page(t, frame->page, frame->data)) {
+                frame->dirty = 0;
+            } else {
+                ok = 0;
+            }
+        }
+    }
+    if (t->header_dirty) {
+        write_header(t, t->scratch);
+        if (write_page(t, 0, t->scratch)) {
+            t->header_dirty = 0;
+        } else {
+            ok = 0;
+        }
+    }
+    return fflush(t->file) == 0 && ok;
+}
+
+void btree_close(BTree *t) {
+    if (t->file) {
+        btree_flush(t);
+        fclose(t->file);
+    }
+    if (t->frames) {
+        free(t->frames[0].data);  // start of the page pool
+    }
+    free(t->frames);
+    free(t->buckets);
+    memset(t, 0, sizeof(BTree));
+}
+
+// ===== Lookup =====
+
+// Pinned frame of the leaf that would hold key, -1 on a read error
+static int find_leaf(BTree *t, const unsigned char *key) {
+    unsigned page = t->root;
+    while (1) {
+        int f = fetch(t, page, 0);
+        if (f < 0) {
+            return -1;
+        }
+        unsigned char *node = frame_data(t, f);
+        if (node_is_leaf(node)) {
+            return f;
+        }
+        page = inner_child(t, node, child_index(t, node, key));
+        unpin(t, f);
+    }
+}
+
+int btree_find(BTree *t, const void *key, void *value) {
+    unsigned char wanted[BTREE_MAX_KEY];
+    make_key(t, key, wanted);
+
+    int f = find_leaf(t, wanted);
+    if (f < 0) {
+        return 0;
+    }
+    unsigned char *leaf = frame_data(t, f);
+    int i = lower_bound(t, leaf, wanted);
+    int found = i < node_count(leaf) && compare_keys(t, entry(t, leaf, i), wanted) == 0;
+    if (found && value) {
+        memcpy(value, entry(t, leaf, i) + t->key_size, t->value_size);
+    }
+    unpin(t, f);
+    return found;
+}
+
+// ===== Insert =====
+
+// Put an entry of size bytes at position i of an array of count entries
+// that has room for one more
+static void insert_entry(unsigned char *entries, int count, int i, const unsigned char *entry_data,
+                         size_t size) {
+    unsigned char *at = entries + (size_t)i * size;
+    memmove(at + size, at, (size_t)(count - i) * size);
+    memcpy(at, entry_data, size);
+}
+
+// Split the full node in frame f after inserting the entry at position i.
+// The new right page is filled and *split_key gets the key that separates
+// it, *split_page its page number. rightmost is 1 for the last page of
+// its level.
+static int split_node(BTree *t, int f, int i, const unsigned char *entry_data, int rightmost,
+                      unsigned char *split_key, unsigned *split_page) {
+    unsigned char *node = frame_data(t, f);
+    int leaf = node_is_leaf(node);
+    int count = node_count(node);
+    size_t size = entry_size(t, node);
+
+    // All count + 1 entries in order
+    unsigned char *all = t->scratch;
+    memcpy(all, node + NODE_HEADER, (size_t)count * size);
+    insert_entry(all, count, i, entry_data, size);
+
+    // Keys arriving in increasing order (new member IDs) fill pages
+    // completely instead of leaving every page half empty
+    int left = rightmost && i == count ? count : (count + 1) / 2;
+
+    unsigned page = t->page_count;
+    int r = fetch(t, page, 1);
+    if (r < 0) {
+        return 0;
+    }
+    t->page_count++;
+    t->header_dirty = 1;
+    unsigned char *right = frame_data(t, r);
+
+    right[0] = (unsigned char)leaf;
+    if (leaf) {
+        // Leaves keep every entry; the right page's first key separates them
+        int moved = count + 1 - left;
+        memcpy(right + NODE_HEADER, all + (size_t)left * size, (size_t)moved * size);
+        set_node_count(right, moved);
+        write_u32(right + 4, node_link(node));
+        write_u32(node + 4, page);
+        memcpy(split_key, right + NODE_HEADER, t->key_size);
+    } else {
+        // Inner pages pass the middle key up; its child becomes the link
+        const unsigned char *middle = all + (size_t)left * size;
+        int moved = count - left;
+        memcpy(split_key, middle, t->key_size);
+        write_u32(right + 4, read_u32(middle + t->key_size));
+        memcpy(right + NODE_HEADER, middle + size, (size_t)moved * size);
+        set_node_count(right, moved);
+    }
+    memcpy(node + NODE_HEADER, all, (size_t)left * size);
+    set_node_count(node, left);
+
+    *split_page = page;
+    mark_dirty(t, f);
+    unpin(t, r);
+    return 1;
+}
+
+static int insert(BTree *t, unsigned page, int rightmost, const unsigned char *key, const void *value,
+                  int *added, unsigned char *split_key, unsigned *split_page) {
+    int f = fetch(t, page, 0);
+    if (f < 0) {
+        return INSERT_ERROR;
+    }
+    unsigned char *node = frame_data(t, f);
+    int count = node_count(node);
+    unsigned char new_entry[BTREE_MAX_KEY + BTREE_MAX_VALUE];
+    int i, result = INSERT_DONE;
+
+    if (node_is_leaf(node)) {
+        i = lower_bound(t, node, key);
+        if (i < count && compare_keys(t, entry(t, node, i), key) == 0) {
+            // Replace the value
+            memcpy(entry(t, node, i) + t->key_size, value, t->value_size);
+            mark_dirty(t, f);
+            unpin(t, f);
+            return INSERT_DONE;
+        }
+        *added = 1;
+        memcpy(new_entry, key, t->key_size);
+        memcpy(new_entry + t->key_size, value, t->value_size);
+        if (count < t->leaf_capacity) {
+            insert_entry(node + NODE_HEADER, count, i, new_entry, entry_size(t, node));
+            set_node_count(node, count + 1);
+            mark_dirty(t, f);
+        } else if (split_node(t, f, i, new_entry, rightmost, split_key, split_page)) {
+            result = INSERT_SPLIT;
+        } else {
+            result = INSERT_ERROR;
+        }
+        unpin(t, f);
+        return result;
+    }
+
+    // Inner page: insert below, then add the child's new sibling here
+    i = child_index(t, node, key);
+    unsigned char child_key[BTREE_MAX_KEY];
+    unsigned child_page;
+    int below = insert(t, inner_child(t, node, i), rightmost && i == count, key, value, added, child_key,
+                       &child_page);
+    if (below != INSERT_SPLIT) {
+        unpin(t, f);
+        return below;
+    }
+    memcpy(new_entry, child_key, t->key_size);
+    write_u32(new_entry + t->key_size, child_page);
+    if (count < t->inner_capacity) {
+        insert_entry(node + NODE_HEADER, count, i, new_entry, entry_size(t, node));
+        set_node_count(node, count + 1);
+        mark_dirty(t, f);
+    } else if (split_node(t, f, i, new_entry, rightmost, split_key, split_page)) {
+        result = INSERT_SPLIT;
+    } else {
+        result = INSERT_ERROR;
+    }
+    unpin(t, f);
+    return result;
+}
+
+int btree_put(BTree *t, const void *key, const void *value) {
+    unsigned char wanted[BTREE_MAX_KEY];
+    make_key(t, key, wanted);
+
+    unsigned char split_key[BTREE_MAX_KEY];
+    unsigned split_page;
+    int added = 0;
+    int result = insert(t, t->root, 1, wanted, value, &added, split_key, &split_page);
+    if (result == INSERT_ERROR) {
+        return 0;
+    }
+    if (added) {
+        t->count++;
+        t->header_dirty = 1;
+    }
+    if (result == INSERT_SPLIT) {
+        // The root split: a new root above the two halves
+        int f = fetch(t, t->page_count, 1);
+        if (f < 0) {
+            return 0;
+        }
+        unsigned char *root = frame_data(t, f);
+        write_u32(root + 4, t->root);
+        memcpy(root + NODE_HEADER, split_key, t->key_size);
+        write_u32(root + NODE_HEADER + t->key_size, split_page);
+        set_node_count(root, 1);
+        unpin(t, f);
+        t->root = t->page_count++;
+        t->height++;
+        t->header_dirty = 1;
+    }
+    return 1;
+}
+
+// ===== Delete =====
+
+int btree_delete(BTree *t, const void *key) {
+    unsigned char wanted[BTREE_MAX_KEY];
+    make_key(t, key, wanted);
+
+    int f = find_leaf(t, wanted);
+    if (f < 0) {
+        return 0;
+    }
+    unsigned char *leaf = frame_data(t, f);
+    int count = node_count(leaf);
+    int i = lower_bound(t, leaf, wanted);
+    int found = i < count && compare_keys(t, entry(t, leaf, i), wanted) == 0;
+    if (found) {
+        size_t size = entry_size(t, leaf);
+        unsigned char *at = entry(t, leaf, i);
+        memmove(at, at + size, (size_t)(count - i - 1) * size);
+        set_node_count(leaf, count - 1);
+        mark_dirty(t, f);
+        t->count--;
+        t->header_dirty = 1;
+    }
+    unpin(t, f);
+    return found;
+}
@@ -0,0 +1,83 @@
+#ifndef BTREE_H
+#define BTREE_H
+
+#include <stdio.h>
+
+// Disk-resident B+tree: fixed-size keys and values stored in pages of a
+// file, with only a bounded number of pages in memory at a time (an LRU
+// page cache). Leaves hold the values and are linked left to right; inner
+// pages hold separator keys and child page numbers.
+
+#define BTREE_PAGE_SIZE 4096
+
+// Key types: an int, or text of at most key_size - 1 characters
+#define BTREE_KEY_INT  0
+#define BTREE_KEY_TEXT 1
+
+// Longest key and value (a value must fit a page a few times)
+#define BTREE_MAX_KEY   64
+#define BTREE_MAX_VALUE 1024
+
+// Pages cached by default, and the fewest a tree accepts (an insert keeps
+// one page per level in memory)
+#define BTREE_DEFAULT_CACHE_PAGES 256
+#define BTREE_MIN_CACHE_PAGES     16
+
+typedef struct BTreeFrame BTreeFrame;
+
+typedef struct {
+    FILE *file;
+    int key_type;
+    int key_size;
+    int value_size;
+    int leaf_capacity;        // entries per leaf page
+    int inner_capacity;       // separator keys per inner page
+    unsigned root;            // page number of the root
+    unsigned page_count;      // pages in the file (page 0 is the header)
+    int height;               // 1 = the root is a leaf
+    long long count;          // keys stored
+    int header_dirty;
+
+    // Page cache
+    BTreeFrame *frames;
+    int frame_count;
+    int frames_used;
+    int *buckets;             // hash of page number -> frame + 1 (chained)
+    int bucket_count;         // power of two
+    int lru_head;             // most recently used frame (-1 if none)
+    int lru_tail;             // least recently used frame
+    unsigned char *scratch;   // room for an overfull page while splitting
+
+    // Statistics
+    long long page_reads;     // pages read from the file
+    long long page_writes;    // pages written to the file
+    long long cache_hits;     // pages found in the cache
+} BTree;
+
+// Function declarations
+
+// Open the tree stored in path, or create it. An existing file must have
+// been created with the same key type and sizes. cache_pages is the most
+// pages kept in memory (raised to BTREE_MIN_CACHE_PAGES).
+// Returns 1 if successful, 0 if the file cannot be used.
+int btree_open(BTree *t, const char *path, int key_type, int key_size, int value_size, int cache_pages);
+
+// Write every changed page and close the file
+void btree_close(BTree *t);
+
+// Write every changed page (returns 1 if successful, 0 on a write error)
+int btree_flush(BTree *t);
+
+// Copy the value stored under key into value. Returns 1 if found.
+// key points to an int (BTREE_KEY_INT) or is a string (BTREE_KEY_TEXT).
+int btree_find(BTree *t, const void *key, void *value);
+
+// Store value under key, replacing any value it had.
+// Returns 1 if successful, 0 on a read or write error.
+int btree_put(BTree *t, const void *key, const void *value);
+
+// Remove key (returns 1 if it was there). Pages are not merged: the space
+// is reused by later keys that fall in the same leaf.
+int btree_delete(BTree *t, const void *key);
+
+#endif
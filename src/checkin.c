@@ -0,0 +1,327 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime, nanosleep
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "checkin.h"
+#include "event_ring.h"
+#include "access.h"
+#include "shared_tables.h"
+#include "subscriptions.h"
+#include "utils.h"
+
+#define PAGE_SIZE (1 << CHECKIN_PAGE_BITS)
+#define PAGE_MASK (PAGE_SIZE - 1)
+
+// Events written to the log in one go
+#define WRITE_BATCH 256
+
+static EventRing ring;
+static pthread_t writer_thread;
+static FILE *log_file = NULL;
+static char log_path[256] = CHECKINS_FILE;
+static atomic_int running = 0;
+static atomic_int stopping = 0;
+
+// Threads between their running check and the end of their push: the ring
+// is only freed once there are none
+static atomic_int producers = 0;
+
+static atomic_int occupancy = 0;
+
+// inside[id] = 1 while the member is in the gym, in lazily allocated pages
+static _Atomic(atomic_uchar *) pages[CHECKIN_MAX_PAGES];
+
+static long long now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+static atomic_uchar *inside_flag(int member_id, int create) {
+    int page = member_id >> CHECKIN_PAGE_BITS;
+    if (member_id < 0 || page >= CHECKIN_MAX_PAGES) {
+        return NULL;
+    }
+
+    atomic_uchar *flags = atomic_load(&pages[page]);
+    if (!flags && create) {
+        // Two threads may race to create the page: the loser frees its copy
+        atomic_uchar *fresh = calloc(PAGE_SIZE, sizeof(atomic_uchar));
+        if (!fresh) {
+            return NULL;
+        }
+        atomic_uchar *expected = NULL;
+        if (atomic_compare_exchange_strong(&pages[page], &expected, fresh)) {
+            flags = fresh;
+        } else {
+            free(fresh);
+            flags = expected;
+        }
+    }
+    return flags ? &flags[member_id & PAGE_MASK] : NULL;
+}
+
+// Apply an accepted event to the inside flags and the occupancy
+static int enter(int member_id) {
+    atomic_uchar *flag = inside_flag(member_id, 1);
+    if (!flag || atomic_exchange(flag, 1) == 1) {
+        return CHECKIN_ALREADY_INSIDE;
+    }
+    atomic_fetch_add(&occupancy, 1);
+    return CHECKIN_OK;
+}
+
+static int leave(int member_id) {
+    atomic_uchar *flag = inside_flag(member_id, 0);
+    if (!flag || atomic_exchange(flag, 0) == 0) {
+        return CHECKIN_NOT_INSIDE;
+    }
+    atomic_fetch_sub(&occupancy, 1);
+    return CHECKIN_OK;
+}
+
+static void log_event(int member_id, int type, int result) {
+    atomic_fetch_add(&producers, 1);
+    if (!atomic_load(&running)) {
+        atomic_fetch_sub(&producers, 1);
+        return;
+    }
+
+    CheckinRecord record;
+    memset(&record, 0, sizeof(record));
+    record.time_ms = now_ms();
+    record.member_id = member_id;
+    record.type = (unsigned char)type;
+    record.result = (unsigned char)result;
+
+    // Only waits if the writer is CHECKIN_RING_SIZE events behind
+    while (!event_ring_push(&ring, &record)) {
+        sched_yield();
+    }
+    atomic_fetch_sub(&producers, 1);
+}
+
+static void *writer_main(void *arg) {
+    (void)arg;
+    CheckinRecord batch[WRITE_BATCH];
+
+    while (1) {
+        int count = 0;
+        while (count < WRITE_BATCH && event_ring_pop(&ring, &batch[count])) {
+            count++;
+        }
+
+        if (count > 0) {
+            fwrite(batch, sizeof(CheckinRecord), count, log_file);
+        }
+        if (count == WRITE_BATCH) {
+            continue;  // More is waiting
+        }
+
+        fflush(log_file);
+        if (count == 0) {
+            if (atomic_load(&stopping)) {
+                break;
+            }
+            // Idle: check again in a millisecond
+            struct timespec pause = { 0, 1000000 };
+            nanosleep(&pause, NULL);
+        }
+    }
+    return NULL;
+}
+
+static long long start_of_today_ms() {
+    time_t now = time(NULL);
+    struct tm *date = localtime(&now);
+    if (!date) {
+        return 0;
+    }
+    struct tm midnight = *date;
+    midnight.tm_hour = 0;
+    midnight.tm_min = 0;
+    midnight.tm_sec = 0;
+    return (long long)mktime(&midnight) * 1000;
+}
+
+static void replay_today() {
+    FILE *f = fopen(log_path, "rb");
+    if (!f) {
+        return;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long count = ftell(f) / (long)sizeof(CheckinRecord);
+    long long since = start_of_today_ms();
+
+    // Records are in time order: binary search the first one of today
+    long low = 0, high = count;
+    CheckinRecord record;
+    while (low < high) {
+        long middle = low + (high - low) / 2;
+        fseek(f, middle * (long)sizeof(CheckinRecord), SEEK_SET);
+        if (fread(&record, sizeof(record), 1, f) != 1) {
+            break;
+        }
+        if (record.time_ms < since) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    fseek(f, low * (long)sizeof(CheckinRecord), SEEK_SET);
+    while (fread(&record, sizeof(record), 1, f) == 1) {
+        if (record.result != CHECKIN_OK) {
+            continue;
+        }
+        if (record.type == CHECKIN_IN) {
+            enter(record.member_id);
+        } else if (record.type == CHECKIN_OUT) {
+            leave(record.member_id);
+        }
+    }
+
+    fclose(f);
+}
+
+int checkin_start() {
+    if (atomic_load(&running)) {
+        return 1;
+    }
+
+    data_file_path(CHECKINS_FILE, log_path, sizeof(log_path));
+    replay_today();
+
+    log_file = fopen(log_path, "ab");
+    if (!log_file) {
+        printf("Warning: Cannot open %s, check-ins will not be logged.\n", log_path);
+        return 0;
+    }
+    if (!event_ring_init(&ring, CHECKIN_RING_SIZE, sizeof(CheckinRecord))) {
+        fclose(log_file);
+        log_file = NULL;
+        return 0;
+    }
+
+    atomic_store(&stopping, 0);
+    if (pthread_create(&writer_thread, NULL, writer_main, NULL) != 0) {
+        event_ring_free(&ring);
+        fclose(log_file);
+        log_file = NULL;
+        printf("Warning: Check-in log writer unavailable, check-ins will not be logged.\n");
+        return 0;
+    }
+
+    atomic_store(&running, 1);
+    return 1;
+}
+
+void checkin_stop() {
+    if (!atomic_load(&running)) {
+        return;
+    }
+
+    // No new events; the ones already being pushed still reach the writer
+    atomic_store(&running, 0);
+    while (atomic_load(&producers) > 0) {
+        sched_yield();
+    }
+    atomic_store(&stopping, 1);
+    pthread_join(writer_thread, NULL);
+
+    fclose(log_file);
+    log_file = NULL;
+    event_ring_free(&ring);
+}
+
+int checkin_badge_in(int member_id) {
+    int result = CHECKIN_OK;
+    unsigned char status = access_status(member_id);
+
+    if (!(status & ACCESS_MEMBER)) {
+        result = CHECKIN_UNKNOWN_MEMBER;
+    } else if (!access_allows(status, PLAN_AREAS_ALL)) {
+        // The entrance lets in any member whose plan grants some area
+        result = CHECKIN_NO_SUBSCRIPTION;
+    } else {
+        result = enter(member_id);
+    }
+
+    log_event(member_id, CHECKIN_IN, result);
+    return result;
+}
+
+int checkin_badge_out(int member_id) {
+    // Leaving is always allowed, even if the subscription ended meanwhile
+    int result = leave(member_id);
+    log_event(member_id, CHECKIN_OUT, result);
+    return result;
+}
+
+int checkin_badge(int member_id, int *type) {
+    if (checkin_is_inside(member_id)) {
+        *type = CHECKIN_OUT;
+        return checkin_badge_out(member_id);
+    }
+    *type = CHECKIN_IN;
+    return checkin_badge_in(member_id);
+}
+
+int checkin_occupancy() {
+    return atomic_load(&occupancy);
+}
+
+int checkin_is_inside(int member_id) {
+    atomic_uchar *flag = inside_flag(member_id, 0);
+    return flag && atomic_load(flag);
+}
+
+const char *checkin_result_text(int result) {
+    switch (result) {
+        case CHECKIN_OK:              return "OK";
+        case CHECKIN_UNKNOWN_MEMBER:  return "Unknown member ID";
+        case CHECKIN_NO_SUBSCRIPTION: return "No active subscription";
+        case CHECKIN_ALREADY_INSIDE:  return "Already checked in";
+        case CHECKIN_NOT_INSIDE:      return "Not checked in";
+        default:                      return "Unknown result";
+    }
+}
+
+void checkin_turnstile(Table *members) {
+    print_header("TURNSTILE");
+    printf("Badge a member ID to check in or out.\n");
+
+    while (1) {
+        printf("\nMember ID (0 to stop): ");
+        int member_id = get_int_input();
+        if (member_id == 0) {
+            break;
+        }
+
+        // Pick up subscriptions that ended or changed in the meantime
+        shared_tables_refresh();
+        subscriptions_expire_due(members);
+        access_sync(members);
+
+        int type;
+        int result = checkin_badge(member_id, &type);
+        if (result != CHECKIN_OK) {
+            printf("[REFUSED] %s\n", checkin_result_text(result));
+            continue;
+        }
+
+        const Member *member = member_find(members, member_id);
+        if (type == CHECKIN_IN) {
+            printf("[IN] Welcome, %s!", member ? member->name : "member");
+        } else {
+            printf("[OUT] Goodbye, %s!", member ? member->name : "member");
+        }
+        printf(" (%d in the gym)\n", checkin_occupancy());
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef CHECKIN_H
+#define CHECKIN_H
+
+#include "member.h"
+
+#define CHECKINS_FILE "data/checkins.log"
+
+// Events waiting for the log writer; badging only blocks if it is full
+#define CHECKIN_RING_SIZE 65536
+
+// Members are tracked in pages of 4096 IDs, allocated on first use
+#define CHECKIN_PAGE_BITS 12
+#define CHECKIN_MAX_PAGES 16384
+
+// Event types
+#define CHECKIN_IN  1
+#define CHECKIN_OUT 2
+
+// Results of a badge
+#define CHECKIN_OK              0
+#define CHECKIN_UNKNOWN_MEMBER  1
+#define CHECKIN_NO_SUBSCRIPTION 2
+#define CHECKIN_ALREADY_INSIDE  3
+#define CHECKIN_NOT_INSIDE      4
+
+// One record of the binary log (16 bytes, appended in time order)
+typedef struct {
+    long long time_ms;        // milliseconds since 1970
+    int member_id;
+    unsigned char type;       // CHECKIN_IN or CHECKIN_OUT
+    unsigned char result;     // CHECKIN_OK or why it was refused
+    unsigned short reserved;
+} CheckinRecord;
+
+// Function declarations
+
+// Restore who is inside from today's part of the log and start the
+// log writer thread (returns 1 if successful, 0 if the log cannot be opened)
+int checkin_start();
+
+// Write every pending event and stop the log writer. Events recorded by
+// other threads meanwhile are either written or ignored; the queue is only
+// freed once no thread is adding to it.
+void checkin_stop();
+
+// Badge a member in or out. Validation reads the member's access status
+// (see access.h, kept up to date by access_sync()), the occupancy update is
+// lock-free and the event is queued for the log writer, so any number of
+// threads may badge at the same time.
+// Returns CHECKIN_OK or the reason the badge was refused.
+int checkin_badge_in(int member_id);
+int checkin_badge_out(int member_id);
+
+// Turnstile: badge out if the member is inside, in otherwise.
+// *type receives CHECKIN_IN or CHECKIN_OUT.
+int checkin_badge(int member_id, int *type);
+
+// Members inside the gym right now
+int checkin_occupancy();
+
+// Returns 1 if the member is inside
+int checkin_is_inside(int member_id);
+
+// Message for a badge result
+const char *checkin_result_text(int result);
+
+// Turnstile screen: badge members by ID until 0 is entered
+void checkin_turnstile(Table *members);
+
+#endif
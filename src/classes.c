@@ -0,0 +1,677 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <time.h>
+#include "classes.h"
+#include "plans.h"
+#include "plan_catalog.h"
+#include "autosave.h"
+#include "shared_tables.h"
+#include "audit.h"
+#include "utils.h"
+
+// Index entry of one class: seats taken and its waitlist, a FIFO of booking
+// IDs. Cancelled waiting bookings stay in the queue and are skipped when
+// the queue is served, so cancelling never searches it.
+typedef struct {
+    int id_class;
+    int booked;
+    int waiting;
+    int *queue;
+    int queue_head;
+    int queue_count;         // entries from queue_head on, including skipped ones
+    int queue_capacity;
+} ClassState;
+
+// Index entry of one member: the slots their bookings take, and the IDs of
+// those bookings (a member has only a few)
+typedef struct {
+    int id_member;
+    WeekSlots slots;
+    int *bookings;
+    int booking_count;
+    int booking_capacity;
+} MemberSlots;
+
+static const char *weekday_names[] = { "Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun" };
+
+// Text format of one class and one booking, generated from their fields
+SCHEMA_CODEC(gym_class, GymClass, CLASS_FIELDS, "class")
+SCHEMA_CODEC(booking, Booking, BOOKING_FIELDS, "booking")
+
+void class_week_slots(const GymClass *gym_class, WeekSlots *slots) {
+    memset(slots, 0, sizeof(WeekSlots));
+    int first = gym_class->weekday * CLASS_SLOTS_PER_DAY + gym_class->start_slot;
+    for (int slot = first; slot < first + gym_class->slot_count; slot++) {
+        slots->bits[slot / 64] |= 1ull << (slot % 64);
+    }
+}
+
+static int slots_overlap(const WeekSlots *a, const WeekSlots *b) {
+    uint64_t common = 0;
+    for (int i = 0; i < CLASS_SLOT_WORDS; i++) {
+        common |= a->bits[i] & b->bits[i];
+    }
+    return common != 0;
+}
+
+static ClassState *state_of(ClassSchedule *s, int class_id) {
+    return table_find(&s->class_states, class_id);
+}
+
+static MemberSlots *member_of(ClassSchedule *s, int member_id, int create) {
+    MemberSlots *entry = table_find(&s->member_slots, member_id);
+    if (!entry && create) {
+        MemberSlots fresh;
+        memset(&fresh, 0, sizeof(fresh));
+        fresh.id_member = member_id;
+        entry = table_append(&s->member_slots, &fresh);
+    }
+    return entry;
+}
+
+static void free_indexes(ClassSchedule *s) {
+    for (int i = 0; i < s->class_states.count; i++) {
+        free(((ClassState *)table_at(&s->class_states, i))->queue);
+    }
+    for (int i = 0; i < s->member_slots.count; i++) {
+        free(((MemberSlots *)table_at(&s->member_slots, i))->bookings);
+    }
+    table_clear(&s->class_states);
+    table_clear(&s->member_slots);
+}
+
+static int queue_push(ClassState *state, int booking_id) {
+    if (state->queue_head + state->queue_count == state->queue_capacity) {
+        if (state->queue_head > 0) {
+            // Reuse the room left by served entries
+            memmove(state->queue, state->queue + state->queue_head,
+                    sizeof(int) * state->queue_count);
+            state->queue_head = 0;
+        } else {
+            int capacity = state->queue_capacity > 0 ? state->queue_capacity * 2 : 8;
+            int *queue = realloc(state->queue, sizeof(int) * capacity);
+            if (!queue) {
+                return 0;
+            }
+            state->queue = queue;
+            state->queue_capacity = capacity;
+        }
+    }
+    state->queue[state->queue_head + state->queue_count++] = booking_id;
+    return 1;
+}
+
+static int member_add_booking(MemberSlots *entry, int booking_id, const WeekSlots *slots) {
+    if (entry->booking_count == entry->booking_capacity) {
+        int capacity = entry->booking_capacity > 0 ? entry->booking_capacity * 2 : 4;
+        int *bookings = realloc(entry->bookings, sizeof(int) * capacity);
+        if (!bookings) {
+            return 0;
+        }
+        entry->bookings = bookings;
+        entry->booking_capacity = capacity;
+    }
+    entry->bookings[entry->booking_count++] = booking_id;
+    for (int i = 0; i < CLASS_SLOT_WORDS; i++) {
+        entry->slots.bits[i] |= slots->bits[i];
+    }
+    return 1;
+}
+
+static void member_remove_booking(MemberSlots *entry, int booking_id, const WeekSlots *slots) {
+    for (int i = 0; i < entry->booking_count; i++) {
+        if (entry->bookings[i] == booking_id) {
+            entry->bookings[i] = entry->bookings[--entry->booking_count];
+            break;
+        }
+    }
+    // A member's bookings never overlap, so the class's slots are theirs alone
+    for (int i = 0; i < CLASS_SLOT_WORDS; i++) {
+        entry->slots.bits[i] &= ~slots->bits[i];
+    }
+}
+
+// The member's booking of a class (NULL if none)
+static Booking *member_booking(ClassSchedule *s, const MemberSlots *entry, int class_id) {
+    for (int i = 0; entry && i < entry->booking_count; i++) {
+        Booking *booking = booking_find(&s->bookings, entry->bookings[i]);
+        if (booking && booking->id_class == class_id) {
+            return booking;
+        }
+    }
+    return NULL;
+}
+
+// The indexes now match the tables again
+static void mark_synced(ClassSchedule *s) {
+    s->synced_classes = s->classes.version;
+    s->synced_bookings = s->bookings.version;
+    s->ready = 1;
+}
+
+static void rebuild(ClassSchedule *s) {
+    free_indexes(s);
+
+    for (int i = 0; i < s->classes.count; i++) {
+        if (table_is_live(&s->classes, i)) {
+            ClassState state;
+            memset(&state, 0, sizeof(state));
+            state.id_class = gym_class_at(&s->classes, i)->id_class;
+            table_append(&s->class_states, &state);
+        }
+    }
+
+    // Bookings are in ID order, so waitlists come back in FIFO order
+    for (int i = 0; i < s->bookings.count; i++) {
+        if (!table_is_live(&s->bookings, i)) {
+            continue;
+        }
+        const Booking *booking = booking_at(&s->bookings, i);
+        const GymClass *gym_class = gym_class_find(&s->classes, booking->id_class);
+        ClassState *state = state_of(s, booking->id_class);
+        if (!gym_class || !state) {
+            continue;  // Booking of a deleted class
+        }
+
+        if (booking->status == BOOKING_WAITING) {
+            state->waiting++;
+            queue_push(state, booking->id_booking);
+        } else {
+            state->booked++;
+        }
+
+        WeekSlots slots;
+        class_week_slots(gym_class, &slots);
+        MemberSlots *entry = member_of(s, booking->id_member, 1);
+        if (entry) {
+            member_add_booking(entry, booking->id_booking, &slots);
+        }
+    }
+
+    mark_synced(s);
+}
+
+void class_schedule_init(ClassSchedule *schedule) {
+    memset(schedule, 0, sizeof(ClassSchedule));
+    gym_class_table_init(&schedule->classes);
+    booking_table_init(&schedule->bookings);
+    // The indexes are never saved, so they need no codec
+    table_init(&schedule->class_states, sizeof(ClassState), offsetof(ClassState, id_class), NULL);
+    table_init(&schedule->member_slots, sizeof(MemberSlots), offsetof(MemberSlots, id_member), NULL);
+}
+
+void class_schedule_free(ClassSchedule *schedule) {
+    free_indexes(schedule);
+    table_free(&schedule->class_states);
+    table_free(&schedule->member_slots);
+    table_free(&schedule->classes);
+    table_free(&schedule->bookings);
+    schedule->ready = 0;
+}
+
+void class_schedule_sync(ClassSchedule *schedule) {
+    if (!schedule->ready || schedule->classes.version != schedule->synced_classes ||
+        schedule->bookings.version != schedule->synced_bookings) {
+        rebuild(schedule);
+    }
+}
+
+int class_add(ClassSchedule *schedule, const GymClass *gym_class) {
+    if (gym_class->weekday < 0 || gym_class->weekday > 6 || gym_class->start_slot < 0 ||
+        gym_class->slot_count < 1 ||
+        gym_class->start_slot + gym_class->slot_count > CLASS_SLOTS_PER_DAY ||
+        gym_class->capacity < 1) {
+        return 0;
+    }
+
+    class_schedule_sync(schedule);
+
+    GymClass added = *gym_class;
+    added.id_class = table_next_id(&schedule->classes);
+    ClassState state;
+    memset(&state, 0, sizeof(state));
+    state.id_class = added.id_class;
+
+    if (!gym_class_append(&schedule->classes, &added)) {
+        return 0;
+    }
+    if (!table_append(&schedule->class_states, &state)) {
+        table_remove(&schedule->classes, added.id_class);
+        return 0;
+    }
+
+    mark_synced(schedule);
+    return added.id_class;
+}
+
+int class_delete(ClassSchedule *schedule, int class_id) {
+    class_schedule_sync(schedule);
+
+    const GymClass *gym_class = gym_class_find(&schedule->classes, class_id);
+    if (!gym_class) {
+        return 0;
+    }
+
+    WeekSlots slots;
+    class_week_slots(gym_class, &slots);
+
+    // Collect the IDs first: removing can compact the table
+    int count = 0;
+    int *ids = malloc(sizeof(int) * (schedule->bookings.live_count > 0 ? schedule->bookings.live_count : 1));
+    if (!ids) {
+        return 0;
+    }
+    for (int i = 0; i < schedule->bookings.count; i++) {
+        if (table_is_live(&schedule->bookings, i) &&
+            booking_at(&schedule->bookings, i)->id_class == class_id) {
+            ids[count++] = booking_at(&schedule->bookings, i)->id_booking;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        const Booking *booking = booking_find(&schedule->bookings, ids[i]);
+        MemberSlots *entry = member_of(schedule, booking->id_member, 0);
+        if (entry) {
+            member_remove_booking(entry, ids[i], &slots);
+        }
+        table_remove(&schedule->bookings, ids[i]);
+    }
+    free(ids);
+
+    ClassState *state = state_of(schedule, class_id);
+    if (state) {
+        free(state->queue);
+        state->queue = NULL;  // The tombstone is freed again by free_indexes()
+        table_remove(&schedule->class_states, class_id);
+    }
+    table_remove(&schedule->classes, class_id);
+
+    mark_synced(schedule);
+    return 1;
+}
+
+// Returns 1 if the member's plan opens every area the class's plan does
+static int plan_covers_class(const Member *member, const GymClass *gym_class) {
+    if (member->id_current_plan == -1) {
+        return 0;
+    }
+    if (member->id_current_plan == gym_class->id_plan) {
+        return 1;
+    }
+
+    const PlanCatalog *catalog = plan_catalog_enter();
+    const Plan *own = plan_find(&catalog->plans, member->id_current_plan);
+    const Plan *needed = plan_find(&catalog->plans, gym_class->id_plan);
+    int covered = own && needed && (needed->areas & PLAN_AREAS_ALL) != 0 &&
+                  (own->areas & needed->areas & PLAN_AREAS_ALL) == (needed->areas & PLAN_AREAS_ALL);
+    plan_catalog_exit();
+    return covered;
+}
+
+int class_book(ClassSchedule *schedule, const Member *member, int class_id) {
+    class_schedule_sync(schedule);
+
+    const GymClass *gym_class = gym_class_find(&schedule->classes, class_id);
+    if (!gym_class) {
+        return CLASS_NOT_FOUND;
+    }
+    if (!plan_covers_class(member, gym_class)) {
+        return CLASS_NOT_IN_PLAN;
+    }
+
+    MemberSlots *entry = member_of(schedule, member->id_member, 0);
+    if (member_booking(schedule, entry, class_id)) {
+        return CLASS_ALREADY_BOOKED;
+    }
+
+    // Waiting also holds the slots, so a promotion can never clash
+    WeekSlots slots;
+    class_week_slots(gym_class, &slots);
+    if (entry && slots_overlap(&entry->slots, &slots)) {
+        return CLASS_CONFLICT;
+    }
+
+    ClassState *state = state_of(schedule, class_id);
+    if (!state) {
+        schedule->ready = 0;  // The last rebuild ran out of memory
+        return CLASS_NO_MEMORY;
+    }
+    Booking booking;
+    booking.id_booking = table_next_id(&schedule->bookings);
+    booking.id_class = class_id;
+    booking.id_member = member->id_member;
+    booking.status = state->booked < gym_class->capacity ? BOOKING_CONFIRMED : BOOKING_WAITING;
+    booking.created = time(NULL);
+
+    if (booking.status == BOOKING_WAITING && !queue_push(state, booking.id_booking)) {
+        return CLASS_NO_MEMORY;
+    }
+    entry = member_of(schedule, member->id_member, 1);
+    if (!entry || !member_add_booking(entry, booking.id_booking, &slots) ||
+        !booking_append(&schedule->bookings, &booking)) {
+        // Drop whatever was indexed so far: the next sync rebuilds cleanly
+        schedule->ready = 0;
+        return CLASS_NO_MEMORY;
+    }
+
+    if (booking.status == BOOKING_WAITING) {
+        state->waiting++;
+    } else {
+        state->booked++;
+    }
+
+    mark_synced(schedule);
+    return booking.status == BOOKING_CONFIRMED ? CLASS_BOOKED : CLASS_WAITLISTED;
+}
+
+// Give a freed seat to the first member still waiting (returns their ID or -1)
+static int promote_waiting(ClassSchedule *schedule, ClassState *state) {
+    while (state->queue_count > 0) {
+        int booking_id = state->queue[state->queue_head];
+        state->queue_head++;
+        state->queue_count--;
+
+        Booking *booking = booking_find(&schedule->bookings, booking_id);
+        if (booking && booking->status == BOOKING_WAITING) {
+            booking->status = BOOKING_CONFIRMED;
+            table_touch(&schedule->bookings);
+            state->waiting--;
+            state->booked++;
+            return booking->id_member;
+        }
+        // Cancelled while waiting: skip it
+    }
+    return -1;
+}
+
+int class_cancel(ClassSchedule *schedule, int member_id, int class_id, int *promoted_member) {
+    *promoted_member = -1;
+    class_schedule_sync(schedule);
+
+    MemberSlots *entry = member_of(schedule, member_id, 0);
+    Booking *booking = member_booking(schedule, entry, class_id);
+    const GymClass *gym_class = gym_class_find(&schedule->classes, class_id);
+    ClassState *state = state_of(schedule, class_id);
+    if (!booking || !gym_class || !state) {
+        return 0;
+    }
+
+    WeekSlots slots;
+    class_week_slots(gym_class, &slots);
+    member_remove_booking(entry, booking->id_booking, &slots);
+
+    int was_waiting = booking->status == BOOKING_WAITING;
+    table_remove(&schedule->bookings, booking->id_booking);
+
+    if (was_waiting) {
+        state->waiting--;
+    } else {
+        state->booked--;
+        *promoted_member = promote_waiting(schedule, state);
+    }
+
+    mark_synced(schedule);
+    return 1;
+}
+
+int class_cancel_member(ClassSchedule *schedule, int member_id) {
+    class_schedule_sync(schedule);
+
+    MemberSlots *entry = member_of(schedule, member_id, 0);
+    if (!entry) {
+        return 0;
+    }
+
+    int cancelled = 0;
+    while (entry && entry->booking_count > 0) {
+        const Booking *booking = booking_find(&schedule->bookings, entry->bookings[0]);
+        int promoted;
+        if (!booking || !class_cancel(schedule, member_id, booking->id_class, &promoted)) {
+            break;
+        }
+        cancelled++;
+        entry = member_of(schedule, member_id, 0);
+    }
+    return cancelled;
+}
+
+void class_open_week(ClassSchedule *schedule) {
+    // Booking IDs keep growing, so waitlist order stays correct next week
+    table_clear(&schedule->bookings);
+    rebuild(schedule);
+}
+
+int class_booked_count(ClassSchedule *schedule, int class_id) {
+    class_schedule_sync(schedule);
+    const ClassState *state = state_of(schedule, class_id);
+    return state ? state->booked : 0;
+}
+
+int class_waiting_count(ClassSchedule *schedule, int class_id) {
+    class_schedule_sync(schedule);
+    const ClassState *state = state_of(schedule, class_id);
+    return state ? state->waiting : 0;
+}
+
+static void format_class_time(const GymClass *gym_class, char *out, int size) {
+    int start = gym_class->start_slot * CLASS_SLOT_MINUTES;
+    int end = start + gym_class->slot_count * CLASS_SLOT_MINUTES;
+    snprintf(out, size, "%s %02d:%02d-%02d:%02d", weekday_names[gym_class->weekday],
+             start / 60, start % 60, end / 60 % 24, end % 60);
+}
+
+static int compare_class_times(const void *a, const void *b) {
+    const GymClass *x = *(const GymClass * const *)a;
+    const GymClass *y = *(const GymClass * const *)b;
+    int x_start = x->weekday * CLASS_SLOTS_PER_DAY + x->start_slot;
+    int y_start = y->weekday * CLASS_SLOTS_PER_DAY + y->start_slot;
+    return x_start != y_start ? x_start - y_start : x->id_class - y->id_class;
+}
+
+void display_class_schedule(ClassSchedule *schedule) {
+    class_schedule_sync(schedule);
+
+    if (schedule->classes.live_count == 0) {
+        printf("\nNo classes scheduled.\n");
+        return;
+    }
+
+    const GymClass **sorted = malloc(sizeof(GymClass *) * schedule->classes.live_count);
+    if (!sorted) {
+        printf("\nError: Not enough memory to show the schedule.\n");
+        return;
+    }
+    int count = 0;
+    for (int i = 0; i < schedule->classes.count; i++) {
+        if (table_is_live(&schedule->classes, i)) {
+            sorted[count++] = gym_class_at(&schedule->classes, i);
+        }
+    }
+    qsort(sorted, count, sizeof(GymClass *), compare_class_times);
+
+    printf("\n--- Weekly Class Schedule ---\n");
+    for (int i = 0; i < count; i++) {
+        const ClassState *state = state_of(schedule, sorted[i]->id_class);
+        char when[32];
+        format_class_time(sorted[i], when, sizeof(when));
+        printf("ID: %d | %s | %s | Plan ID %d | Seats: %d/%d", sorted[i]->id_class,
+               sorted[i]->name, when, sorted[i]->id_plan,
+               state ? state->booked : 0, sorted[i]->capacity);
+        if (state && state->waiting > 0) {
+            printf(" | Waiting: %d", state->waiting);
+        }
+        printf("\n");
+    }
+    printf("\n");
+    free(sorted);
+}
+
+// List a member's bookings (returns how many there are)
+static int display_member_bookings(ClassSchedule *schedule, int member_id) {
+    const MemberSlots *entry = member_of(schedule, member_id, 0);
+    if (!entry || entry->booking_count == 0) {
+        printf("\nYou have no class booked.\n");
+        return 0;
+    }
+
+    printf("\n--- My Classes ---\n");
+    for (int i = 0; i < entry->booking_count; i++) {
+        const Booking *booking = booking_find(&schedule->bookings, entry->bookings[i]);
+        const GymClass *gym_class = booking ? gym_class_find(&schedule->classes, booking->id_class) : NULL;
+        if (!gym_class) {
+            continue;
+        }
+        char when[32];
+        format_class_time(gym_class, when, sizeof(when));
+        printf("Class ID: %d | %s | %s | %s\n", gym_class->id_class, gym_class->name, when,
+               booking->status == BOOKING_WAITING ? "On the waitlist" : "Booked");
+    }
+    return entry->booking_count;
+}
+
+static const char *booking_result_text(int result) {
+    switch (result) {
+        case CLASS_BOOKED:         return "[SUCCESS] Your seat is booked!";
+        case CLASS_WAITLISTED:     return "The class is full: you are on the waitlist and will get the first seat freed.";
+        case CLASS_NOT_FOUND:      return "Error: Invalid Class ID!";
+        case CLASS_NOT_IN_PLAN:    return "Error: Your subscription does not include this class.";
+        case CLASS_ALREADY_BOOKED: return "Error: You already booked this class.";
+        case CLASS_CONFLICT:       return "Error: This class overlaps another class you booked.";
+        default:                   return "Error: Not enough memory to book the class.";
+    }
+}
+
+void member_classes_menu(const Table *members, int member_id, ClassSchedule *schedule) {
+    int choice;
+
+    do {
+        // Show bookings made by other running copies of the app
+        shared_tables_refresh();
+        class_schedule_sync(schedule);
+
+        print_header("GROUP CLASSES");
+        printf("1 - View Schedule\n");
+        printf("2 - Book a Class\n");
+        printf("3 - My Classes\n");
+        printf("4 - Cancel a Booking\n");
+        printf("0 - Back\n");
+        print_separator();
+        printf("Your choice: ");
+        choice = get_int_input();
+
+        switch (choice) {
+            case 1:
+                display_class_schedule(schedule);
+                pause_screen();
+                break;
+
+            case 2: {
+                display_class_schedule(schedule);
+                printf("Enter Class ID to book (or 0 to cancel): ");
+                int class_id = get_int_input();
+                if (class_id == 0) {
+                    break;
+                }
+
+                // Booked on the latest bookings of every copy, so seats and
+                // waitlists are never given out twice
+                shared_tables_begin_edit();
+                const Member *member = member_find(members, member_id);
+                if (!member) {
+                    shared_tables_end_edit();
+                    printf("\nYour account has been removed.\n");
+                    pause_screen();
+                    return;
+                }
+
+                int result = class_book(schedule, member, class_id);
+                if (result >= 0) {
+                    audit_record(member_id, AUDIT_CLASS_BOOK, class_id,
+                                 result == CLASS_WAITLISTED ? "waitlist" : "seat");
+                }
+                shared_tables_end_edit();
+
+                printf("\n%s\n", booking_result_text(result));
+                if (result >= 0) {
+                    autosave_table(&schedule->bookings);
+                }
+                pause_screen();
+                break;
+            }
+
+            case 3:
+                display_member_bookings(schedule, member_id);
+                pause_screen();
+                break;
+
+            case 4: {
+                if (display_member_bookings(schedule, member_id) == 0) {
+                    pause_screen();
+                    break;
+                }
+
+                printf("\nEnter Class ID to cancel (or 0 to keep your bookings): ");
+                int class_id = get_int_input();
+                if (class_id == 0) {
+                    break;
+                }
+
+                int promoted;
+                shared_tables_begin_edit();
+                int cancelled = class_cancel(schedule, member_id, class_id, &promoted);
+                if (cancelled) {
+                    audit_record(member_id, AUDIT_CLASS_CANCEL, class_id, NULL);
+                }
+                shared_tables_end_edit();
+
+                if (cancelled) {
+                    printf("\n[SUCCESS] Booking cancelled.\n");
+                    if (promoted != -1) {
+                        printf("Your seat went to the first member on the waitlist.\n");
+                    }
+                    autosave_table(&schedule->bookings);
+                } else {
+                    printf("\nError: You have no booking for class %d.\n", class_id);
+                }
+                pause_screen();
+                break;
+            }
+
+            case 0:
+                break;
+
+            default:
+                printf("\nInvalid choice. Please try again.\n");
+                pause_screen();
+        }
+
+    } while (choice != 0);
+}
+
+int load_classes_from_file(ClassSchedule *schedule) {
+    char path[256];
+    data_file_path(CLASSES_FILE, path, sizeof(path));
+    int count = table_load(&schedule->classes, path);
+
+    if (count == TABLE_NO_FILE) {
+        printf("No classes file found. Starting with an empty schedule.\n");
+        count = 0;
+    } else if (count == TABLE_BAD_HEADER) {
+        printf("Error reading classes file.\n");
+        count = 0;
+    } else {
+        printf("Loaded %d class(es) from file.\n", count);
+    }
+
+    data_file_path(BOOKINGS_FILE, path, sizeof(path));
+    int bookings = table_load(&schedule->bookings, path);
+    if (bookings == TABLE_BAD_HEADER) {
+        printf("Error reading bookings file.\n");
+    } else if (bookings > 0) {
+        printf("Loaded %d class booking(s) from file.\n", bookings);
+    }
+
+    class_schedule_sync(schedule);
+    return count;
+}
@@ -0,0 +1,133 @@
+#ifndef CLASSES_H
+#define CLASSES_H
+
+#include <stdint.h>
+#include "table.h"
+#include "schema.h"
+#include "member.h"
+
+#define CLASSES_FILE  "data/classes.txt"
+#define BOOKINGS_FILE "data/bookings.txt"
+
+// The weekly schedule is cut into half-hour slots, Monday 00:00 first
+#define CLASS_SLOT_MINUTES   30
+#define CLASS_SLOTS_PER_DAY  48
+#define CLASS_WEEK_SLOTS     (7 * CLASS_SLOTS_PER_DAY)
+#define CLASS_SLOT_WORDS     ((CLASS_WEEK_SLOTS + 63) / 64)
+
+// Results of a booking (0 or more: it went through)
+#define CLASS_BOOKED          0
+#define CLASS_WAITLISTED      1
+#define CLASS_NOT_FOUND      -1
+#define CLASS_NOT_IN_PLAN    -2   // the member's plan does not cover the class
+#define CLASS_ALREADY_BOOKED -3
+#define CLASS_CONFLICT       -4   // overlaps a class the member already booked
+#define CLASS_NO_MEMORY      -5
+
+// Booking states
+#define BOOKING_CONFIRMED 0
+#define BOOKING_WAITING   1
+
+// Class fields (weekly group classes), in file order:
+// id|name|plan_id|weekday|start_slot|slot_count|capacity
+#define CLASS_FIELDS(X)                                              \
+    X(INT,  id_class,   0)                                           \
+    X(TEXT, name,       50)   /* e.g., "Pilates" */                  \
+    X(INT,  id_plan,    0)    /* plan whose areas the class needs */ \
+    X(INT,  weekday,    0)    /* 0 = Monday ... 6 = Sunday */        \
+    X(INT,  start_slot, 0)    /* half hours since midnight */        \
+    X(INT,  slot_count, 0)    /* length in half hours */             \
+    X(INT,  capacity,   0)
+
+// Class structure
+typedef struct {
+    SCHEMA_STRUCT(CLASS_FIELDS)
+} GymClass;
+
+// Class table helpers: gym_class_table_init(), gym_class_at(), gym_class_find(), gym_class_append()
+TABLE_TYPE(gym_class, GymClass, id_class)
+
+// Booking fields, in file order: id|class_id|member_id|status|created.
+// status is BOOKING_CONFIRMED or BOOKING_WAITING. Booking IDs only grow,
+// so waitlists are served in ID order.
+#define BOOKING_FIELDS(X)            \
+    X(INT,  id_booking, 0)           \
+    X(INT,  id_class,   0)           \
+    X(INT,  id_member,  0)           \
+    X(INT,  status,     0)           \
+    X(TIME, created,    0)
+
+// Booking structure
+typedef struct {
+    SCHEMA_STRUCT(BOOKING_FIELDS)
+} Booking;
+
+// Booking table helpers: booking_table_init(), booking_at(), booking_find(), booking_append()
+TABLE_TYPE(booking, Booking, id_booking)
+
+// Set of half-hour slots in the week, one bit each
+typedef struct {
+    uint64_t bits[CLASS_SLOT_WORDS];
+} WeekSlots;
+
+// The classes, their bookings and the indexes kept over them
+typedef struct ClassSchedule {
+    Table classes;
+    Table bookings;
+    Table class_states;       // per class: confirmed count and FIFO waitlist
+    Table member_slots;       // per member: slots taken by their bookings
+    unsigned long synced_classes;
+    unsigned long synced_bookings;
+    int ready;
+} ClassSchedule;
+
+// Function declarations
+
+// Initialize an empty schedule / free its memory
+void class_schedule_init(ClassSchedule *schedule);
+void class_schedule_free(ClassSchedule *schedule);
+
+// Load classes and bookings from their files (returns number of classes)
+int load_classes_from_file(ClassSchedule *schedule);
+
+// Rebuild the indexes if the tables changed outside the functions below
+// (e.g. after loading). Booking and cancelling keep them up to date.
+void class_schedule_sync(ClassSchedule *schedule);
+
+// Slots taken by a class
+void class_week_slots(const GymClass *gym_class, WeekSlots *slots);
+
+// Add a class under the next free ID. Returns the new ID, or 0 if its
+// time or capacity is invalid (or out of memory).
+int class_add(ClassSchedule *schedule, const GymClass *gym_class);
+
+// Delete a class and every booking of it (returns 1 if it existed)
+int class_delete(ClassSchedule *schedule, int class_id);
+
+// Book a class for a member: confirmed while seats are left, on the
+// waitlist after that. O(1) apart from the plan lookup.
+// Returns CLASS_BOOKED, CLASS_WAITLISTED or a negative CLASS_* error.
+int class_book(ClassSchedule *schedule, const Member *member, int class_id);
+
+// Cancel a member's booking of a class. If it held a seat, the first
+// member on the waitlist gets it; *promoted_member receives their ID
+// (-1 if nobody was waiting). Returns 1 if a booking was cancelled.
+int class_cancel(ClassSchedule *schedule, int member_id, int class_id, int *promoted_member);
+
+// Cancel every booking of a member (e.g. when the member is deleted)
+int class_cancel_member(ClassSchedule *schedule, int member_id);
+
+// Remove every booking: a new week's schedule opens
+void class_open_week(ClassSchedule *schedule);
+
+// Seats taken and members waiting for a class
+int class_booked_count(ClassSchedule *schedule, int class_id);
+int class_waiting_count(ClassSchedule *schedule, int class_id);
+
+// Display the weekly schedule with seats left
+void display_class_schedule(ClassSchedule *schedule);
+
+// Member screen: book and cancel classes
+void member_classes_menu(const Table *members, int member_id, ClassSchedule *schedule);
+
+#endif
@@ -1,5 +1,7 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include "equipment.h"
 #include "utils.h"
 
@@ -17,54 +19,72 @@ void create_equipment(Equipment *eq, int id, const char *name, const char *desc,
     
     // Set quantity
     eq->quantity = qty;
+    
+    // No service schedule until the admin sets one; new items start serviced
+    eq->usage_count = 0;
+    eq->service_uses = 0;
+    eq->service_days = 0;
+    eq->last_service = time(NULL);
+}
+
+// Read a service interval: 0 or more, or -1 where keep_allowed
+static int get_interval_input(int keep_allowed) {
+    while (1) {
+        int value = get_int_input();
+        if (value >= 0 || (keep_allowed && value == -1)) {
+            return value;
+        }
+        printf("Please enter 0 or more%s: ", keep_allowed ? " (or -1)" : "");
+    }
 }
 
-void display_single_equipment(Equipment *eq) {
+void display_single_equipment(const Equipment *eq) {
     printf("ID: %d | %s | Quantity: %d\n", 
            eq->id_equipment, eq->name, eq->quantity);
     printf("Description: %s\n", eq->description);
+    
+    if (eq->service_days > 0 || eq->service_uses > 0) {
+        char date[32];
+        format_date(eq->last_service, date, sizeof(date));
+        printf("Service:");
+        if (eq->service_days > 0) {
+            printf(" every %d day(s)", eq->service_days);
+        }
+        if (eq->service_uses > 0) {
+            printf(" %s %d checkout(s)", eq->service_days > 0 ? "or after" : "after", eq->service_uses);
+        }
+        printf(" | Last: %s | %d checkout(s) since\n", date, eq->usage_count);
+    }
 }
 
-void display_equipment(Equipment equipment[], int count) {
-    if (count == 0) {
+// Text format of one equipment item, generated from EQUIPMENT_FIELDS
+SCHEMA_CODEC(equipment, Equipment, EQUIPMENT_FIELDS, "equipment")
+
+void display_equipment(const Table *equipment) {
+    if (equipment->live_count == 0) {
         printf("\nNo equipment available.\n");
         return;
     }
     
     printf("\n--- Equipment List ---\n");
-    for (int i = 0; i < count; i++) {
-        printf("\nEquipment %d:\n", i + 1);
-        display_single_equipment(&equipment[i]);
+    int number = 1;
+    for (int i = 0; i < equipment->count; i++) {
+        // Skip deleted equipment
+        if (!table_is_live(equipment, i)) {
+            continue;
+        }
+        printf("\nEquipment %d:\n", number++);
+        display_single_equipment(equipment_at(equipment, i));
     }
     printf("\n");
 }
 
-int get_next_equipment_id(Equipment equipment[], int count) {
-    // If no equipment exists, start with ID 1
-    if (count == 0) {
-        return 1;
-    }
-    
-    // Find the highest ID among existing equipment
-    int max_id = equipment[0].id_equipment;
-    
-    for (int i = 1; i < count; i++) {
-        if (equipment[i].id_equipment > max_id) {
-            max_id = equipment[i].id_equipment;
-        }
-    }
-    
-    // Return the next available ID
-    int next_id = max_id + 1;
-    return next_id;
+int get_next_equipment_id(const Table *equipment) {
+    // The table remembers the highest ID it has seen
+    return table_next_id(equipment);
 }
 
-void add_equipment_interactive(Equipment equipment[], int *count) {
-    if (*count >= MAX_EQUIPMENT) {
-        printf("\nError: Maximum number of equipment reached (%d).\n", MAX_EQUIPMENT);
-        return;
-    }
-    
+void ask_new_equipment(Equipment *eq) {
     char name[50], desc[100];
     int qty;
     
@@ -78,147 +98,163 @@ void add_equipment_interactive(Equipment equipment[], int *count) {
     printf("Description: ");
     get_string_input(desc, sizeof(desc));
     
-    int new_id = get_next_equipment_id(equipment, *count);
-    create_equipment(&equipment[*count], new_id, name, desc, qty);
-    (*count)++;
+    printf("Service every how many days (0 = no schedule): ");
+    int service_days = get_interval_input(0);
     
-    printf("\nEquipment added successfully! (ID: %d)\n", new_id);
-}
-
-int find_equipment_by_id(Equipment equipment[], int count, int id) {
-    for (int i = 0; i < count; i++) {
-        if (equipment[i].id_equipment == id) {
-            return i;
-        }
-    }
-    return -1;
+    printf("Service after how many checkouts (0 = no limit): ");
+    int service_uses = get_interval_input(0);
+    
+    create_equipment(eq, 0, name, desc, qty);
+    eq->service_days = service_days;
+    eq->service_uses = service_uses;
 }
 
-int modify_equipment(Equipment equipment[], int count, int id) {
-    int index = find_equipment_by_id(equipment, count, id);
+int add_equipment(Table *equipment, Equipment *eq) {
+    // The ID is given now: another copy of the app may have added equipment
+    // while the details were typed
+    eq->id_equipment = get_next_equipment_id(equipment);
     
-    if (index == -1) {
-        printf("\nError: Equipment with ID %d not found.\n", id);
+    if (!equipment_append(equipment, eq)) {
+        printf("\nError: Not enough memory to add the equipment.\n");
         return 0;
     }
     
-    printf("\n--- Modify Equipment (ID: %d) ---\n", id);
+    printf("\nEquipment added successfully! (ID: %d)\n", eq->id_equipment);
+    return eq->id_equipment;
+}
+
+void add_equipment_interactive(Table *equipment) {
+    Equipment new_equipment;
+    ask_new_equipment(&new_equipment);
+    add_equipment(equipment, &new_equipment);
+}
+
+int find_equipment_by_id(const Table *equipment, int id) {
+    // Hash index lookup, no scan
+    return table_find_slot(equipment, id);
+}
+
+void ask_equipment_changes(const Equipment *eq, Equipment *changes) {
+    memset(changes, 0, sizeof(*changes));
+    changes->id_equipment = eq->id_equipment;
+    
+    printf("\n--- Modify Equipment (ID: %d) ---\n", eq->id_equipment);
     printf("Current details:\n");
-    display_single_equipment(&equipment[index]);
+    display_single_equipment(eq);
     
     printf("\nNew Equipment Name (or press Enter to keep current): ");
-    char name[50];
-    get_string_input(name, sizeof(name));
+    get_string_input(changes->name, sizeof(changes->name));
+    
+    printf("New Quantity (or 0 to keep current): ");
+    changes->quantity = get_int_input();
+    
+    printf("New Description (or press Enter to keep current): ");
+    get_string_input(changes->description, sizeof(changes->description));
+    
+    printf("New service interval in days (-1 to keep current, 0 for none): ");
+    changes->service_days = get_interval_input(1);
+    
+    printf("New checkouts between services (-1 to keep current, 0 for no limit): ");
+    changes->service_uses = get_interval_input(1);
+}
+
+int apply_equipment_changes(Table *equipment, const Equipment *changes) {
+    // Found again: the table may have been refreshed since the changes were asked
+    Equipment *eq = equipment_find(equipment, changes->id_equipment);
     
-    // Check if user entered something
-    int name_length = strlen(name);
-    if (name_length > 0) {
-        // Update the equipment name
-        strncpy(equipment[index].name, name, sizeof(equipment[index].name) - 1);
-        equipment[index].name[sizeof(equipment[index].name) - 1] = '\0';
+    if (!eq) {
+        printf("\nError: Equipment with ID %d not found.\n", changes->id_equipment);
+        return 0;
     }
     
-    printf("New Quantity (or 0 to keep current): ");
-    int qty = get_int_input();
+    // Empty text keeps the current value
+    if (changes->name[0] != '\0') {
+        snprintf(eq->name, sizeof(eq->name), "%s", changes->name);
+    }
     
     // Only update if user entered a positive value
-    if (qty > 0) {
-        equipment[index].quantity = qty;
+    if (changes->quantity > 0) {
+        eq->quantity = changes->quantity;
     }
     
-    printf("New Description (or press Enter to keep current): ");
-    char desc[100];
-    get_string_input(desc, sizeof(desc));
+    if (changes->description[0] != '\0') {
+        snprintf(eq->description, sizeof(eq->description), "%s", changes->description);
+    }
     
-    // Check if user entered something
-    int desc_length = strlen(desc);
-    if (desc_length > 0) {
-        // Update the description
-        strncpy(equipment[index].description, desc, sizeof(equipment[index].description) - 1);
-        equipment[index].description[sizeof(equipment[index].description) - 1] = '\0';
+    if (changes->service_days != -1) {
+        eq->service_days = changes->service_days;
     }
+    if (changes->service_uses != -1) {
+        eq->service_uses = changes->service_uses;
+    }
+
+    // Items from files older than the schedule have no service date: the
+    // schedule starts now, not in 1970
+    if ((eq->service_days > 0 || eq->service_uses > 0) && eq->last_service == 0) {
+        eq->last_service = time(NULL);
+    }
+
+    // The record was changed in place: mark the table as changed
+    table_touch_record(equipment, eq->id_equipment);
     
     printf("\nEquipment modified successfully!\n");
     return 1;
 }
 
-int delete_equipment(Equipment equipment[], int *count, int id) {
-    int index = find_equipment_by_id(equipment, *count, id);
+int modify_equipment(Table *equipment, int id) {
+    const Equipment *eq = equipment_find(equipment, id);
     
-    if (index == -1) {
+    if (!eq) {
         printf("\nError: Equipment with ID %d not found.\n", id);
         return 0;
     }
     
-    printf("\nDeleting equipment: %s\n", equipment[index].name);
+    Equipment changes;
+    ask_equipment_changes(eq, &changes);
+    return apply_equipment_changes(equipment, &changes);
+}
+
+int delete_equipment(Table *equipment, int id) {
+    Equipment *eq = equipment_find(equipment, id);
     
-    // Move all equipment after the deleted one forward by one position
-    for (int i = index; i < *count - 1; i++) {
-        equipment[i] = equipment[i + 1];
+    if (!eq) {
+        printf("\nError: Equipment with ID %d not found.\n", id);
+        return 0;
     }
     
-    // Decrease the total count
-    (*count)--;
+    printf("\nDeleting equipment: %s\n", eq->name);
+    
+    // The item is only marked as deleted, other items do not move
+    table_remove(equipment, id);
     
     printf("Equipment deleted successfully!\n");
     return 1;
 }
 
-int load_equipment_from_file(Equipment equipment[]) {
-    FILE *f = fopen("data/equipment.txt", "r");
+int load_equipment_from_file(Table *equipment) {
+    char path[256];
+    data_file_path(EQUIPMENT_FILE, path, sizeof(path));
+    int count = table_load(equipment, path);
     
-    if (!f) {
+    if (count == TABLE_NO_FILE) {
         printf("No equipment file found. Starting with empty equipment list.\n");
         return 0;
     }
     
-    int count;
-    if (fscanf(f, "%d\n", &count) != 1) {
+    if (count == TABLE_BAD_HEADER) {
         printf("Error reading equipment file.\n");
-        fclose(f);
         return 0;
     }
     
-    // Read each equipment from file
-    for (int i = 0; i < count && i < MAX_EQUIPMENT; i++) {
-        // Read: id|name|description|quantity
-        int fields_read = fscanf(f, "%d|%49[^|]|%99[^|]|%d\n",
-                                 &equipment[i].id_equipment,
-                                 equipment[i].name,
-                                 equipment[i].description,
-                                 &equipment[i].quantity);
-        
-        // Check if we successfully read all 4 fields
-        if (fields_read != 4) {
-            printf("Error reading equipment %d from file.\n", i + 1);
-            fclose(f);
-            return i;
-        }
-    }
-    
-    fclose(f);
     printf("Loaded %d equipment item(s) from file.\n", count);
     return count;
 }
 
-void save_equipment_to_file(Equipment equipment[], int count) {
-    FILE *f = fopen("data/equipment.txt", "w");
-    
-    if (!f) {
+void save_equipment_to_file(const Table *equipment) {
+    if (!table_write(equipment, equipment->path[0] ? equipment->path : EQUIPMENT_FILE)) {
         printf("\nError: Cannot save equipment to file.\n");
         return;
     }
     
-    fprintf(f, "%d\n", count);
-    
-    for (int i = 0; i < count; i++) {
-        fprintf(f, "%d|%s|%s|%d\n",
-                equipment[i].id_equipment,
-                equipment[i].name,
-                equipment[i].description,
-                equipment[i].quantity);
-    }
-    
-    fclose(f);
     printf("Equipment saved to file successfully.\n");
 }
@@ -1,46 +1,72 @@
 #ifndef EQUIPMENT_H
 #define EQUIPMENT_H
 
-#define MAX_EQUIPMENT 100
+#include "table.h"
+#include "schema.h"
+
+#define EQUIPMENT_FILE "data/equipment.txt"
+
+// Equipment fields, in file order:
+// id|name|description|quantity|usage_count|service_uses|service_days|last_service
+#define EQUIPMENT_FIELDS(X)                                                \
+    X(INT,   id_equipment, 0)                                              \
+    X(TEXT,  name,         50)                                             \
+    X(TEXT,  description,  100)                                            \
+    X(INT,   quantity,     0)                                              \
+    X(COUNT, usage_count,  0)    /* checkouts since the last service */   \
+    X(COUNT, service_uses, 0)    /* service after this many, 0 = never */ \
+    X(COUNT, service_days, 0)    /* service every N days, 0 = never */    \
+    X(TIME,  last_service, 0)
 
 // Equipment structure
 typedef struct {
-    int id_equipment;
-    char name[50];
-    char description[100];
-    int quantity;
+    SCHEMA_STRUCT(EQUIPMENT_FIELDS)
 } Equipment;
 
+// Equipment table helpers: equipment_table_init(), equipment_at(), equipment_find(), equipment_append()
+TABLE_TYPE(equipment, Equipment, id_equipment)
+
 // Function declarations
 
 // Initialize equipment with given data
 void create_equipment(Equipment *eq, int id, const char *name, const char *desc, int qty);
 
 // Display all equipment
-void display_equipment(Equipment equipment[], int count);
+void display_equipment(const Table *equipment);
 
 // Display a single equipment
-void display_single_equipment(Equipment *eq);
+void display_single_equipment(const Equipment *eq);
 
 // Add new equipment interactively
-void add_equipment_interactive(Equipment equipment[], int *count);
+void add_equipment_interactive(Table *equipment);
 
-// Find equipment by ID (returns index, -1 if not found)
-int find_equipment_by_id(Equipment equipment[], int count, int id);
+// The two halves of add_equipment_interactive(): ask for the details, then
+// add the item with the next free ID (returns the new ID, 0 if failed)
+void ask_new_equipment(Equipment *eq);
+int add_equipment(Table *equipment, Equipment *eq);
+
+// Find equipment by ID (returns slot, -1 if not found)
+int find_equipment_by_id(const Table *equipment, int id);
 
 // Delete equipment by ID
-int delete_equipment(Equipment equipment[], int *count, int id);
+int delete_equipment(Table *equipment, int id);
 
 // Modify equipment by ID
-int modify_equipment(Equipment equipment[], int count, int id);
+int modify_equipment(Table *equipment, int id);
+
+// The two halves of modify_equipment(): ask for the new values (empty text,
+// a quantity of 0 and intervals of -1 keep the current value), then apply
+// them to the item with the same ID (returns 0 if it is gone)
+void ask_equipment_changes(const Equipment *eq, Equipment *changes);
+int apply_equipment_changes(Table *equipment, const Equipment *changes);
 
-// Load equipment from file
-int load_equipment_from_file(Equipment equipment[]);
+// Load equipment from file into an initialized table (returns number of items)
+int load_equipment_from_file(Table *equipment);
 
 // Save equipment to file
-void save_equipment_to_file(Equipment equipment[], int count);
+void save_equipment_to_file(const Table *equipment);
 
 // Get the next available equipment ID
-int get_next_equipment_id(Equipment equipment[], int count);
+int get_next_equipment_id(const Table *equipment);
 
 #endif
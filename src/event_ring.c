@@ -0,0 +1,86 @@
+#include <stdlib.h>
+#include <string.h>
+#include "event_ring.h"
+
+// Slot layout: the sequence number, then the event bytes
+#define SLOT_HEADER sizeof(atomic_size_t)
+
+static atomic_size_t *slot_sequence(const EventRing *ring, size_t position) {
+    return (atomic_size_t *)(ring->slots + (position & ring->mask) * ring->stride);
+}
+
+static unsigned char *slot_data(const EventRing *ring, size_t position) {
+    return ring->slots + (position & ring->mask) * ring->stride + SLOT_HEADER;
+}
+
+int event_ring_init(EventRing *ring, size_t capacity, size_t elem_size) {
+    size_t size = 2;
+    while (size < capacity) {
+        size *= 2;
+    }
+
+    ring->elem_size = elem_size;
+    ring->stride = (SLOT_HEADER + elem_size + 7) & ~(size_t)7;
+    ring->mask = size - 1;
+    ring->slots = malloc(size * ring->stride);
+    if (!ring->slots) {
+        return 0;
+    }
+
+    // Slot i is free for the producer that claims position i
+    for (size_t i = 0; i < size; i++) {
+        atomic_init(slot_sequence(ring, i), i);
+    }
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    return 1;
+}
+
+void event_ring_free(EventRing *ring) {
+    free(ring->slots);
+    ring->slots = NULL;
+}
+
+int event_ring_push(EventRing *ring, const void *event) {
+    size_t position = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    while (1) {
+        size_t sequence = atomic_load_explicit(slot_sequence(ring, position), memory_order_acquire);
+        long difference = (long)(sequence - position);
+
+        if (difference == 0) {
+            // The slot is free: try to claim this position
+            if (atomic_compare_exchange_weak_explicit(&ring->head, &position, position + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            return 0;  // The consumer has not read this slot yet: full
+        } else {
+            // Another producer claimed it first
+            position = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        }
+    }
+
+    memcpy(slot_data(ring, position), event, ring->elem_size);
+    // Hand the slot to the consumer
+    atomic_store_explicit(slot_sequence(ring, position), position + 1, memory_order_release);
+    return 1;
+}
+
+int event_ring_pop(EventRing *ring, void *event) {
+    size_t position = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t sequence = atomic_load_explicit(slot_sequence(ring, position), memory_order_acquire);
+
+    if (sequence != position + 1) {
+        return 0;  // Empty, or the producer is still copying
+    }
+
+    memcpy(event, slot_data(ring, position), ring->elem_size);
+    atomic_store_explicit(&ring->tail, position + 1, memory_order_relaxed);
+    // Free the slot for the producer one lap later
+    atomic_store_explicit(slot_sequence(ring, position), position + ring->mask + 1,
+                          memory_order_release);
+    return 1;
+}
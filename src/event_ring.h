@@ -0,0 +1,37 @@
+#ifndef EVENT_RING_H
+#define EVENT_RING_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+
+// Bounded lock-free queue of fixed-size events: any number of threads may
+// push at the same time, one thread pops. Each slot carries a sequence
+// number telling producers and the consumer whose turn it is, so neither
+// side ever takes a lock or waits for the other.
+
+typedef struct {
+    unsigned char *slots;     // capacity slots of stride bytes
+    size_t elem_size;
+    size_t stride;            // sequence number + event, rounded up
+    size_t mask;              // capacity - 1
+    _Alignas(64) atomic_size_t head;   // next position producers claim
+    _Alignas(64) atomic_size_t tail;   // next position the consumer reads
+} EventRing;
+
+// Function declarations
+
+// Prepare a ring for capacity events (rounded up to a power of two)
+// of elem_size bytes. Returns 1 if successful, 0 if out of memory.
+int event_ring_init(EventRing *ring, size_t capacity, size_t elem_size);
+
+// Free the ring's memory (no thread may use it anymore)
+void event_ring_free(EventRing *ring);
+
+// Add a copy of event (any thread). Returns 1 if added, 0 if the ring is full.
+int event_ring_push(EventRing *ring, const void *event);
+
+// Take the oldest event (consumer thread only). Returns 1 if one was taken,
+// 0 if the ring is empty.
+int event_ring_pop(EventRing *ring, void *event);
+
+#endif
@@ -0,0 +1,436 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+#include "export.h"
+#include "member.h"
+#include "plans.h"
+#include "equipment.h"
+#include "utils.h"
+
+// Latest time written as a date (9999-12-31T23:59:59Z); others stay numbers
+#define EXPORT_MAX_DATE 253402300799LL
+
+// Output buffer shared by all exports, allocated on first use
+static char *export_buffer = NULL;
+
+// Value writers: append the value at *o (the caller guarantees room for
+// EXPORT_MAX_* characters)
+
+static inline void put_unsigned(char **o, unsigned long long v) {
+    char digits[20];
+    int n = 0;
+
+    do {
+        digits[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+
+    char *out = *o;
+    while (n > 0) {
+        *out++ = digits[--n];
+    }
+    *o = out;
+}
+
+static inline void put_signed(char **o, long long v) {
+    if (v < 0) {
+        *(*o)++ = '-';
+        put_unsigned(o, 0ull - (unsigned long long)v);
+    } else {
+        put_unsigned(o, (unsigned long long)v);
+    }
+}
+
+static inline void put_two_digits(char *out, unsigned v) {
+    out[0] = (char)('0' + v / 10);
+    out[1] = (char)('0' + v % 10);
+}
+
+// "YYYY-MM-DDTHH:MM:SSZ" for 0 <= t <= EXPORT_MAX_DATE, without gmtime()
+static inline void put_date(char **o, long long t) {
+    long long days = t / 86400;
+    unsigned seconds = (unsigned)(t % 86400);
+
+    // Civil date from days since 1970-01-01 (400-year eras of 146097 days)
+    unsigned z = (unsigned)(days + 719468);
+    unsigned era = z / 146097;
+    unsigned day_of_era = z - era * 146097;
+    unsigned year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    unsigned day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    unsigned shifted_month = (5 * day_of_year + 2) / 153;   // 0 is March
+    unsigned day = day_of_year - (153 * shifted_month + 2) / 5 + 1;
+    unsigned month = shifted_month < 10 ? shifted_month + 3 : shifted_month - 9;
+    unsigned year = year_of_era + era * 400 + (month <= 2);
+
+    char *out = *o;
+    put_two_digits(out, year / 100);
+    put_two_digits(out + 2, year % 100);
+    out[4] = '-';
+    put_two_digits(out + 5, month);
+    out[7] = '-';
+    put_two_digits(out + 8, day);
+    out[10] = 'T';
+    put_two_digits(out + 11, seconds / 3600);
+    out[13] = ':';
+    put_two_digits(out + 14, seconds / 60 % 60);
+    out[16] = ':';
+    put_two_digits(out + 17, seconds % 60);
+    out[19] = 'Z';
+    *o = out + 20;
+}
+
+static inline size_t text_length(const char *value, size_t size) {
+    const char *nul = memchr(value, '\0', size);
+    return nul ? (size_t)(nul - value) : size;
+}
+
+// CSV text: as is, or in quotes with "" for " if it holds , " or a line end
+static inline void put_csv_text(char **o, const char *value, size_t size) {
+    size_t length = text_length(value, size);
+    size_t i = 0;
+    while (i < length && value[i] != ',' && value[i] != '"' && value[i] != '\n' && value[i] != '\r') {
+        i++;
+    }
+    if (i == length) {
+        memcpy(*o, value, length);
+        *o += length;
+        return;
+    }
+
+    char *out = *o;
+    *out++ = '"';
+    memcpy(out, value, i);
+    out += i;
+    for (; i < length; i++) {
+        if (value[i] == '"') {
+            *out++ = '"';
+        }
+        *out++ = value[i];
+    }
+    *out++ = '"';
+    *o = out;
+}
+
+// JSON string: ", \ and control characters escaped, other bytes as they are
+static inline void put_json_text(char **o, const char *value, size_t size) {
+    static const char hex[] = "0123456789abcdef";
+    size_t length = text_length(value, size);
+    char *out = *o;
+
+    *out++ = '"';
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = (unsigned char)value[i];
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            *out++ = (char)c;
+            continue;
+        }
+        *out++ = '\\';
+        switch (c) {
+            case '"':  *out++ = '"';  break;
+            case '\\': *out++ = '\\'; break;
+            case '\n': *out++ = 'n';  break;
+            case '\r': *out++ = 'r';  break;
+            case '\t': *out++ = 't';  break;
+            default:
+                memcpy(out, "u00", 3);
+                out[3] = hex[c >> 4];
+                out[4] = hex[c & 15];
+                out += 5;
+        }
+    }
+    *out++ = '"';
+    *o = out;
+}
+
+static inline void put_key(char **o, const char *key, size_t length) {
+    memcpy(*o, key, length);
+    *o += length;
+}
+
+// Field writers of each kind: append the value and a ',' (CSV) or
+// "name":value, (JSON). SECRET fields write nothing.
+
+static inline void csv_INT(char **o, const int *value, size_t size) {
+    (void)size;
+    put_signed(o, *value);
+    *(*o)++ = ',';
+}
+
+static inline void csv_COUNT(char **o, const int *value, size_t size) {
+    csv_INT(o, value, size);
+}
+
+static inline void csv_MONEY(char **o, const Money *value, size_t size) {
+    (void)size;
+    *o += money_format(*value, *o);
+    *(*o)++ = ',';
+}
+
+static inline void csv_TIME(char **o, const long long *value, size_t size) {
+    (void)size;
+    if (*value > 0 && *value <= EXPORT_MAX_DATE) {
+        put_date(o, *value);
+    } else if (*value != 0) {
+        put_signed(o, *value);
+    }
+    *(*o)++ = ',';
+}
+
+static inline void csv_FLAGS(char **o, const unsigned *value, size_t size) {
+    (void)size;
+    put_unsigned(o, *value);
+    *(*o)++ = ',';
+}
+
+static inline void csv_TEXT(char **o, const char *value, size_t size) {
+    put_csv_text(o, value, size);
+    *(*o)++ = ',';
+}
+
+static inline void csv_SECRET(char **o, const char *value, size_t size) {
+    (void)o;
+    (void)value;
+    (void)size;
+}
+
+static inline void json_INT(char **o, const char *key, size_t key_length, const int *value, size_t size) {
+    (void)size;
+    put_key(o, key, key_length);
+    put_signed(o, *value);
+    *(*o)++ = ',';
+}
+
+static inline void json_COUNT(char **o, const char *key, size_t key_length, const int *value, size_t size) {
+    json_INT(o, key, key_length, value, size);
+}
+
+static inline void json_MONEY(char **o, const char *key, size_t key_length, const Money *value, size_t size) {
+    (void)size;
+    put_key(o, key, key_length);
+    *o += money_format(*value, *o);
+    *(*o)++ = ',';
+}
+
+static inline void json_TIME(char **o, const char *key, size_t key_length, const long long *value,
+                             size_t size) {
+    (void)size;
+    put_key(o, key, key_length);
+    if (*value > 0 && *value <= EXPORT_MAX_DATE) {
+        *(*o)++ = '"';
+        put_date(o, *value);
+        *(*o)++ = '"';
+    } else if (*value != 0) {
+        put_signed(o, *value);
+    } else {
+        put_key(o, "null", 4);
+    }
+    *(*o)++ = ',';
+}
+
+static inline void json_FLAGS(char **o, const char *key, size_t key_length, const unsigned *value,
+                              size_t size) {
+    (void)size;
+    put_key(o, key, key_length);
+    put_unsigned(o, *value);
+    *(*o)++ = ',';
+}
+
+static inline void json_TEXT(char **o, const char *key, size_t key_length, const char *value, size_t size) {
+    put_key(o, key, key_length);
+    put_json_text(o, value, size);
+    *(*o)++ = ',';
+}
+
+static inline void json_SECRET(char **o, const char *key, size_t key_length, const char *value,
+                               size_t size) {
+    (void)o;
+    (void)key;
+    (void)key_length;
+    (void)value;
+    (void)size;
+}
+
+// Longest JSON output of each kind (CSV is never longer), separator included
+#define EXPORT_MAX_INT(size)    12
+#define EXPORT_MAX_COUNT(size)  12
+#define EXPORT_MAX_MONEY(size)  MONEY_MAX_TEXT
+#define EXPORT_MAX_TIME(size)   23
+#define EXPORT_MAX_FLAGS(size)  11
+#define EXPORT_MAX_TEXT(size)   (6 * (size) + 3)
+#define EXPORT_MAX_SECRET(size) 0
+#define EXPORT_MAX(kind, name, size) + sizeof("\"" #name "\":") + EXPORT_MAX_##kind(size)
+
+// CSV header name of each kind
+#define EXPORT_NAME_INT(name)    #name ","
+#define EXPORT_NAME_COUNT(name)  #name ","
+#define EXPORT_NAME_MONEY(name)  #name ","
+#define EXPORT_NAME_TIME(name)   #name ","
+#define EXPORT_NAME_FLAGS(name)  #name ","
+#define EXPORT_NAME_TEXT(name)   #name ","
+#define EXPORT_NAME_SECRET(name) ""
+#define EXPORT_NAME(kind, name, size) EXPORT_NAME_##kind(name)
+
+#define EXPORT_CSV_FIELD(kind, name, size) \
+    csv_##kind(&o, SCHEMA_ADDR_##kind(r, name), size);
+
+#define EXPORT_JSON_FIELD(kind, name, size)                                          \
+    json_##kind(&o, "\"" #name "\":", sizeof("\"" #name "\":") - 1, SCHEMA_ADDR_##kind(r, name), size);
+
+// How one record type is exported: write one record at o, return the new end
+typedef struct {
+    const char *header;    // CSV field names, each followed by ','
+    size_t max_line;       // longest record in either format, '\n' included
+    char *(*csv)(char *o, const void *record);
+    char *(*json)(char *o, const void *record);
+} ExportSchema;
+
+// Define <prefix>_export from a schema, unrolled over its fields like SCHEMA_CODEC
+#define EXPORT_SCHEMA(prefix, Type, FIELDS)                                      \
+    static char *csv_##prefix(char *o, const void *record) {                     \
+        const Type *r = record;                                                  \
+        FIELDS(EXPORT_CSV_FIELD)                                                 \
+        o[-1] = '\n';  /* the last ',' ends the line */                          \
+        return o;                                                                \
+    }                                                                            \
+    static char *json_##prefix(char *o, const void *record) {                    \
+        const Type *r = record;                                                  \
+        *o++ = '{';                                                              \
+        FIELDS(EXPORT_JSON_FIELD)                                                \
+        o[-1] = '}';   /* in place of the last ',' */                            \
+        *o++ = '\n';                                                             \
+        return o;                                                                \
+    }                                                                            \
+    static const ExportSchema prefix##_export = { FIELDS(EXPORT_NAME), 3 FIELDS(EXPORT_MAX), \
+                                                  csv_##prefix, json_##prefix };
+
+EXPORT_SCHEMA(member, Member, MEMBER_FIELDS)
+EXPORT_SCHEMA(plan, Plan, PLAN_FIELDS)
+EXPORT_SCHEMA(equipment, Equipment, EQUIPMENT_FIELDS)
+
+// Write the buffer out; returns 0 if the write failed
+static int flush_buffer(FILE *out, size_t *used, ExportStats *stats) {
+    int ok = fwrite(export_buffer, 1, *used, out) == *used;
+    stats->bytes += (long long)*used;
+    *used = 0;
+    return ok;
+}
+
+static int export_table(const Table *t, const ExportSchema *schema, FILE *out, int format,
+                        ExportStats *stats) {
+    stats->records = 0;
+    stats->bytes = 0;
+
+    if (!export_buffer) {
+        export_buffer = malloc(EXPORT_BUFFER_SIZE);
+        if (!export_buffer) {
+            return 0;
+        }
+    }
+
+    char *(*write)(char *, const void *) = format == EXPORT_JSONL ? schema->json : schema->csv;
+    size_t used = 0;
+    int ok = 1;
+
+    if (format == EXPORT_CSV) {
+        size_t length = strlen(schema->header);
+        memcpy(export_buffer, schema->header, length);
+        export_buffer[length - 1] = '\n';
+        used = length;
+    }
+
+    for (int i = 0; i < t->count; i++) {
+        if (!table_is_live(t, i)) {
+            continue;
+        }
+        if (used + schema->max_line > EXPORT_BUFFER_SIZE) {
+            ok &= flush_buffer(out, &used, stats);
+        }
+        used = (size_t)(write(export_buffer + used, table_at(t, i)) - export_buffer);
+        stats->records++;
+    }
+    ok &= flush_buffer(out, &used, stats);
+
+    return ok && fflush(out) == 0;
+}
+
+int export_members(const Table *members, FILE *out, int format, ExportStats *stats) {
+    return export_table(members, &member_export, out, format, stats);
+}
+
+int export_plans(const Table *plans, FILE *out, int format, ExportStats *stats) {
+    return export_table(plans, &plan_export, out, format, stats);
+}
+
+int export_equipment(const Table *equipment, FILE *out, int format, ExportStats *stats) {
+    return export_table(equipment, &equipment_export, out, format, stats);
+}
+
+static int export_file(const Table *t, const ExportSchema *schema, const char *dir, const char *name,
+                       int format) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s.%s", dir, name, format == EXPORT_JSONL ? "jsonl" : "csv");
+
+    FILE *out = fopen(path, "wb");
+    if (!out) {
+        printf("Error: Cannot create %s\n", path);
+        return 0;
+    }
+    // The export buffer is already large: write it straight through
+    setvbuf(out, NULL, _IONBF, 0);
+
+    ExportStats stats;
+    int ok = export_table(t, schema, out, format, &stats);
+    ok &= fclose(out) == 0;
+
+    if (ok) {
+        printf("%-10s %8lld records  %10lld bytes  -> %s\n", name, stats.records, stats.bytes, path);
+    } else {
+        printf("Error: Writing %s failed (disk full?)\n", path);
+    }
+    return ok;
+}
+
+int export_all(const Table *members, const Table *plans, const Table *equipment,
+               const char *dir, int format) {
+#ifdef _WIN32
+    _mkdir(dir);
+#else
+    mkdir(dir, 0755);
+#endif
+
+    int ok = export_file(members, &member_export, dir, "members", format);
+    ok &= export_file(plans, &plan_export, dir, "plans", format);
+    ok &= export_file(equipment, &equipment_export, dir, "equipment", format);
+    return ok;
+}
+
+void export_interactive(const Table *members, const Table *plans, const Table *equipment) {
+    char dir[256];
+
+    printf("\n--- Export Data ---\n");
+    printf("Members (without passwords), plans and equipment are written as:\n");
+    printf("1 - CSV\n");
+    printf("2 - JSON Lines\n");
+    printf("Format (0 to cancel): ");
+    int choice = get_int_input();
+    if (choice != 1 && choice != 2) {
+        return;
+    }
+
+    char default_dir[256];
+    data_file_path(EXPORT_DIR, default_dir, sizeof(default_dir));
+    printf("Folder (press Enter for %s): ", default_dir);
+    get_string_input(dir, sizeof(dir));
+    if (dir[0] == '\0') {
+        strcpy(dir, default_dir);
+    }
+
+    printf("\n");
+    if (export_all(members, plans, equipment, dir, choice == 2 ? EXPORT_JSONL : EXPORT_CSV)) {
+        printf("\n[SUCCESS] Export finished.\n");
+    }
+}
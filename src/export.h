@@ -0,0 +1,44 @@
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include <stdio.h>
+#include "table.h"
+
+// Export formats
+#define EXPORT_CSV   0   // a header line naming the fields, then one line per record
+#define EXPORT_JSONL 1   // JSON Lines: one object per record
+
+// Size of the output buffer, allocated once and reused by every export
+#define EXPORT_BUFFER_SIZE (1 << 20)
+
+// Folder the exports go to unless another one is given
+#define EXPORT_DIR "data/export"
+
+// Exports are generated from the table schemas: every field is written
+// except SECRET ones, so passwords never leave the data files. Times are
+// written as UTC dates ("2026-01-31T09:00:00Z", empty or null if not
+// recorded), money with its decimals. Only the output buffer is held in
+// memory, whatever the size of the table. Run one export at a time.
+
+typedef struct {
+    long long records;
+    long long bytes;
+} ExportStats;
+
+// Function declarations
+
+// Stream one table to out. Return 1 if everything was written.
+int export_members(const Table *members, FILE *out, int format, ExportStats *stats);
+int export_plans(const Table *plans, FILE *out, int format, ExportStats *stats);
+int export_equipment(const Table *equipment, FILE *out, int format, ExportStats *stats);
+
+// Write members, plans and equipment to dir/members.csv, dir/plans.csv and
+// dir/equipment.csv (.jsonl for JSON Lines), creating dir if needed, and
+// print what was written. Returns 1 if every file was written.
+int export_all(const Table *members, const Table *plans, const Table *equipment,
+               const char *dir, int format);
+
+// Admin screen: choose the format and folder, then export everything
+void export_interactive(const Table *members, const Table *plans, const Table *equipment);
+
+#endif
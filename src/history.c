@@ -0,0 +1,668 @@
+#define _POSIX_C_SOURCE 200809L  // fileno, ftruncate
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#include "history.h"
+#include "utils.h"
+
+// Bytes read from the file at a time while streaming
+#define READ_CHUNK 65536
+
+// Events shown by the admin timeline
+#define TIMELINE_MAX 100
+
+// A record as stored, before the member's previous record is applied
+typedef struct {
+    int member_id;
+    long long back;           // bytes back to the member's previous record, 0 if none
+    long long delta;          // seconds since that record
+    int type;
+    int plan_id;
+} RawRecord;
+
+// Sequential reader over a range of the file, in READ_CHUNK blocks
+typedef struct {
+    FILE *f;
+    unsigned char *buffer;
+    int length;
+    int position;
+    long long offset;         // file offset of buffer[position]
+    long long limit;          // stop here (-1: end of file)
+    int at_end;
+} Reader;
+
+static FILE *log_file = NULL;
+static long long indexed_end = 0;      // records before this offset are indexed
+
+// Last record of each member: its offset (-1 if none) and time
+static long long *last_offset = NULL;
+static long long *last_time = NULL;
+static int index_capacity = 0;
+
+static int put_varint(unsigned char *out, unsigned long long value) {
+    int n = 0;
+    while (value >= 0x80) {
+        out[n++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (unsigned char)value;
+    return n;
+}
+
+// Returns the bytes read, 0 if the varint is cut off or too long
+static int get_varint(const unsigned char *p, const unsigned char *end, unsigned long long *value) {
+    unsigned long long result = 0;
+    for (int n = 0; n < 10 && p + n < end; n++) {
+        result |= (unsigned long long)(p[n] & 0x7F) << (7 * n);
+        if ((p[n] & 0x80) == 0) {
+            *value = result;
+            return n + 1;
+        }
+    }
+    return 0;
+}
+
+// Small negative numbers stay small: 0, -1, 1, -2, ... -> 0, 1, 2, 3, ...
+static unsigned long long zigzag(long long value) {
+    return ((unsigned long long)value << 1) ^ (unsigned long long)(value >> 63);
+}
+
+static long long unzigzag(unsigned long long value) {
+    return (long long)(value >> 1) ^ -(long long)(value & 1);
+}
+
+static int encode_record(unsigned char *out, const RawRecord *r) {
+    int n = 0;
+    n += put_varint(out + n, (unsigned long long)r->member_id);
+    n += put_varint(out + n, (unsigned long long)r->back);
+    n += put_varint(out + n, zigzag(r->delta));
+    out[n++] = (unsigned char)r->type;
+    n += put_varint(out + n, zigzag(r->plan_id));
+    return n;
+}
+
+// Returns the record's length, 0 if it is cut off or malformed
+static int decode_record(const unsigned char *p, const unsigned char *end, RawRecord *r) {
+    unsigned long long member, back, delta, plan;
+    int n = 0, used;
+
+    if (!(used = get_varint(p + n, end, &member)) || member > 0x7FFFFFFF) {
+        return 0;
+    }
+    n += used;
+    if (!(used = get_varint(p + n, end, &back))) {
+        return 0;
+    }
+    n += used;
+    if (!(used = get_varint(p + n, end, &delta))) {
+        return 0;
+    }
+    n += used;
+    if (p + n >= end || p[n] < HISTORY_SUBSCRIBE || p[n] > HISTORY_DELETE) {
+        return 0;
+    }
+    r->type = p[n++];
+    if (!(used = get_varint(p + n, end, &plan))) {
+        return 0;
+    }
+    n += used;
+
+    r->member_id = (int)member;
+    r->back = (long long)back;
+    r->delta = unzigzag(delta);
+    r->plan_id = (int)unzigzag(plan);
+    return n;
+}
+
+static int reader_open(Reader *reader, FILE *f, long long from, long long limit) {
+    reader->buffer = malloc(READ_CHUNK);
+    if (!reader->buffer) {
+        return 0;
+    }
+    reader->f = f;
+    reader->length = 0;
+    reader->position = 0;
+    reader->offset = from;
+    reader->limit = limit;
+    reader->at_end = 0;
+    fseek(f, (long)from, SEEK_SET);
+    return 1;
+}
+
+static void reader_close(Reader *reader) {
+    free(reader->buffer);
+}
+
+// Next record and its offset. Returns 0 at the end, or at a record cut
+// off by a crash while it was written.
+static int reader_next(Reader *reader, RawRecord *record, long long *offset) {
+    if (reader->length - reader->position < HISTORY_MAX_RECORD && !reader->at_end) {
+        // Keep the unread bytes and fill up the rest of the buffer
+        int kept = reader->length - reader->position;
+        memmove(reader->buffer, reader->buffer + reader->position, kept);
+        size_t wanted = READ_CHUNK - kept;
+        if (reader->limit >= 0) {
+            long long left = reader->limit - (reader->offset + kept);
+            if (left < (long long)wanted) {
+                wanted = left > 0 ? (size_t)left : 0;
+            }
+        }
+        size_t got = wanted > 0 ? fread(reader->buffer + kept, 1, wanted, reader->f) : 0;
+        reader->length = kept + (int)got;
+        reader->position = 0;
+        reader->at_end = got < wanted || wanted == 0;
+    }
+
+    int used = decode_record(reader->buffer + reader->position, reader->buffer + reader->length, record);
+    if (used == 0) {
+        return 0;
+    }
+    *offset = reader->offset;
+    reader->position += used;
+    reader->offset += used;
+    return 1;
+}
+
+static int reserve_members(int member_id) {
+    if (member_id < index_capacity) {
+        return 1;
+    }
+
+    int capacity = index_capacity > 0 ? index_capacity : 1024;
+    while (capacity <= member_id) {
+        capacity *= 2;
+    }
+    long long *offsets = realloc(last_offset, sizeof(long long) * capacity);
+    if (!offsets) {
+        return 0;
+    }
+    last_offset = offsets;
+    long long *times = realloc(last_time, sizeof(long long) * capacity);
+    if (!times) {
+        return 0;
+    }
+    last_time = times;
+
+    for (int i = index_capacity; i < capacity; i++) {
+        last_offset[i] = -1;
+        last_time[i] = 0;
+    }
+    index_capacity = capacity;
+    return 1;
+}
+
+// Index the records between indexed_end and limit (-1: end of file).
+// Returns the number of records read, -1 if out of memory.
+static long long index_records(long long limit) {
+    Reader reader;
+    if (!reader_open(&reader, log_file, indexed_end, limit)) {
+        return -1;
+    }
+
+    long long count = 0, offset;
+    RawRecord record;
+    while (reader_next(&reader, &record, &offset)) {
+        if (!reserve_members(record.member_id)) {
+            reader_close(&reader);
+            return -1;
+        }
+        long long previous = record.back > 0 ? last_time[record.member_id] : 0;
+        last_offset[record.member_id] = offset;
+        last_time[record.member_id] = previous + record.delta;
+        indexed_end = reader.offset;
+        count++;
+    }
+
+    reader_close(&reader);
+    return count;
+}
+
+static long long file_size(FILE *f) {
+    fflush(f);
+    fseek(f, 0, SEEK_END);
+    return ftell(f);
+}
+
+int history_start(const char *path, const Table *members) {
+    if (log_file) {
+        return 0;
+    }
+
+    // Appends always go to the end, reads may seek anywhere
+    log_file = fopen(path, "ab+");
+    if (!log_file) {
+        printf("Warning: Cannot open %s, subscription history will not be kept.\n", path);
+        return -1;
+    }
+
+    indexed_end = 0;
+    long long events = index_records(-1);
+    if (events < 0) {
+        printf("Warning: Not enough memory to read the subscription history.\n");
+        history_stop();
+        return -1;
+    }
+
+    // Drop a record cut off by a crash, or new records would follow it
+    if (file_size(log_file) > indexed_end) {
+        printf("Warning: Ignoring an incomplete record at the end of %s.\n", path);
+#ifdef _WIN32
+        _chsize(_fileno(log_file), (long)indexed_end);
+#else
+        if (ftruncate(fileno(log_file), (off_t)indexed_end) != 0) {
+            printf("Warning: Cannot repair %s, subscription history will not be kept.\n", path);
+            history_stop();
+            return -1;
+        }
+#endif
+    }
+
+    // A new log starts with the subscriptions running now
+    if (events == 0) {
+        long long now = time(NULL);
+        for (int i = 0; i < members->count; i++) {
+            if (!table_is_live(members, i)) {
+                continue;
+            }
+            const Member *member = member_at(members, i);
+            if (member->id_current_plan != -1) {
+                history_record(member->id_member, HISTORY_SUBSCRIBE, member->id_current_plan,
+                               member->subscription_start != 0 ? member->subscription_start : now);
+                events++;
+            }
+        }
+    }
+    return (int)events;
+}
+
+void history_stop() {
+    if (log_file) {
+        fclose(log_file);
+        log_file = NULL;
+    }
+    free(last_offset);
+    free(last_time);
+    last_offset = NULL;
+    last_time = NULL;
+    index_capacity = 0;
+    indexed_end = 0;
+}
+
+int history_record(int member_id, int type, int plan_id, long long time) {
+    if (!log_file || member_id < 0) {
+        return 0;
+    }
+
+    // Another process may have appended since: index its records first
+    if (file_size(log_file) > indexed_end) {
+        if (index_records(-1) < 0) {
+            return 0;
+        }
+        fseek(log_file, 0, SEEK_END);  // Needed between reading and writing
+    }
+    if (!reserve_members(member_id)) {
+        return 0;
+    }
+
+    RawRecord record;
+    record.member_id = member_id;
+    record.back = last_offset[member_id] >= 0 ? indexed_end - last_offset[member_id] : 0;
+    record.delta = record.back > 0 ? time - last_time[member_id] : time;
+    record.type = type;
+    record.plan_id = plan_id;
+
+    unsigned char bytes[HISTORY_MAX_RECORD];
+    int length = encode_record(bytes, &record);
+    if (fwrite(bytes, 1, length, log_file) != (size_t)length || fflush(log_file) != 0) {
+        return 0;
+    }
+
+    last_offset[member_id] = indexed_end;
+    last_time[member_id] = time;
+    indexed_end += length;
+    return 1;
+}
+
+int history_timeline(int member_id, HistoryEvent *events, int max) {
+    if (!log_file || member_id < 0 || member_id >= index_capacity || max <= 0) {
+        return 0;
+    }
+
+    // Follow the member's chain from the newest record back
+    long long offset = last_offset[member_id];
+    long long time = last_time[member_id];
+    int count = 0;
+    while (offset >= 0 && count < max) {
+        unsigned char bytes[HISTORY_MAX_RECORD];
+        RawRecord record;
+        fseek(log_file, (long)offset, SEEK_SET);
+        size_t got = fread(bytes, 1, sizeof(bytes), log_file);
+        if (!decode_record(bytes, bytes + got, &record) || record.member_id != member_id) {
+            break;  // Damaged chain: show what was found
+        }
+
+        events[count].time = time;
+        events[count].member_id = member_id;
+        events[count].type = record.type;
+        events[count].plan_id = record.plan_id;
+        count++;
+
+        if (record.back == 0) {
+            break;
+        }
+        offset -= record.back;
+        time -= record.delta;
+    }
+
+    // Oldest first
+    for (int i = 0; i < count / 2; i++) {
+        HistoryEvent swap = events[i];
+        events[i] = events[count - 1 - i];
+        events[count - 1 - i] = swap;
+    }
+    return count;
+}
+
+// The month a time falls in, as year * 12 + month - 1
+typedef struct {
+    long long start;          // first second of the month last looked up
+    long long end;            // first second of the month after it
+    int key;
+} MonthCache;
+
+static int month_key(long long seconds, MonthCache *cache) {
+    // Events come mostly in time order: most fall in the month of the last one
+    if (seconds >= cache->start && seconds < cache->end) {
+        return cache->key;
+    }
+
+    time_t t = (time_t)seconds;
+    struct tm *date = localtime(&t);
+    if (!date) {
+        return -1;
+    }
+    struct tm first = *date;
+    first.tm_mday = 1;
+    first.tm_hour = 0;
+    first.tm_min = 0;
+    first.tm_sec = 0;
+    first.tm_isdst = -1;
+    struct tm next = first;
+    next.tm_mon++;
+
+    cache->key = (date->tm_year + 1900) * 12 + date->tm_mon;
+    cache->start = (long long)mktime(&first);
+    cache->end = (long long)mktime(&next);
+    return cache->key;
+}
+
+// Month of the report for a key, added (with any months between) if new
+static ChurnMonth *month_of(ChurnReport *report, int key, int *capacity) {
+    if (key < 0) {
+        return NULL;
+    }
+
+    if (report->count == 0) {
+        if (*capacity == 0) {
+            report->months = malloc(sizeof(ChurnMonth) * 16);
+            if (!report->months) {
+                return NULL;
+            }
+            *capacity = 16;
+        }
+        memset(&report->months[0], 0, sizeof(ChurnMonth));
+        report->months[0].year = key / 12;
+        report->months[0].month = key % 12 + 1;
+        report->count = 1;
+    }
+
+    int first = report->months[0].year * 12 + report->months[0].month - 1;
+    int before = key < first ? first - key : 0;
+    int after = key >= first + report->count ? key - (first + report->count) + 1 : 0;
+
+    if (before > 0 || after > 0) {
+        int needed = report->count + before + after;
+        if (needed > *capacity) {
+            int grown_capacity = *capacity * 2 > needed ? *capacity * 2 : needed;
+            ChurnMonth *grown = realloc(report->months, sizeof(ChurnMonth) * grown_capacity);
+            if (!grown) {
+                return NULL;
+            }
+            report->months = grown;
+            *capacity = grown_capacity;
+        }
+        memmove(report->months + before, report->months, sizeof(ChurnMonth) * report->count);
+        report->count = needed;
+
+        // Name the new months, before and after the known ones
+        int start = key < first ? key : first;
+        for (int i = 0; i < report->count; i++) {
+            if (i < before || i >= needed - after) {
+                memset(&report->months[i], 0, sizeof(ChurnMonth));
+                report->months[i].year = (start + i) / 12;
+                report->months[i].month = (start + i) % 12 + 1;
+            }
+        }
+        first = start;
+    }
+    return &report->months[key - first];
+}
+
+int history_churn(const char *path, ChurnReport *report) {
+    report->months = NULL;
+    report->count = 0;
+    report->events = 0;
+
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return 0;
+    }
+
+    Reader reader;
+    if (!reader_open(&reader, f, 0, -1)) {
+        fclose(f);
+        return 0;
+    }
+
+    // One state per member: time of its last record, plan, and whether it
+    // never subscribed (0), is subscribed (1) or saw its subscription end (2)
+    long long *times = NULL;
+    int *plans = NULL;
+    unsigned char *states = NULL;
+    int capacity = 0, month_capacity = 0, ok = 1;
+    MonthCache cache = { 1, 0, 0 };
+
+    RawRecord record;
+    long long offset;
+    while (reader_next(&reader, &record, &offset)) {
+        int id = record.member_id;
+        if (id >= capacity) {
+            int grown_capacity = capacity > 0 ? capacity : 1024;
+            while (grown_capacity <= id) {
+                grown_capacity *= 2;
+            }
+            long long *grown_times = realloc(times, sizeof(long long) * grown_capacity);
+            int *grown_plans = grown_times ? realloc(plans, sizeof(int) * grown_capacity) : NULL;
+            unsigned char *grown_states = grown_plans ? realloc(states, grown_capacity) : NULL;
+            if (grown_times) {
+                times = grown_times;
+            }
+            if (grown_plans) {
+                plans = grown_plans;
+            }
+            if (!grown_states) {
+                ok = 0;
+                break;
+            }
+            states = grown_states;
+            memset(states + capacity, 0, grown_capacity - capacity);
+            capacity = grown_capacity;
+        }
+
+        long long time = (record.back > 0 ? times[id] : 0) + record.delta;
+        times[id] = time;
+
+        ChurnMonth *month = month_of(report, month_key(time, &cache), &month_capacity);
+        if (!month) {
+            ok = 0;
+            break;
+        }
+
+        if (record.type == HISTORY_SUBSCRIBE) {
+            if (states[id] == 0) {
+                month->started++;
+            } else if (states[id] == 2) {
+                month->returned++;
+            } else if (plans[id] == record.plan_id) {
+                month->renewed++;
+            } else {
+                month->changed++;
+            }
+            states[id] = 1;
+            plans[id] = record.plan_id;
+        } else if (states[id] == 1) {
+            month->ended++;
+            states[id] = 2;
+        }
+        report->events++;
+    }
+
+    reader_close(&reader);
+    fclose(f);
+    free(times);
+    free(plans);
+    free(states);
+
+    if (!ok) {
+        free(report->months);
+        report->months = NULL;
+        report->count = 0;
+    }
+    return ok;
+}
+
+int history_scan(const char *path, void (*visit)(const HistoryEvent *event, void *context), void *context) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return 0;
+    }
+
+    Reader reader;
+    if (!reader_open(&reader, f, 0, -1)) {
+        fclose(f);
+        return 0;
+    }
+
+    // Times are stored against the member's previous record
+    long long *times = NULL;
+    int capacity = 0, ok = 1;
+
+    RawRecord record;
+    long long offset;
+    while (reader_next(&reader, &record, &offset)) {
+        int id = record.member_id;
+        if (id >= capacity) {
+            int grown_capacity = capacity > 0 ? capacity : 1024;
+            while (grown_capacity <= id) {
+                grown_capacity *= 2;
+            }
+            long long *grown = realloc(times, sizeof(long long) * grown_capacity);
+            if (!grown) {
+                ok = 0;
+                break;
+            }
+            times = grown;
+            capacity = grown_capacity;
+        }
+
+        HistoryEvent event;
+        event.time = (record.back > 0 ? times[id] : 0) + record.delta;
+        event.member_id = id;
+        event.type = record.type;
+        event.plan_id = record.plan_id;
+        times[id] = event.time;
+        visit(&event, context);
+    }
+
+    reader_close(&reader);
+    fclose(f);
+    free(times);
+    return ok;
+}
+
+void history_display_timeline(int member_id) {
+    HistoryEvent *events = malloc(sizeof(HistoryEvent) * TIMELINE_MAX);
+    if (!events) {
+        printf("\nError: Not enough memory to show the history.\n");
+        return;
+    }
+
+    int count = history_timeline(member_id, events, TIMELINE_MAX);
+    if (count == 0) {
+        printf("\nNo subscription history for member ID %d.\n", member_id);
+        free(events);
+        return;
+    }
+
+    printf("\n--- Subscription History of Member ID %d ---\n", member_id);
+    if (count == TIMELINE_MAX) {
+        printf("(latest %d events)\n", TIMELINE_MAX);
+    }
+    for (int i = 0; i < count; i++) {
+        char date[32];
+        format_date(events[i].time, date, sizeof(date));
+        switch (events[i].type) {
+            case HISTORY_SUBSCRIBE:
+                printf("%s | Subscribed to Plan ID %d\n", date, events[i].plan_id);
+                break;
+            case HISTORY_EXPIRE:
+                printf("%s | Plan ID %d ended\n", date, events[i].plan_id);
+                break;
+            default:
+                printf("%s | Account deleted while on Plan ID %d\n", date, events[i].plan_id);
+        }
+    }
+    printf("\n");
+    free(events);
+}
+
+void history_display_churn() {
+    ChurnReport report;
+    char path[256];
+    data_file_path(HISTORY_FILE, path, sizeof(path));
+    if (!history_churn(path, &report)) {
+        printf("\nError: Cannot read the subscription history.\n");
+        return;
+    }
+    if (report.count == 0) {
+        printf("\nNo subscription history yet.\n");
+        return;
+    }
+
+    printf("\n--- Churn Report (%lld events) ---\n", report.events);
+    printf("Month   |   New |  Back | Renew | Change | Ended | Active | Churn\n");
+
+    // Churn: subscriptions ended in the month per subscription at its start
+    int active = 0;
+    for (int i = 0; i < report.count; i++) {
+        const ChurnMonth *m = &report.months[i];
+        int at_start = active;
+        active += m->started + m->returned - m->ended;
+        printf("%04d-%02d | %5d | %5d | %5d | %6d | %5d | %6d | ", m->year, m->month,
+               m->started, m->returned, m->renewed, m->changed, m->ended, active);
+        if (at_start > 0) {
+            printf("%4.1f%%\n", m->ended * 100.0 / at_start);
+        } else {
+            printf("  -\n");
+        }
+    }
+    printf("\n");
+    free(report.months);
+}
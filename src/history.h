@@ -0,0 +1,81 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdio.h>
+#include "member.h"
+
+#define HISTORY_FILE "data/history.log"
+
+// Event types
+#define HISTORY_SUBSCRIBE 1   // subscribed, renewed or changed plan
+#define HISTORY_EXPIRE    2   // the subscription ran out
+#define HISTORY_DELETE    3   // the member was deleted while subscribed
+
+// Longest encoded record in bytes
+#define HISTORY_MAX_RECORD 32
+
+// The history is an append-only log of subscription events. Each record is
+// a few varints, encoded against the same member's previous record:
+//   member ID | bytes back to that record (0 for the first) |
+//   seconds since it (zigzag) | type byte | plan ID (zigzag)
+// A record is about 10 bytes. Only the last record of each member is kept in
+// memory, and a member's timeline is read by following the chain backwards.
+
+// One decoded event
+typedef struct {
+    long long time;           // seconds since 1970
+    int member_id;
+    int type;                 // HISTORY_*
+    int plan_id;
+} HistoryEvent;
+
+// Subscription movements of one calendar month
+typedef struct {
+    int year;
+    int month;                // 1-12
+    int started;              // first subscription of a member
+    int returned;             // subscribed again after one ended
+    int renewed;              // same plan again while subscribed
+    int changed;              // another plan while subscribed
+    int ended;                // expired or deleted while subscribed
+} ChurnMonth;
+
+typedef struct {
+    ChurnMonth *months;       // in calendar order, without gaps
+    int count;
+    long long events;
+} ChurnReport;
+
+// Function declarations
+
+// Open the history log, reading it once to find each member's last record.
+// If the log is new, the subscriptions running now are recorded first so
+// the history starts complete. Returns the number of events, -1 on error.
+int history_start(const char *path, const Table *members);
+
+// Close the history log
+void history_stop();
+
+// Append an event. In --shared mode call it while holding the edit lock:
+// records appended by other processes are read first, so every member's
+// chain stays whole. Returns 1 if written.
+int history_record(int member_id, int type, int plan_id, long long time);
+
+// A member's events, oldest first: the latest max of them are stored in
+// events. O(events of that member). Returns how many were stored.
+int history_timeline(int member_id, HistoryEvent *events, int max);
+
+// Stream a history file into monthly churn figures, holding only one
+// state per member in memory. The caller frees report->months.
+// Returns 1 if the file was read.
+int history_churn(const char *path, ChurnReport *report);
+
+// Call visit for every event of a history file, oldest first, holding
+// only one time per member in memory. Returns 1 if the file was read.
+int history_scan(const char *path, void (*visit)(const HistoryEvent *event, void *context), void *context);
+
+// Admin views
+void history_display_timeline(int member_id);
+void history_display_churn();
+
+#endif
@@ -0,0 +1,540 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hot_reload.h"
+#include "autosave.h"
+#include "shared_tables.h"
+#include "plan_catalog.h"
+#include "audit.h"
+
+#ifdef __linux__
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+#define TABLE_COUNT 2
+
+// Slots compared at once when looking for changed records
+#define COMPARE_RUN 64
+
+// Records that changed in a file: entries of a flag for each side, the
+// record before and the record after (absent for an added / deleted one)
+typedef struct {
+    char *data;
+    int count;
+    int capacity;
+    size_t elem_size;
+} ChangeList;
+
+typedef struct {
+    char has_old;
+    char has_new;
+} ChangeFlags;
+
+typedef struct {
+    Table *live;               // the app's table (owner thread only)
+    char path[256];
+    char directory[256];
+    char file_name[128];
+    int watch;                 // inotify watch of the directory
+    Table baseline;            // what the file held at the last read (watcher thread only)
+    int changed;               // change events seen, file not read yet (watcher thread only)
+    ChangeList pending;        // changes found, not applied yet (under lock)
+} Watched;
+
+static Watched watched[TABLE_COUNT];
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t watcher_thread;
+static int notify_fd = -1;
+static int stop_pipe[2] = { -1, -1 };
+static HotReloadStatus status;
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static int record_id_of(const Table *t, const char *record) {
+    int id;
+    memcpy(&id, record + t->id_offset, sizeof(int));
+    return id;
+}
+
+static size_t entry_size(const ChangeList *list) {
+    return sizeof(ChangeFlags) + 2 * list->elem_size;
+}
+
+static int change_add(ChangeList *list, const void *old, const void *new_record) {
+    if (list->count == list->capacity) {
+        int capacity = list->capacity > 0 ? list->capacity * 2 : 16;
+        char *data = realloc(list->data, (size_t)capacity * entry_size(list));
+        if (!data) {
+            return 0;
+        }
+        list->data = data;
+        list->capacity = capacity;
+    }
+    char *entry = list->data + (size_t)list->count * entry_size(list);
+    ChangeFlags flags = { old != NULL, new_record != NULL };
+    memcpy(entry, &flags, sizeof(flags));
+    if (old) {
+        memcpy(entry + sizeof(flags), old, list->elem_size);
+    }
+    if (new_record) {
+        memcpy(entry + sizeof(flags) + list->elem_size, new_record, list->elem_size);
+    }
+    list->count++;
+    return 1;
+}
+
+// Move the entries of more to the end of list (more is emptied)
+static int change_append_list(ChangeList *list, ChangeList *more) {
+    if (list->count == 0) {
+        free(list->data);
+        *list = *more;
+    } else {
+        for (int i = 0; i < more->count; i++) {
+            const char *entry = more->data + (size_t)i * entry_size(more);
+            ChangeFlags flags;
+            memcpy(&flags, entry, sizeof(flags));
+            if (!change_add(list, flags.has_old ? entry + sizeof(flags) : NULL,
+                            flags.has_new ? entry + sizeof(flags) + more->elem_size : NULL)) {
+                return 0;
+            }
+        }
+        free(more->data);
+    }
+    more->data = NULL;
+    more->count = 0;
+    more->capacity = 0;
+    return 1;
+}
+
+// Records of after that are new or differ from before, then the records of
+// before that after no longer has. Returns 0 if memory ran out.
+static int diff_tables(const Table *before, const Table *after, ChangeList *out) {
+    int matched = 0;  // records of before found in after
+
+    for (int i = 0; i < after->count; i++) {
+        // A file read again usually has its records in the same slots
+        if (i % COMPARE_RUN == 0) {
+            int run = after->count - i < COMPARE_RUN ? after->count - i : COMPARE_RUN;
+            if (table_same_slots(after, before, i, run)) {
+                for (int k = i; k < i + run; k++) {
+                    matched += table_is_live(after, k);
+                }
+                i += run - 1;
+                continue;
+            }
+        }
+        if (!table_is_live(after, i)) {
+            continue;
+        }
+        const char *record = table_at(after, i);
+        int id = record_id_of(after, record);
+
+        const char *old;
+        if (i < before->count && table_is_live(before, i) && record_id_of(before, table_at(before, i)) == id) {
+            old = table_at(before, i);
+        } else {
+            old = table_find(before, id);
+        }
+        if (old) {
+            matched++;
+            if (memcmp(old, record, after->elem_size) == 0) {
+                continue;
+            }
+        }
+        if (!change_add(out, old, record)) {
+            return 0;
+        }
+    }
+
+    if (matched < before->live_count) {
+        for (int i = 0; i < before->count; i++) {
+            if (table_is_live(before, i) && !table_find(after, record_id_of(before, table_at(before, i))) &&
+                !change_add(out, table_at(before, i), NULL)) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+// Whether two records are written as the same line (lines: room for two;
+// a formatted line ends in '\n', not '\0')
+static int same_line(const TableCodec *codec, const void *a, const void *b, char *lines) {
+    char *other = lines + codec->max_line;
+    int length = codec->format(a, lines, codec->max_line);
+    return length == codec->format(b, other, codec->max_line) && memcmp(lines, other, length) == 0;
+}
+
+// Drop the records the file now holds just as this process last saved
+// them: the app's own edits, not another program's, even if the record has
+// been edited again here since. Compared as written to the file, where
+// bytes after the end of a name never get. (A deletion made here needs no
+// check: the record is gone on both sides.)
+static void drop_own_writes(const Watched *w, ChangeList *list) {
+    const TableCodec *codec = w->baseline.codec;
+    Table saved;
+    table_init(&saved, w->baseline.elem_size, w->baseline.id_offset, codec);
+    char *lines = malloc(2 * codec->max_line);
+    if (!lines || !autosave_copy_saved(w->path, &saved)) {
+        free(lines);
+        table_free(&saved);
+        return;
+    }
+
+    int kept = 0;
+    for (int i = 0; i < list->count; i++) {
+        char *entry = list->data + (size_t)i * entry_size(list);
+        ChangeFlags flags;
+        memcpy(&flags, entry, sizeof(flags));
+        if (flags.has_new) {
+            const char *new_record = entry + sizeof(flags) + list->elem_size;
+            const char *mine = table_find(&saved, record_id_of(&saved, new_record));
+            if (mine && same_line(codec, mine, new_record, lines)) {
+                continue;
+            }
+        }
+        if (kept != i) {
+            memcpy(list->data + (size_t)kept * entry_size(list), entry, entry_size(list));
+        }
+        kept++;
+    }
+    list->count = kept;
+    free(lines);
+    table_free(&saved);
+}
+
+// Read the file of w again and queue what changed since the last read
+static void reload(Watched *w) {
+    double start = now_ms();
+    Table fresh;
+    table_init(&fresh, w->baseline.elem_size, w->baseline.id_offset, w->baseline.codec);
+    int loaded = table_load(&fresh, w->path);
+    if (loaded < 0) {
+        // Being replaced, or not a valid file: keep what was there
+        table_free(&fresh);
+        pthread_mutex_lock(&lock);
+        status.errors++;
+        pthread_mutex_unlock(&lock);
+        return;
+    }
+
+    ChangeList changes = { NULL, 0, 0, fresh.elem_size };
+    int ok = diff_tables(&w->baseline, &fresh, &changes);
+    if (ok) {
+        drop_own_writes(w, &changes);
+    }
+    double elapsed = now_ms() - start;
+
+    pthread_mutex_lock(&lock);
+    ok = ok && change_append_list(&w->pending, &changes);
+    status.reloads++;
+    status.last_parse_ms = elapsed;
+    if (!ok) {
+        status.errors++;
+    }
+    pthread_mutex_unlock(&lock);
+    free(changes.data);
+
+    if (ok) {
+        table_free(&w->baseline);
+        w->baseline = fresh;
+    } else {
+        table_free(&fresh);  // Compared again with the old contents next time
+    }
+}
+
+static void read_events() {
+    union {
+        struct inotify_event event;
+        char bytes[4096];
+    } buffer;
+
+    ssize_t length;
+    while ((length = read(notify_fd, buffer.bytes, sizeof(buffer.bytes))) > 0) {
+        for (char *p = buffer.bytes; p < buffer.bytes + length;) {
+            const struct inotify_event *event = (const struct inotify_event *)p;
+            for (int t = 0; t < TABLE_COUNT; t++) {
+                Watched *w = &watched[t];
+                // Events were lost: read both files
+                if ((event->mask & IN_Q_OVERFLOW) ||
+                    (event->wd == w->watch && event->len > 0 && strcmp(event->name, w->file_name) == 0)) {
+                    w->changed = 1;
+                }
+            }
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+}
+
+static void *watcher_main(void *arg) {
+    (void)arg;
+    struct pollfd fds[2];
+    fds[0].fd = notify_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = stop_pipe[0];
+    fds[1].events = POLLIN;
+
+    for (;;) {
+        int waiting = 0;
+        for (int t = 0; t < TABLE_COUNT; t++) {
+            waiting |= watched[t].changed;
+        }
+        int ready = poll(fds, 2, waiting ? HOT_RELOAD_SETTLE_MS : -1);
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready < 0 || (fds[1].revents & POLLIN)) {
+            break;
+        }
+        if (ready > 0) {
+            // More events: wait until the file has been quiet for a moment
+            read_events();
+            continue;
+        }
+        for (int t = 0; t < TABLE_COUNT; t++) {
+            if (watched[t].changed) {
+                watched[t].changed = 0;
+                reload(&watched[t]);
+            }
+        }
+    }
+    return NULL;
+}
+
+static void split_path(const char *path, Watched *w) {
+    const char *slash = strrchr(path, '/');
+    if (slash) {
+        snprintf(w->directory, sizeof(w->directory), "%.*s", (int)(slash - path), path);
+        snprintf(w->file_name, sizeof(w->file_name), "%s", slash + 1);
+    } else {
+        snprintf(w->directory, sizeof(w->directory), ".");
+        snprintf(w->file_name, sizeof(w->file_name), "%s", path);
+    }
+}
+
+static void close_watch() {
+    if (notify_fd != -1) {
+        close(notify_fd);
+        notify_fd = -1;
+    }
+    for (int i = 0; i < 2; i++) {
+        if (stop_pipe[i] != -1) {
+            close(stop_pipe[i]);
+            stop_pipe[i] = -1;
+        }
+    }
+}
+
+int hot_reload_start(Table *plans, Table *equipment) {
+    if (status.running) {
+        return 1;
+    }
+    Table *tables[TABLE_COUNT] = { plans, equipment };
+
+    notify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (notify_fd == -1 || pipe(stop_pipe) != 0) {
+        close_watch();
+        return 0;
+    }
+
+    for (int t = 0; t < TABLE_COUNT; t++) {
+        Watched *w = &watched[t];
+        memset(w, 0, sizeof(*w));
+        w->live = tables[t];
+        snprintf(w->path, sizeof(w->path), "%s", tables[t]->path);
+        split_path(w->path, w);
+
+        // Files are replaced by a rename when saved, so the folder is
+        // watched, not the file itself
+        w->watch = inotify_add_watch(notify_fd, w->directory, IN_CLOSE_WRITE | IN_MOVED_TO);
+
+        // Watched first, then read: a change made in between is not missed
+        table_init(&w->baseline, tables[t]->elem_size, tables[t]->id_offset, tables[t]->codec);
+        table_load(&w->baseline, w->path);
+        w->pending.elem_size = tables[t]->elem_size;
+    }
+
+    if (pthread_create(&watcher_thread, NULL, watcher_main, NULL) != 0) {
+        for (int t = 0; t < TABLE_COUNT; t++) {
+            table_free(&watched[t].baseline);
+        }
+        close_watch();
+        return 0;
+    }
+    status.running = 1;
+    return 1;
+}
+
+// Apply one table's changes, merging with edits made in the app: a change
+// is applied only where the app's record is still what the file held
+// before. Records are compared as written to the file (see same_line).
+// Returns the number of records changed, -1 if out of memory.
+static int apply_changes(Table *t, const ChangeList *list, long long *conflicts) {
+    char *lines = malloc(2 * t->codec->max_line);
+    if (!lines) {
+        return -1;
+    }
+
+    int changed = 0;
+    for (int i = 0; i < list->count; i++) {
+        const char *entry = list->data + (size_t)i * entry_size(list);
+        ChangeFlags flags;
+        memcpy(&flags, entry, sizeof(flags));
+        const char *old = flags.has_old ? entry + sizeof(flags) : NULL;
+        const char *new_record = flags.has_new ? entry + sizeof(flags) + list->elem_size : NULL;
+        int id = record_id_of(t, new_record ? new_record : old);
+
+        char *live = table_find(t, id);
+        if (new_record && live && same_line(t->codec, live, new_record, lines)) {
+            continue;  // Already the same, e.g. the app's own save
+        }
+        if (!live && !new_record) {
+            continue;  // Deleted on both sides
+        }
+        if ((live && (!old || !same_line(t->codec, live, old, lines))) || (!live && old)) {
+            (*conflicts)++;  // Edited (or deleted) in the app too: the app's version stays
+            continue;
+        }
+
+        if (!new_record) {
+            table_remove(t, id);
+        } else if (live) {
+            // Same ID, same slot: the index needs no change
+            memcpy(live, new_record, t->elem_size);
+            table_touch_record(t, id);
+        } else if (!table_append(t, new_record)) {
+            continue;
+        }
+        changed++;
+    }
+    free(lines);
+    return changed;
+}
+
+int hot_reload_apply() {
+    if (!status.running) {
+        return 0;
+    }
+
+    int total = 0;
+    for (int t = 0; t < TABLE_COUNT; t++) {
+        Watched *w = &watched[t];
+
+        pthread_mutex_lock(&lock);
+        ChangeList list = w->pending;
+        w->pending.data = NULL;
+        w->pending.count = 0;
+        w->pending.capacity = 0;
+        pthread_mutex_unlock(&lock);
+
+        if (list.count == 0) {
+            free(list.data);
+            continue;
+        }
+
+        long long conflicts = 0;
+        shared_tables_begin_edit();
+        int was_saved = !table_is_dirty(w->live);
+        int changed = apply_changes(w->live, &list, &conflicts);
+        shared_tables_end_edit();
+        if (changed < 0) {
+            // Out of memory: kept for the next call, ahead of newer changes
+            pthread_mutex_lock(&lock);
+            if (change_append_list(&list, &w->pending)) {
+                w->pending = list;
+                list.data = NULL;
+            } else {
+                status.errors++;
+            }
+            pthread_mutex_unlock(&lock);
+            free(list.data);
+            continue;
+        }
+        free(list.data);
+
+        if (changed > 0) {
+            if (w->live == watched[0].live) {
+                plan_catalog_publish(w->live);
+            }
+            // The table now matches the file: sent to a standby, not written back
+            if (was_saved && conflicts == 0) {
+                w->live->saved_version = w->live->version;
+            }
+            autosave_table(w->live);
+            printf("\n[RELOADED] %s: %d record(s) changed by another program.\n", w->file_name, changed);
+            char detail[AUDIT_DETAIL_SIZE];
+            snprintf(detail, sizeof(detail), "%.20s: %d records", w->file_name, changed);
+            audit_record(AUDIT_OUTSIDE, AUDIT_FILE_RELOAD, 0, detail);
+        }
+        if (conflicts > 0) {
+            printf("\n[RELOADED] %s: %lld change(s) not applied over edits made here.\n", w->file_name, conflicts);
+        }
+
+        pthread_mutex_lock(&lock);
+        status.records_changed += changed;
+        status.conflicts += conflicts;
+        pthread_mutex_unlock(&lock);
+        total += changed;
+    }
+    return total;
+}
+
+void hot_reload_stop() {
+    if (!status.running) {
+        return;
+    }
+    char byte = 1;
+    ssize_t written = write(stop_pipe[1], &byte, 1);
+    (void)written;
+    pthread_join(watcher_thread, NULL);
+
+    for (int t = 0; t < TABLE_COUNT; t++) {
+        table_free(&watched[t].baseline);
+        free(watched[t].pending.data);
+        watched[t].pending.data = NULL;
+        watched[t].pending.count = 0;
+        watched[t].pending.capacity = 0;
+    }
+    close_watch();
+    status.running = 0;
+}
+
+void hot_reload_status(HotReloadStatus *out) {
+    pthread_mutex_lock(&lock);
+    *out = status;
+    pthread_mutex_unlock(&lock);
+}
+
+#else
+
+// inotify is Linux only; elsewhere the files are read at startup only
+
+int hot_reload_start(Table *plans, Table *equipment) {
+    (void)plans;
+    (void)equipment;
+    return 0;
+}
+
+int hot_reload_apply() {
+    return 0;
+}
+
+void hot_reload_stop() {
+}
+
+void hot_reload_status(HotReloadStatus *out) {
+    memset(out, 0, sizeof(*out));
+}
+
+#endif
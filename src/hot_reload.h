@@ -0,0 +1,47 @@
+#ifndef HOT_RELOAD_H
+#define HOT_RELOAD_H
+
+#include "table.h"
+
+// Picks up changes other programs make to the plans and equipment files
+// while the app runs. A background thread waits for the files to change
+// (inotify on Linux), parses the changed file and compares it record by
+// record with what the file held before. The menus then apply only the
+// records that changed to the live table, in one step: records that did
+// not change, and the table's ID index, are kept as they are.
+//
+// A record also edited in the app since the file last held it is a
+// conflict: the app's version is kept (and saved over the file's). The
+// app's own saves are recognised and never count as a conflict.
+
+// Quiet time after the last change event before the file is read, so a
+// file still being written is not read half-way (milliseconds)
+#define HOT_RELOAD_SETTLE_MS 100
+
+typedef struct {
+    int running;                   // 1 while the watcher thread runs
+    long long reloads;             // files read again after a change
+    long long records_changed;     // records updated, added or deleted in the tables
+    long long conflicts;           // file changes not applied over an edit made in the app
+    long long errors;              // files that could not be read
+    double last_parse_ms;          // reading and comparing the last file changed
+} HotReloadStatus;
+
+// Function declarations
+
+// Start watching the data files of the plans and equipment tables
+// (returns 1 if watching, 0 if not supported or failed)
+int hot_reload_start(Table *plans, Table *equipment);
+
+// Apply the changes found in the files since the last call; call from the
+// thread that owns the tables, outside of an edit. Returns the number of
+// records changed (0 if nothing was waiting).
+int hot_reload_apply();
+
+// Stop the watcher thread and drop the changes not applied
+void hot_reload_stop();
+
+// Counters since the start
+void hot_reload_status(HotReloadStatus *status);
+
+#endif
@@ -0,0 +1,685 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <pthread.h>
+#include "import.h"
+#include "plans.h"
+#include "plan_catalog.h"
+#include "shared_tables.h"
+#include "history.h"
+#include "autosave.h"
+#include "branches.h"
+#include "password.h"
+#include "username_filter.h"
+#include "audit.h"
+#include "popularity.h"
+#include "utils.h"
+
+// Files smaller than this are parsed by the calling thread alone
+#define PARALLEL_MIN_BYTES 65536
+
+// Why a row was refused (ROW_OK: it was not)
+#define ROW_OK            0
+#define ROW_HEADER        1   // the header line, skipped silently
+#define ROW_MALFORMED     2
+#define ROW_FIELD_COUNT   3
+#define ROW_EMPTY_FIELD   4
+#define ROW_TOO_LONG      5
+#define ROW_BAD_CHARACTER 6
+#define ROW_BAD_PLAN      7
+#define ROW_UNKNOWN_PLAN  8
+#define ROW_DUPLICATE     9
+#define ROW_EXISTS        10
+#define ROW_NO_MEMORY     11
+#define ROW_OTHER_BRANCH  12
+
+static const char *reason_texts[] = {
+    "ok", "header", "unbalanced quotes", "expected 3 or 4 fields", "empty name, username or password",
+    "field too long", "field contains '|' (or a quote in the username)", "plan ID is not a number",
+    "no plan with this ID", "username repeats an earlier row", "username already exists",
+    "out of memory", "username used at another branch"
+};
+
+// A field of a row: where it is in the file, as written
+typedef struct {
+    int start;
+    int length;
+    int quoted;            // "" inside stands for one quote
+} Span;
+
+// One data row, parsed by a worker
+typedef struct {
+    int text;              // offset of the line in the file
+    int text_length;
+    int line;              // line number
+    unsigned hash;         // of the username
+    int plan_id;           // -1 if the row has none
+    int duplicate_of;      // line of the earlier row with the same username
+    Span name;
+    Span username;
+    Span password;
+    int hashed;            // index of the password's hash request, -1 if already a hash
+    int reason;            // ROW_*
+} Row;
+
+// The part of the file one worker parses, cut at line ends
+typedef struct {
+    const char *data;      // the whole file
+    int begin;
+    int end;
+    int first_chunk;
+    Row *rows;
+    int count;
+    int capacity;
+    int lines;             // lines seen, empty ones included
+    int failed;            // out of memory
+} Chunk;
+
+// Username set entry: ref > 0 is row ref - 1, ref < 0 is member slot -ref - 1
+typedef struct {
+    unsigned hash;
+    int ref;
+} SetEntry;
+
+static unsigned hash_text(const char *text, int length) {
+    // FNV-1a
+    unsigned hash = 2166136261u;
+    for (int i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)text[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Parse one field starting at *p. Returns 2 if a ',' follows, 1 at the end
+// of the line, 0 if the quotes do not match.
+static int parse_field(const char *data, const char **p, const char *end, Span *span) {
+    const char *s = *p;
+
+    if (s < end && *s == '"') {
+        const char *q = s + 1;
+        while (1) {
+            while (q < end && *q != '"') {
+                q++;
+            }
+            if (q >= end) {
+                return 0;
+            }
+            if (q + 1 < end && q[1] == '"') {
+                q += 2;  // An escaped quote
+                continue;
+            }
+            break;
+        }
+        span->start = (int)(s + 1 - data);
+        span->length = (int)(q - s - 1);
+        span->quoted = 1;
+        s = q + 1;
+        if (s < end && *s != ',') {
+            return 0;
+        }
+    } else {
+        const char *q = s;
+        while (q < end && *q != ',') {
+            if (*q == '"') {
+                return 0;
+            }
+            q++;
+        }
+        span->start = (int)(s - data);
+        span->length = (int)(q - s);
+        span->quoted = 0;
+        s = q;
+    }
+
+    if (s < end) {
+        *p = s + 1;
+        return 2;
+    }
+    *p = s;
+    return 1;
+}
+
+// Length of a field once "" is turned into "
+static int field_length(const char *data, const Span *span) {
+    int length = span->length;
+    if (span->quoted) {
+        for (int i = 0; i + 1 < span->length; i++) {
+            if (data[span->start + i] == '"') {
+                length--;
+                i++;
+            }
+        }
+    }
+    return length;
+}
+
+static void copy_field(char *out, const char *data, const Span *span) {
+    const char *s = data + span->start;
+    int n = 0;
+    for (int i = 0; i < span->length; i++) {
+        out[n++] = s[i];
+        if (span->quoted && s[i] == '"') {
+            i++;  // Skip the second quote of ""
+        }
+    }
+    out[n] = '\0';
+}
+
+static int check_text(const char *data, const Span *span, int size, int is_username) {
+    int length = field_length(data, span);
+    if (length == 0) {
+        return ROW_EMPTY_FIELD;
+    }
+    if (length >= size) {
+        return ROW_TOO_LONG;
+    }
+    for (int i = 0; i < span->length; i++) {
+        char c = data[span->start + i];
+        if (c == '|' || (is_username && c == '"')) {
+            return ROW_BAD_CHARACTER;
+        }
+    }
+    return ROW_OK;
+}
+
+static int parse_plan(const char *data, const Span *span, int *plan_id) {
+    const char *s = data + span->start;
+    int value = 0;
+
+    if (span->length == 0) {
+        *plan_id = -1;
+        return 1;
+    }
+    for (int i = 0; i < span->length; i++) {
+        if (s[i] < '0' || s[i] > '9' || value > (INT_MAX - 9) / 10) {
+            return 0;
+        }
+        value = value * 10 + (s[i] - '0');
+    }
+    *plan_id = value;
+    return 1;
+}
+
+static void parse_row(Chunk *chunk, Row *row, const char *line, const char *end) {
+    const char *data = chunk->data;
+    Span fields[5];
+    int count = 0, more = 2;
+
+    row->reason = ROW_OK;
+    row->plan_id = -1;
+    row->hash = 0;
+    while (more == 2) {
+        Span span;
+        more = parse_field(data, &line, end, &span);
+        if (more == 0) {
+            row->reason = ROW_MALFORMED;
+            return;
+        }
+        if (count < 5) {
+            fields[count] = span;
+        }
+        count++;
+    }
+    if (count < 3 || count > 4) {
+        row->reason = ROW_FIELD_COUNT;
+        return;
+    }
+
+    row->name = fields[0];
+    row->username = fields[1];
+    row->password = fields[2];
+
+    // A first line naming the columns is a header
+    if (chunk->first_chunk && chunk->count == 0 && row->username.length == 8 &&
+        strncmp(data + row->username.start, "username", 8) == 0) {
+        row->reason = ROW_HEADER;
+        return;
+    }
+
+    int reason = check_text(data, &row->name, sizeof(((Member *)0)->name), 0);
+    if (reason == ROW_OK) {
+        reason = check_text(data, &row->username, sizeof(((Member *)0)->username), 1);
+    }
+    if (reason == ROW_OK) {
+        reason = check_text(data, &row->password, sizeof(((Member *)0)->password), 0);
+    }
+    if (reason == ROW_OK && count == 4 && !parse_plan(data, &fields[3], &row->plan_id)) {
+        reason = ROW_BAD_PLAN;
+    }
+    row->reason = reason;
+
+    // Hashed here, in parallel; the set is filled in file order later
+    row->hash = hash_text(data + row->username.start, row->username.length);
+}
+
+static void *parse_chunk(void *arg) {
+    Chunk *chunk = arg;
+    const char *p = chunk->data + chunk->begin;
+    const char *end = chunk->data + chunk->end;
+
+    while (p < end) {
+        const char *newline = memchr(p, '\n', end - p);
+        const char *line_end = newline ? newline : end;
+        const char *next = newline ? newline + 1 : end;
+        if (line_end > p && line_end[-1] == '\r') {
+            line_end--;
+        }
+        chunk->lines++;
+
+        if (line_end == p) {
+            p = next;
+            continue;  // Empty line
+        }
+
+        if (chunk->count == chunk->capacity) {
+            int capacity = chunk->capacity > 0 ? chunk->capacity * 2 : 1024;
+            Row *rows = realloc(chunk->rows, sizeof(Row) * capacity);
+            if (!rows) {
+                chunk->failed = 1;
+                return NULL;
+            }
+            chunk->rows = rows;
+            chunk->capacity = capacity;
+        }
+
+        Row *row = &chunk->rows[chunk->count];
+        row->text = (int)(p - chunk->data);
+        row->text_length = (int)(line_end - p);
+        row->line = chunk->lines;
+        row->duplicate_of = 0;
+        parse_row(chunk, row, p, line_end);
+        chunk->count++;
+
+        p = next;
+    }
+    return NULL;
+}
+
+static char *read_whole_file(const char *path, int *length) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return NULL;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (size < 0 || size >= INT_MAX) {
+        fclose(f);
+        return NULL;
+    }
+
+    char *data = malloc((size_t)size + 1);
+    if (!data) {
+        fclose(f);
+        return NULL;
+    }
+    if (fread(data, 1, (size_t)size, f) != (size_t)size) {
+        free(data);
+        fclose(f);
+        return NULL;
+    }
+    fclose(f);
+
+    data[size] = '\0';
+    *length = (int)size;
+    return data;
+}
+
+// Username of a set entry
+static void entry_username(const SetEntry *entry, const Row *rows, const Table *members, const char *data,
+                           const char **text, int *length) {
+    if (entry->ref > 0) {
+        const Row *row = &rows[entry->ref - 1];
+        *text = data + row->username.start;
+        *length = row->username.length;
+    } else {
+        *text = member_at(members, -entry->ref - 1)->username;
+        *length = (int)strlen(*text);
+    }
+}
+
+// Find a username in the set; if absent, add ref and return 0
+static int set_find_or_add(SetEntry *set, unsigned mask, unsigned hash, const char *text, int length, int ref,
+                           const Row *rows, const Table *members, const char *data) {
+    unsigned slot = hash & mask;
+    while (set[slot].ref != 0) {
+        if (set[slot].hash == hash) {
+            const char *other;
+            int other_length;
+            entry_username(&set[slot], rows, members, data, &other, &other_length);
+            if (other_length == length && memcmp(other, text, length) == 0) {
+                return set[slot].ref;
+            }
+        }
+        slot = (slot + 1) & mask;
+    }
+    set[slot].hash = hash;
+    set[slot].ref = ref;
+    return 0;
+}
+
+static void write_rejects(const char *path, const Row *rows, int count, const char *data) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        printf("Warning: Cannot write %s.\n", path);
+        return;
+    }
+    setvbuf(f, NULL, _IOFBF, 1 << 20);
+
+    fprintf(f, "line,reason,row\n");
+    for (int i = 0; i < count; i++) {
+        const Row *row = &rows[i];
+        if (row->reason == ROW_OK || row->reason == ROW_HEADER) {
+            continue;
+        }
+        fprintf(f, "%d,\"%s", row->line, reason_texts[row->reason]);
+        if (row->reason == ROW_DUPLICATE) {
+            fprintf(f, " (line %d)", row->duplicate_of);
+        }
+        fputs("\",\"", f);
+        // The row as it was, quoted
+        const char *text = data + row->text;
+        for (int c = 0; c < row->text_length; c++) {
+            if (text[c] == '"') {
+                fputc('"', f);
+            }
+            fputc(text[c], f);
+        }
+        fputs("\"\n", f);
+    }
+    fclose(f);
+}
+
+int import_members_csv(Table *members, const char *csv_path, const char *rejects_path,
+                       int threads, ImportSummary *summary) {
+    memset(summary, 0, sizeof(ImportSummary));
+
+    int length;
+    char *data = read_whole_file(csv_path, &length);
+    if (!data) {
+        return 0;
+    }
+
+    // Skip a UTF-8 byte order mark
+    int start = (length >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0) ? 3 : 0;
+
+    if (threads < 1 || length < PARALLEL_MIN_BYTES) {
+        threads = 1;
+    }
+    if (threads > IMPORT_MAX_THREADS) {
+        threads = IMPORT_MAX_THREADS;
+    }
+
+    // Cut the file into one chunk per thread, at line ends
+    Chunk chunks[IMPORT_MAX_THREADS];
+    memset(chunks, 0, sizeof(chunks));
+    int cut = start;
+    for (int c = 0; c < threads; c++) {
+        int end = c == threads - 1 ? length : start + (int)((long long)(length - start) * (c + 1) / threads);
+        while (end < length && end > 0 && data[end - 1] != '\n') {
+            end++;
+        }
+        if (end < cut) {
+            end = cut;
+        }
+        chunks[c].data = data;
+        chunks[c].begin = cut;
+        chunks[c].end = end;
+        chunks[c].first_chunk = (c == 0);
+        cut = end;
+    }
+
+    pthread_t workers[IMPORT_MAX_THREADS];
+    int started[IMPORT_MAX_THREADS];
+    for (int c = 1; c < threads; c++) {
+        started[c] = pthread_create(&workers[c], NULL, parse_chunk, &chunks[c]) == 0;
+    }
+    parse_chunk(&chunks[0]);
+    for (int c = 1; c < threads; c++) {
+        if (started[c]) {
+            pthread_join(workers[c], NULL);
+        } else {
+            parse_chunk(&chunks[c]);  // No thread available: parse it here
+        }
+    }
+
+    // Put the rows together in file order, with file line numbers
+    int total = 0, failed = 0;
+    for (int c = 0; c < threads; c++) {
+        total += chunks[c].count;
+        failed |= chunks[c].failed;
+    }
+    Row *rows = failed ? NULL : malloc(sizeof(Row) * (total > 0 ? total : 1));
+    int set_capacity = 16;
+    while (set_capacity < 2 * (members->live_count + total)) {
+        set_capacity *= 2;
+    }
+    SetEntry *set = rows ? calloc(set_capacity, sizeof(SetEntry)) : NULL;
+
+    int line_base = 0, n = 0;
+    for (int c = 0; c < threads; c++) {
+        for (int i = 0; rows && i < chunks[c].count; i++) {
+            rows[n] = chunks[c].rows[i];
+            rows[n].line += line_base;
+            n++;
+        }
+        line_base += chunks[c].lines;
+        free(chunks[c].rows);
+    }
+    if (!set) {
+        free(rows);
+        free(data);
+        return 0;
+    }
+
+    unsigned mask = (unsigned)set_capacity - 1;
+    for (int i = 0; i < members->count; i++) {
+        if (table_is_live(members, i)) {
+            const char *username = member_at(members, i)->username;
+            int username_length = (int)strlen(username);
+            set_find_or_add(set, mask, hash_text(username, username_length), username, username_length,
+                            -(i + 1), rows, members, data);
+        }
+    }
+
+    // One pass in file order: the first row with a username wins
+    int accepted = 0;
+    const PlanCatalog *catalog = plan_catalog_enter();
+    for (int i = 0; i < total; i++) {
+        Row *row = &rows[i];
+        if (row->reason == ROW_HEADER) {
+            continue;
+        }
+        summary->rows++;
+        if (row->reason != ROW_OK) {
+            continue;
+        }
+
+        if (row->plan_id != -1 && !plan_find(&catalog->plans, row->plan_id)) {
+            row->reason = ROW_UNKNOWN_PLAN;
+            continue;
+        }
+
+        int found = set_find_or_add(set, mask, row->hash, data + row->username.start, row->username.length,
+                                    i + 1, rows, members, data);
+        if (found > 0) {
+            row->reason = ROW_DUPLICATE;
+            row->duplicate_of = rows[found - 1].line;
+        } else if (found < 0) {
+            row->reason = ROW_EXISTS;
+        } else {
+            accepted++;
+        }
+    }
+    plan_catalog_exit();
+    free(set);
+
+    // Plain text passwords are hashed on the hashing threads, all queued at
+    // once; a password that is already a hash is stored as it is
+    PasswordRequest *hashes = accepted > 0 ? malloc(sizeof(PasswordRequest) * accepted) : NULL;
+    if (accepted > 0 && !hashes) {
+        free(rows);
+        free(data);
+        return 0;
+    }
+    for (int i = 0; i < total; i++) {
+        Row *row = &rows[i];
+        row->hashed = -1;
+        if (row->reason != ROW_OK) {
+            continue;
+        }
+        char password[PASSWORD_HASH_SIZE];
+        copy_field(password, data, &row->password);
+        if (strncmp(password, PASSWORD_SCHEME, strlen(PASSWORD_SCHEME)) != 0) {
+            row->hashed = summary->hashed++;
+            password_hash_async(&hashes[row->hashed], password, NULL, NULL);
+        }
+    }
+    for (int h = 0; h < summary->hashed; h++) {
+        password_wait(&hashes[h]);
+    }
+
+    // Only the appends are made under the edit lock, so other copies of the
+    // app are not kept waiting while the file is parsed and hashed. If one
+    // of them added members meanwhile, the usernames are checked again.
+    unsigned long checked_version = members->version;
+    shared_tables_begin_edit();
+    int refreshed = members->version != checked_version;
+
+    // Room for every new member at once, then IDs in one block
+    if (accepted > 0 && !table_reserve(members, members->count + accepted)) {
+        shared_tables_end_edit();
+        free(hashes);
+        free(rows);
+        free(data);
+        return 0;
+    }
+
+    long long now = time(NULL);
+    int next_id = table_next_id(members);
+    for (int i = 0; i < total; i++) {
+        Row *row = &rows[i];
+        if (row->reason != ROW_OK) {
+            continue;
+        }
+
+        Member member;
+        memset(&member, 0, sizeof(member));
+        member.id_member = next_id;
+        copy_field(member.name, data, &row->name);
+        copy_field(member.username, data, &row->username);
+        if (refreshed && username_filter_may_contain(members, member.username) &&
+            find_member_by_username(members, member.username) != -1) {
+            row->reason = ROW_EXISTS;
+            continue;
+        }
+        if (row->hashed == -1) {
+            copy_field(member.password, data, &row->password);
+        } else if (hashes[row->hashed].result) {
+            strcpy(member.password, hashes[row->hashed].hash);
+        } else {
+            row->reason = ROW_NO_MEMORY;
+            continue;
+        }
+        member.id_current_plan = row->plan_id;
+        if (row->plan_id != -1) {
+            member.subscription_start = now;
+            member.subscription_end = now + SUBSCRIPTION_DAYS * 24LL * 60 * 60;
+        }
+
+        if (!username_index_claim(member.username, get_current_branch(), member.id_member)) {
+            row->reason = ROW_OTHER_BRANCH;
+            continue;
+        }
+        if (!member_append(members, &member)) {
+            username_index_release(member.username);
+            row->reason = ROW_NO_MEMORY;
+            continue;
+        }
+        username_filter_track(members, member.username, 1);
+        if (row->plan_id != -1) {
+            history_record(member.id_member, HISTORY_SUBSCRIBE, row->plan_id, now);
+            popularity_record_subscription(row->plan_id, now);
+            summary->subscribed++;
+        }
+        if (summary->imported++ == 0) {
+            summary->first_id = next_id;
+        }
+        summary->last_id = next_id++;
+    }
+    shared_tables_end_edit();
+
+    summary->rejected = summary->rows - summary->imported;
+    if (rejects_path) {
+        if (summary->rejected > 0) {
+            write_rejects(rejects_path, rows, total, data);
+        } else {
+            remove(rejects_path);  // Do not leave the report of an older import
+        }
+    }
+
+    free(hashes);
+    free(rows);
+    free(data);
+    return 1;
+}
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+void import_members_interactive(Table *members) {
+    char path[256];
+
+    printf("\n--- Import Members from CSV ---\n");
+    printf("Columns: name,username,password[,plan_id] (one member per line,\n");
+    printf("an optional header line first, fields may be in double quotes)\n");
+    printf("CSV file path (or press Enter to cancel): ");
+    get_string_input(path, sizeof(path));
+    if (path[0] == '\0') {
+        return;
+    }
+
+    char rejects_path[256];
+    data_file_path(IMPORT_REJECTS_FILE, rejects_path, sizeof(rejects_path));
+
+    // Takes the edit lock itself, only while the members are added
+    double start = now_ms();
+    ImportSummary summary;
+    int ok = import_members_csv(members, path, rejects_path,
+                                online_cpu_count(IMPORT_MAX_THREADS), &summary);
+    double elapsed = now_ms() - start;
+
+    if (!ok) {
+        printf("\nError: Cannot read %s (or not enough memory to import it).\n", path);
+        return;
+    }
+
+    // One save for the whole import
+    if (summary.imported > 0) {
+        char detail[AUDIT_DETAIL_SIZE];
+        snprintf(detail, sizeof(detail), "%d members, IDs %d to %d", summary.imported, summary.first_id,
+                 summary.last_id);
+        audit_record(AUDIT_ADMIN, AUDIT_MEMBER_IMPORT, 0, detail);
+        autosave_table(members);
+    }
+
+    printf("\n[SUCCESS] Import finished in %.0f ms.\n", elapsed);
+    printf("Rows read: %d\n", summary.rows);
+    printf("Members imported: %d", summary.imported);
+    if (summary.imported > 0) {
+        printf(" (IDs %d to %d, %d with a plan)", summary.first_id, summary.last_id, summary.subscribed);
+    }
+    printf("\nPasswords hashed: %d\n", summary.hashed);
+    printf("Rows rejected: %d\n", summary.rejected);
+    if (summary.rejected > 0) {
+        printf("See %s for each rejected row and why.\n", rejects_path);
+    }
+}
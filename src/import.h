@@ -0,0 +1,49 @@
+#ifndef IMPORT_H
+#define IMPORT_H
+
+#include "member.h"
+
+// Most worker threads parsing one file
+#define IMPORT_MAX_THREADS 64
+
+// Where the admin import writes the rows it refused
+#define IMPORT_REJECTS_FILE "data/import_rejects.csv"
+
+// Totals of one import
+typedef struct {
+    int rows;              // data rows read (the header line not included)
+    int imported;          // members added
+    int rejected;          // rows refused, listed in the rejects file
+    int subscribed;        // imported members given the plan in their row
+    int hashed;            // plain text passwords hashed (the others were hashes already)
+    int first_id;          // IDs given out: first_id .. last_id (0 if none)
+    int last_id;
+} ImportSummary;
+
+// Function declarations
+
+// Import members from a CSV file with the columns
+//   name,username,password[,plan_id]
+// (an optional header line naming them comes first; fields may be quoted,
+// "" inside quotes is a quote, one row per line). The file is parsed in
+// chunks by up to threads worker threads. Usernames are checked against the
+// members already there and the earlier rows with one hash set, the rows
+// accepted get consecutive IDs and are appended in file order (when running
+// for a branch, each username is also claimed in the username index, so
+// names used at other branches are refused). Plain text passwords are
+// hashed on the hashing threads (see password.h); a password already
+// written as a hash is kept. The shared edit lock (see shared_tables.h) is
+// only taken to append the members, after parsing and hashing; usernames
+// added by another copy in the meantime are refused then. Nothing is saved:
+// the caller saves the table once.
+// Refused rows are written to rejects_path (if not NULL) as
+//   line,reason,row
+// Returns 1 if the file was read, 0 if it could not be read or memory ran out
+// (the table is then unchanged).
+int import_members_csv(Table *members, const char *csv_path, const char *rejects_path,
+                       int threads, ImportSummary *summary);
+
+// Admin screen: import a CSV file into the members table
+void import_members_interactive(Table *members);
+
+#endif
@@ -0,0 +1,368 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <stdatomic.h>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+#include "loans.h"
+#include "maintenance.h"
+#include "autosave.h"
+#include "shared_tables.h"
+#include "audit.h"
+#include "utils.h"
+
+#define PAGE_SIZE (1 << STOCK_PAGE_BITS)
+#define PAGE_MASK (PAGE_SIZE - 1)
+
+// One item's counter, alone on its cache line so threads working on
+// different items never slow each other down
+typedef struct {
+    _Alignas(64) atomic_int available;   // may go below 0 if the stock was lowered
+    int quantity;                        // stock already counted (syncing thread only)
+} StockCounter;
+
+static _Atomic(StockCounter *) pages[STOCK_MAX_PAGES];
+
+static int stock_ready = 0;
+static unsigned long synced_version = 0;
+static int highest_id = -1;
+
+// Version of the loans table the counters were last brought up to date with
+static unsigned long synced_loans_version = 0;
+
+// Text format of one loan, generated from LOAN_FIELDS
+SCHEMA_CODEC(loan, Loan, LOAN_FIELDS, "loan")
+
+static StockCounter *counter_of(int equipment_id, int create) {
+    int page = equipment_id >> STOCK_PAGE_BITS;
+    if (equipment_id < 0 || page >= STOCK_MAX_PAGES) {
+        return NULL;
+    }
+
+    // Only the syncing thread creates pages, other threads just see them appear
+    StockCounter *counters = atomic_load(&pages[page]);
+    if (!counters && create) {
+#ifdef _WIN32
+        counters = _aligned_malloc(sizeof(StockCounter) * PAGE_SIZE, 64);
+#else
+        counters = aligned_alloc(64, sizeof(StockCounter) * PAGE_SIZE);
+#endif
+        if (!counters) {
+            return NULL;
+        }
+        for (int i = 0; i < PAGE_SIZE; i++) {
+            atomic_init(&counters[i].available, 0);
+            counters[i].quantity = 0;
+        }
+        atomic_store(&pages[page], counters);
+    }
+    return counters ? &counters[equipment_id & PAGE_MASK] : NULL;
+}
+
+void equipment_stock_sync(const Table *equipment, const Table *loans) {
+    int equipment_changed = !stock_ready || equipment->version != synced_version;
+    int loans_changed = !stock_ready || loans->version != synced_loans_version;
+    if (!equipment_changed && !loans_changed) {
+        return;
+    }
+
+    // Apply each item's stock change as a difference, so units taken by
+    // other threads meanwhile are not lost. Deleted items go to 0.
+    int last = equipment->max_id > highest_id ? equipment->max_id : highest_id;
+    for (int id = 0; equipment_changed && id <= last; id++) {
+        const Equipment *item = equipment_find(equipment, id);
+        int quantity = item && item->quantity > 0 ? item->quantity : 0;
+
+        StockCounter *counter = counter_of(id, quantity != 0);
+        if (counter && counter->quantity != quantity) {
+            atomic_fetch_add(&counter->available, quantity - counter->quantity);
+            counter->quantity = quantity;
+        }
+    }
+
+    // Loans loaded, or changed by another copy of the app (--shared): count
+    // the units members have again
+    if (loans_changed) {
+        for (int id = 0; id <= last; id++) {
+            StockCounter *counter = counter_of(id, 0);
+            if (counter) {
+                atomic_store(&counter->available, counter->quantity);
+            }
+        }
+        for (int i = 0; i < loans->count; i++) {
+            if (table_is_live(loans, i)) {
+                int id = loan_at(loans, i)->id_equipment;
+                StockCounter *counter = counter_of(id, 1);
+                if (counter) {
+                    atomic_fetch_sub(&counter->available, 1);
+                    last = id > last ? id : last;
+                }
+            }
+        }
+    }
+
+    highest_id = last;
+    synced_version = equipment->version;
+    synced_loans_version = loans->version;
+    stock_ready = 1;
+}
+
+// A loan just made or returned here: the counters already have it
+static void loans_track(const Table *loans) {
+    if (synced_loans_version + 1 == loans->version) {
+        synced_loans_version = loans->version;
+    }
+}
+
+int equipment_reserve(int equipment_id) {
+    StockCounter *counter = counter_of(equipment_id, 0);
+    if (!counter) {
+        return 0;
+    }
+
+    // Take a unit only if one is left: a failed exchange means another
+    // thread got there first, so look at the new count and try again
+    int available = atomic_load_explicit(&counter->available, memory_order_relaxed);
+    while (available > 0) {
+        if (atomic_compare_exchange_weak_explicit(&counter->available, &available, available - 1,
+                                                  memory_order_acq_rel, memory_order_relaxed)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void equipment_release(int equipment_id) {
+    StockCounter *counter = counter_of(equipment_id, 0);
+    if (counter) {
+        atomic_fetch_add_explicit(&counter->available, 1, memory_order_release);
+    }
+}
+
+int equipment_available(int equipment_id) {
+    StockCounter *counter = counter_of(equipment_id, 0);
+    int available = counter ? atomic_load_explicit(&counter->available, memory_order_acquire) : 0;
+    return available > 0 ? available : 0;
+}
+
+int loan_checkout(Table *loans, int member_id, int equipment_id) {
+    if (!equipment_reserve(equipment_id)) {
+        return LOAN_UNAVAILABLE;
+    }
+
+    Loan loan;
+    loan.id_loan = table_next_id(loans);
+    loan.id_member = member_id;
+    loan.id_equipment = equipment_id;
+    loan.start = time(NULL);
+
+    if (!loan_append(loans, &loan)) {
+        equipment_release(equipment_id);
+        return LOAN_NO_MEMORY;
+    }
+    loans_track(loans);
+    return loan.id_loan;
+}
+
+int loan_return(Table *loans, int member_id, int loan_id) {
+    const Loan *loan = loan_find(loans, loan_id);
+    if (!loan || loan->id_member != member_id) {
+        return 0;
+    }
+
+    equipment_release(loan->id_equipment);
+    table_remove(loans, loan_id);
+    loans_track(loans);
+    return 1;
+}
+
+int loan_return_all(Table *loans, int member_id) {
+    // Collect the IDs first: removing can compact the table
+    int *ids = malloc(sizeof(int) * (loans->live_count > 0 ? loans->live_count : 1));
+    if (!ids) {
+        return 0;
+    }
+
+    int count = 0;
+    for (int i = 0; i < loans->count; i++) {
+        if (table_is_live(loans, i) && loan_at(loans, i)->id_member == member_id) {
+            ids[count++] = loan_at(loans, i)->id_loan;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        loan_return(loans, member_id, ids[i]);
+    }
+
+    free(ids);
+    return count;
+}
+
+void display_equipment_availability(const Table *equipment) {
+    if (equipment->live_count == 0) {
+        printf("\nNo equipment available.\n");
+        return;
+    }
+
+    printf("\n--- Equipment Availability ---\n");
+    for (int i = 0; i < equipment->count; i++) {
+        if (!table_is_live(equipment, i)) {
+            continue;
+        }
+        const Equipment *item = equipment_at(equipment, i);
+        printf("ID: %d | %s | Available: %d of %d\n", item->id_equipment, item->name,
+               equipment_available(item->id_equipment), item->quantity);
+    }
+    printf("\n");
+}
+
+// List a member's loans (returns how many there are)
+static int display_member_loans(int member_id, const Table *equipment, const Table *loans) {
+    int count = 0;
+
+    for (int i = 0; i < loans->count; i++) {
+        if (!table_is_live(loans, i)) {
+            continue;
+        }
+        const Loan *loan = loan_at(loans, i);
+        if (loan->id_member != member_id) {
+            continue;
+        }
+
+        if (count++ == 0) {
+            printf("\n--- My Equipment ---\n");
+        }
+        const Equipment *item = equipment_find(equipment, loan->id_equipment);
+        char date[32];
+        format_date(loan->start, date, sizeof(date));
+        printf("Loan ID: %d | %s | Since %s\n", loan->id_loan,
+               item ? item->name : "(removed equipment)", date);
+    }
+
+    if (count == 0) {
+        printf("\nYou have no equipment checked out.\n");
+    }
+    return count;
+}
+
+void member_equipment_menu(int member_id, Table *equipment, Table *loans) {
+    int choice;
+
+    do {
+        // Show stock changes made by the admin or other running copies
+        shared_tables_refresh();
+        equipment_stock_sync(equipment, loans);
+
+        print_header("EQUIPMENT");
+        printf("1 - View Availability\n");
+        printf("2 - Check Out Equipment\n");
+        printf("3 - My Equipment\n");
+        printf("4 - Return Equipment\n");
+        printf("0 - Back\n");
+        print_separator();
+        printf("Your choice: ");
+        choice = get_int_input();
+
+        switch (choice) {
+            case 1:
+                display_equipment_availability(equipment);
+                pause_screen();
+                break;
+
+            case 2: {
+                display_equipment_availability(equipment);
+                printf("Enter Equipment ID to check out (or 0 to cancel): ");
+                int equipment_id = get_int_input();
+                if (equipment_id == 0) {
+                    break;
+                }
+
+                // On the latest loans of every copy (--shared), so the last
+                // unit is never handed out twice
+                shared_tables_begin_edit();
+                equipment_stock_sync(equipment, loans);
+                int loan_id = loan_checkout(loans, member_id, equipment_id);
+                
+                // Each checkout counts towards the item's next service
+                int counted = loan_id > 0 && maintenance_record_use(equipment, equipment_id);
+                shared_tables_end_edit();
+                
+                if (loan_id == LOAN_UNAVAILABLE) {
+                    printf("\nSorry, no unit of this equipment is available right now.\n");
+                } else if (loan_id == LOAN_NO_MEMORY) {
+                    printf("\nError: Not enough memory to record the loan.\n");
+                } else {
+                    printf("\n[SUCCESS] Equipment checked out (Loan ID: %d).\n", loan_id);
+                    const Equipment *item = equipment_find(equipment, equipment_id);
+                    audit_record(member_id, AUDIT_LOAN_CHECKOUT, loan_id, item ? item->name : NULL);
+                    autosave_table(loans);
+                    if (counted) {
+                        autosave_table(equipment);
+                    }
+                }
+                pause_screen();
+                break;
+            }
+
+            case 3:
+                display_member_loans(member_id, equipment, loans);
+                pause_screen();
+                break;
+
+            case 4: {
+                if (display_member_loans(member_id, equipment, loans) == 0) {
+                    pause_screen();
+                    break;
+                }
+
+                printf("\nEnter Loan ID to return (or 0 to cancel): ");
+                int loan_id = get_int_input();
+                if (loan_id == 0) {
+                    break;
+                }
+
+                shared_tables_begin_edit();
+                equipment_stock_sync(equipment, loans);
+                int returned = loan_return(loans, member_id, loan_id);
+                shared_tables_end_edit();
+                
+                if (returned) {
+                    printf("\n[SUCCESS] Equipment returned. Thank you!\n");
+                    audit_record(member_id, AUDIT_LOAN_RETURN, loan_id, NULL);
+                    autosave_table(loans);
+                } else {
+                    printf("\nError: You have no loan with ID %d.\n", loan_id);
+                }
+                pause_screen();
+                break;
+            }
+
+            case 0:
+                break;
+
+            default:
+                printf("\nInvalid choice. Please try again.\n");
+                pause_screen();
+        }
+
+    } while (choice != 0);
+}
+
+int load_loans_from_file(Table *loans) {
+    char path[256];
+    data_file_path(LOANS_FILE, path, sizeof(path));
+    int count = table_load(loans, path);
+
+    if (count == TABLE_NO_FILE) {
+        printf("No loans file found. Starting with no equipment checked out.\n");
+        return 0;
+    }
+
+    if (count == TABLE_BAD_HEADER) {
+        printf("Error reading loans file.\n");
+        return 0;
+    }
+
+    printf("Loaded %d equipment loan(s) from file.\n", count);
+    return count;
+}
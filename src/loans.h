@@ -0,0 +1,76 @@
+#ifndef LOANS_H
+#define LOANS_H
+
+#include "table.h"
+#include "schema.h"
+#include "equipment.h"
+
+#define LOANS_FILE "data/loans.txt"
+
+// Stock counters are kept in pages of 64 items (one cache line each),
+// allocated on first use
+#define STOCK_PAGE_BITS 6
+#define STOCK_MAX_PAGES 16384
+
+// Results of a checkout
+#define LOAN_UNAVAILABLE -1   // every unit is in use (or the item does not exist)
+#define LOAN_NO_MEMORY   -2
+
+// Loan fields (equipment units checked out by members), in file order:
+// id|member_id|equipment_id|start
+#define LOAN_FIELDS(X)              \
+    X(INT,  id_loan,      0)        \
+    X(INT,  id_member,    0)        \
+    X(INT,  id_equipment, 0)        \
+    X(TIME, start,        0)        /* seconds since 1970 */
+
+// Loan structure
+typedef struct {
+    SCHEMA_STRUCT(LOAN_FIELDS)
+} Loan;
+
+// Loan table helpers: loan_table_init(), loan_at(), loan_find(), loan_append()
+TABLE_TYPE(loan, Loan, id_loan)
+
+// Function declarations
+
+// Make the stock counters match the equipment table. The first call sets
+// every counter to quantity minus the units on loan; later calls only add
+// the quantity changes made since, so they are safe while other threads
+// reserve. Loans changed other than by loan_checkout() / loan_return()
+// (e.g. by another copy, --shared) are counted again: no thread may
+// reserve meanwhile. Call from one thread at a time.
+void equipment_stock_sync(const Table *equipment, const Table *loans);
+
+// Take one unit of an item. Lock-free, any thread: never hands out more
+// units than the stock, however many threads ask at once.
+// Returns 1 if a unit was taken, 0 if none is available.
+int equipment_reserve(int equipment_id);
+
+// Give back one unit taken with equipment_reserve()
+void equipment_release(int equipment_id);
+
+// Units of an item available right now (O(1), any thread; 0 if unknown)
+int equipment_available(int equipment_id);
+
+// Check out one unit for a member and record the loan.
+// Returns the loan ID, LOAN_UNAVAILABLE or LOAN_NO_MEMORY.
+int loan_checkout(Table *loans, int member_id, int equipment_id);
+
+// Return a member's loan (returns 1 if successful, 0 if not their loan)
+int loan_return(Table *loans, int member_id, int loan_id);
+
+// Return every loan of a member, e.g. when the member is deleted.
+// Returns how many were returned.
+int loan_return_all(Table *loans, int member_id);
+
+// Display equipment with the units available right now
+void display_equipment_availability(const Table *equipment);
+
+// Member screen: check equipment out and return it
+void member_equipment_menu(int member_id, Table *equipment, Table *loans);
+
+// Load loans from file into an initialized table (returns number of loans)
+int load_loans_from_file(Table *loans);
+
+#endif
@@ -1,27 +1,169 @@
 #include <stdio.h>
+#include <string.h>
 #include "member.h"
 #include "admin.h"
 #include "plans.h"
 #include "equipment.h"
+#include "autosave.h"
+#include "shared_tables.h"
+#include "plan_catalog.h"
+#include "subscriptions.h"
+#include "access.h"
+#include "loans.h"
+#include "maintenance.h"
+#include "history.h"
+#include "classes.h"
+#include "checkin.h"
+#include "audit.h"
+#include "popularity.h"
+#include "export.h"
+#include "branches.h"
+#include "replication.h"
+#include "hot_reload.h"
+#include "password.h"
+#include "username_filter.h"
 #include "utils.h"
 
-int main() {
-    // Initialize arrays and counters
-    Plan plans[MAX_PLANS];
-    Equipment equipment[MAX_EQUIPMENT];
-    Member members[MAX_MEMBERS];
+int main(int argc, char *argv[]) {
+    // Initialize the tables (they grow as records are added)
+    Table plans, equipment, members, loans;
+    plan_table_init(&plans);
+    equipment_table_init(&equipment);
+    member_table_init(&members);
+    loan_table_init(&loans);
+    ClassSchedule schedule;
+    class_schedule_init(&schedule);
     
-    int plan_count = 0;
-    int equipment_count = 0;
-    int member_count = 0;
+    // "--branch <name>" runs on the data of one listed branch (data/<name>/),
+    // "--shared" lets several running copies work on the same live tables,
+    // "--export csv|jsonl [folder]" writes the export files and exits,
+    // "--replicate [socket]" sends every change to a standby, which is a
+    // copy started with "--standby [socket]" from its own folder
+    int shared = 0;
+    int export_format = -1;
+    const char *export_dir = NULL;
+    const char *replicate_socket = NULL;
+    const char *standby_socket = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--shared") == 0) {
+            shared = 1;
+        } else if (strcmp(argv[i], "--branch") == 0 && i + 1 < argc) {
+            i++;
+            // Only branches added in the admin menu: a mistyped name must
+            // not start a new, empty branch
+            if (!branch_exists(BRANCHES_FILE, argv[i])) {
+                printf("Unknown branch '%s'. Add it first in the admin menu (Branches).\n", argv[i]);
+                return 1;
+            }
+            // Its folder is made again if it went missing
+            if (!branch_create(BRANCHES_ROOT, BRANCHES_FILE, argv[i])) {
+                printf("Cannot open the folder of branch '%s'.\n", argv[i]);
+                return 1;
+            }
+            set_current_branch(argv[i]);
+        } else if (strcmp(argv[i], "--export") == 0 && i + 1 < argc) {
+            export_format = strcmp(argv[++i], "jsonl") == 0 ? EXPORT_JSONL : EXPORT_CSV;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                export_dir = argv[++i];
+            }
+        } else if (strcmp(argv[i], "--replicate") == 0 || strcmp(argv[i], "--standby") == 0) {
+            const char **socket_path = argv[i][2] == 'r' ? &replicate_socket : &standby_socket;
+            *socket_path = REPLICATION_SOCKET;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                *socket_path = argv[++i];
+            }
+        }
+    }
     
     // Load data from files at startup
     printf("===== GYM MANAGEMENT SYSTEM =====\n");
+    if (get_current_branch()[0] != '\0') {
+        printf("Branch: %s\n", get_current_branch());
+    }
     printf("Loading data...\n\n");
     
-    plan_count = load_plans_from_file(plans);
-    equipment_count = load_equipment_from_file(equipment);
-    member_count = load_members_from_file(members);
+    load_plans_from_file(&plans);
+    load_equipment_from_file(&equipment);
+    load_members_from_file(&members);
+    load_loans_from_file(&loans);
+    load_classes_from_file(&schedule);
+    
+    // Usernames taken, saved at the last exit (or built if out of date)
+    username_filter_load(&members);
+    
+    if (shared) {
+        shared_tables_attach(&plans, &equipment, &members, &loans,
+                             &schedule.classes, &schedule.bookings);
+    }
+    
+    if (export_format != -1) {
+        char default_dir[256];
+        data_file_path(EXPORT_DIR, default_dir, sizeof(default_dir));
+        shared_tables_begin_edit();
+        int ok = export_all(&members, &plans, &equipment, export_dir ? export_dir : default_dir, export_format);
+        shared_tables_end_edit();
+        shared_tables_detach();
+        table_free(&plans);
+        table_free(&equipment);
+        table_free(&members);
+        table_free(&loans);
+        class_schedule_free(&schedule);
+        return ok ? 0 : 1;
+    }
+    
+    // Warm standby: apply the primary's changes until the admin promotes it
+    if (standby_socket) {
+        autosave_start();
+        set_input_wait_hook(autosave_poll);
+        if (!replication_start_standby(standby_socket, &plans, &equipment, &members) ||
+            !replication_standby_menu()) {
+            autosave_stop();
+            shared_tables_detach();
+            table_free(&plans);
+            table_free(&equipment);
+            table_free(&members);
+            table_free(&loans);
+            class_schedule_free(&schedule);
+            return 0;
+        }
+    }
+    
+    // Usernames are unique across branches
+    if (get_current_branch()[0] != '\0' &&
+        username_index_start(USERNAME_INDEX_FILE, BRANCHES_ROOT, BRANCHES_FILE) < 0) {
+        printf("Warning: Cannot open %s, usernames are only checked in this branch.\n",
+               USERNAME_INDEX_FILE);
+    }
+    
+    // Subscription events are appended to the history from now on
+    char history_path[256];
+    data_file_path(HISTORY_FILE, history_path, sizeof(history_path));
+    history_start(history_path, &members);
+    
+    // Members read plans from the published catalog
+    plan_catalog_publish(&plans);
+    
+    // Changes are written by a background thread from now on, handed over
+    // each time the app waits for the user
+    autosave_start();
+    set_input_wait_hook(autosave_poll);
+    
+    // Every saved change is also sent to the standby
+    if (replicate_socket && replication_start_primary(replicate_socket, &plans, &equipment, &members)) {
+        printf("Replicating to a standby on %s\n", replicate_socket);
+    }
+    
+    // Plans and equipment changed by other programs are picked up while running
+    hot_reload_start(&plans, &equipment);
+    
+    // Check-ins are logged by a background thread too
+    checkin_start();
+    
+    // So is every change made by the admin and the members
+    audit_start();
+    
+    // Passwords are hashed and checked on their own threads, one per CPU
+    password_pool_start(0);
     
     printf("\nSystem ready!\n");
     pause_screen();
@@ -29,9 +171,27 @@ int main() {
     int main_choice;
     
     do {
+        // Show changes made by other running copies of the app, and by
+        // other programs to the plans and equipment files
+        shared_tables_refresh();
+        hot_reload_apply();
+        
+        // End subscriptions whose month is over
+        subscriptions_expire_due(&members);
+        
+        // Turnstile checks read member statuses, not the tables
+        access_sync(&members);
+        
+        // Equipment counters follow the stock set by the admin
+        equipment_stock_sync(&equipment, &loans);
+        
+        // Equipment due for service is kept ordered by due date
+        maintenance_sync(&equipment);
+        
         print_header("GYM MANAGEMENT SYSTEM");
         printf("1 - Member Login\n");
         printf("2 - Admin Login\n");
+        printf("3 - Turnstile (Check In / Out)\n");
         printf("0 - Exit\n");
         print_separator();
         printf("Your choice: ");
@@ -51,20 +211,25 @@ int main() {
                     member_choice = get_int_input();
                     
                     switch (member_choice) {
-                        case 1:
-                            if (create_member_account(members, &member_count)) {
-                                save_members_to_file(members, member_count);
-                            }
+                        case 1: {
+                            // Takes the edit lock itself, once everything is typed
+                            shared_tables_refresh();
+                            create_member_account(&members);
+                            autosave_table(&members);
                             pause_screen();
                             break;
+                        }
                             
                         case 2: {
-                            int member_id = member_login(members, member_count);
-                            if (member_id != -1) {
+                            shared_tables_refresh();
+                            int member_slot = member_login(&members);
+                            if (member_slot != -1) {
                                 pause_screen();
-                                display_member_menu(member_id, members, member_count);
+                                display_member_menu(member_slot, &members, &equipment, &loans, &schedule);
                                 // Save any changes (like subscriptions)
-                                save_members_to_file(members, member_count);
+                                autosave_table(&members);
+                                autosave_table(&loans);
+                                autosave_table(&schedule.bookings);
                             } else {
                                 pause_screen();
                             }
@@ -86,26 +251,60 @@ int main() {
                 // Admin section
                 if (admin_login()) {
                     pause_screen();
-                    display_admin_menu(members, &member_count,
-                                     plans, &plan_count,
-                                     equipment, &equipment_count);
+                    display_admin_menu(&members, &plans, &equipment, &loans, &schedule);
                     
                     // Save all data after admin operations
-                    save_plans_to_file(plans, plan_count);
-                    save_equipment_to_file(equipment, equipment_count);
-                    save_members_to_file(members, member_count);
+                    autosave_table(&plans);
+                    autosave_table(&equipment);
+                    autosave_table(&members);
+                    autosave_table(&loans);
+                    autosave_table(&schedule.classes);
+                    autosave_table(&schedule.bookings);
                 } else {
                     pause_screen();
                 }
                 break;
             }
             
+            case 3:
+                checkin_turnstile(&members);
+                break;
+            
             case 0: {
+                // From now on the files are only written by this copy
+                hot_reload_stop();
+                
                 // Save all data before exit
                 printf("\nSaving all data...\n");
-                save_plans_to_file(plans, plan_count);
-                save_equipment_to_file(equipment, equipment_count);
-                save_members_to_file(members, member_count);
+                autosave_table(&plans);
+                autosave_table(&equipment);
+                autosave_table(&members);
+                autosave_table(&loans);
+                autosave_table(&schedule.classes);
+                autosave_table(&schedule.bookings);
+                
+                // Give the standby a moment to apply the last changes
+                replication_flush(REPLICATION_FLUSH_MS);
+                replication_stop_primary();
+                
+                // Wait for the background thread to finish writing before exiting
+                autosave_stop();
+                checkin_stop();
+                audit_stop();
+                password_pool_stop();
+                
+                // The members file is written: keep the filter for the next start
+                username_filter_save(&members);
+                username_filter_free();
+                popularity_free();
+                history_stop();
+                username_index_stop();
+                shared_tables_detach();
+                table_free(&plans);
+                table_free(&equipment);
+                table_free(&members);
+                table_free(&loans);
+                class_schedule_free(&schedule);
                 printf("\n[SUCCESS] All data saved successfully!\n");
                 printf("Thank you for using Gym Management System. Goodbye!\n");
                 break;
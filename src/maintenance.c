@@ -0,0 +1,357 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "maintenance.h"
+#include "utils.h"
+
+#define SECONDS_PER_DAY (24LL * 60 * 60)
+
+// Min-heap of scheduled items by due date: heap[0] is due first, and the
+// children of heap[i] are heap[2i + 1] and heap[2i + 2]
+static MaintenanceDue *heap = NULL;
+static int heap_count = 0;
+static int heap_capacity = 0;
+
+// Heap index of each equipment ID (-1 if the item is not in the heap), so
+// one item's entry is found and moved without searching
+static int *position = NULL;
+static int position_capacity = 0;
+
+static int heap_ready = 0;
+
+// Version of the equipment table the heap was last brought up to date with
+static unsigned long synced_version = 0;
+
+long long equipment_service_due(const Equipment *item) {
+    long long due = 0;
+
+    if (item->service_days > 0) {
+        due = item->last_service + item->service_days * SECONDS_PER_DAY;
+    }
+
+    // Out of checkouts: due as soon as the last service, so it sorts first
+    if (item->service_uses > 0 && item->usage_count >= item->service_uses) {
+        long long since = item->last_service > 0 ? item->last_service : 1;
+        if (due == 0 || since < due) {
+            due = since;
+        }
+    }
+    return due;
+}
+
+static int reserve_positions(int id) {
+    if (id < position_capacity) {
+        return 1;
+    }
+
+    int capacity = position_capacity > 0 ? position_capacity : 64;
+    while (capacity <= id) {
+        capacity *= 2;
+    }
+    int *grown = realloc(position, sizeof(int) * capacity);
+    if (!grown) {
+        return 0;
+    }
+    memset(grown + position_capacity, 0xff, sizeof(int) * (capacity - position_capacity));
+    position = grown;
+    position_capacity = capacity;
+    return 1;
+}
+
+static void place(int index, MaintenanceDue entry) {
+    heap[index] = entry;
+    position[entry.id_equipment] = index;
+}
+
+static void sift_up(int index) {
+    MaintenanceDue entry = heap[index];
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (heap[parent].due <= entry.due) {
+            break;
+        }
+        place(index, heap[parent]);
+        index = parent;
+    }
+    place(index, entry);
+}
+
+static void sift_down(int index) {
+    MaintenanceDue entry = heap[index];
+    while (1) {
+        int child = 2 * index + 1;
+        if (child >= heap_count) {
+            break;
+        }
+        if (child + 1 < heap_count && heap[child + 1].due < heap[child].due) {
+            child++;
+        }
+        if (entry.due <= heap[child].due) {
+            break;
+        }
+        place(index, heap[child]);
+        index = child;
+    }
+    place(index, entry);
+}
+
+static int heap_push(MaintenanceDue entry) {
+    if (heap_count == heap_capacity) {
+        int capacity = heap_capacity > 0 ? heap_capacity * 2 : 64;
+        MaintenanceDue *grown = realloc(heap, sizeof(MaintenanceDue) * capacity);
+        if (!grown) {
+            return 0;
+        }
+        heap = grown;
+        heap_capacity = capacity;
+    }
+    heap[heap_count++] = entry;
+    return 1;
+}
+
+static void heap_remove(int index) {
+    position[heap[index].id_equipment] = -1;
+    heap_count--;
+    if (index == heap_count) {
+        return;
+    }
+
+    // Fill the hole with the last entry, which may belong above or below it
+    MaintenanceDue moved = heap[heap_count];
+    place(index, moved);
+    sift_up(index);
+    if (position[moved.id_equipment] == index) {
+        sift_down(index);
+    }
+}
+
+// Put an item at its due date in the heap, or take it out (due 0)
+static int schedule_item(int id, long long due) {
+    if (id < 0 || !reserve_positions(id)) {
+        return 0;
+    }
+
+    int index = position[id];
+    if (due == 0) {
+        if (index != -1) {
+            heap_remove(index);
+        }
+        return 1;
+    }
+
+    if (index == -1) {
+        if (!heap_push((MaintenanceDue){ due, id })) {
+            return 0;
+        }
+        sift_up(heap_count - 1);
+    } else {
+        long long old_due = heap[index].due;
+        heap[index].due = due;
+        if (due < old_due) {
+            sift_up(index);
+        } else {
+            sift_down(index);
+        }
+    }
+    return 1;
+}
+
+void maintenance_sync(const Table *equipment) {
+    if (heap_ready && equipment->version == synced_version) {
+        return;
+    }
+
+    if (!reserve_positions(equipment->max_id > 0 ? equipment->max_id : 0)) {
+        return;  // Keep the old heap and try again next time
+    }
+    memset(position, 0xff, sizeof(int) * position_capacity);
+    heap_count = 0;
+
+    for (int i = 0; i < equipment->count; i++) {
+        if (!table_is_live(equipment, i)) {
+            continue;
+        }
+        const Equipment *item = equipment_at(equipment, i);
+        long long due = equipment_service_due(item);
+        if (due != 0 && item->id_equipment >= 0 && heap_push((MaintenanceDue){ due, item->id_equipment })) {
+            position[item->id_equipment] = heap_count - 1;
+        }
+    }
+
+    // Heapify from the last parent up: O(n), cheaper than n pushes
+    for (int i = heap_count / 2 - 1; i >= 0; i--) {
+        sift_down(i);
+    }
+
+    synced_version = equipment->version;
+    heap_ready = 1;
+}
+
+void maintenance_track(const Table *equipment, int equipment_id) {
+    // Only this item's change since the last sync: move just its entry.
+    // Anything more means the table changed elsewhere and needs a rebuild.
+    if (!heap_ready || synced_version + 1 != equipment->version) {
+        maintenance_sync(equipment);
+        return;
+    }
+
+    const Equipment *item = equipment_find(equipment, equipment_id);
+    if (!schedule_item(equipment_id, item ? equipment_service_due(item) : 0)) {
+        heap_ready = 0;  // Out of memory: rebuild on the next sync
+        return;
+    }
+    synced_version = equipment->version;
+}
+
+static int compare_due(const void *a, const void *b) {
+    const MaintenanceDue *x = a;
+    const MaintenanceDue *y = b;
+    if (x->due != y->due) {
+        return x->due < y->due ? -1 : 1;
+    }
+    return x->id_equipment - y->id_equipment;
+}
+
+int maintenance_due_before(long long until, MaintenanceDue **due) {
+    *due = NULL;
+    int count = 0, capacity = 0;
+
+    // Walk down from the root while entries are due: a parent is never due
+    // later than its children, so entries past 'until' end their branch
+    int *pending = malloc(sizeof(int) * 64);
+    int pending_count = 0, pending_capacity = 64;
+    if (!pending) {
+        return -1;
+    }
+    if (heap_count > 0 && heap[0].due <= until) {
+        pending[pending_count++] = 0;
+    }
+
+    while (pending_count > 0) {
+        int index = pending[--pending_count];
+
+        if (count == capacity) {
+            capacity = capacity > 0 ? capacity * 2 : 16;
+            MaintenanceDue *grown = realloc(*due, sizeof(MaintenanceDue) * capacity);
+            if (!grown) {
+                free(pending);
+                free(*due);
+                *due = NULL;
+                return -1;
+            }
+            *due = grown;
+        }
+        (*due)[count++] = heap[index];
+
+        if (pending_count + 2 > pending_capacity) {
+            int *grown = realloc(pending, sizeof(int) * pending_capacity * 2);
+            if (!grown) {
+                free(pending);
+                free(*due);
+                *due = NULL;
+                return -1;
+            }
+            pending = grown;
+            pending_capacity *= 2;
+        }
+        for (int child = 2 * index + 1; child <= 2 * index + 2 && child < heap_count; child++) {
+            if (heap[child].due <= until) {
+                pending[pending_count++] = child;
+            }
+        }
+    }
+    free(pending);
+
+    if (count > 0) {
+        qsort(*due, count, sizeof(MaintenanceDue), compare_due);
+    }
+    return count;
+}
+
+int maintenance_scheduled_count() {
+    return heap_count;
+}
+
+int maintenance_record_use(Table *equipment, int equipment_id) {
+    Equipment *item = equipment_find(equipment, equipment_id);
+    if (!item) {
+        return 0;
+    }
+
+    item->usage_count++;
+    table_touch_record(equipment, equipment_id);
+    maintenance_track(equipment, equipment_id);
+    return 1;
+}
+
+int maintenance_record_service(Table *equipment, int equipment_id) {
+    Equipment *item = equipment_find(equipment, equipment_id);
+    if (!item) {
+        return 0;
+    }
+
+    item->usage_count = 0;
+    item->last_service = time(NULL);
+    table_touch_record(equipment, equipment_id);
+    maintenance_track(equipment, equipment_id);
+    return 1;
+}
+
+static void display_due_item(const Table *equipment, const MaintenanceDue *entry, long long now) {
+    const Equipment *item = equipment_find(equipment, entry->id_equipment);
+    if (!item) {
+        return;
+    }
+
+    char date[32];
+    format_date(entry->due, date, sizeof(date));
+    printf("ID: %d | %s | ", item->id_equipment, item->name);
+    if (item->service_uses > 0 && item->usage_count >= item->service_uses) {
+        printf("%d of %d checkout(s) used", item->usage_count, item->service_uses);
+    } else if (entry->due <= now) {
+        printf("Due since %s (%lld day(s) overdue)", date, (now - entry->due) / SECONDS_PER_DAY);
+    } else {
+        printf("Due %s (in %lld day(s))", date, (entry->due - now + SECONDS_PER_DAY - 1) / SECONDS_PER_DAY);
+    }
+    printf("\n");
+}
+
+int maintenance_display_due(const Table *equipment, int days) {
+    maintenance_sync(equipment);
+
+    long long now = time(NULL);
+    MaintenanceDue *due;
+    int count = maintenance_due_before(now + days * SECONDS_PER_DAY, &due);
+    if (count < 0) {
+        printf("\nError: Not enough memory to list the maintenance due.\n");
+        return 0;
+    }
+    if (count == 0) {
+        printf("\nNo equipment needs service within %d day(s).\n", days);
+        return 0;
+    }
+
+    // The list is sorted by due date, so the overdue items come first
+    int overdue = 0;
+    while (overdue < count && due[overdue].due <= now) {
+        overdue++;
+    }
+
+    if (overdue > 0) {
+        printf("\n--- Overdue Equipment (%d) ---\n", overdue);
+        for (int i = 0; i < overdue; i++) {
+            display_due_item(equipment, &due[i], now);
+        }
+    }
+    if (count > overdue) {
+        printf("\n--- Service Due Within %d Day(s) (%d) ---\n", days, count - overdue);
+        for (int i = overdue; i < count; i++) {
+            display_due_item(equipment, &due[i], now);
+        }
+    }
+    printf("\n");
+
+    free(due);
+    return count;
+}
@@ -0,0 +1,50 @@
+#ifndef MAINTENANCE_H
+#define MAINTENANCE_H
+
+#include "equipment.h"
+
+// Equipment due for service, kept in a min-heap ordered by due date, so
+// listing what is due reads only those items, never the whole inventory.
+// Items without a service schedule are not in the heap.
+
+// One item due for service
+typedef struct {
+    long long due;          // when the service fell due (seconds since 1970)
+    int id_equipment;
+} MaintenanceDue;
+
+// Function declarations
+
+// When an item needs its next service: last_service + service_days, or its
+// last service time once service_uses checkouts are reached (the earlier
+// of the two). Returns 0 if the item has no service schedule.
+long long equipment_service_due(const Equipment *item);
+
+// Make the heap match the equipment table. Only rebuilds (O(n)) if the table
+// changed without maintenance_track(), e.g. after loading or a refresh from
+// another process. Single thread.
+void maintenance_sync(const Table *equipment);
+
+// Update one item after changing (or deleting) it: O(log n)
+void maintenance_track(const Table *equipment, int equipment_id);
+
+// Items due at or before a time, earliest first, in *due (the caller frees
+// it). O(k log k) for k items due. Returns k, or -1 if out of memory.
+int maintenance_due_before(long long until, MaintenanceDue **due);
+
+// Number of items in the heap (items with a service schedule)
+int maintenance_scheduled_count();
+
+// Count one checkout of an item towards its service (returns 1 if it exists).
+// Changes the record: call between shared_tables_begin_edit()/end_edit().
+int maintenance_record_use(Table *equipment, int equipment_id);
+
+// Record that an item was serviced now: its usage count starts again
+// (returns 1 if it exists). Also an edit of the record.
+int maintenance_record_service(Table *equipment, int equipment_id);
+
+// Display overdue equipment, then what falls due within the next days
+// (returns how many items were listed)
+int maintenance_display_due(const Table *equipment, int days);
+
+#endif
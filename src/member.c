@@ -1,47 +1,48 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include "member.h"
 #include "plans.h"
+#include "autosave.h"
+#include "shared_tables.h"
+#include "plan_catalog.h"
+#include "subscriptions.h"
+#include "access.h"
+#include "loans.h"
+#include "classes.h"
+#include "history.h"
+#include "branches.h"
+#include "password.h"
+#include "username_filter.h"
+#include "hot_reload.h"
+#include "audit.h"
+#include "popularity.h"
 #include "utils.h"
 
-int get_next_member_id(Member members[], int count) {
-    // If no members exist, start with ID 1
-    if (count == 0) {
-        return 1;
-    }
-    
-    // Find the highest ID among existing members
-    int max_id = members[0].id_member;
-    
-    for (int i = 1; i < count; i++) {
-        if (members[i].id_member > max_id) {
-            max_id = members[i].id_member;
-        }
-    }
-    
-    // Return the next available ID
-    int next_id = max_id + 1;
-    return next_id;
+// Text format of one member, generated from MEMBER_FIELDS
+SCHEMA_CODEC(member, Member, MEMBER_FIELDS, "member")
+
+int get_next_member_id(const Table *members) {
+    // The table remembers the highest ID it has seen
+    return table_next_id(members);
 }
 
-int find_member_by_username(Member members[], int count, const char *username) {
-    for (int i = 0; i < count; i++) {
-        if (strcmp(members[i].username, username) == 0) {
+int find_member_by_username(const Table *members, const char *username) {
+    for (int i = 0; i < members->count; i++) {
+        if (table_is_live(members, i) && strcmp(member_at(members, i)->username, username) == 0) {
             return i;
         }
     }
     return -1;
 }
 
-int create_member_account(Member members[], int *count) {
-    if (*count >= MAX_MEMBERS) {
-        printf("\nError: Maximum number of members reached (%d).\n", MAX_MEMBERS);
-        return 0;
-    }
-    
+int create_member_account(Table *members) {
     Member new_member;
-    new_member.id_member = get_next_member_id(members, *count);
+    new_member.id_member = 0;
     new_member.id_current_plan = -1;
+    new_member.subscription_start = 0;
+    new_member.subscription_end = 0;
     
     print_header("CREATE NEW ACCOUNT");
     
@@ -65,37 +66,86 @@ int create_member_account(Member members[], int *count) {
         return 0;
     }
     
-    // Check if username already exists
-    int username_exists = find_member_by_username(members, *count, new_member.username);
+    // Check if username already exists (the filter rules out most new
+    // usernames without searching the table)
+    int username_exists = username_filter_may_contain(members, new_member.username)
+                              ? find_member_by_username(members, new_member.username) : -1;
     if (username_exists != -1) {
         printf("\nError: Username '%s' already exists!\n", new_member.username);
         printf("Please try again with a different username.\n");
         return 0;
     }
     
+    // Usernames are unique across branches too
+    char other_branch[BRANCH_NAME_SIZE];
+    int other_id;
+    if (username_index_lookup(new_member.username, other_branch, sizeof(other_branch), &other_id)) {
+        printf("\nError: Username '%s' is already used at branch %s!\n", new_member.username, other_branch);
+        printf("Please try again with a different username.\n");
+        return 0;
+    }
+    
     printf("Enter Password: ");
-    get_string_input(new_member.password, sizeof(new_member.password));
+    char password[PASSWORD_INPUT_SIZE];
+    get_string_input(password, sizeof(password));
     
     // Check if password is empty
-    int password_length = strlen(new_member.password);
+    int password_length = strlen(password);
     if (password_length == 0) {
         printf("Password cannot be empty!\n");
         return 0;
     }
     
     printf("Confirm Password: ");
-    char confirm[50];
+    char confirm[PASSWORD_INPUT_SIZE];
     get_string_input(confirm, sizeof(confirm));
     
     // Check if passwords match
-    int passwords_match = strcmp(new_member.password, confirm);
+    int passwords_match = strcmp(password, confirm);
     if (passwords_match != 0) {
         printf("\nError: Passwords do not match!\n");
         return 0;
     }
     
-    members[*count] = new_member;
-    (*count)++;
+    // Only the salted hash is stored
+    PasswordRequest request;
+    password_hash_async(&request, password, NULL, NULL);
+    if (!password_wait(&request)) {
+        printf("\nError: Not enough memory to create the account.\n");
+        return 0;
+    }
+    strcpy(new_member.password, request.hash);
+    
+    // Only the account itself is added under the edit lock: other copies of
+    // the app were not kept waiting while the details were typed and hashed,
+    // so one of them may have taken the username in the meantime
+    shared_tables_begin_edit();
+    if (find_member_by_username(members, new_member.username) != -1) {
+        shared_tables_end_edit();
+        printf("\nError: Username '%s' was just taken!\n", new_member.username);
+        return 0;
+    }
+    new_member.id_member = get_next_member_id(members);
+    
+    if (!username_index_claim(new_member.username, get_current_branch(), new_member.id_member)) {
+        shared_tables_end_edit();
+        printf("\nError: Username '%s' was just taken at another branch!\n", new_member.username);
+        return 0;
+    }
+    
+    if (!member_append(members, &new_member)) {
+        username_index_release(new_member.username);
+        shared_tables_end_edit();
+        printf("\nError: Not enough memory to create the account.\n");
+        return 0;
+    }
+    
+    username_filter_track(members, new_member.username, 1);
+    subscriptions_track(members, new_member.id_member);
+    access_track(members, new_member.id_member);
+    popularity_track(members, new_member.id_member);
+    audit_record(new_member.id_member, AUDIT_MEMBER_SIGNUP, new_member.id_member, new_member.username);
+    shared_tables_end_edit();
     
     printf("\n[SUCCESS] Account created successfully!\n");
     printf("Your Member ID: %d\n", new_member.id_member);
@@ -104,17 +154,18 @@ int create_member_account(Member members[], int *count) {
     return 1;
 }
 
-int member_login(Member members[], int count) {
-    char username[50], password[50];
+int member_login(Table *members) {
+    char username[50], password[PASSWORD_INPUT_SIZE];
     
     print_header("MEMBER LOGIN");
     
     printf("Enter Username: ");
     get_string_input(username, sizeof(username));
     
-    int member_id = find_member_by_username(members, count, username);
+    int member_slot = username_filter_may_contain(members, username)
+                          ? find_member_by_username(members, username) : -1;
     
-    if (member_id == -1) {
+    if (member_slot == -1) {
         printf("\nError: Username not found!\n");
         printf("Please check your username or create a new account.\n");
         return -1;
@@ -123,18 +174,40 @@ int member_login(Member members[], int count) {
     printf("Enter Password: ");
     get_string_input(password, sizeof(password));
     
-    // Check if password matches
-    int password_matches = strcmp(members[member_id].password, password);
-    if (password_matches != 0) {
+    // Check if password matches (on a hashing thread, other logins go on)
+    Member *member = member_at(members, member_slot);
+    char stored[PASSWORD_HASH_SIZE];
+    strcpy(stored, member->password);
+    if (!password_check(password, stored)) {
         printf("\nError: Incorrect password!\n");
         return -1;
     }
     
-    printf("\n[SUCCESS] Login successful! Welcome %s!\n", members[member_id].name);
-    return member_id;
+    // Old plain text passwords are hashed on the first login
+    if (password_needs_rehash(stored)) {
+        PasswordRequest request;
+        password_hash_async(&request, password, NULL, NULL);
+        if (password_wait(&request)) {
+            shared_tables_begin_edit();
+            member_slot = find_member_by_username(members, username);
+            if (member_slot != -1 && strcmp(member_at(members, member_slot)->password, stored) == 0) {
+                strcpy(member_at(members, member_slot)->password, request.hash);
+                table_touch_record(members, member_at(members, member_slot)->id_member);
+            }
+            shared_tables_end_edit();
+            if (member_slot == -1) {
+                printf("\nError: Username not found!\n");
+                return -1;
+            }
+            member = member_at(members, member_slot);
+        }
+    }
+    
+    printf("\n[SUCCESS] Login successful! Welcome %s!\n", member->name);
+    return member_slot;
 }
 
-void display_member_profile(Member *member) {
+void display_member_profile(const Member *member) {
     print_header("MY PROFILE");
     printf("Member ID: %d\n", member->id_member);
     printf("Name: %s\n", member->name);
@@ -148,57 +221,104 @@ void display_member_profile(Member *member) {
     }
 }
 
-int subscribe_to_plan(Member *member, int plan_id) {
-    if (member->id_current_plan == plan_id) {
+int subscribe_to_plan(Member *member, int plan_id, long long now) {
+    if (member->id_current_plan == plan_id &&
+        (member->subscription_end == 0 || member->subscription_end > now)) {
         printf("\nYou are already subscribed to this plan!\n");
         return 0;
     }
     
+    // A new subscription (or a new plan) starts a full period from today
     member->id_current_plan = plan_id;
+    member->subscription_start = now;
+    member->subscription_end = now + SUBSCRIPTION_DAYS * 24LL * 60 * 60;
+    
+    char end_date[32];
+    format_date(member->subscription_end, end_date, sizeof(end_date));
     printf("\n[SUCCESS] Subscription successful!\n");
     printf("You are now subscribed to Plan ID: %d\n", plan_id);
+    printf("Your subscription runs until %s.\n", end_date);
     return 1;
 }
 
-void view_member_subscription(Member *member) {
+void view_member_subscription(const Member *member) {
     print_header("MY SUBSCRIPTION");
     
+    char date[32];
+    
     if (member->id_current_plan == -1) {
         printf("You have no active subscription.\n");
+        if (member->subscription_end != 0) {
+            format_date(member->subscription_end, date, sizeof(date));
+            printf("Your last subscription ended on %s.\n", date);
+        }
         printf("Please subscribe to a plan to access gym facilities.\n");
     } else {
         printf("Current Plan ID: %d\n", member->id_current_plan);
         printf("Status: Active\n");
         printf("Billing: Monthly\n");
+        
+        // Older accounts have no recorded dates
+        if (member->subscription_end != 0) {
+            long long seconds_left = member->subscription_end - (long long)time(NULL);
+            format_date(member->subscription_start, date, sizeof(date));
+            printf("Started: %s\n", date);
+            format_date(member->subscription_end, date, sizeof(date));
+            printf("Ends: %s (%lld day(s) left)\n", date,
+                   seconds_left > 0 ? (seconds_left + 86399) / 86400 : 0);
+        }
     }
 }
 
-void display_member_menu(int member_id, Member members[], int member_count) {
+void display_member_menu(int member_slot, Table *members, Table *equipment, Table *loans,
+                         ClassSchedule *schedule) {
     int choice;
     
-    // Load plans for subscription
-    Plan plans[MAX_PLANS];
-    int plan_count = load_plans_from_file(plans);
+    // Remember who is logged in: deleting members (here or in another
+    // process in shared mode) can move this member to another slot
+    char username[50];
+    strcpy(username, member_at(members, member_slot)->username);
     
     do {
+        shared_tables_refresh();
+        hot_reload_apply();
+        subscriptions_expire_due(members);
+        member_slot = find_member_by_username(members, username);
+        if (member_slot == -1) {
+            printf("\nYour account has been removed. Logging out...\n");
+            return;
+        }
+        
         print_header("MEMBER MENU");
         printf("1 - View Available Plans\n");
         printf("2 - Subscribe to a Plan\n");
         printf("3 - View My Subscription\n");
         printf("4 - My Profile\n");
+        printf("5 - Equipment (Check Out / Return)\n");
+        printf("6 - Group Classes\n");
         printf("0 - Logout\n");
         print_separator();
         printf("Your choice: ");
         choice = get_int_input();
         
+        Member *member = member_at(members, member_slot);
+        
         switch (choice) {
-            case 1:
-                display_plans(plans, plan_count);
+            case 1: {
+                // Plans are read from the published catalog without locking;
+                // an admin edit can never show up half-done here
+                const PlanCatalog *catalog = plan_catalog_enter();
+                display_plans(&catalog->plans);
+                plan_catalog_exit();
                 pause_screen();
                 break;
+            }
                 
             case 2: {
-                display_plans(plans, plan_count);
+                const PlanCatalog *catalog = plan_catalog_enter();
+                display_plans(&catalog->plans);
+                plan_catalog_exit();
+                
                 printf("\nEnter Plan ID to subscribe (or 0 to cancel): ");
                 int plan_id = get_int_input();
                 
@@ -206,39 +326,66 @@ void display_member_menu(int member_id, Member members[], int member_count) {
                     break;
                 }
                 
-                // Verify plan exists
-                int plan_index = find_plan_by_id(plans, plan_count, plan_id);
+                // Verify plan exists in the latest version
+                catalog = plan_catalog_enter();
+                int plan_index = find_plan_by_id(&catalog->plans, plan_id);
+                plan_catalog_exit();
+                
                 if (plan_index == -1) {
                     printf("\nError: Invalid Plan ID!\n");
                 } else {
-                    if (subscribe_to_plan(&members[member_id], plan_id)) {
-                        save_members_to_file(members, member_count);
+                    shared_tables_begin_edit();
+                    member_slot = find_member_by_username(members, username);
+                    int subscribed = (member_slot != -1) &&
+                                     subscribe_to_plan(member_at(members, member_slot), plan_id,
+                                                       time(NULL));
+                    if (subscribed) {
+                        Member *subscriber = member_at(members, member_slot);
+                        history_record(subscriber->id_member, HISTORY_SUBSCRIBE, plan_id,
+                                       subscriber->subscription_start);
+                        table_touch_record(members, subscriber->id_member);
+                        subscriptions_track(members, member_at(members, member_slot)->id_member);
+                        access_track(members, member_at(members, member_slot)->id_member);
+                        popularity_track(members, subscriber->id_member);
+                        popularity_record_subscription(plan_id, subscriber->subscription_start);
+                        audit_record(subscriber->id_member, AUDIT_SUBSCRIBE, plan_id, NULL);
                     }
+                    shared_tables_end_edit();
+                    autosave_table(members);
                 }
                 pause_screen();
                 break;
             }
             
             case 3:
-                view_member_subscription(&members[member_id]);
+                view_member_subscription(member);
                 
                 // Show plan details if subscribed
-                if (members[member_id].id_current_plan != -1) {
-                    int plan_index = find_plan_by_id(plans, plan_count, 
-                                                     members[member_id].id_current_plan);
-                    if (plan_index != -1) {
+                if (member->id_current_plan != -1) {
+                    const PlanCatalog *catalog = plan_catalog_enter();
+                    const Plan *plan = plan_find(&catalog->plans, member->id_current_plan);
+                    if (plan) {
                         printf("\nPlan Details:\n");
-                        display_single_plan(&plans[plan_index]);
+                        display_single_plan(plan);
                     }
+                    plan_catalog_exit();
                 }
                 pause_screen();
                 break;
                 
             case 4:
-                display_member_profile(&members[member_id]);
+                display_member_profile(member);
                 pause_screen();
                 break;
                 
+            case 5:
+                member_equipment_menu(member->id_member, equipment, loans);
+                break;
+                
+            case 6:
+                member_classes_menu(members, member->id_member, schedule);
+                break;
+                
             case 0:
                 printf("\nLogging out...\n");
                 break;
@@ -252,63 +399,30 @@ void display_member_menu(int member_id, Member members[], int member_count) {
 }
 
 
-int load_members_from_file(Member members[]) {
-    FILE *f = fopen("data/members.txt", "r");
+int load_members_from_file(Table *members) {
+    char path[256];
+    data_file_path(MEMBERS_FILE, path, sizeof(path));
+    int count = table_load(members, path);
     
-    if (!f) {
+    if (count == TABLE_NO_FILE) {
         printf("No members file found. Starting with empty member list.\n");
         return 0;
     }
     
-    int count;
-    if (fscanf(f, "%d\n", &count) != 1) {
+    if (count == TABLE_BAD_HEADER) {
         printf("Error reading members file.\n");
-        fclose(f);
         return 0;
     }
     
-    // Read each member from file
-    for (int i = 0; i < count && i < MAX_MEMBERS; i++) {
-        // Read: id|username|password|name|plan_id
-        int fields_read = fscanf(f, "%d|%49[^|]|%49[^|]|%99[^|]|%d\n",
-                                 &members[i].id_member,
-                                 members[i].username,
-                                 members[i].password,
-                                 members[i].name,
-                                 &members[i].id_current_plan);
-        
-        // Check if we successfully read all 5 fields
-        if (fields_read != 5) {
-            printf("Error reading member %d from file.\n", i + 1);
-            fclose(f);
-            return i;
-        }
-    }
-    
-    fclose(f);
     printf("Loaded %d member(s) from file.\n", count);
     return count;
 }
 
-void save_members_to_file(Member members[], int count) {
-    FILE *f = fopen("data/members.txt", "w");
-    
-    if (!f) {
+void save_members_to_file(const Table *members) {
+    if (!table_write(members, members->path[0] ? members->path : MEMBERS_FILE)) {
         printf("\nError: Cannot save members to file.\n");
         return;
     }
     
-    fprintf(f, "%d\n", count);
-    
-    for (int i = 0; i < count; i++) {
-        fprintf(f, "%d|%s|%s|%s|%d\n",
-                members[i].id_member,
-                members[i].username,
-                members[i].password,
-                members[i].name,
-                members[i].id_current_plan);
-    }
-    
-    fclose(f);
     printf("Members saved to file successfully.\n");
 }
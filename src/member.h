@@ -1,47 +1,67 @@
 #ifndef MEMBER_H
 #define MEMBER_H
 
-#define MAX_MEMBERS 200
+#include "table.h"
+#include "schema.h"
+
+typedef struct ClassSchedule ClassSchedule;
+
+#define MEMBERS_FILE "data/members.txt"
+
+// How long one subscription runs (billing is monthly)
+#define SUBSCRIPTION_DAYS 30
+
+// Member account fields, in file order:
+// id|username|password|name|plan_id|subscription_start|subscription_end
+#define MEMBER_FIELDS(X)                                                    \
+    X(INT,  id_member,          0)                                          \
+    X(TEXT, username,           50)                                         \
+    X(SECRET, password,         100)  /* scrypt hash, see password.h */     \
+    X(TEXT, name,               100)                                        \
+    X(INT,  id_current_plan,    0)    /* -1 if no subscription */           \
+    X(TIME, subscription_start, 0)    /* 0 if not recorded */               \
+    X(TIME, subscription_end,   0)    /* expiry time, 0 if not recorded */
 
 // Member account structure
 typedef struct {
-    int id_member;
-    char username[50];
-    char password[50];
-    char name[100];
-    int id_current_plan;  // -1 if no subscription
+    SCHEMA_STRUCT(MEMBER_FIELDS)
 } Member;
 
+// Member table helpers: member_table_init(), member_at(), member_find(), member_append()
+TABLE_TYPE(member, Member, id_member)
+
 // Function declarations
 
 // Create a new member account interactively
-int create_member_account(Member members[], int *count);
+int create_member_account(Table *members);
 
-// Member login (returns member index if successful, -1 if failed)
-int member_login(Member members[], int count);
+// Member login (returns member slot if successful, -1 if failed).
+// A password still stored as plain text is replaced by its hash.
+int member_login(Table *members);
 
 // Display member menu and handle member operations
-void display_member_menu(int member_id, Member members[], int member_count);
+void display_member_menu(int member_slot, Table *members, Table *equipment, Table *loans,
+                         ClassSchedule *schedule);
 
-// Find member by username (returns index, -1 if not found)
-int find_member_by_username(Member members[], int count, const char *username);
+// Find member by username (returns slot, -1 if not found)
+int find_member_by_username(const Table *members, const char *username);
 
 // Display member profile
-void display_member_profile(Member *member);
+void display_member_profile(const Member *member);
 
-// Subscribe member to a plan
-int subscribe_to_plan(Member *member, int plan_id);
+// Subscribe member to a plan for SUBSCRIPTION_DAYS starting at now
+int subscribe_to_plan(Member *member, int plan_id, long long now);
 
 // View member's subscription
-void view_member_subscription(Member *member);
+void view_member_subscription(const Member *member);
 
 // Get the next available member ID
-int get_next_member_id(Member members[], int count);
+int get_next_member_id(const Table *members);
 
-// Load members from file
-int load_members_from_file(Member members[]);
+// Load members from file into an initialized table (returns number of members)
+int load_members_from_file(Table *members);
 
 // Save members to file
-void save_members_to_file(Member members[], int count);
+void save_members_to_file(const Table *members);
 
 #endif
@@ -0,0 +1,199 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "member_archive.h"
+#include "utils.h"
+
+int member_archive_open(MemberArchive *archive, const char *path, const char *username_path, int cache_pages) {
+    if (!btree_open(&archive->by_id, path, BTREE_KEY_INT, sizeof(int), sizeof(Member), cache_pages)) {
+        return 0;
+    }
+    if (!btree_open(&archive->by_username, username_path, BTREE_KEY_TEXT, sizeof(((Member *)0)->username),
+                    sizeof(int), cache_pages)) {
+        btree_close(&archive->by_id);
+        return 0;
+    }
+    return 1;
+}
+
+void member_archive_close(MemberArchive *archive) {
+    btree_close(&archive->by_id);
+    btree_close(&archive->by_username);
+}
+
+int member_archive_put(MemberArchive *archive, const Member *member) {
+    // A renamed member's old username no longer points to it
+    Member old;
+    if (btree_find(&archive->by_id, &member->id_member, &old) && strcmp(old.username, member->username) != 0) {
+        int owner;
+        if (btree_find(&archive->by_username, old.username, &owner) && owner == member->id_member) {
+            btree_delete(&archive->by_username, old.username);
+        }
+    }
+    return btree_put(&archive->by_id, &member->id_member, member) &&
+           btree_put(&archive->by_username, member->username, &member->id_member);
+}
+
+int member_archive_find(MemberArchive *archive, int member_id, Member *member) {
+    return btree_find(&archive->by_id, &member_id, member);
+}
+
+int member_archive_find_by_username(MemberArchive *archive, const char *username, Member *member) {
+    int member_id;
+    return btree_find(&archive->by_username, username, &member_id) &&
+           btree_find(&archive->by_id, &member_id, member);
+}
+
+int member_archive_remove(MemberArchive *archive, int member_id) {
+    Member old;
+    if (!btree_find(&archive->by_id, &member_id, &old)) {
+        return 0;
+    }
+    int owner;
+    if (btree_find(&archive->by_username, old.username, &owner) && owner == member_id) {
+        btree_delete(&archive->by_username, old.username);
+    }
+    return btree_delete(&archive->by_id, &member_id);
+}
+
+int member_archive_add_table(MemberArchive *archive, const Table *members) {
+    int written = 0;
+    for (int i = 0; i < members->count; i++) {
+        if (!table_is_live(members, i)) {
+            continue;
+        }
+        const Member *member = member_at(members, i);
+        Member archived;
+        if (member_archive_find(archive, member->id_member, &archived) &&
+            memcmp(&archived, member, sizeof(Member)) == 0) {
+            continue;
+        }
+        if (!member_archive_put(archive, member)) {
+            return -1;
+        }
+        written++;
+    }
+    return written;
+}
+
+static int open_default(MemberArchive *archive) {
+    char path[256], username_path[256];
+    data_file_path(MEMBER_ARCHIVE_FILE, path, sizeof(path));
+    data_file_path(MEMBER_ARCHIVE_USERNAME_FILE, username_path, sizeof(username_path));
+    if (!member_archive_open(archive, path, username_path, MEMBER_ARCHIVE_CACHE_PAGES)) {
+        printf("\nError: Cannot open the member archive (%s).\n", path);
+        return 0;
+    }
+    return 1;
+}
+
+void member_archive_keep(const Member *member) {
+    MemberArchive archive;
+    if (!open_default(&archive)) {
+        return;
+    }
+    if (!member_archive_put(&archive, member)) {
+        printf("\nError: Cannot archive member %s.\n", member->username);
+    }
+    member_archive_close(&archive);
+}
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static void display_archived(const Table *members, const Member *member) {
+    printf("\n--- Archived Member ---\n");
+    printf("Member ID: %d\n", member->id_member);
+    printf("Name: %s\n", member->name);
+    printf("Username: %s\n", member->username);
+    if (member->id_current_plan == -1) {
+        printf("Last Subscription: None\n");
+    } else {
+        printf("Last Subscription: Plan ID %d", member->id_current_plan);
+        if (member->subscription_end != 0) {
+            char date[32];
+            format_date(member->subscription_end, date, sizeof(date));
+            printf(" (until %s)", date);
+        }
+        printf("\n");
+    }
+    printf("Status: %s\n", member_find(members, member->id_member) ? "Active member" : "Deleted");
+}
+
+void member_archive_interactive(const Table *members) {
+    MemberArchive archive;
+    if (!open_default(&archive)) {
+        return;
+    }
+
+    int choice;
+    do {
+        print_header("MEMBER ARCHIVE");
+        printf("Archived members: %lld\n\n", archive.by_id.count);
+        printf("1 - Archive Current Members\n");
+        printf("2 - Find by Username\n");
+        printf("3 - Find by Member ID\n");
+        printf("0 - Back\n");
+        print_separator();
+        printf("Your choice: ");
+        choice = get_int_input();
+
+        Member member;
+
+        switch (choice) {
+            case 1: {
+                double start = now_ms();
+                int written = member_archive_add_table(&archive, members);
+                if (written < 0 || !btree_flush(&archive.by_id) || !btree_flush(&archive.by_username)) {
+                    printf("\nError: Cannot write the member archive.\n");
+                } else {
+                    printf("\n[SUCCESS] %d member(s) added or updated in %.0f ms.\n", written, now_ms() - start);
+                }
+                pause_screen();
+                break;
+            }
+
+            case 2:
+            case 3: {
+                char username[50];
+                int member_id = 0;
+                if (choice == 2) {
+                    printf("\nEnter username: ");
+                    get_string_input(username, sizeof(username));
+                } else {
+                    printf("\nEnter Member ID: ");
+                    member_id = get_int_input();
+                }
+
+                long long reads_before = archive.by_id.page_reads + archive.by_username.page_reads;
+                double start = now_ms();
+                int found = choice == 2 ? member_archive_find_by_username(&archive, username, &member)
+                                        : member_archive_find(&archive, member_id, &member);
+                double elapsed = now_ms() - start;
+                if (found) {
+                    display_archived(members, &member);
+                } else {
+                    printf("\nMember not found in the archive.\n");
+                }
+                printf("(%lld page read(s), %.2f ms)\n",
+                       archive.by_id.page_reads + archive.by_username.page_reads - reads_before, elapsed);
+                pause_screen();
+                break;
+            }
+
+            case 0:
+                break;
+
+            default:
+                printf("\nInvalid choice. Try again.\n");
+                pause_screen();
+        }
+    } while (choice != 0);
+
+    member_archive_close(&archive);
+}
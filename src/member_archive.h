@@ -0,0 +1,52 @@
+#ifndef MEMBER_ARCHIVE_H
+#define MEMBER_ARCHIVE_H
+
+#include "member.h"
+#include "btree.h"
+
+// Archive of every member ever registered, lapsed and deleted ones
+// included, kept on disk in two B+trees: the member records by ID, and the
+// member ID of each username. A lookup reads a few pages (one per tree
+// level, 3 or 4 for millions of members) and memory stays within the page
+// cache however many members the archive holds.
+#define MEMBER_ARCHIVE_FILE          "data/archive_members.idx"
+#define MEMBER_ARCHIVE_USERNAME_FILE "data/archive_usernames.idx"
+
+// Pages each tree keeps in memory (4 KB each)
+#define MEMBER_ARCHIVE_CACHE_PAGES BTREE_DEFAULT_CACHE_PAGES
+
+typedef struct {
+    BTree by_id;          // id_member -> Member
+    BTree by_username;    // username -> id_member
+} MemberArchive;
+
+// Function declarations
+
+// Open (or create) the archive files with cache_pages pages per tree.
+// Returns 1 if successful, 0 if a file cannot be used.
+int member_archive_open(MemberArchive *archive, const char *path, const char *username_path, int cache_pages);
+
+// Write every changed page and close the files
+void member_archive_close(MemberArchive *archive);
+
+// Add a member, or replace the archived copy (returns 1 if successful)
+int member_archive_put(MemberArchive *archive, const Member *member);
+
+// Copy the archived member into member. Returns 1 if found.
+int member_archive_find(MemberArchive *archive, int member_id, Member *member);
+int member_archive_find_by_username(MemberArchive *archive, const char *username, Member *member);
+
+// Forget a member (returns 1 if it was archived)
+int member_archive_remove(MemberArchive *archive, int member_id);
+
+// Archive every live member of the table that is new or changed.
+// Returns the number written, -1 on a file error.
+int member_archive_add_table(MemberArchive *archive, const Table *members);
+
+// Keep a copy of a member that is about to be deleted
+void member_archive_keep(const Member *member);
+
+// Admin screen: archive the current members, look members up
+void member_archive_interactive(const Table *members);
+
+#endif
@@ -0,0 +1,112 @@
+#include <stdio.h>
+#include <limits.h>
+#include <string.h>
+#include "money.h"
+#include "utils.h"
+
+const char *money_parse(const char *text, Money *out) {
+    const char *s = text;
+    int negative = (*s == '-');
+    s += negative;
+
+    if (*s < '0' || *s > '9') {
+        return NULL;
+    }
+
+    // Whole dinars, as long as they fit in millimes (with the decimals)
+    Money units = 0;
+    while (*s >= '0' && *s <= '9') {
+        units = units * 10 + (*s++ - '0');
+        if (units > (LLONG_MAX - (MONEY_SCALE - 1)) / MONEY_SCALE) {
+            return NULL;
+        }
+    }
+
+    // Up to 3 decimals, padded to millimes
+    Money millimes = 0;
+    int decimals = 0;
+    if (*s == '.') {
+        s++;
+        while (*s >= '0' && *s <= '9' && decimals < 3) {
+            millimes = millimes * 10 + (*s++ - '0');
+            decimals++;
+        }
+        if (*s >= '0' && *s <= '9') {
+            return NULL;  // More precision than a millime
+        }
+    }
+    for (; decimals < 3; decimals++) {
+        millimes *= 10;
+    }
+
+    Money value = units * MONEY_SCALE + millimes;
+    *out = negative ? -value : value;
+    return s;
+}
+
+int money_format(Money amount, char *out) {
+    char *o = out;
+    unsigned long long value = amount < 0 ? 0ull - (unsigned long long)amount
+                                          : (unsigned long long)amount;
+    if (amount < 0) {
+        *o++ = '-';
+    }
+
+    // Whole dinars, digits produced backwards
+    char digits[20];
+    int n = 0;
+    unsigned long long units = value / MONEY_SCALE;
+    do {
+        digits[n++] = (char)('0' + units % 10);
+        units /= 10;
+    } while (units != 0);
+    while (n > 0) {
+        *o++ = digits[--n];
+    }
+
+    unsigned millimes = (unsigned)(value % MONEY_SCALE);
+    *o++ = '.';
+    *o++ = (char)('0' + millimes / 100);
+    *o++ = (char)('0' + millimes / 10 % 10);
+    if (millimes % 10 != 0) {
+        *o++ = (char)('0' + millimes % 10);
+    }
+    *o = '\0';
+    return (int)(o - out);
+}
+
+Money money_sum(const Money *amounts, size_t count) {
+    // Four independent lanes let the compiler use vector adds
+    Money lane[4] = { 0, 0, 0, 0 };
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        for (int k = 0; k < 4; k++) {
+            lane[k] += amounts[i + k];
+        }
+    }
+
+    Money total = lane[0] + lane[1] + lane[2] + lane[3];
+    for (; i < count; i++) {
+        total += amounts[i];
+    }
+    return total;
+}
+
+Money get_money_input() {
+    char line[64];
+    Money amount;
+
+    while (1) {
+        if (!fgets(line, sizeof(line), stdin)) {
+            return 0;  // End of input
+        }
+        line[strcspn(line, "\r\n")] = '\0';
+
+        const char *end = money_parse(line, &amount);
+        if (end && *end == '\0' && amount >= 0) {
+            return amount;
+        }
+        printf("Invalid amount. Please enter a price like 49.900: ");
+    }
+}
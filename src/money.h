@@ -0,0 +1,32 @@
+#ifndef MONEY_H
+#define MONEY_H
+
+#include <stddef.h>
+
+// Amounts of money as a whole number of millimes (1 DT = 1000 millimes),
+// so sums are exact no matter how many amounts are added
+typedef long long Money;
+
+#define MONEY_SCALE 1000
+
+// Longest text money_format() writes, including '\0'
+#define MONEY_MAX_TEXT 24
+
+// Function declarations
+
+// Parse "50", "49.9", "49.90" or "49.950" (at most 3 decimals, optional '-').
+// Returns a pointer past the amount, NULL if text does not start with one
+// or it is too large to count in millimes.
+const char *money_parse(const char *text, Money *out);
+
+// Write an amount with 2 decimals, or 3 when the millimes need it
+// ("50.00", "49.95", "49.125"). Returns the number of characters written.
+int money_format(Money amount, char *out);
+
+// Exact sum of count amounts (the loop is written so compilers vectorize it)
+Money money_sum(const Money *amounts, size_t count);
+
+// Read a price typed by the user (>= 0); asks again until it is valid
+Money get_money_input();
+
+#endif
@@ -0,0 +1,606 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <pthread.h>
+#include "password.h"
+#include "utils.h"
+
+// Largest settings accepted from a stored hash (256 MB per hash at most)
+#define MAX_LOG_N 20
+#define MAX_R     32
+#define MAX_P     16
+#define MAX_MEMORY (256u << 20)
+
+// ===== SHA-256 =====
+
+typedef struct {
+    uint32_t state[8];
+    uint64_t length;          // bytes hashed so far
+    uint8_t block[64];
+    size_t used;              // bytes waiting in block
+} Sha256;
+
+static const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void sha256_block(Sha256 *s, const uint8_t *p) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (uint32_t)p[4 * i] << 24 | (uint32_t)p[4 * i + 1] << 16 | (uint32_t)p[4 * i + 2] << 8 | p[4 * i + 3];
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = ROTR(w[i - 15], 7) ^ ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = ROTR(w[i - 2], 17) ^ ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = s->state[0], b = s->state[1], c = s->state[2], d = s->state[3];
+    uint32_t e = s->state[4], f = s->state[5], g = s->state[6], h = s->state[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = h + (ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25)) + ((e & f) ^ (~e & g)) + sha256_k[i] + w[i];
+        uint32_t t2 = (ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    s->state[0] += a;
+    s->state[1] += b;
+    s->state[2] += c;
+    s->state[3] += d;
+    s->state[4] += e;
+    s->state[5] += f;
+    s->state[6] += g;
+    s->state[7] += h;
+}
+
+static void sha256_init(Sha256 *s) {
+    static const uint32_t initial[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                         0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+    memcpy(s->state, initial, sizeof(initial));
+    s->length = 0;
+    s->used = 0;
+}
+
+static void sha256_update(Sha256 *s, const uint8_t *data, size_t length) {
+    s->length += length;
+    while (length > 0) {
+        if (s->used == 0 && length >= 64) {
+            sha256_block(s, data);
+            data += 64;
+            length -= 64;
+            continue;
+        }
+        size_t take = 64 - s->used < length ? 64 - s->used : length;
+        memcpy(s->block + s->used, data, take);
+        s->used += take;
+        data += take;
+        length -= take;
+        if (s->used == 64) {
+            sha256_block(s, s->block);
+            s->used = 0;
+        }
+    }
+}
+
+static void sha256_final(Sha256 *s, uint8_t out[32]) {
+    uint64_t bits = s->length * 8;
+    uint8_t pad = 0x80;
+    sha256_update(s, &pad, 1);
+    pad = 0;
+    while (s->used != 56) {
+        sha256_update(s, &pad, 1);
+    }
+    uint8_t size[8];
+    for (int i = 0; i < 8; i++) {
+        size[i] = (uint8_t)(bits >> (56 - 8 * i));
+    }
+    sha256_update(s, size, 8);
+    for (int i = 0; i < 8; i++) {
+        out[4 * i] = (uint8_t)(s->state[i] >> 24);
+        out[4 * i + 1] = (uint8_t)(s->state[i] >> 16);
+        out[4 * i + 2] = (uint8_t)(s->state[i] >> 8);
+        out[4 * i + 3] = (uint8_t)s->state[i];
+    }
+}
+
+// ===== PBKDF2-HMAC-SHA256 (one iteration, all scrypt needs) =====
+
+static void pbkdf2_sha256(const uint8_t *password, size_t password_length, const uint8_t *salt,
+                          size_t salt_length, uint8_t *out, size_t out_length) {
+    // The key padded to a block, hashed first if longer than a block
+    uint8_t key[64];
+    memset(key, 0, sizeof(key));
+    if (password_length > 64) {
+        Sha256 s;
+        sha256_init(&s);
+        sha256_update(&s, password, password_length);
+        sha256_final(&s, key);
+    } else {
+        memcpy(key, password, password_length);
+    }
+    uint8_t pad[64];
+    Sha256 inner, outer;
+    for (int i = 0; i < 64; i++) {
+        pad[i] = key[i] ^ 0x36;
+    }
+    sha256_init(&inner);
+    sha256_update(&inner, pad, 64);
+    sha256_update(&inner, salt, salt_length);
+    for (int i = 0; i < 64; i++) {
+        pad[i] = key[i] ^ 0x5c;
+    }
+    sha256_init(&outer);
+    sha256_update(&outer, pad, 64);
+
+    // The inner and outer states after the key are reused for every block
+    for (uint32_t block = 1; out_length > 0; block++) {
+        uint8_t counter[4] = { (uint8_t)(block >> 24), (uint8_t)(block >> 16), (uint8_t)(block >> 8),
+                               (uint8_t)block };
+        uint8_t digest[32];
+        Sha256 s = inner;
+        sha256_update(&s, counter, 4);
+        sha256_final(&s, digest);
+        s = outer;
+        sha256_update(&s, digest, 32);
+        sha256_final(&s, digest);
+
+        size_t take = out_length < 32 ? out_length : 32;
+        memcpy(out, digest, take);
+        out += take;
+        out_length -= take;
+    }
+}
+
+// ===== scrypt =====
+
+#define ROTL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+static void salsa20_8(uint32_t b[16]) {
+    uint32_t x[16];
+    memcpy(x, b, sizeof(x));
+    for (int i = 0; i < 8; i += 2) {
+        x[4] ^= ROTL(x[0] + x[12], 7);    x[8] ^= ROTL(x[4] + x[0], 9);
+        x[12] ^= ROTL(x[8] + x[4], 13);   x[0] ^= ROTL(x[12] + x[8], 18);
+        x[9] ^= ROTL(x[5] + x[1], 7);     x[13] ^= ROTL(x[9] + x[5], 9);
+        x[1] ^= ROTL(x[13] + x[9], 13);   x[5] ^= ROTL(x[1] + x[13], 18);
+        x[14] ^= ROTL(x[10] + x[6], 7);   x[2] ^= ROTL(x[14] + x[10], 9);
+        x[6] ^= ROTL(x[2] + x[14], 13);   x[10] ^= ROTL(x[6] + x[2], 18);
+        x[3] ^= ROTL(x[15] + x[11], 7);   x[7] ^= ROTL(x[3] + x[15], 9);
+        x[11] ^= ROTL(x[7] + x[3], 13);   x[15] ^= ROTL(x[11] + x[7], 18);
+        x[1] ^= ROTL(x[0] + x[3], 7);     x[2] ^= ROTL(x[1] + x[0], 9);
+        x[3] ^= ROTL(x[2] + x[1], 13);    x[0] ^= ROTL(x[3] + x[2], 18);
+        x[6] ^= ROTL(x[5] + x[4], 7);     x[7] ^= ROTL(x[6] + x[5], 9);
+        x[4] ^= ROTL(x[7] + x[6], 13);    x[5] ^= ROTL(x[4] + x[7], 18);
+        x[11] ^= ROTL(x[10] + x[9], 7);   x[8] ^= ROTL(x[11] + x[10], 9);
+        x[9] ^= ROTL(x[8] + x[11], 13);   x[10] ^= ROTL(x[9] + x[8], 18);
+        x[12] ^= ROTL(x[15] + x[14], 7);  x[13] ^= ROTL(x[12] + x[15], 9);
+        x[14] ^= ROTL(x[13] + x[12], 13); x[15] ^= ROTL(x[14] + x[13], 18);
+    }
+    for (int i = 0; i < 16; i++) {
+        b[i] += x[i];
+    }
+}
+
+// b holds 2r blocks of 16 words; y is room for as many
+static void block_mix(uint32_t *b, uint32_t *y, unsigned r) {
+    uint32_t x[16];
+    memcpy(x, &b[(2 * r - 1) * 16], sizeof(x));
+    for (unsigned i = 0; i < 2 * r; i++) {
+        for (int k = 0; k < 16; k++) {
+            x[k] ^= b[i * 16 + k];
+        }
+        salsa20_8(x);
+        // Even blocks go to the first half, odd ones to the second
+        memcpy(&y[(i / 2 + (i & 1) * r) * 16], x, sizeof(x));
+    }
+    memcpy(b, y, 128 * r);
+}
+
+static void ro_mix(uint8_t *block, unsigned r, uint32_t n, uint32_t *work) {
+    size_t words = 32 * r;
+    uint32_t *x = work;
+    uint32_t *y = x + words;
+    uint32_t *v = y + words;
+
+    for (size_t k = 0; k < words; k++) {
+        const uint8_t *p = block + 4 * k;
+        x[k] = (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        memcpy(&v[i * words], x, words * 4);
+        block_mix(x, y, r);
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t j = x[(2 * r - 1) * 16] & (n - 1);
+        for (size_t k = 0; k < words; k++) {
+            x[k] ^= v[j * words + k];
+        }
+        block_mix(x, y, r);
+    }
+    for (size_t k = 0; k < words; k++) {
+        uint8_t *p = block + 4 * k;
+        p[0] = (uint8_t)x[k];
+        p[1] = (uint8_t)(x[k] >> 8);
+        p[2] = (uint8_t)(x[k] >> 16);
+        p[3] = (uint8_t)(x[k] >> 24);
+    }
+}
+
+// Memory kept by a hashing thread between requests, so a login does not
+// allocate (and page in) 16 MB each time
+typedef struct {
+    uint32_t *words;
+    size_t capacity;          // words
+} Scratch;
+
+static size_t scratch_words(unsigned log_n, unsigned r) {
+    return 32 * (size_t)r * ((1u << log_n) + 2);
+}
+
+static int scrypt_with(Scratch *scratch, const uint8_t *password, size_t password_length, const uint8_t *salt,
+                       size_t salt_length, unsigned log_n, unsigned r, unsigned p, uint8_t *out,
+                       size_t out_length) {
+    if (log_n < 1 || log_n > MAX_LOG_N || r < 1 || r > MAX_R || p < 1 || p > MAX_P ||
+        128u * r * (1u << log_n) > MAX_MEMORY) {
+        return 0;
+    }
+    size_t words = scratch_words(log_n, r);
+    if (scratch->capacity < words) {
+        free(scratch->words);
+        scratch->words = malloc(words * sizeof(uint32_t));
+        scratch->capacity = scratch->words ? words : 0;
+        if (!scratch->words) {
+            return 0;
+        }
+    }
+    size_t block_bytes = 128 * (size_t)r;
+    uint8_t *blocks = malloc(block_bytes * p);
+    if (!blocks) {
+        return 0;
+    }
+
+    pbkdf2_sha256(password, password_length, salt, salt_length, blocks, block_bytes * p);
+    for (unsigned i = 0; i < p; i++) {
+        ro_mix(blocks + i * block_bytes, r, 1u << log_n, scratch->words);
+    }
+    pbkdf2_sha256(password, password_length, blocks, block_bytes * p, out, out_length);
+
+    free(blocks);
+    return 1;
+}
+
+static void scratch_free(Scratch *scratch) {
+    free(scratch->words);
+    scratch->words = NULL;
+    scratch->capacity = 0;
+}
+
+int scrypt(const uint8_t *password, size_t password_length, const uint8_t *salt, size_t salt_length,
+           unsigned log_n, unsigned r, unsigned p, uint8_t *out, size_t out_length) {
+    Scratch scratch = { NULL, 0 };
+    int ok = scrypt_with(&scratch, password, password_length, salt, salt_length, log_n, r, p, out, out_length);
+    scratch_free(&scratch);
+    return ok;
+}
+
+// ===== Encoded hashes =====
+
+static const char base64_digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Base64 without padding; out needs 4 * length / 3 + 2 bytes
+static void base64_encode(const uint8_t *data, size_t length, char *out) {
+    uint32_t bits = 0;
+    int count = 0;
+    for (size_t i = 0; i < length; i++) {
+        bits = bits << 8 | data[i];
+        count += 8;
+        while (count >= 6) {
+            count -= 6;
+            *out++ = base64_digits[(bits >> count) & 63];
+        }
+    }
+    if (count > 0) {
+        *out++ = base64_digits[(bits << (6 - count)) & 63];
+    }
+    *out = '\0';
+}
+
+// Decode text[0..length) into out. Returns the bytes written, -1 if invalid.
+static int base64_decode(const char *text, size_t length, uint8_t *out, size_t size) {
+    uint32_t bits = 0;
+    int count = 0;
+    size_t written = 0;
+    for (size_t i = 0; i < length; i++) {
+        const char *digit = text[i] ? strchr(base64_digits, text[i]) : NULL;
+        if (!digit) {
+            return -1;
+        }
+        bits = bits << 6 | (uint32_t)(digit - base64_digits);
+        count += 6;
+        if (count >= 8) {
+            count -= 8;
+            if (written == size) {
+                return -1;
+            }
+            out[written++] = (uint8_t)(bits >> count);
+        }
+    }
+    return (int)written;
+}
+
+typedef struct {
+    unsigned log_n, r, p;
+    uint8_t salt[64];
+    int salt_length;
+    uint8_t hash[64];
+    int hash_length;
+} Encoded;
+
+static int decode_hash(const char *stored, Encoded *e) {
+    int used = 0;
+    if (strncmp(stored, PASSWORD_SCHEME, strlen(PASSWORD_SCHEME)) != 0 ||
+        sscanf(stored + strlen(PASSWORD_SCHEME), "ln=%u,r=%u,p=%u$%n", &e->log_n, &e->r, &e->p, &used) != 3 ||
+        used == 0) {
+        return 0;
+    }
+    const char *salt = stored + strlen(PASSWORD_SCHEME) + used;
+    const char *dollar = strchr(salt, '$');
+    if (!dollar) {
+        return 0;
+    }
+    e->salt_length = base64_decode(salt, dollar - salt, e->salt, sizeof(e->salt));
+    e->hash_length = base64_decode(dollar + 1, strlen(dollar + 1), e->hash, sizeof(e->hash));
+    return e->salt_length >= 8 && e->hash_length >= 16;
+}
+
+static void random_bytes(uint8_t *out, size_t length) {
+    FILE *f = fopen("/dev/urandom", "rb");
+    size_t got = f ? fread(out, 1, length, f) : 0;
+    if (f) {
+        fclose(f);
+    }
+    if (got == length) {
+        return;
+    }
+
+    // No system random source: mix the time, the clock and a counter
+    static atomic_ullong counter = 0;
+    struct {
+        time_t now;
+        clock_t clock;
+        unsigned long long counter;
+        const void *address;
+    } seed = { time(NULL), clock(), atomic_fetch_add(&counter, 1), &seed };
+    uint8_t digest[32];
+    Sha256 s;
+    sha256_init(&s);
+    sha256_update(&s, (const uint8_t *)&seed, sizeof(seed));
+    sha256_final(&s, digest);
+    memcpy(out, digest, length < 32 ? length : 32);
+}
+
+// Compare without stopping at the first difference, so the time taken
+// does not tell how much of the value was right
+static int same_bytes(const uint8_t *a, const uint8_t *b, size_t length) {
+    uint8_t difference = 0;
+    for (size_t i = 0; i < length; i++) {
+        difference |= a[i] ^ b[i];
+    }
+    return difference == 0;
+}
+
+static int hash_with(Scratch *scratch, const char *password, char *out, size_t size) {
+    uint8_t salt[PASSWORD_SALT_BYTES], hash[PASSWORD_HASH_BYTES];
+    random_bytes(salt, sizeof(salt));
+    if (!scrypt_with(scratch, (const uint8_t *)password, strlen(password), salt, sizeof(salt), PASSWORD_LOG_N,
+                     PASSWORD_R, PASSWORD_P, hash, sizeof(hash))) {
+        return 0;
+    }
+    char salt_text[4 * PASSWORD_SALT_BYTES / 3 + 2], hash_text[4 * PASSWORD_HASH_BYTES / 3 + 2];
+    base64_encode(salt, sizeof(salt), salt_text);
+    base64_encode(hash, sizeof(hash), hash_text);
+    int length = snprintf(out, size, "%sln=%d,r=%d,p=%d$%s$%s", PASSWORD_SCHEME, PASSWORD_LOG_N, PASSWORD_R,
+                          PASSWORD_P, salt_text, hash_text);
+    return length > 0 && (size_t)length < size;
+}
+
+static int verify_with(Scratch *scratch, const char *password, const char *stored) {
+    if (strncmp(stored, PASSWORD_SCHEME, strlen(PASSWORD_SCHEME)) != 0) {
+        // Old plain text password
+        size_t length = strlen(stored);
+        return strlen(password) == length && same_bytes((const uint8_t *)password, (const uint8_t *)stored, length);
+    }
+    Encoded e;
+    uint8_t hash[64];
+    return decode_hash(stored, &e) &&
+           scrypt_with(scratch, (const uint8_t *)password, strlen(password), e.salt, e.salt_length, e.log_n, e.r,
+                       e.p, hash, e.hash_length) &&
+           same_bytes(hash, e.hash, e.hash_length);
+}
+
+int password_hash(const char *password, char *out, size_t size) {
+    Scratch scratch = { NULL, 0 };
+    int ok = hash_with(&scratch, password, out, size);
+    scratch_free(&scratch);
+    return ok;
+}
+
+int password_verify(const char *password, const char *stored) {
+    Scratch scratch = { NULL, 0 };
+    int ok = verify_with(&scratch, password, stored);
+    scratch_free(&scratch);
+    return ok;
+}
+
+int password_needs_rehash(const char *stored) {
+    Encoded e;
+    return !decode_hash(stored, &e) || e.log_n != PASSWORD_LOG_N || e.r != PASSWORD_R || e.p != PASSWORD_P ||
+           e.salt_length != PASSWORD_SALT_BYTES || e.hash_length != PASSWORD_HASH_BYTES;
+}
+
+// ===== Hashing threads =====
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_ready = PTHREAD_COND_INITIALIZER;   // signaled when a request is queued
+static pthread_cond_t work_done = PTHREAD_COND_INITIALIZER;    // signaled when a request finished
+static PasswordRequest *queue_head = NULL;
+static PasswordRequest *queue_tail = NULL;
+static pthread_t workers[PASSWORD_MAX_WORKERS];
+static int worker_count = 0;
+static int stopping = 0;
+
+static void run_request(Scratch *scratch, PasswordRequest *request) {
+    request->result = request->verify ? verify_with(scratch, request->password, request->hash)
+                                      : hash_with(scratch, request->password, request->hash, sizeof(request->hash));
+
+    // The typed password is not needed any more
+    memset(request->password, 0, sizeof(request->password));
+
+    if (request->callback) {
+        // The callback may free or reuse the request: it is not touched after
+        request->callback(request, request->arg);
+        return;
+    }
+    pthread_mutex_lock(&lock);
+    request->finished = 1;
+    pthread_cond_broadcast(&work_done);
+    pthread_mutex_unlock(&lock);
+}
+
+static void *worker_main(void *arg) {
+    (void)arg;
+    Scratch scratch = { NULL, 0 };
+
+    pthread_mutex_lock(&lock);
+    for (;;) {
+        while (!queue_head && !stopping) {
+            pthread_cond_wait(&work_ready, &lock);
+        }
+        if (!queue_head) {
+            break;  // Stopping and nothing left to do
+        }
+        PasswordRequest *request = queue_head;
+        queue_head = request->next;
+        if (!queue_head) {
+            queue_tail = NULL;
+        }
+        pthread_mutex_unlock(&lock);
+
+        run_request(&scratch, request);
+
+        pthread_mutex_lock(&lock);
+    }
+    pthread_mutex_unlock(&lock);
+
+    scratch_free(&scratch);
+    return NULL;
+}
+
+int password_pool_start(int workers_wanted) {
+    if (workers_wanted < 1) {
+        workers_wanted = online_cpu_count(PASSWORD_MAX_WORKERS);
+    }
+    if (workers_wanted > PASSWORD_MAX_WORKERS) {
+        workers_wanted = PASSWORD_MAX_WORKERS;
+    }
+    pthread_mutex_lock(&lock);
+    stopping = 0;
+    while (worker_count < workers_wanted &&
+           pthread_create(&workers[worker_count], NULL, worker_main, NULL) == 0) {
+        worker_count++;
+    }
+    int started = worker_count;
+    pthread_mutex_unlock(&lock);
+    return started;
+}
+
+void password_pool_stop() {
+    pthread_mutex_lock(&lock);
+    stopping = 1;
+    pthread_cond_broadcast(&work_ready);
+    int count = worker_count;
+    pthread_mutex_unlock(&lock);
+
+    for (int i = 0; i < count; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    pthread_mutex_lock(&lock);
+    worker_count = 0;
+    stopping = 0;
+    pthread_mutex_unlock(&lock);
+}
+
+static void submit(PasswordRequest *request) {
+    request->finished = 0;
+    request->next = NULL;
+
+    pthread_mutex_lock(&lock);
+    if (worker_count == 0 || stopping) {
+        pthread_mutex_unlock(&lock);
+        // No hashing threads: do it here
+        Scratch scratch = { NULL, 0 };
+        run_request(&scratch, request);
+        scratch_free(&scratch);
+        return;
+    }
+    if (queue_tail) {
+        queue_tail->next = request;
+    } else {
+        queue_head = request;
+    }
+    queue_tail = request;
+    pthread_cond_signal(&work_ready);
+    pthread_mutex_unlock(&lock);
+}
+
+void password_verify_async(PasswordRequest *request, const char *password, const char *stored,
+                           PasswordCallback callback, void *arg) {
+    request->verify = 1;
+    snprintf(request->password, sizeof(request->password), "%s", password);
+    snprintf(request->hash, sizeof(request->hash), "%s", stored);
+    request->callback = callback;
+    request->arg = arg;
+    submit(request);
+}
+
+void password_hash_async(PasswordRequest *request, const char *password, PasswordCallback callback, void *arg) {
+    request->verify = 0;
+    snprintf(request->password, sizeof(request->password), "%s", password);
+    request->hash[0] = '\0';
+    request->callback = callback;
+    request->arg = arg;
+    submit(request);
+}
+
+int password_wait(PasswordRequest *request) {
+    pthread_mutex_lock(&lock);
+    while (!request->finished) {
+        pthread_cond_wait(&work_done, &lock);
+    }
+    pthread_mutex_unlock(&lock);
+    return request->result;
+}
+
+int password_check(const char *password, const char *stored) {
+    PasswordRequest request;
+    password_verify_async(&request, password, stored, NULL, NULL);
+    return password_wait(&request);
+}
@@ -0,0 +1,89 @@
+#ifndef PASSWORD_H
+#define PASSWORD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Passwords are stored as salted scrypt hashes (RFC 7914), written as
+//   $scrypt$ln=14,r=8,p=1$<salt>$<hash>
+// with the salt and hash in base64. scrypt is slow on purpose and needs
+// 128 * r * 2^ln bytes of memory per hash (16 MB here), so a stolen members
+// file cannot be searched quickly. A stored value that does not start with
+// "$scrypt$" is an old plain text password: it is still accepted, and
+// replaced by a hash at the member's next login.
+#define PASSWORD_SCHEME "$scrypt$"
+#define PASSWORD_LOG_N  14     // N = 2^14
+#define PASSWORD_R      8
+#define PASSWORD_P      1
+
+#define PASSWORD_SALT_BYTES 16
+#define PASSWORD_HASH_BYTES 32
+
+// Room for an encoded hash (the member password field is this size)
+#define PASSWORD_HASH_SIZE 100
+
+// Longest password typed in, plus the terminator
+#define PASSWORD_INPUT_SIZE 50
+
+// Most hashing threads
+#define PASSWORD_MAX_WORKERS 64
+
+// One hash or verify handed to the hashing threads. The caller owns the
+// request and must keep it alive until password_wait() returns or its
+// callback ran.
+typedef struct PasswordRequest PasswordRequest;
+
+// Called on the hashing thread when a request is done
+typedef void (*PasswordCallback)(PasswordRequest *request, void *arg);
+
+struct PasswordRequest {
+    int verify;                          // 1 = check password against hash, 0 = hash it
+    char password[PASSWORD_HASH_SIZE];
+    char hash[PASSWORD_HASH_SIZE];       // stored hash to check, or the new hash
+    int result;                          // 1 = match / hashed, 0 = wrong password / failed
+    PasswordCallback callback;
+    void *arg;
+    int finished;
+    PasswordRequest *next;
+};
+
+// Function declarations
+
+// scrypt key derivation: N = 2^log_n, block size r, parallelism p.
+// Returns 1 if successful, 0 if the parameters are out of range or memory
+// ran out.
+int scrypt(const uint8_t *password, size_t password_length, const uint8_t *salt, size_t salt_length,
+           unsigned log_n, unsigned r, unsigned p, uint8_t *out, size_t out_length);
+
+// Hash a password with a fresh random salt into out (PASSWORD_HASH_SIZE
+// bytes). Returns 1 if successful, 0 if memory ran out.
+int password_hash(const char *password, char *out, size_t size);
+
+// Check a password against a stored hash (or old plain text value).
+// Returns 1 if it matches.
+int password_verify(const char *password, const char *stored);
+
+// 1 if the stored value is plain text or a hash made with other settings
+int password_needs_rehash(const char *stored);
+
+// Start the hashing threads (workers < 1: one per CPU). While they are not
+// running, requests are done on the calling thread. Returns the number of
+// threads started.
+int password_pool_start(int workers);
+
+// Finish the queued requests and stop the hashing threads
+void password_pool_stop();
+
+// Queue a check of password against stored, or the hashing of password.
+// callback (may be NULL) is called with arg once the request is done.
+void password_verify_async(PasswordRequest *request, const char *password, const char *stored,
+                           PasswordCallback callback, void *arg);
+void password_hash_async(PasswordRequest *request, const char *password, PasswordCallback callback, void *arg);
+
+// Wait for a request and return its result
+int password_wait(PasswordRequest *request);
+
+// Check a password on the hashing threads and wait for the answer
+int password_check(const char *password, const char *stored);
+
+#endif
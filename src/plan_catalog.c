@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include "plan_catalog.h"
+
+// Epoch-based reclamation:
+// - a reader writes the global epoch into its slot before loading the catalog
+//   pointer, and clears the slot when it is done;
+// - a writer swaps the pointer, then retires the old version with the epoch
+//   of the swap. A retired version is freed when every busy reader slot
+//   shows a later epoch, i.e. nobody can still be looking at it.
+
+#define EPOCH_IDLE 0
+
+// Old version waiting until no reader can see it anymore
+typedef struct RetiredCatalog {
+    PlanCatalog *catalog;
+    unsigned long epoch;
+    struct RetiredCatalog *next;
+} RetiredCatalog;
+
+// Readers see this until the first publish (a zeroed table is a valid empty table)
+static PlanCatalog empty_catalog;
+
+static _Atomic(PlanCatalog *) current = &empty_catalog;
+static atomic_ulong global_epoch = 1;
+static atomic_ulong reader_epoch[CATALOG_MAX_READERS];  // EPOCH_IDLE when not reading
+static atomic_int slot_taken[CATALOG_MAX_READERS];
+
+// Writers are rare (admin edits), so they simply take turns
+static pthread_mutex_t writer_lock = PTHREAD_MUTEX_INITIALIZER;
+static RetiredCatalog *retired = NULL;
+static unsigned long next_version = 1;
+
+// Each reading thread owns one slot, released when the thread exits
+static _Thread_local int my_slot = -1;
+static pthread_key_t slot_key;
+static pthread_once_t slot_key_once = PTHREAD_ONCE_INIT;
+
+static void release_slot(void *value) {
+    int slot = (int)(long)value - 1;
+    atomic_store(&reader_epoch[slot], EPOCH_IDLE);
+    atomic_store(&slot_taken[slot], 0);
+}
+
+static void create_slot_key() {
+    pthread_key_create(&slot_key, release_slot);
+}
+
+static int claim_slot() {
+    pthread_once(&slot_key_once, create_slot_key);
+
+    while (1) {
+        for (int i = 0; i < CATALOG_MAX_READERS; i++) {
+            int expected = 0;
+            if (atomic_compare_exchange_strong(&slot_taken[i], &expected, 1)) {
+                // Store slot + 1 so the destructor also runs for slot 0
+                pthread_setspecific(slot_key, (void *)(long)(i + 1));
+                return i;
+            }
+        }
+        // Every slot is busy: wait for a reading thread to finish
+        sched_yield();
+    }
+}
+
+static void reclaim_retired() {
+    // Oldest epoch any reader may still be using
+    unsigned long oldest = atomic_load(&global_epoch);
+    for (int i = 0; i < CATALOG_MAX_READERS; i++) {
+        unsigned long epoch = atomic_load(&reader_epoch[i]);
+        if (epoch != EPOCH_IDLE && epoch < oldest) {
+            oldest = epoch;
+        }
+    }
+
+    RetiredCatalog **link = &retired;
+    while (*link) {
+        RetiredCatalog *entry = *link;
+        if (entry->epoch < oldest) {
+            *link = entry->next;
+            table_free(&entry->catalog->plans);
+            free(entry->catalog);
+            free(entry);
+        } else {
+            link = &entry->next;
+        }
+    }
+}
+
+void plan_catalog_publish(const Table *plans) {
+    // Build the complete new version (with its own ID index) before anyone can see it
+    PlanCatalog *catalog = calloc(1, sizeof(PlanCatalog));
+    if (!catalog || !table_copy(&catalog->plans, plans)) {
+        free(catalog);
+        printf("\nError: Not enough memory to publish plans.\n");
+        return;
+    }
+
+    pthread_mutex_lock(&writer_lock);
+
+    catalog->version = next_version++;
+    PlanCatalog *old = atomic_exchange(&current, catalog);
+    unsigned long epoch = atomic_fetch_add(&global_epoch, 1);
+
+    if (old != &empty_catalog) {
+        RetiredCatalog *entry = malloc(sizeof(RetiredCatalog));
+        if (entry) {
+            entry->catalog = old;
+            entry->epoch = epoch;
+            entry->next = retired;
+            retired = entry;
+        }
+        // Without memory for the entry the old version is leaked, never freed early
+    }
+
+    reclaim_retired();
+    pthread_mutex_unlock(&writer_lock);
+}
+
+const PlanCatalog *plan_catalog_enter() {
+    if (my_slot == -1) {
+        my_slot = claim_slot();
+    }
+
+    // Announce the epoch first, then read the pointer
+    atomic_store(&reader_epoch[my_slot], atomic_load(&global_epoch));
+    return atomic_load(&current);
+}
+
+void plan_catalog_exit() {
+    if (my_slot != -1) {
+        atomic_store(&reader_epoch[my_slot], EPOCH_IDLE);
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef PLAN_CATALOG_H
+#define PLAN_CATALOG_H
+
+#include "plans.h"
+
+// Most threads that may read the catalog at the same time
+#define CATALOG_MAX_READERS 64
+
+// One published version of the plan list. Never modified after publishing.
+typedef struct {
+    unsigned long version;
+    Table plans;
+} PlanCatalog;
+
+// Function declarations
+
+// Publish a copy of the given plans as the new current version.
+// Readers switch to it atomically; old versions are freed once no reader uses them.
+void plan_catalog_publish(const Table *plans);
+
+// Start reading: returns the current version (never NULL, may be empty).
+// No lock is taken. The returned catalog stays valid until plan_catalog_exit().
+// Do not wait for user input between enter and exit.
+const PlanCatalog *plan_catalog_enter();
+
+// Stop reading the catalog returned by the last plan_catalog_enter()
+void plan_catalog_exit();
+
+#endif
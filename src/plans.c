@@ -1,9 +1,10 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "plans.h"
 #include "utils.h"
 
-void create_plan(Plan *plan, int id, const char *name, float price, const char *desc) {
+void create_plan(Plan *plan, int id, const char *name, Money price, const char *desc) {
     // Set plan ID
     plan->id_plan = id;
     
@@ -17,208 +18,233 @@ void create_plan(Plan *plan, int id, const char *name, float price, const char *
     // Copy plan description (safely)
     strncpy(plan->description, desc, sizeof(plan->description) - 1);
     plan->description[sizeof(plan->description) - 1] = '\0';  // Ensure null terminator
+    
+    // Full access unless the plan is limited afterwards
+    plan->areas = PLAN_AREAS_ALL;
+}
+
+void format_plan_areas(unsigned areas, char *out, int size) {
+    static const char *names[] = { "Weights", "Cardio", "Studio" };
+    int length = 0;
+    
+    out[0] = '\0';
+    for (int i = 0; i < (int)(sizeof(names) / sizeof(names[0])); i++) {
+        if (areas & (1u << i)) {
+            length += snprintf(out + length, length < size ? size - length : 0,
+                               "%s%s", length > 0 ? ", " : "", names[i]);
+        }
+    }
+    if (length == 0) {
+        snprintf(out, size, "None");
+    }
 }
 
-void display_single_plan(Plan *plan) {
-    printf("ID: %d | %s | %.2f DT/month\n", 
-           plan->id_plan, plan->name, plan->price);
+// Ask for a set of areas; 0 is returned as is (callers use it for "keep")
+static unsigned get_areas_input() {
+    while (1) {
+        int areas = get_int_input();
+        if (areas >= 0 && areas <= PLAN_AREAS_ALL) {
+            return (unsigned)areas;
+        }
+        printf("Please enter a number from 0 to %d: ", PLAN_AREAS_ALL);
+    }
+}
+
+void display_single_plan(const Plan *plan) {
+    char price[MONEY_MAX_TEXT];
+    char areas[64];
+    money_format(plan->price, price);
+    format_plan_areas(plan->areas, areas, sizeof(areas));
+    printf("ID: %d | %s | %s DT/month\n", 
+           plan->id_plan, plan->name, price);
     printf("Description: %s\n", plan->description);
+    printf("Areas: %s\n", areas);
 }
 
-void display_plans(Plan plans[], int count) {
-    if (count == 0) {
+// Text format of one plan, generated from PLAN_FIELDS
+SCHEMA_CODEC(plan, Plan, PLAN_FIELDS, "plan")
+
+void display_plans(const Table *plans) {
+    if (plans->live_count == 0) {
         printf("\nNo plans available.\n");
         return;
     }
     
     printf("\n--- Available Plans ---\n");
-    for (int i = 0; i < count; i++) {
-        printf("\nPlan %d:\n", i + 1);
-        display_single_plan(&plans[i]);
+    int number = 1;
+    for (int i = 0; i < plans->count; i++) {
+        // Skip deleted plans
+        if (!table_is_live(plans, i)) {
+            continue;
+        }
+        printf("\nPlan %d:\n", number++);
+        display_single_plan(plan_at(plans, i));
     }
     printf("\n");
 }
 
-int get_next_plan_id(Plan plans[], int count) {
-    // If no plans exist, start with ID 1
-    if (count == 0) {
-        return 1;
-    }
-    
-    // Find the highest ID among existing plans
-    int max_id = plans[0].id_plan;
-    
-    for (int i = 1; i < count; i++) {
-        if (plans[i].id_plan > max_id) {
-            max_id = plans[i].id_plan;
-        }
-    }
-    
-    // Return the next available ID
-    int next_id = max_id + 1;
-    return next_id;
+int get_next_plan_id(const Table *plans) {
+    // The table remembers the highest ID it has seen
+    return table_next_id(plans);
 }
 
-void add_plan_interactive(Plan plans[], int *count) {
-    if (*count >= MAX_PLANS) {
-        printf("\nError: Maximum number of plans reached (%d).\n", MAX_PLANS);
-        return;
-    }
-    
+void ask_new_plan(Plan *plan) {
     char name[50], desc[100];
-    float price;
+    Money price;
     
     printf("\n--- Add New Plan ---\n");
     printf("Plan Name: ");
     get_string_input(name, sizeof(name));
     
     printf("Price (DT/month): ");
-    price = get_float_input();
+    price = get_money_input();
     
     printf("Description: ");
     get_string_input(desc, sizeof(desc));
     
-    int new_id = get_next_plan_id(plans, *count);
-    create_plan(&plans[*count], new_id, name, price, desc);
-    (*count)++;
+    printf("Areas (1 = Weights, 2 = Cardio, 4 = Studio, add them up, 0 = all): ");
+    unsigned areas = get_areas_input();
     
-    printf("\nPlan added successfully! (ID: %d)\n", new_id);
-}
-
-int find_plan_by_id(Plan plans[], int count, int id) {
-    for (int i = 0; i < count; i++) {
-        if (plans[i].id_plan == id) {
-            return i;
-        }
+    create_plan(plan, 0, name, price, desc);
+    if (areas != 0) {
+        plan->areas = areas;
     }
-    return -1;
 }
 
-int modify_plan(Plan plans[], int count, int id) {
-    int index = find_plan_by_id(plans, count, id);
+int add_plan(Table *plans, Plan *plan) {
+    // The ID is given now: another copy of the app may have added plans
+    // while the details were typed
+    plan->id_plan = get_next_plan_id(plans);
     
-    if (index == -1) {
-        printf("\nError: Plan with ID %d not found.\n", id);
+    if (!plan_append(plans, plan)) {
+        printf("\nError: Not enough memory to add the plan.\n");
         return 0;
     }
     
-    printf("\n--- Modify Plan (ID: %d) ---\n", id);
+    printf("\nPlan added successfully! (ID: %d)\n", plan->id_plan);
+    return plan->id_plan;
+}
+
+void add_plan_interactive(Table *plans) {
+    Plan new_plan;
+    ask_new_plan(&new_plan);
+    add_plan(plans, &new_plan);
+}
+
+int find_plan_by_id(const Table *plans, int id) {
+    // Hash index lookup, no scan
+    return table_find_slot(plans, id);
+}
+
+void ask_plan_changes(const Plan *plan, Plan *changes) {
+    memset(changes, 0, sizeof(*changes));
+    changes->id_plan = plan->id_plan;
+    
+    printf("\n--- Modify Plan (ID: %d) ---\n", plan->id_plan);
     printf("Current details:\n");
-    display_single_plan(&plans[index]);
+    display_single_plan(plan);
     
     printf("\nNew Plan Name (or press Enter to keep current): ");
-    char name[50];
-    get_string_input(name, sizeof(name));
+    get_string_input(changes->name, sizeof(changes->name));
+    
+    printf("New Price (or 0 to keep current): ");
+    changes->price = get_money_input();
+    
+    printf("New Description (or press Enter to keep current): ");
+    get_string_input(changes->description, sizeof(changes->description));
     
-    // Check if user entered something
-    int name_length = strlen(name);
-    if (name_length > 0) {
-        // Update the plan name
-        strncpy(plans[index].name, name, sizeof(plans[index].name) - 1);
-        plans[index].name[sizeof(plans[index].name) - 1] = '\0';
+    printf("New Areas (1 = Weights, 2 = Cardio, 4 = Studio, add them up, 0 to keep current): ");
+    changes->areas = get_areas_input();
+}
+
+int apply_plan_changes(Table *plans, const Plan *changes) {
+    // Found again: the table may have been refreshed since the changes were asked
+    Plan *plan = plan_find(plans, changes->id_plan);
+    
+    if (!plan) {
+        printf("\nError: Plan with ID %d not found.\n", changes->id_plan);
+        return 0;
     }
     
-    printf("New Price (or 0 to keep current): ");
-    float price = get_float_input();
+    // Empty text keeps the current value
+    if (changes->name[0] != '\0') {
+        snprintf(plan->name, sizeof(plan->name), "%s", changes->name);
+    }
     
     // Only update if user entered a positive value
-    if (price > 0) {
-        plans[index].price = price;
+    if (changes->price > 0) {
+        plan->price = changes->price;
     }
     
-    printf("New Description (or press Enter to keep current): ");
-    char desc[100];
-    get_string_input(desc, sizeof(desc));
+    if (changes->description[0] != '\0') {
+        snprintf(plan->description, sizeof(plan->description), "%s", changes->description);
+    }
     
-    // Check if user entered something
-    int desc_length = strlen(desc);
-    if (desc_length > 0) {
-        // Update the description
-        strncpy(plans[index].description, desc, sizeof(plans[index].description) - 1);
-        plans[index].description[sizeof(plans[index].description) - 1] = '\0';
+    if (changes->areas != 0) {
+        plan->areas = changes->areas;
     }
     
+    // The record was changed in place: mark the table as changed
+    table_touch_record(plans, plan->id_plan);
+    
     printf("\nPlan modified successfully!\n");
     return 1;
 }
 
-int delete_plan(Plan plans[], int *count, int id) {
-    int index = find_plan_by_id(plans, *count, id);
+int modify_plan(Table *plans, int id) {
+    const Plan *plan = plan_find(plans, id);
     
-    if (index == -1) {
+    if (!plan) {
         printf("\nError: Plan with ID %d not found.\n", id);
         return 0;
     }
     
-    printf("\nDeleting plan: %s\n", plans[index].name);
+    Plan changes;
+    ask_plan_changes(plan, &changes);
+    return apply_plan_changes(plans, &changes);
+}
+
+int delete_plan(Table *plans, int id) {
+    Plan *plan = plan_find(plans, id);
     
-    // Move all plans after the deleted one forward by one position
-    for (int i = index; i < *count - 1; i++) {
-        plans[i] = plans[i + 1];
+    if (!plan) {
+        printf("\nError: Plan with ID %d not found.\n", id);
+        return 0;
     }
     
-    // Decrease the total count
-    (*count)--;
+    printf("\nDeleting plan: %s\n", plan->name);
+    
+    // The plan is only marked as deleted, other plans do not move
+    table_remove(plans, id);
     
     printf("Plan deleted successfully!\n");
     return 1;
 }
 
-int load_plans_from_file(Plan plans[]) {
-    FILE *f = fopen("data/plans.txt", "r");
+int load_plans_from_file(Table *plans) {
+    char path[256];
+    data_file_path(PLANS_FILE, path, sizeof(path));
+    int count = table_load(plans, path);
     
-    if (!f) {
+    if (count == TABLE_NO_FILE) {
         printf("No plans file found. Starting with empty plan list.\n");
         return 0;
     }
     
-    int count;
-    if (fscanf(f, "%d\n", &count) != 1) {
+    if (count == TABLE_BAD_HEADER) {
         printf("Error reading plans file.\n");
-        fclose(f);
         return 0;
     }
     
-    // Read each plan from file
-    for (int i = 0; i < count && i < MAX_PLANS; i++) {
-        // Read: id|name|price|description
-        int fields_read = fscanf(f, "%d|%49[^|]|%f|%99[^\n]\n",
-                                 &plans[i].id_plan,
-                                 plans[i].name,
-                                 &plans[i].price,
-                                 plans[i].description);
-        
-        // Check if we successfully read all 4 fields
-        if (fields_read != 4) {
-            printf("Error reading plan %d from file.\n", i + 1);
-            fclose(f);
-            return i;
-        }
-    }
-    
-    fclose(f);
     printf("Loaded %d plan(s) from file.\n", count);
     return count;
 }
 
-void save_plans_to_file(Plan plans[], int count) {
-    FILE *f = fopen("data/plans.txt", "w");
-    
-    if (!f) {
+void save_plans_to_file(const Table *plans) {
+    if (!table_write(plans, plans->path[0] ? plans->path : PLANS_FILE)) {
         printf("\nError: Cannot save plans to file.\n");
         return;
     }
     
-    fprintf(f, "%d\n", count);
-    
-    for (int i = 0; i < count; i++) {
-        fprintf(f, "%d|%s|%.2f|%s\n",
-                plans[i].id_plan,
-                plans[i].name,
-                plans[i].price,
-                plans[i].description);
-    }
-    
-    fclose(f);
     printf("Plans saved to file successfully.\n");
 }
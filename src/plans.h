@@ -1,46 +1,78 @@
 #ifndef PLANS_H
 #define PLANS_H
 
-#define MAX_PLANS 50
+#include "table.h"
+#include "schema.h"
 
-// Plan structure (subscription types)
+#define PLANS_FILE "data/plans.txt"
+
+// Gym areas a plan can give access to (bits of Plan.areas)
+#define PLAN_AREA_WEIGHTS 0x01
+#define PLAN_AREA_CARDIO  0x02
+#define PLAN_AREA_STUDIO  0x04
+#define PLAN_AREAS_ALL    0x07
+
+// Plan fields (subscription types), in file order: id|name|price|description|areas
+#define PLAN_FIELDS(X)                                              \
+    X(INT,   id_plan,     0)                                        \
+    X(TEXT,  name,        50)   /* e.g., "Musculation Only" */      \
+    X(MONEY, price,       0)    /* monthly price in millimes */     \
+    X(TEXT,  description, 100)  /* e.g., "Musculation + Cardio" */  \
+    X(FLAGS, areas,       0)    /* PLAN_AREA_* bits */
+
+// Plan structure
 typedef struct {
-    int id_plan;
-    char name[50];          // e.g., "Musculation Only"
-    float price;            // monthly price in DT
-    char description[100];  // e.g., "Musculation + Cardio"
+    SCHEMA_STRUCT(PLAN_FIELDS)
 } Plan;
 
+// Plan table helpers: plan_table_init(), plan_at(), plan_find(), plan_append()
+TABLE_TYPE(plan, Plan, id_plan)
+
 // Function declarations
 
-// Initialize a plan with given data
-void create_plan(Plan *plan, int id, const char *name, float price, const char *desc);
+// Initialize a plan with given data (giving access to every area)
+void create_plan(Plan *plan, int id, const char *name, Money price, const char *desc);
+
+// Write the names of the areas in areas, e.g. "Weights, Cardio"
+void format_plan_areas(unsigned areas, char *out, int size);
 
 // Display all plans
-void display_plans(Plan plans[], int count);
+void display_plans(const Table *plans);
 
 // Display a single plan
-void display_single_plan(Plan *plan);
+void display_single_plan(const Plan *plan);
 
 // Add a new plan interactively
-void add_plan_interactive(Plan plans[], int *count);
+void add_plan_interactive(Table *plans);
+
+// The two halves of add_plan_interactive(), so nothing is locked while the
+// admin types: ask for the details, then add the plan with the next free ID
+// (returns the new ID, 0 if failed)
+void ask_new_plan(Plan *plan);
+int add_plan(Table *plans, Plan *plan);
 
-// Find plan by ID (returns index, -1 if not found)
-int find_plan_by_id(Plan plans[], int count, int id);
+// Find plan by ID (returns slot, -1 if not found)
+int find_plan_by_id(const Table *plans, int id);
 
 // Delete plan by ID
-int delete_plan(Plan plans[], int *count, int id);
+int delete_plan(Table *plans, int id);
 
 // Modify plan by ID
-int modify_plan(Plan plans[], int count, int id);
+int modify_plan(Table *plans, int id);
+
+// The two halves of modify_plan(): ask for the new values (empty text and 0
+// keep the current value), then apply them to the plan with the same ID
+// (returns 0 if it is gone)
+void ask_plan_changes(const Plan *plan, Plan *changes);
+int apply_plan_changes(Table *plans, const Plan *changes);
 
-// Load plans from file
-int load_plans_from_file(Plan plans[]);
+// Load plans from file into an initialized table (returns number of plans)
+int load_plans_from_file(Table *plans);
 
 // Save plans to file
-void save_plans_to_file(Plan plans[], int count);
+void save_plans_to_file(const Table *plans);
 
 // Get the next available plan ID
-int get_next_plan_id(Plan plans[], int count);
+int get_next_plan_id(const Table *plans);
 
 #endif
@@ -0,0 +1,397 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "popularity.h"
+#include "plans.h"
+#include "history.h"
+#include "utils.h"
+
+typedef struct {
+    int *count;               // by plan ID
+    int *order;               // plan IDs, highest count first
+    int *position;            // by plan ID: its index in order
+} Ranking;
+
+static Ranking rankings[POPULARITY_RANKINGS];
+static int plan_capacity = 0;      // plan IDs 0 .. plan_capacity - 1 are ranked
+
+// Plan each member is counted under (-1: none), by member ID
+static int *member_plan = NULL;
+static int member_capacity = 0;
+
+// Table and version of it the subscriber counts match
+static const Table *synced_table = NULL;
+static unsigned long synced_version = 0;
+static int synced = 0;
+
+// New subscriptions by plan and hour of the last week:
+// buckets[plan * POPULARITY_WEEK_HOURS + hour % POPULARITY_WEEK_HOURS]
+static int *buckets = NULL;
+static long long current_hour = 0;  // hours since 1970 the windows end at
+static int windows_ready = 0;
+
+static int reserve_plans(int plan_id) {
+    if (plan_id < 0) {
+        return 0;
+    }
+    if (plan_id < plan_capacity) {
+        return 1;
+    }
+
+    int capacity = plan_capacity > 0 ? plan_capacity * 2 : 16;
+    while (capacity <= plan_id) {
+        capacity *= 2;
+    }
+    for (int r = 0; r < POPULARITY_RANKINGS; r++) {
+        Ranking *ranking = &rankings[r];
+        int *count = realloc(ranking->count, sizeof(int) * capacity);
+        if (count) {
+            ranking->count = count;
+        }
+        int *order = count ? realloc(ranking->order, sizeof(int) * capacity) : NULL;
+        if (order) {
+            ranking->order = order;
+        }
+        int *position = order ? realloc(ranking->position, sizeof(int) * capacity) : NULL;
+        if (!position) {
+            return 0;
+        }
+        ranking->position = position;
+    }
+    int *grown = realloc(buckets, sizeof(int) * POPULARITY_WEEK_HOURS * capacity);
+    if (!grown) {
+        return 0;
+    }
+    buckets = grown;
+    memset(buckets + (size_t)POPULARITY_WEEK_HOURS * plan_capacity, 0,
+           sizeof(int) * POPULARITY_WEEK_HOURS * (capacity - plan_capacity));
+
+    // New plans count 0, the lowest: they go at the end of every order
+    for (int r = 0; r < POPULARITY_RANKINGS; r++) {
+        for (int id = plan_capacity; id < capacity; id++) {
+            rankings[r].count[id] = 0;
+            rankings[r].order[id] = id;
+            rankings[r].position[id] = id;
+        }
+    }
+    plan_capacity = capacity;
+    return 1;
+}
+
+static int reserve_members(int member_id) {
+    if (member_id < member_capacity) {
+        return 1;
+    }
+    int capacity = member_capacity > 0 ? member_capacity * 2 : 1024;
+    while (capacity <= member_id) {
+        capacity *= 2;
+    }
+    int *grown = realloc(member_plan, sizeof(int) * capacity);
+    if (!grown) {
+        return 0;
+    }
+    for (int id = member_capacity; id < capacity; id++) {
+        grown[id] = -1;
+    }
+    member_plan = grown;
+    member_capacity = capacity;
+    return 1;
+}
+
+static void swap(Ranking *ranking, int i, int j) {
+    int a = ranking->order[i], b = ranking->order[j];
+    ranking->order[i] = b;
+    ranking->order[j] = a;
+    ranking->position[a] = j;
+    ranking->position[b] = i;
+}
+
+// Count one more or one less for a plan. Plans with the same count sit
+// together in the order: the plan first swaps places with the first (or
+// last) of them, so the order stays sorted after the change.
+static void step(Ranking *ranking, int plan_id, int up) {
+    int at = ranking->position[plan_id];
+    int count = ranking->count[plan_id];
+
+    if (up) {
+        // First plan counted no more than this one (all before it count as much or more)
+        int low = 0, high = at;
+        while (low < high) {
+            int middle = low + (high - low) / 2;
+            if (ranking->count[ranking->order[middle]] > count) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        swap(ranking, low, at);
+        ranking->count[plan_id]++;
+    } else {
+        // Last plan counted no less than this one
+        int low = at, high = plan_capacity - 1;
+        while (low < high) {
+            int middle = low + (high - low + 1) / 2;
+            if (ranking->count[ranking->order[middle]] < count) {
+                high = middle - 1;
+            } else {
+                low = middle;
+            }
+        }
+        swap(ranking, low, at);
+        ranking->count[plan_id]--;
+    }
+}
+
+static void rank_add(Ranking *ranking, int plan_id, int delta) {
+    if (delta == 1 || delta == -1) {
+        if (delta > 0 || ranking->count[plan_id] > 0) {
+            step(ranking, plan_id, delta > 0);
+        }
+        return;
+    }
+
+    // An hour leaving a window: set the count, then slide the plan past
+    // the plans it now passes (one pass instead of one step per subscription)
+    int count = ranking->count[plan_id] + delta;
+    ranking->count[plan_id] = count > 0 ? count : 0;
+    int at = ranking->position[plan_id];
+    while (at > 0 && ranking->count[ranking->order[at - 1]] < ranking->count[plan_id]) {
+        swap(ranking, at - 1, at);
+        at--;
+    }
+    while (at + 1 < plan_capacity && ranking->count[ranking->order[at + 1]] > ranking->count[plan_id]) {
+        swap(ranking, at, at + 1);
+        at++;
+    }
+}
+
+static const int *sort_counts = NULL;
+
+static int compare_plans(const void *a, const void *b) {
+    int x = sort_counts[*(const int *)a], y = sort_counts[*(const int *)b];
+    return (y > x) - (y < x);
+}
+
+static void rebuild(const Table *members) {
+    synced = 0;
+    if (!reserve_members(members->max_id)) {
+        return;
+    }
+    for (int id = 0; id < member_capacity; id++) {
+        member_plan[id] = -1;
+    }
+    Ranking *ranking = &rankings[POPULARITY_CURRENT];
+    for (int id = 0; id < plan_capacity; id++) {
+        ranking->count[id] = 0;
+    }
+
+    for (int i = 0; i < members->count; i++) {
+        if (!table_is_live(members, i)) {
+            continue;
+        }
+        const Member *member = member_at(members, i);
+        int plan_id = member->id_current_plan;
+        if (plan_id < 0 || member->id_member < 0 || !reserve_plans(plan_id)) {
+            continue;
+        }
+        ranking->count[plan_id]++;
+        member_plan[member->id_member] = plan_id;
+    }
+
+    for (int id = 0; id < plan_capacity; id++) {
+        ranking->order[id] = id;
+    }
+    if (plan_capacity > 0) {
+        sort_counts = ranking->count;
+        qsort(ranking->order, plan_capacity, sizeof(int), compare_plans);
+    }
+    for (int i = 0; i < plan_capacity; i++) {
+        ranking->position[ranking->order[i]] = i;
+    }
+
+    synced_table = members;
+    synced_version = members->version;
+    synced = 1;
+}
+
+void popularity_sync(const Table *members) {
+    if (!synced || synced_table != members || synced_version != members->version) {
+        rebuild(members);
+    }
+}
+
+void popularity_track(const Table *members, int member_id) {
+    if (!synced) {
+        return;  // Built when first used
+    }
+    // Only this member's change since the last sync: move just its plan.
+    // Anything more means the table changed elsewhere and needs a rebuild.
+    if (synced_table != members || synced_version + 1 != members->version) {
+        rebuild(members);
+        return;
+    }
+
+    const Member *member = member_find(members, member_id);
+    int plan_id = member ? member->id_current_plan : -1;
+    if (member_id < 0 || !reserve_members(member_id) || (plan_id >= 0 && !reserve_plans(plan_id))) {
+        synced = 0;
+        return;
+    }
+
+    int was = member_plan[member_id];
+    if (was != plan_id) {
+        if (was >= 0) {
+            rank_add(&rankings[POPULARITY_CURRENT], was, -1);
+        }
+        if (plan_id >= 0) {
+            rank_add(&rankings[POPULARITY_CURRENT], plan_id, 1);
+        }
+        member_plan[member_id] = plan_id;
+    }
+    synced_version = members->version;
+}
+
+// Move the windows on to the hour of now: the hours leaving each window
+// are taken off its counts
+static void advance(long long now) {
+    long long hour = now / 3600;
+    if (hour <= current_hour) {
+        return;
+    }
+
+    if (hour - current_hour >= POPULARITY_WEEK_HOURS) {
+        // Everything counted is more than a week old
+        for (int id = 0; id < plan_capacity; id++) {
+            rankings[POPULARITY_DAY].count[id] = 0;
+            rankings[POPULARITY_WEEK].count[id] = 0;
+        }
+        memset(buckets, 0, sizeof(int) * POPULARITY_WEEK_HOURS * plan_capacity);
+    } else {
+        for (long long h = current_hour + 1; h <= hour; h++) {
+            int leaving_day = (int)((h - POPULARITY_DAY_HOURS) % POPULARITY_WEEK_HOURS);
+            int leaving_week = (int)(h % POPULARITY_WEEK_HOURS);
+            for (int id = 0; id < plan_capacity; id++) {
+                int *bucket = &buckets[(size_t)id * POPULARITY_WEEK_HOURS];
+                if (bucket[leaving_day] > 0) {
+                    rank_add(&rankings[POPULARITY_DAY], id, -bucket[leaving_day]);
+                }
+                if (bucket[leaving_week] > 0) {
+                    rank_add(&rankings[POPULARITY_WEEK], id, -bucket[leaving_week]);
+                    bucket[leaving_week] = 0;
+                }
+            }
+        }
+    }
+    current_hour = hour;
+}
+
+static void count_subscription(int plan_id, long long time) {
+    long long hour = time / 3600;
+    if (hour > current_hour) {
+        hour = current_hour;
+    }
+    if (hour <= current_hour - POPULARITY_WEEK_HOURS || !reserve_plans(plan_id)) {
+        return;
+    }
+    buckets[(size_t)plan_id * POPULARITY_WEEK_HOURS + hour % POPULARITY_WEEK_HOURS]++;
+    rank_add(&rankings[POPULARITY_WEEK], plan_id, 1);
+    if (hour > current_hour - POPULARITY_DAY_HOURS) {
+        rank_add(&rankings[POPULARITY_DAY], plan_id, 1);
+    }
+}
+
+static void count_history_event(const HistoryEvent *event, void *context) {
+    (void)context;
+    if (event->type == HISTORY_SUBSCRIBE) {
+        count_subscription(event->plan_id, event->time);
+    }
+}
+
+// The last week of the subscription history, read once
+static void load_windows(long long now) {
+    windows_ready = 1;
+    current_hour = now / 3600;
+
+    char path[256];
+    data_file_path(HISTORY_FILE, path, sizeof(path));
+    history_scan(path, count_history_event, NULL);
+}
+
+void popularity_record_subscription(int plan_id, long long time) {
+    if (!windows_ready) {
+        return;  // Read from the history when first used
+    }
+    advance(time);
+    count_subscription(plan_id, time);
+}
+
+int popularity_top(int ranking, long long now, PlanCount *top, int k) {
+    if (ranking < 0 || ranking >= POPULARITY_RANKINGS) {
+        return 0;
+    }
+    if (ranking != POPULARITY_CURRENT) {
+        if (!windows_ready) {
+            load_windows(now);
+        }
+        advance(now);
+    }
+
+    const Ranking *r = &rankings[ranking];
+    int found = 0;
+    while (found < k && found < plan_capacity && r->count[r->order[found]] > 0) {
+        top[found].plan_id = r->order[found];
+        top[found].count = r->count[r->order[found]];
+        found++;
+    }
+    return found;
+}
+
+void popularity_display(const Table *plans, const Table *members) {
+    static const char *titles[POPULARITY_RANKINGS] = {
+        "Subscribers right now",
+        "New subscriptions, last 24 hours",
+        "New subscriptions, last 7 days",
+    };
+
+    popularity_sync(members);
+    long long now = time(NULL);
+
+    print_header("PLAN POPULARITY");
+    for (int r = 0; r < POPULARITY_RANKINGS; r++) {
+        PlanCount top[POPULARITY_TOP_K];
+        int count = popularity_top(r, now, top, POPULARITY_TOP_K);
+
+        printf("%s%s:\n", r > 0 ? "\n" : "", titles[r]);
+        if (count == 0) {
+            printf("  None\n");
+        }
+        for (int i = 0; i < count; i++) {
+            const Plan *plan = plan_find(plans, top[i].plan_id);
+            printf("  %d. %-30s %5d", i + 1, plan ? plan->name : "(deleted plan)", top[i].count);
+            if (r == POPULARITY_WEEK) {
+                // The trend: how much of the week came in the last day
+                printf("  (%d in the last 24 hours)", rankings[POPULARITY_DAY].count[top[i].plan_id]);
+            }
+            printf("\n");
+        }
+    }
+}
+
+void popularity_free() {
+    for (int r = 0; r < POPULARITY_RANKINGS; r++) {
+        free(rankings[r].count);
+        free(rankings[r].order);
+        free(rankings[r].position);
+        memset(&rankings[r], 0, sizeof(Ranking));
+    }
+    free(buckets);
+    free(member_plan);
+    buckets = NULL;
+    member_plan = NULL;
+    plan_capacity = 0;
+    member_capacity = 0;
+    synced = 0;
+    synced_table = NULL;
+    windows_ready = 0;
+}
@@ -0,0 +1,60 @@
+#ifndef POPULARITY_H
+#define POPULARITY_H
+
+#include "member.h"
+
+// Plan popularity, kept up to date as members subscribe and subscriptions
+// end, so the admin's top plans never need a pass over all members.
+// Each ranking keeps every plan ID ordered by its count; a change of one
+// moves the plan to the edge of its group of equal counts (a binary search
+// and one swap), and the top K plans are the first K of the order.
+//
+// New subscriptions are counted in hourly buckets of the last week, so the
+// day and week windows move by the hour. They are read from the
+// subscription history the first time they are asked for, then counted as
+// subscriptions are made by this copy of the app.
+
+// Rankings
+#define POPULARITY_CURRENT 0      // members subscribed to the plan now
+#define POPULARITY_DAY     1      // new subscriptions in the last 24 hours
+#define POPULARITY_WEEK    2      // new subscriptions in the last 7 days
+#define POPULARITY_RANKINGS 3
+
+#define POPULARITY_DAY_HOURS  24
+#define POPULARITY_WEEK_HOURS (7 * 24)
+
+// Plans listed per ranking by the admin view
+#define POPULARITY_TOP_K 5
+
+typedef struct {
+    int plan_id;
+    int count;
+} PlanCount;
+
+// Function declarations
+
+// Make the subscriber counts match the member table. Only rebuilds
+// (O(members)) if it changed without popularity_track(), e.g. after
+// loading, an import or a refresh from another process.
+void popularity_sync(const Table *members);
+
+// Update the counts after changing (or deleting) one member. Cheap, and
+// does nothing until the counts are first used.
+void popularity_track(const Table *members, int member_id);
+
+// Count a new subscription (call with the time recorded in the history)
+void popularity_record_subscription(int plan_id, long long time);
+
+// The k most popular plans of a ranking at time now (seconds since 1970),
+// most popular first; plans counted 0 are left out. O(k), apart from
+// moving the windows on by the hours passed since the last call.
+// Returns how many were stored in top.
+int popularity_top(int ranking, long long now, PlanCount *top, int k);
+
+// Admin view: top plans by subscribers now and by new subscriptions
+void popularity_display(const Table *plans, const Table *members);
+
+// Free the counts
+void popularity_free();
+
+#endif
@@ -0,0 +1,1090 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime, pthread_cond_timedwait
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "replication.h"
+#include "autosave.h"
+#include "utils.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define TABLE_COUNT 3
+
+// Slots compared at once when looking for changed records
+#define COMPARE_RUN 64
+
+// Free space asked for before each read from the socket
+#define RECEIVE_CHUNK (64 * 1024)
+
+// Letter of each table in the change lines: plans, equipment, members
+static const char table_letters[TABLE_COUNT] = { 'p', 'e', 'm' };
+
+// Growable byte buffer
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+} Buffer;
+
+static int buffer_reserve(Buffer *b, size_t extra) {
+    if (b->length + extra <= b->capacity) {
+        return 1;
+    }
+    size_t capacity = b->capacity > 0 ? b->capacity : 4096;
+    while (capacity < b->length + extra) {
+        capacity *= 2;
+    }
+    char *data = realloc(b->data, capacity);
+    if (!data) {
+        return 0;
+    }
+    b->data = data;
+    b->capacity = capacity;
+    return 1;
+}
+
+static int buffer_append(Buffer *b, const char *text, size_t length) {
+    if (!buffer_reserve(b, length)) {
+        return 0;
+    }
+    memcpy(b->data + b->length, text, length);
+    b->length += length;
+    return 1;
+}
+
+static void buffer_free(Buffer *b) {
+    free(b->data);
+    b->data = NULL;
+    b->length = 0;
+    b->capacity = 0;
+}
+
+static long long now_us() {
+    // Both processes run on the same machine, so their clocks agree
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+static void add_lag(ReplicationStatus *status, long long *samples, long long sent_us) {
+    double lag_ms = (now_us() - sent_us) / 1000.0;
+    (*samples)++;
+    status->last_lag_ms = lag_ms;
+    status->avg_lag_ms += (lag_ms - status->avg_lag_ms) / *samples;
+    if (lag_ms > status->max_lag_ms) {
+        status->max_lag_ms = lag_ms;
+    }
+}
+
+static int set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+static int socket_address(const char *path, struct sockaddr_un *address) {
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address->sun_path)) {
+        printf("Error: Socket path '%s' is too long.\n", path);
+        return 0;
+    }
+    strcpy(address->sun_path, path);
+    return 1;
+}
+
+static void wake_up(int fd) {
+    // The pipe only has to be non-empty, a full pipe is fine
+    char byte = 1;
+    ssize_t written = write(fd, &byte, 1);
+    (void)written;
+}
+
+static void drain(int fd) {
+    char bytes[64];
+    while (read(fd, bytes, sizeof(bytes)) > 0) {
+    }
+}
+
+// ===== Primary =====
+
+// Shared between the app thread (publish) and the network thread
+static pthread_mutex_t primary_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t primary_acked = PTHREAD_COND_INITIALIZER;  // signaled on every acknowledgement
+static pthread_t primary_thread;
+static ReplicationStatus primary;
+static long long primary_acks = 0;
+static char primary_path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+static int listen_fd = -1;
+static int standby_fd = -1;              // connected standby, -1 if none
+static int primary_wake[2] = { -1, -1 };
+static int primary_stopping = 0;
+static int drop_standby = 0;             // set when the standby fell too far behind
+
+// The replicated tables, and a copy of each as it was last sent. The
+// copies are what a new standby gets, and what changes are diffed against.
+static Table *sources[TABLE_COUNT];
+static Table shadows[TABLE_COUNT];
+static int shadow_ok[TABLE_COUNT];       // 0 if a copy ran out of memory
+
+static Buffer queue;                     // batches not fully sent yet
+static size_t queue_sent = 0;            // bytes of queue already sent
+static Buffer batch;                     // lines of the batch being built
+static Buffer removed;                   // ids of records deleted since the last publish
+static Buffer compared;                  // both lines of a record whose bytes changed
+static unsigned long long next_seq = 0;
+
+static int record_id(const Table *t, const void *record) {
+    int id;
+    memcpy(&id, (const char *)record + t->id_offset, sizeof(int));
+    return id;
+}
+
+static int append_upsert(Buffer *out, int t, const Table *table, const void *record) {
+    if (!buffer_reserve(out, table->codec->max_line + 4)) {
+        return 0;
+    }
+    char *line = out->data + out->length;
+    line[0] = 'U';
+    line[1] = ' ';
+    line[2] = table_letters[t];
+    line[3] = ' ';
+    out->length += 4 + table->codec->format(record, line + 4, out->capacity - out->length - 4);
+    return 1;
+}
+
+// Returns 1 if two versions of a record are written the same way: text
+// edits leave old bytes behind the end of a string, which are never sent.
+// Returns -1 if out of memory.
+static int same_line(const Table *table, const void *a, const void *b) {
+    size_t max_line = table->codec->max_line;
+    if (!buffer_reserve(&compared, 2 * max_line)) {
+        return -1;
+    }
+    char *line_a = compared.data;
+    char *line_b = compared.data + max_line;
+    int length_a = table->codec->format(a, line_a, max_line);
+    int length_b = table->codec->format(b, line_b, max_line);
+    return length_a == length_b && memcmp(line_a, line_b, length_a) == 0;
+}
+
+// Bring the shadow's copy of a live record up to date (old is that copy,
+// NULL if the shadow does not have it), writing a line to out if the
+// record really changed. Returns the number of lines, -1 if out of memory.
+static int update_record(int t, const void *record, void *old, Buffer *out) {
+    const Table *now = sources[t];
+    if (old && memcmp(old, record, now->elem_size) == 0) {
+        return 0;
+    }
+
+    int same = old ? same_line(now, old, record) : 0;
+    if (same < 0 || (!same && out && !append_upsert(out, t, now, record))) {
+        return -1;
+    }
+    if (old) {
+        memcpy(old, record, now->elem_size);
+    } else if (!table_append(&shadows[t], record)) {
+        return -1;
+    }
+    return !same;
+}
+
+static int remove_record(int t, int id, Buffer *out) {
+    char line[32];
+    int length = snprintf(line, sizeof(line), "D %c %d\n", table_letters[t], id);
+    if (out && !buffer_append(out, line, length)) {
+        return -1;
+    }
+    table_remove(&shadows[t], id);
+    return 1;
+}
+
+// Bring the shadow of table t up to date from the ids the table logged
+static int append_logged_changes(int t, const int *ids, int count, Buffer *out) {
+    const Table *now = sources[t];
+    Table *before = &shadows[t];
+    int lines = 0;
+
+    // An id logged twice is simply found unchanged the second time
+    for (int k = 0; k < count; k++) {
+        const void *record = table_find(now, ids[k]);
+        void *old = table_find(before, ids[k]);
+        int added = 0;
+        if (record) {
+            added = update_record(t, record, old, out);
+        } else if (old) {
+            added = remove_record(t, ids[k], out);
+        }
+        if (added < 0) {
+            return -1;
+        }
+        lines += added;
+    }
+    return lines;
+}
+
+// Bring the shadow of table t up to date by comparing every record
+static int append_all_changes(int t, Buffer *out) {
+    const Table *now = sources[t];
+    Table *before = &shadows[t];
+    int lines = 0;
+
+    for (int i = 0; i < now->count; i++) {
+        // Records usually stay in the same slot: skip runs that did not change
+        if (i % COMPARE_RUN == 0) {
+            int run = now->count - i < COMPARE_RUN ? now->count - i : COMPARE_RUN;
+            if (table_same_slots(now, before, i, run)) {
+                i += run - 1;
+                continue;
+            }
+        }
+        if (!table_is_live(now, i)) {
+            continue;
+        }
+        const void *record = table_at(now, i);
+        int id = record_id(now, record);
+
+        void *old = NULL;
+        if (i < before->count && table_is_live(before, i) && record_id(before, table_at(before, i)) == id) {
+            old = table_at(before, i);
+        } else {
+            old = table_find(before, id);
+        }
+        int added = update_record(t, record, old, out);
+        if (added < 0) {
+            return -1;
+        }
+        lines += added;
+    }
+
+    // The shadow now holds every record of the table, so it has extra
+    // ones only if records were deleted
+    if (before->live_count > now->live_count) {
+        removed.length = 0;
+        for (int i = 0; i < before->count; i++) {
+            if (!table_is_live(before, i)) {
+                continue;
+            }
+            int id = record_id(before, table_at(before, i));
+            if (!table_find(now, id) && !buffer_append(&removed, (const char *)&id, sizeof(id))) {
+                return -1;
+            }
+        }
+        const int *ids = (const int *)removed.data;
+        for (size_t k = 0; k < removed.length / sizeof(int); k++) {
+            if (remove_record(t, ids[k], out) < 0) {
+                return -1;
+            }
+            lines++;
+        }
+    }
+    return lines;
+}
+
+// Bring the shadow of table t up to date with the table, writing a line
+// for each change to out (NULL when nobody listens). Only the records the
+// table logged are looked at, unless its log is incomplete.
+// Returns the number of changes, -1 if out of memory.
+static int append_changes(int t, Buffer *out) {
+    const int *ids;
+    int count = table_changes(sources[t], &ids);
+    int lines = count >= 0 ? append_logged_changes(t, ids, count, out) : append_all_changes(t, out);
+    if (lines >= 0) {
+        shadows[t].version = sources[t]->version;
+    }
+    return lines;
+}
+
+// Lines replacing the standby's copy of table t with its shadow
+static int append_snapshot(int t, Buffer *out) {
+    const Table *shadow = &shadows[t];
+    char line[8];
+    int length = snprintf(line, sizeof(line), "R %c\n", table_letters[t]);
+    if (!buffer_append(out, line, length)) {
+        return -1;
+    }
+    for (int i = 0; i < shadow->count; i++) {
+        if (table_is_live(shadow, i) && !append_upsert(out, t, shadow, table_at(shadow, i))) {
+            return -1;
+        }
+    }
+    return 1 + shadow->live_count;
+}
+
+// Queue the lines in batch behind a header (primary_lock held)
+static void queue_batch(int lines) {
+    char header[80];
+    int length = snprintf(header, sizeof(header), "B %llu %lld %d\n", next_seq + 1, now_us(), lines);
+
+    if (queue_sent == queue.length) {
+        queue.length = 0;
+        queue_sent = 0;
+    } else if (queue_sent > queue.length / 2) {
+        memmove(queue.data, queue.data + queue_sent, queue.length - queue_sent);
+        queue.length -= queue_sent;
+        queue_sent = 0;
+    }
+
+    // The limit only applies behind other batches, so any snapshot fits
+    size_t waiting = queue.length - queue_sent;
+    if ((waiting > 0 && waiting + length + batch.length > REPLICATION_QUEUE_MAX) ||
+        !buffer_reserve(&queue, length + batch.length)) {
+        drop_standby = 1;
+        return;
+    }
+    buffer_append(&queue, header, length);
+    buffer_append(&queue, batch.data, batch.length);
+
+    next_seq++;
+    primary.last_seq = next_seq;
+    primary.batches++;
+    primary.records += lines;
+    primary.queued_bytes = (long long)(queue.length - queue_sent);
+}
+
+static void close_standby() {
+    close(standby_fd);
+    standby_fd = -1;
+    drop_standby = 0;
+    queue.length = 0;
+    queue_sent = 0;
+    primary.connected = 0;
+    primary.queued_bytes = 0;
+    pthread_cond_broadcast(&primary_acked);
+}
+
+static void accept_standby() {
+    int fd = accept(listen_fd, NULL, NULL);
+    if (fd < 0) {
+        return;
+    }
+    int shadows_complete = 1;
+    for (int t = 0; t < TABLE_COUNT; t++) {
+        shadows_complete = shadows_complete && shadow_ok[t];
+    }
+    // One standby at a time
+    if (standby_fd >= 0 || !shadows_complete || !set_nonblocking(fd)) {
+        close(fd);
+        return;
+    }
+
+    standby_fd = fd;
+    primary.connected = 1;
+
+    // Start with a copy of every table
+    batch.length = 0;
+    int lines = 0;
+    for (int t = 0; t < TABLE_COUNT; t++) {
+        int added = append_snapshot(t, &batch);
+        if (added < 0) {
+            close_standby();
+            return;
+        }
+        lines += added;
+    }
+    queue_batch(lines);
+}
+
+// Read acknowledgements "A <seq> <sent_us>" (primary_lock held)
+static void receive_acks(char *acks, size_t *length) {
+    ssize_t got = recv(standby_fd, acks + *length, 255 - *length, 0);
+    if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return;
+    }
+    if (got <= 0) {
+        close_standby();
+        return;
+    }
+    *length += got;
+    acks[*length] = '\0';
+
+    char *line = acks;
+    char *end;
+    while ((end = strchr(line, '\n')) != NULL) {
+        *end = '\0';
+        unsigned long long seq;
+        long long sent_us;
+        if (sscanf(line, "A %llu %lld", &seq, &sent_us) == 2 && seq > primary.acked_seq) {
+            primary.acked_seq = seq;
+            add_lag(&primary, &primary_acks, sent_us);
+        }
+        line = end + 1;
+    }
+    *length = strlen(line);
+    memmove(acks, line, *length);
+    if (*length == 255) {
+        close_standby();  // Not a standby
+    }
+    pthread_cond_broadcast(&primary_acked);
+}
+
+static void send_queue() {
+    ssize_t sent = send(standby_fd, queue.data + queue_sent, queue.length - queue_sent, 0);
+    if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return;
+    }
+    if (sent <= 0) {
+        close_standby();
+        return;
+    }
+    queue_sent += sent;
+    primary.bytes += sent;
+    primary.queued_bytes = (long long)(queue.length - queue_sent);
+}
+
+static void *primary_main(void *arg) {
+    (void)arg;
+    char acks[256];
+    size_t ack_length = 0;
+
+    pthread_mutex_lock(&primary_lock);
+
+    while (!primary_stopping) {
+        if (drop_standby && standby_fd >= 0) {
+            printf("\nWarning: The standby fell behind and was disconnected.\n");
+            close_standby();
+        }
+
+        struct pollfd fds[3];
+        int count = 2;
+        fds[0].fd = primary_wake[0];
+        fds[0].events = POLLIN;
+        fds[1].fd = listen_fd;
+        fds[1].events = POLLIN;
+        if (standby_fd >= 0) {
+            fds[2].fd = standby_fd;
+            fds[2].events = POLLIN | (queue.length > queue_sent ? POLLOUT : 0);
+            count = 3;
+        }
+
+        // Only this thread opens and closes standby_fd, so it stays the same
+        // while the lock is released
+        pthread_mutex_unlock(&primary_lock);
+        int ready = poll(fds, count, -1);
+        pthread_mutex_lock(&primary_lock);
+        if (ready <= 0) {
+            continue;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            drain(primary_wake[0]);
+        }
+        if (count == 3 && (fds[2].revents & (POLLIN | POLLHUP | POLLERR))) {
+            receive_acks(acks, &ack_length);
+        }
+        if (count == 3 && standby_fd >= 0 && (fds[2].revents & POLLOUT)) {
+            send_queue();
+        }
+        if (fds[1].revents & POLLIN) {
+            int had_standby = standby_fd >= 0;
+            accept_standby();
+            if (!had_standby && standby_fd >= 0) {
+                ack_length = 0;
+            }
+        }
+    }
+
+    if (standby_fd >= 0) {
+        close_standby();
+    }
+    pthread_mutex_unlock(&primary_lock);
+    return NULL;
+}
+
+static void close_primary_files() {
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        unlink(primary_path);
+        listen_fd = -1;
+    }
+    for (int i = 0; i < 2; i++) {
+        if (primary_wake[i] >= 0) {
+            close(primary_wake[i]);
+            primary_wake[i] = -1;
+        }
+    }
+}
+
+int replication_start_primary(const char *socket_path, Table *plans, Table *equipment, Table *members) {
+    struct sockaddr_un address;
+    if (!socket_address(socket_path, &address)) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&primary_lock);
+
+    if (primary.running) {
+        pthread_mutex_unlock(&primary_lock);
+        return 1;
+    }
+
+    // A socket file nobody answers on is left over from a crash
+    int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe >= 0 && connect(probe, (struct sockaddr *)&address, sizeof(address)) == 0) {
+        close(probe);
+        pthread_mutex_unlock(&primary_lock);
+        printf("Error: Another primary is already using %s.\n", socket_path);
+        return 0;
+    }
+    if (probe >= 0) {
+        close(probe);
+    }
+    unlink(socket_path);
+    strcpy(primary_path, socket_path);
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0 || bind(listen_fd, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+        listen(listen_fd, 1) != 0 || !set_nonblocking(listen_fd) || pipe(primary_wake) != 0 ||
+        !set_nonblocking(primary_wake[0]) || !set_nonblocking(primary_wake[1])) {
+        close_primary_files();
+        pthread_mutex_unlock(&primary_lock);
+        printf("Error: Cannot listen on %s.\n", socket_path);
+        return 0;
+    }
+
+    sources[0] = plans;
+    sources[1] = equipment;
+    sources[2] = members;
+    for (int t = 0; t < TABLE_COUNT; t++) {
+        table_init(&shadows[t], sources[t]->elem_size, sources[t]->id_offset, sources[t]->codec);
+        shadow_ok[t] = table_copy(&shadows[t], sources[t]);
+        table_track_changes(sources[t], 1);
+    }
+
+    // A standby that goes away must not end the app
+    signal(SIGPIPE, SIG_IGN);
+
+    memset(&primary, 0, sizeof(primary));
+    primary_acks = 0;
+    next_seq = 0;
+    primary_stopping = 0;
+    if (pthread_create(&primary_thread, NULL, primary_main, NULL) != 0) {
+        close_primary_files();
+        for (int t = 0; t < TABLE_COUNT; t++) {
+            table_track_changes(sources[t], 0);
+            table_free(&shadows[t]);
+        }
+        pthread_mutex_unlock(&primary_lock);
+        printf("Error: Cannot start replication.\n");
+        return 0;
+    }
+    primary.running = 1;
+
+    pthread_mutex_unlock(&primary_lock);
+    return 1;
+}
+
+void replication_publish(const Table *t) {
+    pthread_mutex_lock(&primary_lock);
+
+    int source = -1;
+    for (int i = 0; i < TABLE_COUNT && primary.running; i++) {
+        if (sources[i] == t) {
+            source = i;
+        }
+    }
+    if (source == -1 || (shadow_ok[source] && t->version == shadows[source].version)) {
+        pthread_mutex_unlock(&primary_lock);
+        return;
+    }
+
+    // Only a connected standby needs the lines, a new one gets a snapshot
+    int listening = standby_fd >= 0 && !drop_standby;
+    int lines = -1;
+    if (shadow_ok[source]) {
+        batch.length = 0;
+        lines = append_changes(source, listening ? &batch : NULL);
+    }
+    if (lines < 0) {
+        // Out of memory (or an earlier copy failed): start over from a full copy
+        shadow_ok[source] = table_copy(&shadows[source], t);
+        if (!shadow_ok[source]) {
+            printf("\nWarning: Not enough memory to replicate the %s table.\n", t->codec->name);
+        }
+        drop_standby = listening;
+    } else if (lines > 0 && listening) {
+        queue_batch(lines);
+    }
+    // The shadow holds every change logged so far
+    table_forget_changes(sources[source]);
+
+    pthread_mutex_unlock(&primary_lock);
+    wake_up(primary_wake[1]);
+}
+
+int replication_flush(int timeout_ms) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+    deadline.tv_nsec %= 1000000000L;
+
+    pthread_mutex_lock(&primary_lock);
+    while (primary.running && standby_fd >= 0 && primary.acked_seq < primary.last_seq) {
+        if (pthread_cond_timedwait(&primary_acked, &primary_lock, &deadline) != 0) {
+            break;  // Timed out
+        }
+    }
+    int up_to_date = !(primary.running && standby_fd >= 0 && primary.acked_seq < primary.last_seq);
+    pthread_mutex_unlock(&primary_lock);
+    return up_to_date;
+}
+
+void replication_stop_primary() {
+    pthread_mutex_lock(&primary_lock);
+    if (!primary.running) {
+        pthread_mutex_unlock(&primary_lock);
+        return;
+    }
+    primary_stopping = 1;
+    pthread_mutex_unlock(&primary_lock);
+
+    wake_up(primary_wake[1]);
+    pthread_join(primary_thread, NULL);
+
+    pthread_mutex_lock(&primary_lock);
+    close_primary_files();
+    for (int t = 0; t < TABLE_COUNT; t++) {
+        table_track_changes(sources[t], 0);
+        table_free(&shadows[t]);
+        sources[t] = NULL;
+    }
+    buffer_free(&queue);
+    buffer_free(&batch);
+    buffer_free(&removed);
+    buffer_free(&compared);
+    queue_sent = 0;
+    primary.running = 0;
+    pthread_mutex_unlock(&primary_lock);
+}
+
+// ===== Standby =====
+
+static pthread_mutex_t standby_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t standby_thread;
+static ReplicationStatus standby;
+static long long standby_samples = 0;
+static char standby_path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+static int standby_wake[2] = { -1, -1 };
+static int standby_stopping = 0;
+
+// Tables the receiver applies changes to (only it touches them while running)
+static Table *targets[TABLE_COUNT];
+static char *record_buffer = NULL;      // room for the largest record
+
+// Batch being applied
+typedef struct {
+    int remaining;                      // lines still to come, 0 = expecting a header
+    int lines;
+    unsigned long long seq;
+    long long sent_us;
+    int touched[TABLE_COUNT];
+    unsigned long long ack_seq;         // newest batch applied but not acknowledged
+    long long ack_sent_us;
+} ApplyState;
+
+static int standby_should_stop() {
+    pthread_mutex_lock(&standby_lock);
+    int stop = standby_stopping;
+    pthread_mutex_unlock(&standby_lock);
+    return stop;
+}
+
+static void apply_record_line(char *line) {
+    int t;
+    for (t = 0; t < TABLE_COUNT && table_letters[t] != line[2]; t++) {
+    }
+    if (line[1] != ' ' || t == TABLE_COUNT) {
+        return;
+    }
+    Table *table = targets[t];
+
+    switch (line[0]) {
+        case 'R':
+            table_clear(table);
+            break;
+        case 'D':
+            table_remove(table, atoi(line + 4));
+            break;
+        case 'U': {
+            memset(record_buffer, 0, table->elem_size);
+            if (line[3] != ' ' || !table->codec->parse(line + 4, record_buffer)) {
+                return;
+            }
+            void *existing = table_find(table, record_id(table, record_buffer));
+            if (existing) {
+                memcpy(existing, record_buffer, table->elem_size);
+                table_touch(table);
+            } else {
+                table_append(table, record_buffer);
+            }
+            break;
+        }
+        default:
+            return;
+    }
+}
+
+static void finish_batch(ApplyState *state) {
+    pthread_mutex_lock(&standby_lock);
+    standby.last_seq = state->seq;
+    standby.batches++;
+    standby.records += state->lines;
+    add_lag(&standby, &standby_samples, state->sent_us);
+    pthread_mutex_unlock(&standby_lock);
+
+    state->ack_seq = state->seq;
+    state->ack_sent_us = state->sent_us;
+}
+
+static void apply_line(char *line, ApplyState *state) {
+    if (state->remaining == 0) {
+        if (sscanf(line, "B %llu %lld %d", &state->seq, &state->sent_us, &state->remaining) != 3 ||
+            state->remaining < 0) {
+            state->remaining = 0;
+            return;
+        }
+        state->lines = state->remaining;
+        if (state->remaining == 0) {
+            finish_batch(state);
+        }
+        return;
+    }
+
+    apply_record_line(line);
+    for (int t = 0; t < TABLE_COUNT; t++) {
+        state->touched[t] |= line[2] == table_letters[t];
+    }
+    if (--state->remaining == 0) {
+        finish_batch(state);
+    }
+}
+
+// Save what the received batches changed
+static void save_tables(ApplyState *state) {
+    for (int t = 0; t < TABLE_COUNT; t++) {
+        if (state->touched[t]) {
+            autosave_table(targets[t]);
+            state->touched[t] = 0;
+        }
+    }
+}
+
+// Acknowledge the newest batch applied (returns 0 if the primary is gone)
+static int acknowledge(int fd, ApplyState *state) {
+    if (state->ack_seq == 0) {
+        return 1;
+    }
+    char ack[64];
+    int length = snprintf(ack, sizeof(ack), "A %llu %lld\n", state->ack_seq, state->ack_sent_us);
+    state->ack_seq = 0;
+    return send(fd, ack, length, 0) == length;
+}
+
+// Apply batches until the primary goes away or the standby is stopped
+static void receive_batches(int fd, Buffer *in) {
+    ApplyState state;
+    memset(&state, 0, sizeof(state));
+    in->length = 0;
+
+    while (1) {
+        // Nothing more to apply for now: the saver can have the tables
+        autosave_poll();
+
+        struct pollfd fds[2];
+        fds[0].fd = fd;
+        fds[0].events = POLLIN;
+        fds[1].fd = standby_wake[0];
+        fds[1].events = POLLIN;
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (fds[1].revents & POLLIN) {
+            break;
+        }
+
+        if (!buffer_reserve(in, RECEIVE_CHUNK)) {
+            break;
+        }
+        ssize_t got = recv(fd, in->data + in->length, in->capacity - in->length, 0);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            break;
+        }
+        in->length += got;
+
+        pthread_mutex_lock(&standby_lock);
+        standby.bytes += got;
+        pthread_mutex_unlock(&standby_lock);
+
+        // Apply every complete line, keep the rest for the next read
+        char *line = in->data;
+        char *end = in->data + in->length;
+        char *newline;
+        while ((newline = memchr(line, '\n', end - line)) != NULL) {
+            *newline = '\0';
+            apply_line(line, &state);
+            line = newline + 1;
+        }
+        in->length = end - line;
+        memmove(in->data, line, in->length);
+
+        save_tables(&state);
+        if (!acknowledge(fd, &state)) {
+            break;
+        }
+    }
+
+    // A batch cut short is replaced by the snapshot sent on reconnect
+    save_tables(&state);
+    autosave_poll();
+}
+
+static void *standby_main(void *arg) {
+    (void)arg;
+    Buffer in = { NULL, 0, 0 };
+    struct sockaddr_un address;
+    socket_address(standby_path, &address);
+
+    while (!standby_should_stop()) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0 && connect(fd, (struct sockaddr *)&address, sizeof(address)) == 0) {
+            pthread_mutex_lock(&standby_lock);
+            standby.connected = 1;
+            pthread_mutex_unlock(&standby_lock);
+
+            receive_batches(fd, &in);
+
+            pthread_mutex_lock(&standby_lock);
+            standby.connected = 0;
+            pthread_mutex_unlock(&standby_lock);
+            close(fd);
+            continue;
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+
+        // Primary not there (yet): try again a little later
+        struct pollfd wake = { standby_wake[0], POLLIN, 0 };
+        poll(&wake, 1, REPLICATION_RETRY_MS);
+    }
+
+    buffer_free(&in);
+    return NULL;
+}
+
+int replication_start_standby(const char *socket_path, Table *plans, Table *equipment, Table *members) {
+    struct sockaddr_un address;
+    if (!socket_address(socket_path, &address)) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&standby_lock);
+    if (standby.running) {
+        pthread_mutex_unlock(&standby_lock);
+        return 1;
+    }
+
+    targets[0] = plans;
+    targets[1] = equipment;
+    targets[2] = members;
+    size_t largest = 0;
+    for (int t = 0; t < TABLE_COUNT; t++) {
+        if (targets[t]->elem_size > largest) {
+            largest = targets[t]->elem_size;
+        }
+    }
+    record_buffer = malloc(largest);
+    if (!record_buffer || pipe(standby_wake) != 0) {
+        free(record_buffer);
+        record_buffer = NULL;
+        pthread_mutex_unlock(&standby_lock);
+        printf("Error: Cannot start the standby.\n");
+        return 0;
+    }
+    strcpy(standby_path, socket_path);
+    signal(SIGPIPE, SIG_IGN);
+
+    memset(&standby, 0, sizeof(standby));
+    standby_samples = 0;
+    standby_stopping = 0;
+    if (pthread_create(&standby_thread, NULL, standby_main, NULL) != 0) {
+        close(standby_wake[0]);
+        close(standby_wake[1]);
+        free(record_buffer);
+        record_buffer = NULL;
+        pthread_mutex_unlock(&standby_lock);
+        printf("Error: Cannot start the standby.\n");
+        return 0;
+    }
+    standby.running = 1;
+
+    pthread_mutex_unlock(&standby_lock);
+    return 1;
+}
+
+void replication_stop_standby() {
+    pthread_mutex_lock(&standby_lock);
+    if (!standby.running) {
+        pthread_mutex_unlock(&standby_lock);
+        return;
+    }
+    standby_stopping = 1;
+    pthread_mutex_unlock(&standby_lock);
+
+    wake_up(standby_wake[1]);
+    pthread_join(standby_thread, NULL);
+
+    pthread_mutex_lock(&standby_lock);
+    close(standby_wake[0]);
+    close(standby_wake[1]);
+    standby_wake[0] = standby_wake[1] = -1;
+    free(record_buffer);
+    record_buffer = NULL;
+    standby.running = 0;
+    standby.connected = 0;
+    pthread_mutex_unlock(&standby_lock);
+}
+
+void replication_status(int role, ReplicationStatus *status) {
+    pthread_mutex_t *lock = role == REPLICATION_PRIMARY ? &primary_lock : &standby_lock;
+    pthread_mutex_lock(lock);
+    *status = role == REPLICATION_PRIMARY ? primary : standby;
+    pthread_mutex_unlock(lock);
+}
+
+static void print_status(int role) {
+    ReplicationStatus s;
+    replication_status(role, &s);
+
+    if (role == REPLICATION_PRIMARY) {
+        printf("Role        : Primary (%s)\n", primary_path);
+        printf("Standby     : %s\n", s.connected ? "Connected" : "Not connected");
+        printf("Batches     : %lld sent (last #%llu, applied #%llu)\n", s.batches, s.last_seq, s.acked_seq);
+        printf("Records     : %lld sent, %lld bytes (%lld waiting)\n", s.records, s.bytes, s.queued_bytes);
+    } else {
+        printf("Role        : Standby (%s)\n", standby_path);
+        printf("Primary     : %s\n", s.connected ? "Connected" : "Not connected, retrying");
+        printf("Batches     : %lld applied (last #%llu)\n", s.batches, s.last_seq);
+        printf("Records     : %lld applied, %lld bytes received\n", s.records, s.bytes);
+    }
+    printf("Lag         : last %.2f ms, average %.2f ms, max %.2f ms\n", s.last_lag_ms, s.avg_lag_ms,
+           s.max_lag_ms);
+}
+
+int replication_standby_menu() {
+    int choice;
+
+    do {
+        print_header("STANDBY");
+        print_status(REPLICATION_STANDBY);
+        print_separator();
+        printf("1 - Refresh Status\n");
+        printf("2 - Promote to Primary\n");
+        printf("0 - Stop Standby\n");
+        print_separator();
+        printf("Your choice: ");
+        choice = get_int_input();
+
+        switch (choice) {
+            case 1:
+                break;
+
+            case 2:
+                replication_stop_standby();
+                printf("\n[SUCCESS] Standby promoted, the app now runs on the replicated data.\n");
+                pause_screen();
+                return 1;
+
+            case 0:
+                replication_stop_standby();
+                return 0;
+
+            default:
+                printf("\nInvalid choice. Try again.\n");
+                pause_screen();
+        }
+    } while (1);
+}
+
+void replication_display_status() {
+    print_header("REPLICATION STATUS");
+
+    ReplicationStatus s;
+    replication_status(REPLICATION_PRIMARY, &s);
+    if (!s.running) {
+        printf("Replication is off (start the app with --replicate to feed a standby).\n");
+        return;
+    }
+    print_status(REPLICATION_PRIMARY);
+}
+
+#else
+
+// Local sockets need POSIX; other systems run without a standby
+
+int replication_start_primary(const char *socket_path, Table *plans, Table *equipment, Table *members) {
+    (void)socket_path;
+    (void)plans;
+    (void)equipment;
+    (void)members;
+    printf("Warning: Replication is not supported on this system.\n");
+    return 0;
+}
+
+void replication_publish(const Table *t) {
+    (void)t;
+}
+
+int replication_flush(int timeout_ms) {
+    (void)timeout_ms;
+    return 1;
+}
+
+void replication_stop_primary() {
+}
+
+int replication_start_standby(const char *socket_path, Table *plans, Table *equipment, Table *members) {
+    (void)socket_path;
+    (void)plans;
+    (void)equipment;
+    (void)members;
+    printf("Warning: Replication is not supported on this system.\n");
+    return 0;
+}
+
+void replication_stop_standby() {
+}
+
+void replication_status(int role, ReplicationStatus *status) {
+    (void)role;
+    memset(status, 0, sizeof(*status));
+}
+
+int replication_standby_menu() {
+    return 1;
+}
+
+void replication_display_status() {
+    print_header("REPLICATION STATUS");
+    printf("Replication is not supported on this system.\n");
+}
+
+#endif
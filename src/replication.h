@@ -0,0 +1,82 @@
+#ifndef REPLICATION_H
+#define REPLICATION_H
+
+#include "table.h"
+
+// Log shipping to a warm standby. The primary (--replicate) sends every
+// change to its plans, equipment and members as a batch of text lines over
+// a local socket; the standby (--standby, started from its own folder)
+// applies each batch to its tables, saves them and acknowledges it.
+//
+//   B <seq> <sent_us> <lines>     start of a batch of <lines> lines
+//   R <table>                     remove every record (start of a snapshot)
+//   U <table> <record line>       add or replace a record (data file format)
+//   D <table> <id>                delete a record
+//   A <seq> <sent_us>             standby -> primary: batch applied
+//
+// <table> is p, e or m. A standby that connects gets a snapshot first.
+#define REPLICATION_SOCKET "/tmp/gym_replication.sock"
+
+// Changes waiting to be sent; a standby that falls further behind is
+// disconnected and catches up with a new snapshot when it reconnects
+#define REPLICATION_QUEUE_MAX (16 << 20)
+
+// How often the standby tries to reach the primary, and how long the
+// primary waits for the last acknowledgement when it exits (milliseconds)
+#define REPLICATION_RETRY_MS 500
+#define REPLICATION_FLUSH_MS 2000
+
+// Roles for replication_status()
+#define REPLICATION_PRIMARY 1
+#define REPLICATION_STANDBY 2
+
+typedef struct {
+    int running;                   // 1 if this role is active
+    int connected;                 // 1 while the other side is connected
+    unsigned long long last_seq;   // primary: last batch sent, standby: last batch applied
+    unsigned long long acked_seq;  // primary: last batch the standby applied
+    long long batches;             // batches sent or applied
+    long long records;             // record lines sent or applied
+    long long bytes;               // bytes sent or received
+    long long queued_bytes;        // primary: bytes not sent yet
+    double last_lag_ms;            // from the change to its acknowledgement (or apply)
+    double avg_lag_ms;
+    double max_lag_ms;
+} ReplicationStatus;
+
+// Function declarations
+
+// Start sending changes of these tables to a standby that connects on
+// socket_path (returns 1 if listening, 0 if failed)
+int replication_start_primary(const char *socket_path, Table *plans, Table *equipment, Table *members);
+
+// Send what changed in t since its last publish (called by autosave_table).
+// Does nothing for other tables or when the primary is not running.
+void replication_publish(const Table *t);
+
+// Wait until the standby acknowledged every batch sent, at most timeout_ms.
+// Returns 1 if it is up to date (or no standby is connected).
+int replication_flush(int timeout_ms);
+
+// Stop the primary and close the socket
+void replication_stop_primary();
+
+// Connect to the primary on socket_path (retrying until it is there) and
+// apply its changes to these tables from a background thread.
+// Returns 1 if the receiver thread started.
+int replication_start_standby(const char *socket_path, Table *plans, Table *equipment, Table *members);
+
+// Stop applying changes; the tables then belong to the caller again
+void replication_stop_standby();
+
+// Statistics of one role
+void replication_status(int role, ReplicationStatus *status);
+
+// Standby screen: status until the admin promotes (returns 1) or stops
+// (returns 0) the standby
+int replication_standby_menu();
+
+// Admin view of the replication state
+void replication_display_status();
+
+#endif
@@ -0,0 +1,318 @@
+#ifndef SCHEMA_H
+#define SCHEMA_H
+
+#include <limits.h>
+#include <string.h>
+#include "table.h"
+#include "money.h"
+
+// Record schemas: each record type lists its fields once, as an X-macro
+//
+//   #define PLAN_FIELDS(X)  X(INT, id_plan, 0)  X(TEXT, name, 50) ...
+//
+// and the struct, the text parser and the text formatter are all generated
+// from that list, so adding a field is a single edit.
+//
+// Field kinds (the third value is the array size for TEXT and SECRET, unused
+// otherwise):
+//   INT    int, written in decimal
+//   COUNT  int, written in decimal; a missing field at the end of the line
+//          reads as 0, so counters can be appended to existing files
+//   MONEY  Money (integer millimes), written like "49.90"
+//   TIME   long long seconds since 1970; a missing field at the end of
+//          the line reads as 0, so fields of this kind can be appended to
+//          existing files
+//   FLAGS  unsigned bit set, written in decimal; a missing field at the end
+//          of the line reads as every bit set, so existing records keep
+//          every permission the field can grant
+//   TEXT   char[size], written as is (must not contain '|' or a newline)
+//   SECRET like TEXT, but left out of exports (passwords)
+//
+// The text format is one line per record with the fields separated by '|'.
+
+// Struct member of each kind
+#define SCHEMA_MEMBER_INT(name, size)   int name;
+#define SCHEMA_MEMBER_COUNT(name, size) int name;
+#define SCHEMA_MEMBER_MONEY(name, size) Money name;
+#define SCHEMA_MEMBER_TIME(name, size)  long long name;
+#define SCHEMA_MEMBER_FLAGS(name, size) unsigned name;
+#define SCHEMA_MEMBER_TEXT(name, size)  char name[size];
+#define SCHEMA_MEMBER_SECRET(name, size) char name[size];
+#define SCHEMA_MEMBER(kind, name, size) SCHEMA_MEMBER_##kind(name, size)
+
+// Longest text of each kind, including the '|' or '\n' after it
+#define SCHEMA_MAX_INT(size)   12
+#define SCHEMA_MAX_COUNT(size) 12
+#define SCHEMA_MAX_MONEY(size) MONEY_MAX_TEXT
+#define SCHEMA_MAX_TIME(size)  21
+#define SCHEMA_MAX_FLAGS(size) 11
+#define SCHEMA_MAX_TEXT(size)  (size)
+#define SCHEMA_MAX_SECRET(size) (size)
+#define SCHEMA_MAX(kind, name, size) + SCHEMA_MAX_##kind(size)
+
+// Field readers: parse the field starting at *p, stop at '|' or the end of
+// the line and move *p past the '|'. Return 0 if the field is malformed.
+
+static inline int schema_read_INT(char **p, int *out, size_t size) {
+    (void)size;
+    char *s = *p;
+    int negative = (*s == '-');
+    s += negative;
+
+    if (*s < '0' || *s > '9') {
+        return 0;
+    }
+
+    int value = 0;
+    while (*s >= '0' && *s <= '9') {
+        int digit = *s++ - '0';
+        if (value > (INT_MAX - digit) / 10) {
+            return 0;  // Too large for the field
+        }
+        value = value * 10 + digit;
+    }
+    if (*s != '|' && *s != '\0') {
+        return 0;
+    }
+
+    *out = negative ? -value : value;
+    *p = s + (*s == '|');
+    return 1;
+}
+
+static inline int schema_read_COUNT(char **p, int *out, size_t size) {
+    if (**p == '\0') {
+        *out = 0;  // Written before the field existed
+        return 1;
+    }
+    return schema_read_INT(p, out, size);
+}
+
+static inline int schema_read_TIME(char **p, long long *out, size_t size) {
+    (void)size;
+    char *s = *p;
+
+    if (*s == '\0') {
+        *out = 0;  // Written before the field existed
+        return 1;
+    }
+
+    int negative = (*s == '-');
+    s += negative;
+    if (*s < '0' || *s > '9') {
+        return 0;
+    }
+
+    long long value = 0;
+    while (*s >= '0' && *s <= '9') {
+        int digit = *s++ - '0';
+        if (value > (LLONG_MAX - digit) / 10) {
+            return 0;  // Too large for the field
+        }
+        value = value * 10 + digit;
+    }
+    if (*s != '|' && *s != '\0') {
+        return 0;
+    }
+
+    *out = negative ? -value : value;
+    *p = s + (*s == '|');
+    return 1;
+}
+
+static inline int schema_read_FLAGS(char **p, unsigned *out, size_t size) {
+    (void)size;
+    char *s = *p;
+
+    if (*s == '\0') {
+        *out = ~0u;  // Written before the field existed
+        return 1;
+    }
+    if (*s < '0' || *s > '9') {
+        return 0;
+    }
+
+    unsigned value = 0;
+    while (*s >= '0' && *s <= '9') {
+        unsigned digit = (unsigned)(*s++ - '0');
+        if (value > (UINT_MAX - digit) / 10) {
+            return 0;  // Too large for the field
+        }
+        value = value * 10 + digit;
+    }
+    if (*s != '|' && *s != '\0') {
+        return 0;
+    }
+
+    *out = value;
+    *p = s + (*s == '|');
+    return 1;
+}
+
+static inline int schema_read_MONEY(char **p, Money *out, size_t size) {
+    (void)size;
+    const char *end = money_parse(*p, out);
+
+    if (!end || (*end != '|' && *end != '\0')) {
+        return 0;
+    }
+    *p = (char *)end + (*end == '|');
+    return 1;
+}
+
+static inline int schema_read_TEXT(char **p, char *out, size_t size) {
+    char *s = *p;
+    char *bar = strchr(s, '|');
+    size_t length = bar ? (size_t)(bar - s) : strlen(s);
+
+    if (length == 0) {
+        return 0;
+    }
+    // Too long values are cut, like the old "%49[^|]" formats did
+    size_t kept = length < size ? length : size - 1;
+    memcpy(out, s, kept);
+    out[kept] = '\0';
+
+    *p = s + length + (bar != NULL);
+    return 1;
+}
+
+static inline int schema_read_SECRET(char **p, char *out, size_t size) {
+    return schema_read_TEXT(p, out, size);
+}
+
+// Field writers: append the field and a '|' at *o (the caller guarantees
+// room for SCHEMA_MAX_* characters).
+
+static inline void schema_write_INT(char **o, const int *value, size_t size) {
+    (void)size;
+    char digits[12];
+    int n = 0;
+    unsigned v = *value < 0 ? 0u - (unsigned)*value : (unsigned)*value;
+
+    do {
+        digits[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+
+    char *out = *o;
+    if (*value < 0) {
+        *out++ = '-';
+    }
+    while (n > 0) {
+        *out++ = digits[--n];
+    }
+    *out++ = '|';
+    *o = out;
+}
+
+static inline void schema_write_COUNT(char **o, const int *value, size_t size) {
+    schema_write_INT(o, value, size);
+}
+
+static inline void schema_write_TIME(char **o, const long long *value, size_t size) {
+    (void)size;
+    char digits[20];
+    int n = 0;
+    unsigned long long v = *value < 0 ? 0ull - (unsigned long long)*value
+                                      : (unsigned long long)*value;
+
+    do {
+        digits[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+
+    char *out = *o;
+    if (*value < 0) {
+        *out++ = '-';
+    }
+    while (n > 0) {
+        *out++ = digits[--n];
+    }
+    *out++ = '|';
+    *o = out;
+}
+
+static inline void schema_write_FLAGS(char **o, const unsigned *value, size_t size) {
+    (void)size;
+    char digits[10];
+    int n = 0;
+    unsigned v = *value;
+
+    do {
+        digits[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+
+    char *out = *o;
+    while (n > 0) {
+        *out++ = digits[--n];
+    }
+    *out++ = '|';
+    *o = out;
+}
+
+static inline void schema_write_MONEY(char **o, const Money *value, size_t size) {
+    (void)size;
+    *o += money_format(*value, *o);
+    *(*o)++ = '|';
+}
+
+static inline void schema_write_TEXT(char **o, const char *value, size_t size) {
+    const char *nul = memchr(value, '\0', size - 1);
+    size_t length = nul ? (size_t)(nul - value) : size - 1;
+    memcpy(*o, value, length);
+    (*o)[length] = '|';
+    *o += length + 1;
+}
+
+static inline void schema_write_SECRET(char **o, const char *value, size_t size) {
+    schema_write_TEXT(o, value, size);
+}
+
+// Address of a field as the reader/writer of its kind expects it
+#define SCHEMA_ADDR_INT(record, name)   (&(record)->name)
+#define SCHEMA_ADDR_COUNT(record, name) (&(record)->name)
+#define SCHEMA_ADDR_MONEY(record, name) (&(record)->name)
+#define SCHEMA_ADDR_TIME(record, name)  (&(record)->name)
+#define SCHEMA_ADDR_FLAGS(record, name) (&(record)->name)
+#define SCHEMA_ADDR_TEXT(record, name)  ((record)->name)
+#define SCHEMA_ADDR_SECRET(record, name) ((record)->name)
+
+#define SCHEMA_READ(kind, name, size)                                       \
+    if (!schema_read_##kind(&p, SCHEMA_ADDR_##kind(r, name), size)) {       \
+        return 0;                                                           \
+    }
+
+#define SCHEMA_WRITE(kind, name, size) \
+    schema_write_##kind(&o, SCHEMA_ADDR_##kind(r, name), size);
+
+// The struct of a schema: typedef struct { SCHEMA_STRUCT(PLAN_FIELDS) } Plan;
+#define SCHEMA_STRUCT(FIELDS) FIELDS(SCHEMA_MEMBER)
+
+// Longest formatted line of a schema, including '\n'
+#define SCHEMA_MAX_LINE(FIELDS) (0 FIELDS(SCHEMA_MAX))
+
+// Define the table codec <prefix>_codec of a schema (in the module's .c file).
+// The parser and formatter are unrolled over the fields at compile time.
+#define SCHEMA_CODEC(prefix, Type, FIELDS, label)                               \
+    static int parse_##prefix(char *line, void *record) {                       \
+        Type *r = record;                                                       \
+        char *p = line;                                                         \
+        FIELDS(SCHEMA_READ)                                                     \
+        return 1;                                                               \
+    }                                                                           \
+    static int format_##prefix(const void *record, char *out, size_t size) {    \
+        const Type *r = record;                                                 \
+        char *o = out;                                                          \
+        if (size < SCHEMA_MAX_LINE(FIELDS)) {                                   \
+            return 0;                                                           \
+        }                                                                       \
+        FIELDS(SCHEMA_WRITE)                                                    \
+        o[-1] = '\n';  /* the last '|' ends the line */                         \
+        return (int)(o - out);                                                  \
+    }                                                                           \
+    const TableCodec prefix##_codec = { label, SCHEMA_MAX_LINE(FIELDS),         \
+                                        parse_##prefix, format_##prefix };
+
+#endif
@@ -0,0 +1,446 @@
+#define _GNU_SOURCE  // shm_open, robust and process-shared pthread objects
+
+#include <stdio.h>
+#include <string.h>
+#include "shared_tables.h"
+#include "plan_catalog.h"
+#include "utils.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define TABLE_COUNT 6
+
+// Layout of the shared-memory segment. The records of each table live in
+// a segment of their own, which is replaced by a bigger one when the
+// table outgrows it.
+typedef struct {
+    int initialized;              // set once the first process filled the segment
+    int attached;                 // number of processes using the segment
+    pthread_mutex_t edit_lock;    // held for a whole edit, serializes writers
+    pthread_rwlock_t data_lock;   // held only while tables are copied in or out
+    unsigned long version[TABLE_COUNT];  // bumped every time a table is published
+    int count[TABLE_COUNT];
+    int capacity[TABLE_COUNT];    // records the table's segment holds
+    int generation[TABLE_COUNT];  // bumped each time a table moves to a bigger segment
+} SharedSegment;
+
+static SharedSegment *segment = NULL;
+
+// Name of the segment: each branch (--branch) has its own
+static char segment_name[64] = SHARED_TABLES_NAME;
+
+// This process's tables, the segment version each one last saw, and the
+// local version it had at that moment (a different one means local edits)
+static Table *local_tables[TABLE_COUNT];
+static unsigned long seen_version[TABLE_COUNT];
+static unsigned long synced_version[TABLE_COUNT];
+
+// This process's mapping of each table's records, and which generation it is
+static char *records[TABLE_COUNT];
+static size_t records_size[TABLE_COUNT];
+static int mapped_generation[TABLE_COUNT];
+
+static const int initial_capacity[TABLE_COUNT] = {
+    SHARED_MIN_PLANS, SHARED_MIN_EQUIPMENT, SHARED_MIN_MEMBERS, SHARED_MIN_LOANS,
+    SHARED_MIN_CLASSES, SHARED_MIN_BOOKINGS
+};
+
+static void records_name(int t, int generation, char *out, int size) {
+    snprintf(out, size, "%s_%d_%d", segment_name, t, generation);
+}
+
+static void unmap_records(int t) {
+    if (records[t]) {
+        munmap(records[t], records_size[t]);
+        records[t] = NULL;
+    }
+}
+
+// Map the table's current records segment, if not mapped yet (data_lock held)
+static int map_records(int t) {
+    if (records[t] && mapped_generation[t] == segment->generation[t]) {
+        return 1;
+    }
+    unmap_records(t);
+
+    char name[96];
+    records_name(t, segment->generation[t], name, sizeof(name));
+    int fd = shm_open(name, O_RDWR, 0600);
+    if (fd < 0) {
+        return 0;
+    }
+    size_t size = (size_t)segment->capacity[t] * local_tables[t]->elem_size;
+    void *memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        return 0;
+    }
+
+    records[t] = memory;
+    records_size[t] = size;
+    mapped_generation[t] = segment->generation[t];
+    return 1;
+}
+
+// Move the table to a new segment with room for at least needed records
+// (data_lock held for writing, or the segment not shared yet)
+static int grow_records(int t, int needed) {
+    int capacity = initial_capacity[t];
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+    int generation = segment->generation[t] + 1;
+
+    char name[96];
+    records_name(t, generation, name, sizeof(name));
+    shm_unlink(name);  // Left over by a copy that crashed
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        return 0;
+    }
+    size_t size = (size_t)capacity * local_tables[t]->elem_size;
+    if (ftruncate(fd, size) != 0) {
+        close(fd);
+        shm_unlink(name);
+        return 0;
+    }
+    void *memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        shm_unlink(name);
+        return 0;
+    }
+
+    // Processes still mapping the old segment keep it until they switch
+    if (segment->generation[t] > 0) {
+        char old_name[96];
+        records_name(t, segment->generation[t], old_name, sizeof(old_name));
+        shm_unlink(old_name);
+    }
+    unmap_records(t);
+
+    records[t] = memory;
+    records_size[t] = size;
+    mapped_generation[t] = generation;
+    segment->capacity[t] = capacity;
+    segment->generation[t] = generation;
+    return 1;
+}
+
+// Publish the whole table, or nothing if it cannot be made to fit
+static int copy_to_segment(int t) {
+    Table *local = local_tables[t];
+
+    if (!map_records(t) ||
+        (local->live_count > segment->capacity[t] && !grow_records(t, local->live_count))) {
+        printf("Warning: No room in shared memory for %d %s records, the change stays in this copy.\n",
+               local->live_count, local->codec->name);
+        return 0;
+    }
+
+    char *out = records[t];
+    int copied = 0;
+    for (int i = 0; i < local->count; i++) {
+        if (table_is_live(local, i)) {
+            memcpy(out + (size_t)copied * local->elem_size, table_at(local, i), local->elem_size);
+            copied++;
+        }
+    }
+
+    segment->count[t] = copied;
+    return 1;
+}
+
+static int copy_from_segment(int t) {
+    Table *local = local_tables[t];
+    if (!map_records(t)) {
+        return 0;  // Local table kept as it is, tried again at the next refresh
+    }
+    const char *in = records[t];
+
+    table_clear(local);
+    table_reserve(local, segment->count[t]);
+    for (int i = 0; i < segment->count[t]; i++) {
+        table_append(local, in + (size_t)i * local->elem_size);
+    }
+
+    // The process that changed the table has already saved it
+    local->saved_version = local->version;
+    return 1;
+}
+
+static int init_segment() {
+    // Locks inside the segment must work across processes
+    pthread_mutexattr_t mutex_attr;
+    pthread_mutexattr_init(&mutex_attr);
+    pthread_mutexattr_setpshared(&mutex_attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&mutex_attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&segment->edit_lock, &mutex_attr);
+    pthread_mutexattr_destroy(&mutex_attr);
+
+    pthread_rwlockattr_t rwlock_attr;
+    pthread_rwlockattr_init(&rwlock_attr);
+    pthread_rwlockattr_setpshared(&rwlock_attr, PTHREAD_PROCESS_SHARED);
+    pthread_rwlock_init(&segment->data_lock, &rwlock_attr);
+    pthread_rwlockattr_destroy(&rwlock_attr);
+
+    // Start from the tables this process loaded from the files
+    for (int t = 0; t < TABLE_COUNT; t++) {
+        if (!grow_records(t, local_tables[t]->live_count) || !copy_to_segment(t)) {
+            return 0;
+        }
+        segment->version[t] = 1;
+    }
+
+    __atomic_store_n(&segment->initialized, 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+// Remove every segment (the last process, or a failed start)
+static void unlink_segments() {
+    for (int t = 0; t < TABLE_COUNT; t++) {
+        unmap_records(t);
+        if (segment->generation[t] > 0) {
+            char name[96];
+            records_name(t, segment->generation[t], name, sizeof(name));
+            shm_unlink(name);
+        }
+    }
+    shm_unlink(segment_name);
+}
+
+static void lock_edit() {
+    // If a process died while editing, take over its lock instead of waiting forever
+    if (pthread_mutex_lock(&segment->edit_lock) == EOWNERDEAD) {
+        pthread_mutex_consistent(&segment->edit_lock);
+    }
+}
+
+// Wait a millisecond for the copy that creates the segment
+static void pause_attach(int *waited_ms) {
+    struct timespec pause = { 0, 1000000 };
+    nanosleep(&pause, NULL);
+    (*waited_ms)++;
+}
+
+static void attach_timed_out() {
+    // Most likely left behind by a copy that stopped while creating it
+    printf("Warning: The shared tables were never filled, using private tables.\n");
+    printf("If no other copy is starting, remove /dev/shm%s and start again.\n", segment_name);
+}
+
+int shared_tables_attach(Table *plans, Table *equipment, Table *members, Table *loans,
+                         Table *classes, Table *bookings) {
+    if (segment) {
+        return 1;
+    }
+
+    local_tables[0] = plans;
+    local_tables[1] = equipment;
+    local_tables[2] = members;
+    local_tables[3] = loans;
+    local_tables[4] = classes;
+    local_tables[5] = bookings;
+
+    if (get_current_branch()[0] != '\0') {
+        snprintf(segment_name, sizeof(segment_name), "%s_%s", SHARED_TABLES_NAME, get_current_branch());
+    }
+
+    // Try to create the segment; if another process already did, open theirs
+    int created = 1;
+    int fd = shm_open(segment_name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0 && errno == EEXIST) {
+        created = 0;
+        fd = shm_open(segment_name, O_RDWR, 0600);
+    }
+
+    if (fd < 0) {
+        printf("Warning: Cannot open shared memory, using private tables.\n");
+        return 0;
+    }
+
+    if (created && ftruncate(fd, sizeof(SharedSegment)) != 0) {
+        close(fd);
+        shm_unlink(segment_name);
+        printf("Warning: Cannot size shared memory, using private tables.\n");
+        return 0;
+    }
+
+    // A segment just created by another copy may not be sized yet: touching
+    // it then would crash (SIGBUS)
+    int waited = 0;
+    struct stat info;
+    while (!created && fstat(fd, &info) == 0 && info.st_size < (off_t)sizeof(SharedSegment) &&
+           waited < SHARED_ATTACH_TIMEOUT_MS) {
+        pause_attach(&waited);
+    }
+    if (!created && (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(SharedSegment))) {
+        close(fd);
+        attach_timed_out();
+        return 0;
+    }
+
+    void *memory = mmap(NULL, sizeof(SharedSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (memory == MAP_FAILED) {
+        printf("Warning: Cannot map shared memory, using private tables.\n");
+        return 0;
+    }
+
+    segment = memory;
+
+    if (created) {
+        if (!init_segment()) {
+            printf("Warning: Cannot fill shared memory, using private tables.\n");
+            unlink_segments();
+            munmap(segment, sizeof(SharedSegment));
+            segment = NULL;
+            return 0;
+        }
+    } else {
+        // Wait until the creating process has finished filling the segment
+        while (!__atomic_load_n(&segment->initialized, __ATOMIC_ACQUIRE) && waited < SHARED_ATTACH_TIMEOUT_MS) {
+            pause_attach(&waited);
+        }
+        if (!__atomic_load_n(&segment->initialized, __ATOMIC_ACQUIRE)) {
+            munmap(segment, sizeof(SharedSegment));
+            segment = NULL;
+            attach_timed_out();
+            return 0;
+        }
+    }
+
+    lock_edit();
+    segment->attached++;
+    pthread_mutex_unlock(&segment->edit_lock);
+
+    // Never seen any version yet: the refresh copies every table
+    for (int t = 0; t < TABLE_COUNT; t++) {
+        seen_version[t] = 0;
+    }
+    shared_tables_refresh();
+
+    printf("Shared mode: %s live tables (%d process(es) attached).\n",
+           created ? "created" : "joined", segment->attached);
+    return 1;
+}
+
+void shared_tables_detach() {
+    if (!segment) {
+        return;
+    }
+
+    lock_edit();
+    segment->attached--;
+    int last = (segment->attached == 0);
+    pthread_mutex_unlock(&segment->edit_lock);
+
+    // The data is already in the files, so the last process can drop the segments
+    if (last) {
+        unlink_segments();
+    }
+    for (int t = 0; t < TABLE_COUNT; t++) {
+        unmap_records(t);
+    }
+    munmap(segment, sizeof(SharedSegment));
+    segment = NULL;
+}
+
+int shared_tables_enabled() {
+    return segment != NULL;
+}
+
+void shared_tables_refresh() {
+    if (!segment) {
+        return;
+    }
+
+    pthread_rwlock_rdlock(&segment->data_lock);
+
+    for (int t = 0; t < TABLE_COUNT; t++) {
+        if (segment->version[t] != seen_version[t] && copy_from_segment(t)) {
+            seen_version[t] = segment->version[t];
+            synced_version[t] = local_tables[t]->version;
+
+            if (t == 0) {
+                // Readers of this process switch to the other process's plans
+                plan_catalog_publish(local_tables[0]);
+            }
+        }
+    }
+
+    pthread_rwlock_unlock(&segment->data_lock);
+}
+
+void shared_tables_begin_edit() {
+    if (!segment) {
+        return;
+    }
+
+    // Only one process edits at a time, and it always edits the latest data,
+    // so no update from another process is overwritten
+    lock_edit();
+    shared_tables_refresh();
+}
+
+void shared_tables_end_edit() {
+    if (!segment) {
+        return;
+    }
+
+    pthread_rwlock_wrlock(&segment->data_lock);
+
+    for (int t = 0; t < TABLE_COUNT; t++) {
+        // A table that cannot be published is tried again at the next edit
+        if (local_tables[t]->version != synced_version[t] && copy_to_segment(t)) {
+            seen_version[t] = ++segment->version[t];
+            synced_version[t] = local_tables[t]->version;
+        }
+    }
+
+    pthread_rwlock_unlock(&segment->data_lock);
+    pthread_mutex_unlock(&segment->edit_lock);
+}
+
+#else
+
+// Shared memory needs POSIX; other systems always use private tables
+
+int shared_tables_attach(Table *plans, Table *equipment, Table *members, Table *loans,
+                         Table *classes, Table *bookings) {
+    (void)plans;
+    (void)equipment;
+    (void)members;
+    (void)loans;
+    (void)classes;
+    (void)bookings;
+    printf("Warning: Shared mode is not supported on this system.\n");
+    return 0;
+}
+
+void shared_tables_detach() {
+}
+
+int shared_tables_enabled() {
+    return 0;
+}
+
+void shared_tables_refresh() {
+}
+
+void shared_tables_begin_edit() {
+}
+
+void shared_tables_end_edit() {
+}
+
+#endif
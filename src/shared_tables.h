@@ -0,0 +1,53 @@
+#ifndef SHARED_TABLES_H
+#define SHARED_TABLES_H
+
+#include "plans.h"
+#include "equipment.h"
+#include "member.h"
+#include "loans.h"
+#include "classes.h"
+
+// Name of the POSIX shared-memory segment used by every running copy of the app
+#define SHARED_TABLES_NAME "/gym_management_tables"
+
+// Records each table has room for at first; a table that outgrows its
+// shared segment moves to one twice as big
+#define SHARED_MIN_PLANS     1000
+#define SHARED_MIN_EQUIPMENT 1000
+#define SHARED_MIN_MEMBERS   50000
+#define SHARED_MIN_LOANS     10000
+#define SHARED_MIN_CLASSES   1000
+#define SHARED_MIN_BOOKINGS  50000
+
+// How long a joining copy waits for the copy that created the segment to
+// finish filling it (milliseconds)
+#define SHARED_ATTACH_TIMEOUT_MS 10000
+
+// Function declarations
+
+// Place the tables in shared memory so several processes see the same data.
+// The first process copies its loaded tables into the segment; later ones
+// replace their loaded tables with the live shared copy.
+// The tables must stay valid until shared_tables_detach().
+// Returns 1 if shared mode is active, 0 if it could not be enabled.
+int shared_tables_attach(Table *plans, Table *equipment, Table *members, Table *loans,
+                         Table *classes, Table *bookings);
+
+// Leave shared mode (the last process removes the segment)
+void shared_tables_detach();
+
+// Returns 1 if shared mode is active
+int shared_tables_enabled();
+
+// Copy changes made by other processes into the local tables.
+// Does nothing if shared mode is off or nothing changed.
+void shared_tables_refresh();
+
+// Start an edit: waits until no other process is editing, then refreshes.
+// Every begin must be followed by shared_tables_end_edit().
+void shared_tables_begin_edit();
+
+// Publish the tables that changed during the edit and end the edit
+void shared_tables_end_edit();
+
+#endif
@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "subscriptions.h"
+#include "timer_wheel.h"
+#include "history.h"
+#include "popularity.h"
+#include "autosave.h"
+#include "shared_tables.h"
+#include "utils.h"
+
+#define SECONDS_PER_DAY (24LL * 60 * 60)
+
+static TimerWheel wheel;
+static int wheel_ready = 0;
+
+// Version of the member table the wheel was last brought up to date with
+static unsigned long synced_version = 0;
+
+typedef struct {
+    Table *members;
+    long long now;
+    int expired;
+} ExpireRun;
+
+typedef struct {
+    int id;
+    long long expires;
+} ExpiringMember;
+
+typedef struct {
+    ExpiringMember *items;
+    int count;
+    int capacity;
+} ExpiringList;
+
+static void schedule_member(const Member *member) {
+    // Only subscriptions with a recorded end can expire
+    if (member->id_current_plan != -1 && member->subscription_end != 0) {
+        timer_wheel_schedule(&wheel, member->id_member, member->subscription_end);
+    } else {
+        timer_wheel_cancel(&wheel, member->id_member);
+    }
+}
+
+void subscriptions_sync(Table *members) {
+    long long now = time(NULL);
+
+    if (!wheel_ready) {
+        timer_wheel_init(&wheel, SUBSCRIPTION_TICK_SECONDS, now);
+        wheel_ready = 1;
+    } else if (members->version == synced_version) {
+        return;
+    }
+
+    timer_wheel_reset(&wheel, now);
+    for (int i = 0; i < members->count; i++) {
+        if (table_is_live(members, i)) {
+            schedule_member(member_at(members, i));
+        }
+    }
+    synced_version = members->version;
+}
+
+void subscriptions_track(Table *members, int member_id) {
+    // Only this member's change since the last sync: update just its timer.
+    // Anything more means the table changed elsewhere and needs a rebuild.
+    if (!wheel_ready || synced_version + 1 != members->version) {
+        subscriptions_sync(members);
+        return;
+    }
+
+    const Member *member = member_find(members, member_id);
+    if (member) {
+        schedule_member(member);
+    } else {
+        timer_wheel_cancel(&wheel, member_id);
+    }
+    synced_version = members->version;
+}
+
+static void expire_member(int id, long long expires, void *context) {
+    ExpireRun *run = context;
+    Member *member = member_find(run->members, id);
+
+    if (!member || member->id_current_plan == -1) {
+        return;
+    }
+    if (member->subscription_end > run->now) {
+        // Renewed since the timer was set
+        timer_wheel_schedule(&wheel, id, member->subscription_end);
+        return;
+    }
+
+    (void)expires;
+    history_record(id, HISTORY_EXPIRE, member->id_current_plan, member->subscription_end);
+    
+    // The dates stay on the record so the member can see when it ended
+    member->id_current_plan = -1;
+    table_touch(run->members);
+    popularity_track(run->members, id);
+    run->expired++;
+}
+
+int subscriptions_expire_due(Table *members) {
+    long long now = time(NULL);
+
+    subscriptions_sync(members);
+    if (!timer_wheel_pending(&wheel, now)) {
+        return 0;
+    }
+
+    shared_tables_begin_edit();
+    subscriptions_sync(members);  // Another process may have changed members
+
+    ExpireRun run = { members, now, 0 };
+    timer_wheel_advance(&wheel, now, expire_member, &run);
+
+    if (run.expired > 0) {
+        synced_version = members->version;
+    }
+    shared_tables_end_edit();
+
+    if (run.expired > 0) {
+        autosave_table(members);
+    }
+    return run.expired;
+}
+
+static void collect_expiring(int id, long long expires, void *context) {
+    ExpiringList *list = context;
+
+    if (list->count == list->capacity) {
+        int capacity = list->capacity > 0 ? list->capacity * 2 : 16;
+        ExpiringMember *items = realloc(list->items, sizeof(ExpiringMember) * capacity);
+        if (!items) {
+            return;
+        }
+        list->items = items;
+        list->capacity = capacity;
+    }
+
+    list->items[list->count].id = id;
+    list->items[list->count].expires = expires;
+    list->count++;
+}
+
+static int compare_expiring(const void *a, const void *b) {
+    const ExpiringMember *x = a;
+    const ExpiringMember *y = b;
+    if (x->expires != y->expires) {
+        return x->expires < y->expires ? -1 : 1;
+    }
+    return x->id - y->id;
+}
+
+void subscriptions_display_expiring(Table *members, int days) {
+    subscriptions_expire_due(members);
+
+    long long now = time(NULL);
+    ExpiringList list = { NULL, 0, 0 };
+    timer_wheel_for_each_before(&wheel, now + days * SECONDS_PER_DAY, collect_expiring, &list);
+
+    if (list.count == 0) {
+        printf("\nNo subscriptions end within %d day(s).\n", days);
+        free(list.items);
+        return;
+    }
+
+    qsort(list.items, list.count, sizeof(ExpiringMember), compare_expiring);
+
+    printf("\n--- Subscriptions Ending Within %d Day(s) ---\n", days);
+    printf("Total: %d\n\n", list.count);
+    for (int i = 0; i < list.count; i++) {
+        const Member *member = member_find(members, list.items[i].id);
+        if (!member) {
+            continue;
+        }
+
+        char date[32];
+        format_date(list.items[i].expires, date, sizeof(date));
+        long long days_left = (list.items[i].expires - now + SECONDS_PER_DAY - 1) / SECONDS_PER_DAY;
+
+        printf("ID: %d | %s (%s) | Plan ID %d | Ends %s (%lld day(s) left)\n",
+               member->id_member, member->name, member->username,
+               member->id_current_plan, date, days_left);
+    }
+
+    free(list.items);
+}
@@ -0,0 +1,27 @@
+#ifndef SUBSCRIPTIONS_H
+#define SUBSCRIPTIONS_H
+
+#include "member.h"
+
+// Expiry checks run at this granularity: a subscription may stay active up
+// to one tick after its end time
+#define SUBSCRIPTION_TICK_SECONDS 3600
+
+// Function declarations
+
+// Make the expiry wheel match the member table. Only rebuilds (O(members))
+// if the table was changed without subscriptions_track(), e.g. loaded or
+// refreshed from another process.
+void subscriptions_sync(Table *members);
+
+// Update the expiry timer of one member after changing (or deleting) it
+void subscriptions_track(Table *members, int member_id);
+
+// End every subscription whose time is up and save the members table.
+// Costs O(expired subscriptions), not O(members). Returns how many ended.
+int subscriptions_expire_due(Table *members);
+
+// Admin view: members whose subscription ends within the next days days
+void subscriptions_display_expiring(Table *members, int days);
+
+#endif
@@ -0,0 +1,518 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "table.h"
+#include "utils.h"
+
+#define INITIAL_CAPACITY 16
+
+// Changes logged before the log gives up: comparing the whole table is
+// then about as cheap
+#define CHANGE_LOG_MAX 4096
+
+// Header of the binary format
+#define BINARY_MAGIC "GYMT"
+
+typedef struct {
+    char magic[4];
+    int elem_size;
+    int count;
+} BinaryHeader;
+
+static int record_id(const Table *t, const char *record) {
+    int id;
+    memcpy(&id, record + t->id_offset, sizeof(int));
+    return id;
+}
+
+static void log_change(Table *t, int id) {
+    if (!t->tracking || t->changes_lost) {
+        return;
+    }
+    if (t->change_count == t->change_capacity) {
+        int capacity = t->change_capacity > 0 ? t->change_capacity * 2 : INITIAL_CAPACITY;
+        int *changes = capacity <= CHANGE_LOG_MAX ? realloc(t->changes, sizeof(int) * capacity) : NULL;
+        if (!changes) {
+            t->changes_lost = 1;
+            return;
+        }
+        t->changes = changes;
+        t->change_capacity = capacity;
+    }
+    t->changes[t->change_count++] = id;
+}
+
+static unsigned hash_id(int id) {
+    // Multiplicative hashing spreads consecutive ids over the index
+    return (unsigned)id * 2654435761u;
+}
+
+static void index_insert(Table *t, int id, int slot) {
+    unsigned mask = t->index_capacity - 1;
+    unsigned pos = hash_id(id) & mask;
+
+    while (t->index[pos] != 0) {
+        pos = (pos + 1) & mask;
+    }
+    t->index[pos] = slot + 1;
+}
+
+static int index_rebuild(Table *t, int index_capacity) {
+    int *index = calloc(index_capacity, sizeof(int));
+    if (!index) {
+        return 0;
+    }
+
+    free(t->index);
+    t->index = index;
+    t->index_capacity = index_capacity;
+
+    for (int i = 0; i < t->count; i++) {
+        if (t->live[i]) {
+            index_insert(t, record_id(t, t->items + (size_t)i * t->elem_size), i);
+        }
+    }
+    return 1;
+}
+
+static int index_position(const Table *t, int id) {
+    if (t->index_capacity == 0) {
+        return -1;
+    }
+
+    unsigned mask = t->index_capacity - 1;
+    unsigned pos = hash_id(id) & mask;
+
+    while (t->index[pos] != 0) {
+        int slot = t->index[pos] - 1;
+        if (record_id(t, t->items + (size_t)slot * t->elem_size) == id) {
+            return (int)pos;
+        }
+        pos = (pos + 1) & mask;
+    }
+    return -1;
+}
+
+static void index_delete(Table *t, int pos) {
+    // Shift later entries of the same run back so lookups never stop early
+    unsigned mask = t->index_capacity - 1;
+    unsigned hole = pos;
+    unsigned next = (hole + 1) & mask;
+
+    while (t->index[next] != 0) {
+        int slot = t->index[next] - 1;
+        unsigned home = hash_id(record_id(t, t->items + (size_t)slot * t->elem_size)) & mask;
+
+        // Move the entry if its home position is not between the hole and itself
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            t->index[hole] = t->index[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    t->index[hole] = 0;
+}
+
+void table_init(Table *t, size_t elem_size, size_t id_offset, const TableCodec *codec) {
+    memset(t, 0, sizeof(Table));
+    t->elem_size = elem_size;
+    t->id_offset = id_offset;
+    t->codec = codec;
+    t->format = TABLE_FORMAT_TEXT;
+}
+
+void table_free(Table *t) {
+    free(t->items);
+    free(t->live);
+    free(t->index);
+    free(t->changes);
+    t->items = NULL;
+    t->live = NULL;
+    t->index = NULL;
+    t->changes = NULL;
+    t->count = 0;
+    t->live_count = 0;
+    t->capacity = 0;
+    t->index_capacity = 0;
+    t->change_count = 0;
+    t->change_capacity = 0;
+}
+
+void table_clear(Table *t) {
+    t->count = 0;
+    t->live_count = 0;
+    if (t->index) {
+        memset(t->index, 0, sizeof(int) * t->index_capacity);
+    }
+    t->changes_lost = t->tracking;
+    t->version++;
+}
+
+int table_reserve(Table *t, int capacity) {
+    if (capacity <= t->capacity) {
+        return 1;
+    }
+
+    int new_capacity = t->capacity > 0 ? t->capacity : INITIAL_CAPACITY;
+    while (new_capacity < capacity) {
+        new_capacity *= 2;
+    }
+
+    char *items = realloc(t->items, (size_t)new_capacity * t->elem_size);
+    if (!items) {
+        return 0;
+    }
+    t->items = items;
+
+    unsigned char *live = realloc(t->live, new_capacity);
+    if (!live) {
+        return 0;
+    }
+    t->live = live;
+
+    t->capacity = new_capacity;
+    return 1;
+}
+
+void *table_append(Table *t, const void *record) {
+    int id = record_id(t, record);
+
+    if (index_position(t, id) != -1) {
+        return NULL;  // Primary key already used
+    }
+
+    if (!table_reserve(t, t->count + 1)) {
+        return NULL;
+    }
+
+    // Keep the index at most half full
+    if ((t->live_count + 1) * 2 > t->index_capacity) {
+        int index_capacity = t->index_capacity > 0 ? t->index_capacity * 2 : INITIAL_CAPACITY * 2;
+        if (!index_rebuild(t, index_capacity)) {
+            return NULL;
+        }
+    }
+
+    char *slot_record = t->items + (size_t)t->count * t->elem_size;
+    memcpy(slot_record, record, t->elem_size);
+    t->live[t->count] = 1;
+    index_insert(t, id, t->count);
+
+    t->count++;
+    t->live_count++;
+    if (id > t->max_id) {
+        t->max_id = id;
+    }
+    log_change(t, id);
+    t->version++;
+    return slot_record;
+}
+
+int table_find_slot(const Table *t, int id) {
+    int pos = index_position(t, id);
+    return pos == -1 ? -1 : t->index[pos] - 1;
+}
+
+void *table_find(const Table *t, int id) {
+    int slot = table_find_slot(t, id);
+    return slot == -1 ? NULL : t->items + (size_t)slot * t->elem_size;
+}
+
+int table_remove(Table *t, int id) {
+    int pos = index_position(t, id);
+    if (pos == -1) {
+        return 0;
+    }
+
+    // Only mark the record; nothing has to be shifted
+    t->live[t->index[pos] - 1] = 0;
+    index_delete(t, pos);
+    t->live_count--;
+    log_change(t, id);
+    t->version++;
+
+    // Compact when deleted records take more room than live ones
+    if (t->count - t->live_count > t->live_count && t->count > INITIAL_CAPACITY) {
+        table_compact(t);
+    }
+    return 1;
+}
+
+void *table_at(const Table *t, int slot) {
+    return t->items + (size_t)slot * t->elem_size;
+}
+
+int table_is_live(const Table *t, int slot) {
+    return slot >= 0 && slot < t->count && t->live[slot];
+}
+
+void table_touch(Table *t) {
+    t->changes_lost = t->tracking;
+    t->version++;
+}
+
+void table_touch_record(Table *t, int id) {
+    log_change(t, id);
+    t->version++;
+}
+
+void table_track_changes(Table *t, int on) {
+    t->tracking = on;
+    table_forget_changes(t);
+}
+
+int table_changes(const Table *t, const int **ids) {
+    *ids = t->changes;
+    return t->tracking && !t->changes_lost ? t->change_count : -1;
+}
+
+void table_forget_changes(Table *t) {
+    t->change_count = 0;
+    t->changes_lost = 0;
+}
+
+int table_is_dirty(const Table *t) {
+    return t->version != t->saved_version;
+}
+
+int table_next_id(const Table *t) {
+    return t->max_id + 1;
+}
+
+void table_compact(Table *t) {
+    int kept = 0;
+
+    for (int i = 0; i < t->count; i++) {
+        if (!t->live[i]) {
+            continue;
+        }
+        if (kept != i) {
+            memcpy(t->items + (size_t)kept * t->elem_size,
+                   t->items + (size_t)i * t->elem_size, t->elem_size);
+        }
+        t->live[kept] = 1;
+        kept++;
+    }
+
+    t->count = kept;
+    if (t->index_capacity > 0) {
+        index_rebuild(t, t->index_capacity);
+    }
+}
+
+int table_copy(Table *dst, const Table *src) {
+    table_free(dst);
+    *dst = *src;
+    dst->items = NULL;
+    dst->live = NULL;
+    dst->index = NULL;
+    dst->capacity = 0;
+    dst->index_capacity = 0;
+    // The copy starts without a change log of its own
+    dst->tracking = 0;
+    dst->changes = NULL;
+    dst->change_count = 0;
+    dst->change_capacity = 0;
+    dst->changes_lost = 0;
+
+    if (src->count > 0 && !table_reserve(dst, src->count)) {
+        table_free(dst);
+        return 0;
+    }
+    if (src->index_capacity > 0) {
+        dst->index = malloc(sizeof(int) * src->index_capacity);
+        if (!dst->index) {
+            table_free(dst);
+            return 0;
+        }
+        memcpy(dst->index, src->index, sizeof(int) * src->index_capacity);
+        dst->index_capacity = src->index_capacity;
+    }
+
+    memcpy(dst->items, src->items, (size_t)src->count * src->elem_size);
+    memcpy(dst->live, src->live, src->count);
+    return 1;
+}
+
+int table_same_slots(const Table *a, const Table *b, int first, int count) {
+    if (a->elem_size != b->elem_size || first + count > a->count || first + count > b->count) {
+        return 0;
+    }
+    return memcmp(a->live + first, b->live + first, count) == 0 &&
+           memcmp(a->items + (size_t)first * a->elem_size, b->items + (size_t)first * b->elem_size,
+                  (size_t)count * a->elem_size) == 0;
+}
+
+static char *read_whole_file(FILE *f, size_t *length) {
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    if (size < 0) {
+        return NULL;
+    }
+
+    char *data = malloc(size + 1);
+    if (!data) {
+        return NULL;
+    }
+
+    *length = fread(data, 1, size, f);
+    data[*length] = '\0';
+    return data;
+}
+
+static int load_binary(Table *t, const char *data, size_t length) {
+    BinaryHeader header;
+    memcpy(&header, data, sizeof(header));
+
+    if (header.elem_size != (int)t->elem_size || header.count < 0 ||
+        sizeof(header) + (size_t)header.count * t->elem_size > length) {
+        return TABLE_BAD_HEADER;
+    }
+
+    table_reserve(t, header.count);
+    const char *record = data + sizeof(header);
+    int loaded = 0;
+
+    for (int i = 0; i < header.count; i++) {
+        if (table_append(t, record + (size_t)i * t->elem_size)) {
+            loaded++;
+        }
+    }
+    return loaded;
+}
+
+static int load_text(Table *t, char *data) {
+    char *line = data;
+    char *end = strchr(line, '\n');
+    int count;
+
+    if (sscanf(line, "%d", &count) != 1 || count < 0) {
+        return TABLE_BAD_HEADER;
+    }
+
+    table_reserve(t, count);
+    char *record = malloc(t->elem_size);
+    if (!record) {
+        return 0;
+    }
+
+    int loaded = 0;
+    for (int i = 0; i < count && end; i++) {
+        line = end + 1;
+        end = strchr(line, '\n');
+        if (end) {
+            *end = '\0';
+        }
+
+        // Accept files saved with Windows line endings
+        size_t length = strlen(line);
+        if (length > 0 && line[length - 1] == '\r') {
+            line[length - 1] = '\0';
+        }
+
+        memset(record, 0, t->elem_size);
+        if (!t->codec->parse(line, record)) {
+            printf("Error reading %s %d from file.\n", t->codec->name, i + 1);
+            break;
+        }
+        if (!table_append(t, record)) {
+            printf("Warning: %s %d has a duplicate ID and was skipped.\n", t->codec->name, i + 1);
+            continue;
+        }
+        loaded++;
+    }
+
+    free(record);
+    return loaded;
+}
+
+int table_load(Table *t, const char *path) {
+    snprintf(t->path, sizeof(t->path), "%s", path);
+
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return TABLE_NO_FILE;
+    }
+
+    size_t length = 0;
+    char *data = read_whole_file(f, &length);
+    fclose(f);
+
+    if (!data) {
+        return TABLE_BAD_HEADER;
+    }
+
+    int result;
+    if (length >= sizeof(BinaryHeader) && memcmp(data, BINARY_MAGIC, 4) == 0) {
+        t->format = TABLE_FORMAT_BINARY;
+        result = load_binary(t, data, length);
+    } else {
+        t->format = TABLE_FORMAT_TEXT;
+        result = load_text(t, data);
+    }
+
+    free(data);
+    // What was just loaded is what the file holds
+    t->saved_version = t->version;
+    return result;
+}
+
+char *table_format(const Table *t, size_t *length) {
+    if (t->format == TABLE_FORMAT_BINARY) {
+        size_t size = sizeof(BinaryHeader) + (size_t)t->live_count * t->elem_size;
+        char *data = malloc(size);
+        if (!data) {
+            return NULL;
+        }
+
+        BinaryHeader header;
+        memcpy(header.magic, BINARY_MAGIC, 4);
+        header.elem_size = (int)t->elem_size;
+        header.count = t->live_count;
+        memcpy(data, &header, sizeof(header));
+
+        char *out = data + sizeof(header);
+        for (int i = 0; i < t->count; i++) {
+            if (t->live[i]) {
+                memcpy(out, t->items + (size_t)i * t->elem_size, t->elem_size);
+                out += t->elem_size;
+            }
+        }
+
+        *length = size;
+        return data;
+    }
+
+    // Text: every line fits in codec->max_line characters
+    size_t capacity = (size_t)t->live_count * t->codec->max_line + 16;
+    char *text = malloc(capacity);
+    if (!text) {
+        return NULL;
+    }
+
+    size_t used = snprintf(text, capacity, "%d\n", t->live_count);
+    for (int i = 0; i < t->count; i++) {
+        if (t->live[i]) {
+            used += t->codec->format(t->items + (size_t)i * t->elem_size,
+                                     text + used, capacity - used);
+        }
+    }
+
+    *length = used;
+    return text;
+}
+
+int table_write(const Table *t, const char *path) {
+    size_t length;
+    char *data = table_format(t, &length);
+
+    if (!data) {
+        return 0;
+    }
+
+    int ok = write_file_atomically(path, data, length);
+    free(data);
+    return ok;
+}
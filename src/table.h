@@ -0,0 +1,149 @@
+#ifndef TABLE_H
+#define TABLE_H
+
+#include <stddef.h>
+
+// Generic record table shared by plans, equipment and members.
+// Records live in one growable array; an int primary key inside each record
+// is indexed in a hash table, deleted records are only marked (tombstones)
+// and the array is compacted once more than half of it is deleted.
+
+// File formats a table can be stored in
+#define TABLE_FORMAT_TEXT   0   // "count" line, then one "a|b|c" line per record
+#define TABLE_FORMAT_BINARY 1   // small header, then the raw records
+
+// Results of table_load() besides a record count
+#define TABLE_NO_FILE    -1
+#define TABLE_BAD_HEADER -2
+
+// How one record type is written to and read from a text line
+typedef struct {
+    const char *name;      // singular name used in messages, e.g. "plan"
+    size_t max_line;       // longest possible formatted line, including '\n'
+    // Parse one line (without '\n') into record, returns 1 if successful
+    int (*parse)(char *line, void *record);
+    // Format record as one line ending in '\n', returns the number of characters
+    int (*format)(const void *record, char *out, size_t size);
+} TableCodec;
+
+typedef struct {
+    char *items;              // count records of elem_size bytes
+    unsigned char *live;      // 1 = record in use, 0 = deleted
+    int count;                // slots in use (live and deleted)
+    int live_count;           // live records
+    int capacity;             // slots allocated
+    size_t elem_size;
+    size_t id_offset;         // position of the int primary key in a record
+    int *index;               // hash of id -> slot + 1 (0 = empty)
+    int index_capacity;       // power of two (0 = no index yet)
+    int max_id;               // highest id ever stored, for new ids
+    unsigned long version;        // increased on every change
+    unsigned long saved_version;  // version last written to the file
+    int format;               // TABLE_FORMAT_* used when saving
+    char path[256];           // data file of this table
+    const TableCodec *codec;
+    int tracking;             // 1 while changed ids are logged (table_track_changes)
+    int *changes;             // ids added, removed or touched since the log was emptied
+    int change_count;
+    int change_capacity;
+    int changes_lost;         // 1 if a change could not be logged
+} Table;
+
+// Function declarations
+
+// Prepare an empty table (usually through the typed *_table_init() helpers)
+void table_init(Table *t, size_t elem_size, size_t id_offset, const TableCodec *codec);
+
+// Free all memory of a table (it can be initialized again afterwards)
+void table_free(Table *t);
+
+// Remove every record (keeps the path, format and max_id)
+void table_clear(Table *t);
+
+// Make room for at least capacity records (returns 1 if successful, 0 if out of memory)
+int table_reserve(Table *t, int capacity);
+
+// Copy a record into the table. Returns the stored record,
+// or NULL if its id is already used or memory ran out.
+void *table_append(Table *t, const void *record);
+
+// Slot of the record with this id (-1 if not found)
+int table_find_slot(const Table *t, int id);
+
+// Record with this id (NULL if not found)
+void *table_find(const Table *t, int id);
+
+// Delete the record with this id (returns 1 if deleted, 0 if not found).
+// Slots of other records may change when the table is compacted.
+int table_remove(Table *t, int id);
+
+// Record in a slot and whether it is still in use
+void *table_at(const Table *t, int slot);
+int table_is_live(const Table *t, int slot);
+
+// Call after changing a record in place, so the change gets saved
+void table_touch(Table *t);
+
+// Same for one record whose id is known: the change log then only lists
+// that record instead of asking for the whole table to be compared
+void table_touch_record(Table *t, int id);
+
+// Start (on = 1) or stop (on = 0) logging the ids of changed records
+void table_track_changes(Table *t, int on);
+
+// Ids changed since the log was last emptied (in change order, an id may
+// repeat). Returns their number, or -1 if some change was not logged (a
+// table_touch(), a clear, too many changes, no memory): compare the whole
+// table then.
+int table_changes(const Table *t, const int **ids);
+
+// Empty the change log
+void table_forget_changes(Table *t);
+
+// Returns 1 if the table changed since it was last saved
+int table_is_dirty(const Table *t);
+
+// Smallest id not used yet
+int table_next_id(const Table *t);
+
+// Move live records together and drop the deleted ones
+void table_compact(Table *t);
+
+// Make dst an independent copy of src (returns 1 if successful, 0 if out of memory)
+int table_copy(Table *dst, const Table *src);
+
+// Returns 1 if slots first to first + count - 1 exist in both tables and
+// hold the same records, byte for byte (a quick check for unchanged runs)
+int table_same_slots(const Table *a, const Table *b, int first, int count);
+
+// Load the table from a text or binary file (the format is detected).
+// Sets the table's path and format. Returns the number of records loaded,
+// TABLE_NO_FILE or TABLE_BAD_HEADER.
+int table_load(Table *t, const char *path);
+
+// Format the table as it is stored on disk, in its current format.
+// Returns a malloc'd buffer (caller frees) and its length, NULL if out of memory.
+char *table_format(const Table *t, size_t *length);
+
+// Write the table to path in its current format (returns 1 if successful, 0 if failed)
+int table_write(const Table *t, const char *path);
+
+// Typed helpers for one record type, e.g. TABLE_TYPE(plan, Plan, id_plan)
+// gives plan_table_init(), plan_at(), plan_find() and plan_append().
+// The module defines the codec as <prefix>_codec.
+#define TABLE_TYPE(prefix, Type, id_field)                                      \
+    extern const TableCodec prefix##_codec;                                     \
+    static inline void prefix##_table_init(Table *t) {                          \
+        table_init(t, sizeof(Type), offsetof(Type, id_field), &prefix##_codec); \
+    }                                                                           \
+    static inline Type *prefix##_at(const Table *t, int slot) {                 \
+        return (Type *)table_at(t, slot);                                       \
+    }                                                                           \
+    static inline Type *prefix##_find(const Table *t, int id) {                 \
+        return (Type *)table_find(t, id);                                       \
+    }                                                                           \
+    static inline Type *prefix##_append(Table *t, const Type *record) {         \
+        return (Type *)table_append(t, record);                                 \
+    }
+
+#endif
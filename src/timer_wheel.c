@@ -0,0 +1,232 @@
+#include <stdlib.h>
+#include <string.h>
+#include "timer_wheel.h"
+
+#define DUE_LEVEL TIMER_WHEEL_LEVELS
+#define SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+
+// Tick at which a timer fires: the first tick that starts at or after expires
+static long long tick_of(const TimerWheel *w, long long expires) {
+    long long tick = expires / w->tick_seconds;
+    if (tick * w->tick_seconds < expires) {
+        tick++;
+    }
+    return tick;
+}
+
+static void link_node(TimerWheel *w, int id, int level, int slot) {
+    TimerNode *node = &w->nodes[id];
+    node->level = (short)level;
+    node->slot = (short)slot;
+    node->prev = -1;
+    node->next = w->head[level][slot];
+    if (node->next != -1) {
+        w->nodes[node->next].prev = id;
+    }
+    w->head[level][slot] = id;
+}
+
+static void unlink_node(TimerWheel *w, int id) {
+    TimerNode *node = &w->nodes[id];
+    if (node->prev != -1) {
+        w->nodes[node->prev].next = node->next;
+    } else {
+        w->head[node->level][node->slot] = node->next;
+    }
+    if (node->next != -1) {
+        w->nodes[node->next].prev = node->prev;
+    }
+    node->level = -1;
+}
+
+static void place(TimerWheel *w, int id) {
+    long long tick = tick_of(w, w->nodes[id].expires);
+    long long delta = tick - w->current;
+
+    if (delta <= 0) {
+        link_node(w, id, DUE_LEVEL, 0);
+        return;
+    }
+
+    // The lowest level whose range still reaches the timer
+    int level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 &&
+           delta >= (1LL << (TIMER_WHEEL_BITS * (level + 1)))) {
+        level++;
+    }
+
+    long long max_delta = 1LL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS);
+    if (delta >= max_delta) {
+        tick = w->current + max_delta - 1;  // Very far timers wait in the last slot
+    }
+
+    link_node(w, id, level, (int)((tick >> (TIMER_WHEEL_BITS * level)) & SLOT_MASK));
+}
+
+static int grow_nodes(TimerWheel *w, int id) {
+    if (id < w->node_capacity) {
+        return 1;
+    }
+
+    int capacity = w->node_capacity > 0 ? w->node_capacity : 64;
+    while (capacity <= id) {
+        capacity *= 2;
+    }
+
+    TimerNode *nodes = realloc(w->nodes, sizeof(TimerNode) * capacity);
+    if (!nodes) {
+        return 0;
+    }
+    for (int i = w->node_capacity; i < capacity; i++) {
+        nodes[i].level = -1;
+    }
+
+    w->nodes = nodes;
+    w->node_capacity = capacity;
+    return 1;
+}
+
+void timer_wheel_init(TimerWheel *w, long long tick_seconds, long long now) {
+    w->tick_seconds = tick_seconds;
+    w->nodes = NULL;
+    w->node_capacity = 0;
+    timer_wheel_reset(w, now);
+}
+
+void timer_wheel_free(TimerWheel *w) {
+    free(w->nodes);
+    w->nodes = NULL;
+    w->node_capacity = 0;
+    w->scheduled = 0;
+}
+
+void timer_wheel_reset(TimerWheel *w, long long now) {
+    memset(w->head, -1, sizeof(w->head));
+    for (int i = 0; i < w->node_capacity; i++) {
+        w->nodes[i].level = -1;
+    }
+    w->current = now / w->tick_seconds;
+    w->scheduled = 0;
+}
+
+int timer_wheel_schedule(TimerWheel *w, int id, long long expires) {
+    if (id < 0 || !grow_nodes(w, id)) {
+        return 0;
+    }
+
+    if (w->nodes[id].level != -1) {
+        unlink_node(w, id);
+        w->scheduled--;
+    }
+
+    w->nodes[id].expires = expires;
+    place(w, id);
+    w->scheduled++;
+    return 1;
+}
+
+void timer_wheel_cancel(TimerWheel *w, int id) {
+    if (id >= 0 && id < w->node_capacity && w->nodes[id].level != -1) {
+        unlink_node(w, id);
+        w->scheduled--;
+    }
+}
+
+// Take every timer out of one slot and place it again (lower, or due)
+static void cascade(TimerWheel *w, int level, int slot) {
+    int id = w->head[level][slot];
+    w->head[level][slot] = -1;
+
+    while (id != -1) {
+        int next = w->nodes[id].next;
+        place(w, id);
+        id = next;
+    }
+}
+
+static int fire_list(TimerWheel *w, int level, int slot,
+                     void (*fire)(int id, long long expires, void *context), void *context) {
+    int fired = 0;
+
+    while (w->head[level][slot] != -1) {
+        int id = w->head[level][slot];
+        long long expires = w->nodes[id].expires;
+        unlink_node(w, id);
+        w->scheduled--;
+        fired++;
+        fire(id, expires, context);
+    }
+    return fired;
+}
+
+int timer_wheel_advance(TimerWheel *w, long long now,
+                        void (*fire)(int id, long long expires, void *context), void *context) {
+    long long target = now / w->tick_seconds;
+    int fired = fire_list(w, DUE_LEVEL, 0, fire, context);
+
+    while (w->current < target) {
+        if (w->scheduled == 0) {
+            w->current = target;  // Nothing to wait for: jump straight there
+            break;
+        }
+
+        w->current++;
+
+        // At the start of a block, move the timers of that block one level down
+        for (int level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+            long long shift = TIMER_WHEEL_BITS * level;
+            if ((w->current & ((1LL << shift) - 1)) != 0) {
+                break;
+            }
+            cascade(w, level, (int)((w->current >> shift) & SLOT_MASK));
+        }
+
+        cascade(w, 0, (int)(w->current & SLOT_MASK));
+        fired += fire_list(w, DUE_LEVEL, 0, fire, context);
+    }
+    return fired;
+}
+
+int timer_wheel_pending(const TimerWheel *w, long long now) {
+    if (w->head[DUE_LEVEL][0] != -1) {
+        return 1;
+    }
+    if (now / w->tick_seconds <= w->current) {
+        return 0;
+    }
+    // The next tick's slot, or a block boundary that may bring timers down
+    long long next = w->current + 1;
+    return w->head[0][next & SLOT_MASK] != -1 || (next & SLOT_MASK) == 0 ||
+           now / w->tick_seconds > next;
+}
+
+static void visit_list(const TimerWheel *w, int level, int slot, long long until,
+                       void (*visit)(int id, long long expires, void *context), void *context) {
+    for (int id = w->head[level][slot]; id != -1; id = w->nodes[id].next) {
+        if (w->nodes[id].expires <= until) {
+            visit(id, w->nodes[id].expires, context);
+        }
+    }
+}
+
+void timer_wheel_for_each_before(const TimerWheel *w, long long until,
+                                 void (*visit)(int id, long long expires, void *context),
+                                 void *context) {
+    long long until_tick = tick_of(w, until);
+
+    visit_list(w, DUE_LEVEL, 0, until, visit, context);
+
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        long long shift = TIMER_WHEEL_BITS * level;
+        long long block = w->current >> shift;
+
+        // Slot k after the current block holds timers of block + k only,
+        // so stop at the first block that starts after until
+        for (int k = 0; k < TIMER_WHEEL_SLOTS; k++) {
+            if (k > 0 && ((block + k) << shift) > until_tick) {
+                break;
+            }
+            visit_list(w, level, (int)((block + k) & SLOT_MASK), until, visit, context);
+        }
+    }
+}
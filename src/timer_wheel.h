@@ -0,0 +1,64 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+// Hierarchical timer wheel keyed by small int ids (e.g. member IDs).
+// Timers are kept in TIMER_WHEEL_LEVELS rings of TIMER_WHEEL_SLOTS slots;
+// level 0 holds timers due within 64 ticks, level 1 within 64*64 ticks, ...
+// Far timers move down one level when their block comes up, so advancing
+// the clock only touches timers that are (almost) due, never all of them.
+
+#define TIMER_WHEEL_BITS   6
+#define TIMER_WHEEL_SLOTS  (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS 4
+
+typedef struct {
+    long long expires;  // time the timer fires (seconds)
+    int prev, next;     // links inside its slot (-1 = none)
+    short level;        // -1 = not scheduled, TIMER_WHEEL_LEVELS = due list
+    short slot;
+} TimerNode;
+
+typedef struct {
+    long long tick_seconds;   // length of one tick
+    long long current;        // last tick processed
+    int head[TIMER_WHEEL_LEVELS + 1][TIMER_WHEEL_SLOTS];  // last row: due list (slot 0)
+    TimerNode *nodes;         // indexed by id
+    int node_capacity;
+    int scheduled;            // number of timers in the wheel
+} TimerWheel;
+
+// Function declarations
+
+// Prepare an empty wheel that starts at time now
+void timer_wheel_init(TimerWheel *w, long long tick_seconds, long long now);
+
+// Free the wheel's memory
+void timer_wheel_free(TimerWheel *w);
+
+// Remove every timer and restart at time now
+void timer_wheel_reset(TimerWheel *w, long long now);
+
+// Set (or move) the timer of id to fire at expires (returns 0 if out of memory).
+// Timers in the past fire on the next timer_wheel_advance().
+int timer_wheel_schedule(TimerWheel *w, int id, long long expires);
+
+// Remove the timer of id, if any
+void timer_wheel_cancel(TimerWheel *w, int id);
+
+// Move the clock to now and call fire(id, expires, context) for every timer
+// that is due. Fired timers are removed before the call, so fire() may
+// schedule them again. Returns the number of timers fired.
+int timer_wheel_advance(TimerWheel *w, long long now,
+                        void (*fire)(int id, long long expires, void *context), void *context);
+
+// Returns 1 if timer_wheel_advance(w, now, ...) would fire something soon
+// (within one tick); cheap enough to call on every menu refresh
+int timer_wheel_pending(const TimerWheel *w, long long now);
+
+// Call visit(id, expires, context) for every timer that fires at or before
+// until, looking only at the slots that can hold such timers
+void timer_wheel_for_each_before(const TimerWheel *w, long long until,
+                                 void (*visit)(int id, long long expires, void *context),
+                                 void *context);
+
+#endif
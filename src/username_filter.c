@@ -0,0 +1,319 @@
+#define _POSIX_C_SOURCE 200809L  // stat
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include "username_filter.h"
+#include "utils.h"
+
+#define FILTER_MAGIC "GYMU"
+#define FILTER_FORMAT 1
+
+// Moves tried before an insert gives up and the filter is rebuilt bigger
+#define MAX_KICKS 500
+
+// What the saved filter was built from
+typedef struct {
+    char magic[4];
+    int format;
+    int buckets;
+    int count;
+    int live_count;           // of the member table
+    int max_id;
+    long long file_size;      // of the members file
+    long long file_time;
+    long long file_inode;     // a new file on every save (written then renamed)
+} FilterHeader;
+
+static uint16_t *slots = NULL;     // buckets * USERNAME_FILTER_SLOTS, 0 = empty
+static unsigned bucket_mask = 0;
+static int stored = 0;
+
+// Table the filter matches, with its live count and highest ID then.
+// IDs are never reused and usernames never edited in place, so the same
+// two numbers mean the same usernames: editing other fields (subscribing,
+// a rehashed password) never calls for a rebuild.
+static const Table *synced_table = NULL;
+static int synced_live_count = 0;
+static int synced_max_id = 0;
+static int synced = 0;
+
+static int rebuilds = 0;
+static int loaded = 0;
+static unsigned kick_state = 2463534242u;
+
+static uint64_t mix(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    return x ^ (x >> 33);
+}
+
+static uint64_t hash_username(const char *username) {
+    // FNV-1a, then mixed so every bit depends on every character
+    uint64_t hash = 14695981039346656037ULL;
+    for (const unsigned char *c = (const unsigned char *)username; *c; c++) {
+        hash = (hash ^ *c) * 1099511628211ULL;
+    }
+    return mix(hash);
+}
+
+static uint16_t fingerprint_of(uint64_t hash) {
+    uint16_t fingerprint = (uint16_t)(hash >> 48);
+    return fingerprint ? fingerprint : 1;
+}
+
+// The other bucket of a fingerprint, found from either one
+static unsigned alternate(unsigned bucket, uint16_t fingerprint) {
+    return (bucket ^ (unsigned)mix(fingerprint)) & bucket_mask;
+}
+
+static int bucket_add(unsigned bucket, uint16_t fingerprint) {
+    uint16_t *b = &slots[(size_t)bucket * USERNAME_FILTER_SLOTS];
+    for (int i = 0; i < USERNAME_FILTER_SLOTS; i++) {
+        if (b[i] == 0) {
+            b[i] = fingerprint;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int bucket_has(unsigned bucket, uint16_t fingerprint) {
+    const uint16_t *b = &slots[(size_t)bucket * USERNAME_FILTER_SLOTS];
+    return b[0] == fingerprint || b[1] == fingerprint || b[2] == fingerprint || b[3] == fingerprint;
+}
+
+static int bucket_remove(unsigned bucket, uint16_t fingerprint) {
+    uint16_t *b = &slots[(size_t)bucket * USERNAME_FILTER_SLOTS];
+    for (int i = 0; i < USERNAME_FILTER_SLOTS; i++) {
+        if (b[i] == fingerprint) {
+            b[i] = 0;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Returns 0 if the filter is too full (a fingerprint was dropped: rebuild)
+static int insert(const char *username) {
+    uint64_t hash = hash_username(username);
+    uint16_t fingerprint = fingerprint_of(hash);
+    unsigned bucket = (unsigned)hash & bucket_mask;
+    if (bucket_add(bucket, fingerprint) || bucket_add(alternate(bucket, fingerprint), fingerprint)) {
+        stored++;
+        return 1;
+    }
+
+    // Both full: move a fingerprint to its other bucket, and so on
+    for (int kick = 0; kick < MAX_KICKS; kick++) {
+        kick_state ^= kick_state << 13;
+        kick_state ^= kick_state >> 17;
+        kick_state ^= kick_state << 5;
+        uint16_t *victim = &slots[(size_t)bucket * USERNAME_FILTER_SLOTS + kick_state % USERNAME_FILTER_SLOTS];
+        uint16_t moved = *victim;
+        *victim = fingerprint;
+        fingerprint = moved;
+        bucket = alternate(bucket, fingerprint);
+        if (bucket_add(bucket, fingerprint)) {
+            stored++;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int allocate(int buckets) {
+    uint16_t *fresh = calloc((size_t)buckets * USERNAME_FILTER_SLOTS, sizeof(uint16_t));
+    if (!fresh) {
+        return 0;
+    }
+    free(slots);
+    slots = fresh;
+    bucket_mask = (unsigned)buckets - 1;
+    stored = 0;
+    return 1;
+}
+
+// Buckets for a table: at most half full, so signups have room
+static int buckets_for(int members) {
+    int buckets = USERNAME_FILTER_MIN_BUCKETS;
+    while (buckets < (members * 2 + USERNAME_FILTER_SLOTS - 1) / USERNAME_FILTER_SLOTS && buckets < (1 << 28)) {
+        buckets *= 2;
+    }
+    return buckets;
+}
+
+static void rebuild(const Table *members) {
+    synced = 0;
+    for (int buckets = buckets_for(members->live_count); buckets <= (1 << 28); buckets *= 2) {
+        if (!allocate(buckets)) {
+            return;  // Out of memory: checks fall back to the table
+        }
+        int full = 0;
+        for (int i = 0; i < members->count && !full; i++) {
+            if (table_is_live(members, i)) {
+                full = !insert(member_at(members, i)->username);
+            }
+        }
+        if (!full) {
+            synced_table = members;
+            synced_live_count = members->live_count;
+            synced_max_id = members->max_id;
+            synced = 1;
+            rebuilds++;
+            return;
+        }
+    }
+}
+
+static void sync(const Table *members) {
+    if (!synced || synced_table != members || synced_live_count != members->live_count ||
+        synced_max_id != members->max_id) {
+        rebuild(members);
+    }
+}
+
+static int file_stamp(const char *path, FilterHeader *header) {
+    struct stat info;
+    if (path[0] == '\0' || stat(path, &info) != 0) {
+        return 0;
+    }
+    header->file_size = (long long)info.st_size;
+    header->file_time = (long long)info.st_mtime;
+    header->file_inode = (long long)info.st_ino;
+    return 1;
+}
+
+// The members file path with its extension replaced
+static int filter_path(const Table *members, char *path, int size) {
+    const char *slash = strrchr(members->path, '/');
+    const char *dot = strrchr(slash ? slash : members->path, '.');
+    int stem = dot ? (int)(dot - members->path) : (int)strlen(members->path);
+    return members->path[0] != '\0' &&
+           snprintf(path, size, "%.*s%s", stem, members->path, USERNAME_FILTER_EXTENSION) < size;
+}
+
+void username_filter_load(const Table *members) {
+    char path[256];
+    loaded = 0;
+
+    FilterHeader expected, header;
+    memset(&expected, 0, sizeof(expected));
+    FILE *f = filter_path(members, path, sizeof(path)) && file_stamp(members->path, &expected)
+                  ? fopen(path, "rb") : NULL;
+    if (f) {
+        int ok = fread(&header, sizeof(header), 1, f) == 1 && memcmp(header.magic, FILTER_MAGIC, 4) == 0 &&
+                 header.format == FILTER_FORMAT && header.buckets >= USERNAME_FILTER_MIN_BUCKETS &&
+                 header.buckets <= (1 << 28) && (header.buckets & (header.buckets - 1)) == 0 &&
+                 header.live_count == members->live_count && header.max_id == members->max_id &&
+                 header.file_size == expected.file_size && header.file_time == expected.file_time &&
+                 header.file_inode == expected.file_inode && allocate(header.buckets);
+        ok = ok && fread(slots, sizeof(uint16_t) * USERNAME_FILTER_SLOTS, header.buckets, f) ==
+                       (size_t)header.buckets;
+        fclose(f);
+        if (ok) {
+            stored = header.count;
+            synced_table = members;
+            synced_live_count = members->live_count;
+            synced_max_id = members->max_id;
+            synced = 1;
+            loaded = 1;
+            return;
+        }
+    }
+
+    // Missing or out of date: build it from the table
+    rebuild(members);
+}
+
+int username_filter_may_contain(const Table *members, const char *username) {
+    sync(members);
+    if (!synced) {
+        return 1;  // No filter: the table has to be searched
+    }
+    uint64_t hash = hash_username(username);
+    uint16_t fingerprint = fingerprint_of(hash);
+    unsigned bucket = (unsigned)hash & bucket_mask;
+    return bucket_has(bucket, fingerprint) || bucket_has(alternate(bucket, fingerprint), fingerprint);
+}
+
+void username_filter_track(const Table *members, const char *username, int added) {
+    // Only this change since the last sync: update just this username.
+    // Anything more means a change made elsewhere and needs a rebuild
+    // (an added member takes the next ID, a removed one keeps the highest).
+    int live_count = synced_live_count + (added ? 1 : -1);
+    int max_id = added ? synced_max_id + 1 : synced_max_id;
+    if (!synced || synced_table != members || live_count != members->live_count || max_id != members->max_id) {
+        rebuild(members);
+        return;
+    }
+
+    if (added) {
+        if (!insert(username)) {
+            rebuild(members);  // Too full: a bigger filter
+            return;
+        }
+    } else {
+        uint64_t hash = hash_username(username);
+        uint16_t fingerprint = fingerprint_of(hash);
+        unsigned bucket = (unsigned)hash & bucket_mask;
+        if (bucket_remove(bucket, fingerprint) || bucket_remove(alternate(bucket, fingerprint), fingerprint)) {
+            stored--;
+        }
+    }
+    synced_live_count = members->live_count;
+    synced_max_id = members->max_id;
+}
+
+int username_filter_save(const Table *members) {
+    // The saved filter must describe the members file as written
+    char path[256];
+    FilterHeader header;
+    memset(&header, 0, sizeof(header));
+    if (table_is_dirty(members) || !file_stamp(members->path, &header)) {
+        return 0;
+    }
+    sync(members);
+    if (!synced) {
+        return 0;
+    }
+
+    memcpy(header.magic, FILTER_MAGIC, 4);
+    header.format = FILTER_FORMAT;
+    header.buckets = (int)bucket_mask + 1;
+    header.count = stored;
+    header.live_count = members->live_count;
+    header.max_id = members->max_id;
+
+    size_t slot_bytes = sizeof(uint16_t) * USERNAME_FILTER_SLOTS * (size_t)header.buckets;
+    char *data = malloc(sizeof(header) + slot_bytes);
+    if (!data) {
+        return 0;
+    }
+    memcpy(data, &header, sizeof(header));
+    memcpy(data + sizeof(header), slots, slot_bytes);
+
+    int ok = filter_path(members, path, sizeof(path)) && write_file_atomically(path, data, sizeof(header) + slot_bytes);
+    free(data);
+    return ok;
+}
+
+void username_filter_stats(UsernameFilterStats *stats) {
+    stats->buckets = slots ? (int)bucket_mask + 1 : 0;
+    stats->count = stored;
+    stats->rebuilds = rebuilds;
+    stats->loaded = loaded;
+}
+
+void username_filter_free() {
+    free(slots);
+    slots = NULL;
+    bucket_mask = 0;
+    stored = 0;
+    synced = 0;
+    synced_table = NULL;
+}
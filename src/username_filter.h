@@ -0,0 +1,54 @@
+#ifndef USERNAME_FILTER_H
+#define USERNAME_FILTER_H
+
+#include "member.h"
+
+// Cuckoo filter over the usernames of the member table: a 16-bit
+// fingerprint of each username in one of two buckets of 4. A username
+// whose fingerprint is in neither of its buckets is certainly not taken,
+// found without touching the member table; otherwise the table is
+// searched (a wrong "maybe" happens for at most about one new name in 8000).
+// Unlike a Bloom filter, a deleted member's fingerprint can be taken out.
+// The filter is saved next to the members file on exit (members.txt ->
+// members.filter) and used again at the next start if the members file has
+// not changed since.
+#define USERNAME_FILTER_EXTENSION ".filter"
+
+// Fingerprints per bucket, and the fewest buckets a filter has
+#define USERNAME_FILTER_SLOTS 4
+#define USERNAME_FILTER_MIN_BUCKETS 256
+
+typedef struct {
+    int buckets;
+    int count;                // fingerprints stored
+    int rebuilds;             // times built from the member table
+    int loaded;               // 1 if the last start used the saved filter
+} UsernameFilterStats;
+
+// Function declarations
+
+// Use the saved filter if it matches the members file just loaded,
+// otherwise build one sized for the member count
+void username_filter_load(const Table *members);
+
+// Returns 0 if no member has this username, 1 if one may have it.
+// Rebuilds first if members were added or removed without
+// username_filter_track() (e.g. by another process); changes to other
+// fields of a member need no rebuild.
+int username_filter_may_contain(const Table *members, const char *username);
+
+// Record a username added to (added = 1) or removed from the table,
+// right after that one change
+void username_filter_track(const Table *members, const char *username, int added);
+
+// Save the filter for the next start; call once the members file has been
+// written (returns 1 if saved)
+int username_filter_save(const Table *members);
+
+// Current size and counters
+void username_filter_stats(UsernameFilterStats *stats);
+
+// Free the filter
+void username_filter_free();
+
+#endif
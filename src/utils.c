@@ -1,7 +1,26 @@
+#define _POSIX_C_SOURCE 200809L  // fileno, fsync, sysconf
+
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 #include "utils.h"
 
+// Called before waiting for the user (see set_input_wait_hook)
+static void (*input_wait_hook)() = NULL;
+
+void set_input_wait_hook(void (*hook)()) {
+    input_wait_hook = hook;
+}
+
+static void before_input() {
+    if (input_wait_hook) {
+        input_wait_hook();
+    }
+}
+
 void clear_input_buffer() {
     int c;
     // Keep reading characters until we find newline or end of file
@@ -13,6 +32,7 @@ void clear_input_buffer() {
 
 int get_int_input() {
     int num;
+    before_input();
     while (scanf("%d", &num) != 1) {
         printf("Invalid input. Please enter a number: ");
         clear_input_buffer();
@@ -23,6 +43,7 @@ int get_int_input() {
 
 float get_float_input() {
     float num;
+    before_input();
     while (scanf("%f", &num) != 1) {
         printf("Invalid input. Please enter a number: ");
         clear_input_buffer();
@@ -33,6 +54,7 @@ float get_float_input() {
 
 void get_string_input(char *buffer, int size) {
     // Read a line of text from user
+    before_input();
     char *result = fgets(buffer, size, stdin);
     
     if (result != NULL) {
@@ -61,5 +83,85 @@ void print_separator() {
 
 void pause_screen() {
     printf("\nPress Enter to continue...");
+    before_input();
     clear_input_buffer();
 }
+
+void format_date(long long seconds, char *out, int size) {
+    time_t t = (time_t)seconds;
+    struct tm *date = localtime(&t);
+    
+    if (!date || strftime(out, size, "%Y-%m-%d", date) == 0) {
+        snprintf(out, size, "?");
+    }
+}
+
+static char current_branch[BRANCH_NAME_SIZE] = "";
+
+void set_current_branch(const char *branch) {
+    snprintf(current_branch, sizeof(current_branch), "%s", branch);
+}
+
+const char *get_current_branch() {
+    return current_branch;
+}
+
+void data_file_path(const char *default_path, char *out, int size) {
+    if (current_branch[0] == '\0' || strncmp(default_path, "data/", 5) != 0) {
+        snprintf(out, size, "%s", default_path);
+        return;
+    }
+    snprintf(out, size, "data/%s/%s", current_branch, default_path + 5);
+}
+
+int online_cpu_count(int max) {
+#ifdef _SC_NPROCESSORS_ONLN
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus > max) {
+        cpus = max;
+    }
+    return cpus > 0 ? (int)cpus : 1;
+#else
+    (void)max;
+    return 1;
+#endif
+}
+
+int write_file_atomically(const char *path, const char *data, size_t length) {
+    // Write to a temporary file first so a crash never leaves a half-written file
+    char tmp_path[256];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    
+    FILE *f = fopen(tmp_path, "wb");
+    
+    if (!f) {
+        return 0;
+    }
+    
+    size_t written = fwrite(data, 1, length, f);
+    int ok = (written == length) && fflush(f) == 0;
+    
+#ifndef _WIN32
+    // Make sure the data is on disk before the rename makes it visible
+    if (ok && fsync(fileno(f)) != 0) {
+        ok = 0;
+    }
+#endif
+    
+    if (fclose(f) != 0 || !ok) {
+        remove(tmp_path);
+        return 0;
+    }
+    
+#ifdef _WIN32
+    // rename() does not replace an existing file on Windows
+    remove(path);
+#endif
+    // Replace the old file with the complete new one
+    if (rename(tmp_path, path) != 0) {
+        remove(tmp_path);
+        return 0;
+    }
+    
+    return 1;
+}
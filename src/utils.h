@@ -1,6 +1,8 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <stddef.h>
+
 // Utility function declarations
 
 // Clear input buffer to prevent scanf issues
@@ -15,6 +17,11 @@ void get_string_input(char *buffer, int size);
 // Get float input with validation
 float get_float_input();
 
+// Run hook each time the input functions above (and pause_screen) are about
+// to wait for the user, e.g. to hand finished work to background threads.
+// NULL removes it.
+void set_input_wait_hook(void (*hook)());
+
 // Print formatted header for menus
 void print_header(const char *title);
 
@@ -24,4 +31,26 @@ void print_separator();
 // Pause and wait for user to press Enter
 void pause_screen();
 
+// Format a time (seconds since 1970) as a local date "YYYY-MM-DD"
+void format_date(long long seconds, char *out, int size);
+
+// Longest branch name, including '\0'
+#define BRANCH_NAME_SIZE 32
+
+// Run on the data of one branch (--branch): data files are then read from
+// and written to data/<branch>/ instead of data/. "" means no branch.
+void set_current_branch(const char *branch);
+const char *get_current_branch();
+
+// Path of a data file for the current branch: "data/members.txt" becomes
+// "data/<branch>/members.txt" (unchanged when no branch is set)
+void data_file_path(const char *default_path, char *out, int size);
+
+// Number of CPUs online, from 1 to max (1 if unknown)
+int online_cpu_count(int max);
+
+// Write data to a temporary file, flush it to disk and rename it over path.
+// Readers never see a half-written file. Returns 1 if successful, 0 if failed.
+int write_file_atomically(const char *path, const char *data, size_t length);
+
 #endif
@@ -0,0 +1,211 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime, mkdir, chdir
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "../src/audit.h"
+
+// Latency is measured on one event out of SAMPLE_EVERY
+#define SAMPLE_EVERY 64
+#define MAX_THREADS  64
+#define QUERIES      200
+
+// Record changes from several threads at once and report the cost of one
+// audit_record() call, next to writing each event to the file under a
+// mutex. Checks that every event reached the log in each thread's order,
+// and times queries of a short time range and of one actor.
+// Build: gcc -O2 -o test/bench_audit test/bench_audit.c src/branches.c src/history.c
+//        src/maintenance.c src/classes.c src/member.c src/plans.c src/equipment.c src/table.c
+//        src/money.c src/subscriptions.c src/timer_wheel.c src/access.c src/loans.c src/autosave.c
+//        src/replication.c src/password.c src/username_filter.c src/hot_reload.c src/audit.c
+//        src/event_ring.c src/popularity.c src/batch_save.c src/shared_tables.c src/plan_catalog.c
+//        src/utils.c -lpthread
+// Usage: ./test/bench_audit [threads] [events_per_thread]
+// The log is written to bench_tmp/data/audit.log, the real data/ folder is not touched.
+
+typedef struct {
+    int actor;
+    int events;
+    int use_mutex;
+    double *latencies;
+    int samples;
+} Producer;
+
+// Baseline: each event written and flushed by the thread that made it
+static pthread_mutex_t file_lock = PTHREAD_MUTEX_INITIALIZER;
+static FILE *direct_file = NULL;
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static void record_directly(int actor, int action, int target, const char *detail) {
+    AuditRecord record;
+    memset(&record, 0, sizeof(record));
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    record.time_ms = ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+    record.actor = actor;
+    record.target = target;
+    record.action = (unsigned short)action;
+    snprintf(record.detail, sizeof(record.detail), "%s", detail);
+
+    pthread_mutex_lock(&file_lock);
+    fwrite(&record, sizeof(record), 1, direct_file);
+    fflush(direct_file);
+    pthread_mutex_unlock(&file_lock);
+}
+
+static void *producer_main(void *arg) {
+    Producer *p = arg;
+
+    // The target counts up, so the order of each thread's events can be checked
+    for (int i = 0; i < p->events; i++) {
+        int action = AUDIT_PLAN_ADD + i % (AUDIT_ACTION_COUNT - 1);
+        double start = i % SAMPLE_EVERY == 0 ? now_ms() : 0;
+        if (p->use_mutex) {
+            record_directly(p->actor, action, i + 1, "Generated change");
+        } else {
+            audit_record(p->actor, action, i + 1, "Generated change");
+        }
+        if (i % SAMPLE_EVERY == 0) {
+            p->latencies[p->samples++] = (now_ms() - start) * 1e6;
+        }
+    }
+    return NULL;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Run the producers; returns the elapsed time and fills p50 / p99 (ns)
+static double run(int threads, int events, int use_mutex, double *latencies, double *p50, double *p99) {
+    Producer producers[MAX_THREADS];
+    pthread_t ids[MAX_THREADS];
+    int per_thread_samples = events / SAMPLE_EVERY + 1;
+
+    double start = now_ms();
+    for (int t = 0; t < threads; t++) {
+        producers[t] = (Producer){ t + 1, events, use_mutex, latencies + (size_t)t * per_thread_samples, 0 };
+        pthread_create(&ids[t], NULL, producer_main, &producers[t]);
+    }
+    for (int t = 0; t < threads; t++) {
+        pthread_join(ids[t], NULL);
+    }
+    double elapsed = now_ms() - start;
+
+    int samples = 0;
+    for (int t = 0; t < threads; t++) {
+        for (int i = 0; i < producers[t].samples; i++) {
+            latencies[samples++] = producers[t].latencies[i];
+        }
+    }
+    qsort(latencies, samples, sizeof(double), compare_doubles);
+    *p50 = latencies[samples / 2];
+    *p99 = latencies[samples * 99 / 100];
+    return elapsed;
+}
+
+int main(int argc, char *argv[]) {
+    int threads = argc > 1 ? atoi(argv[1]) : 4;
+    int events = argc > 2 ? atoi(argv[2]) : 500000;
+    if (threads < 1 || threads > MAX_THREADS || events < 1) {
+        printf("Usage: %s [threads 1-%d] [events_per_thread]\n", argv[0], MAX_THREADS);
+        return 1;
+    }
+
+    mkdir("bench_tmp", 0755);
+    if (chdir("bench_tmp") != 0) {
+        printf("Cannot enter bench_tmp/.\n");
+        return 1;
+    }
+    mkdir("data", 0755);
+    remove(AUDIT_FILE);
+
+    printf("===== AUDIT LOG BENCHMARK =====\n\n");
+    printf("Threads: %d, events per thread: %d (%d bytes each)\n\n", threads, events, (int)sizeof(AuditRecord));
+
+    double *latencies = malloc(sizeof(double) * (events / SAMPLE_EVERY + 1) * threads);
+    int *last_target = calloc(threads + 1, sizeof(int));
+    if (!latencies || !last_target) {
+        printf("Not enough memory.\n");
+        return 1;
+    }
+
+    // Baseline: write and flush under a mutex
+    direct_file = fopen("direct_audit.log", "wb");
+    if (!direct_file) {
+        printf("Cannot write bench_tmp/direct_audit.log.\n");
+        return 1;
+    }
+    double p50, p99;
+    double direct_ms = run(threads, events, 1, latencies, &p50, &p99);
+    fclose(direct_file);
+    remove("direct_audit.log");
+    long total = (long)threads * events;
+    printf("Mutex + write   : %8.0f ns per event (p50 %.0f ns, p99 %.0f ns), %.0f events/s\n",
+           direct_ms * 1e6 / total, p50, p99, total / (direct_ms / 1000.0));
+
+    // Lock-free queue and the log writer thread
+    if (!audit_start()) {
+        return 1;
+    }
+    long long first_ms = (long long)time(NULL) * 1000 - AUDIT_ORDER_SLACK_MS;
+    double queued_ms = run(threads, events, 0, latencies, &p50, &p99);
+    double start = now_ms();
+    audit_flush();
+    double drain_ms = now_ms() - start;
+    printf("audit_record()  : %8.0f ns per event (p50 %.0f ns, p99 %.0f ns), %.0f events/s\n",
+           queued_ms * 1e6 / total, p50, p99, total / (queued_ms / 1000.0));
+    printf("Writer          : %.1f ms more to finish writing after the last event\n\n", drain_ms);
+
+    // Every event, each thread's in the order it recorded them
+    AuditRecord *found;
+    long long last_ms = (long long)time(NULL) * 1000 + AUDIT_ORDER_SLACK_MS;
+    int count = audit_query(first_ms, last_ms, AUDIT_ANYONE, &found);
+    int in_order = count > 0;
+    long long end_ms = count > 0 ? found[count - 1].time_ms : last_ms;
+    for (int i = 0; i < count && in_order; i++) {
+        int actor = found[i].actor;
+        in_order = actor >= 1 && actor <= threads && found[i].target == last_target[actor] + 1;
+        last_target[actor] = found[i].target;
+    }
+    free(found);
+
+    // A short time range near the end, then one actor over the whole log
+    start = now_ms();
+    int recent = 0;
+    for (int i = 0; i < QUERIES; i++) {
+        recent = audit_query(end_ms - 5, end_ms, AUDIT_ANYONE, &found);
+        free(found);
+    }
+    double range_ms = (now_ms() - start) / QUERIES;
+    start = now_ms();
+    int by_actor = audit_query(first_ms, last_ms, 1, &found);
+    double actor_ms = now_ms() - start;
+    free(found);
+    printf("Query by time   : %8.3f ms (%d events of the last 5 ms: binary search, then a scan\n"
+           "                  from %d ms before, which holds most of this burst)\n",
+           range_ms, recent, AUDIT_ORDER_SLACK_MS);
+    printf("Query by actor  : %8.1f ms (%d events, the whole log scanned)\n", actor_ms, by_actor);
+
+    audit_stop();
+
+    struct stat log_stat;
+    long logged = stat(AUDIT_FILE, &log_stat) == 0 ? (long)(log_stat.st_size / sizeof(AuditRecord)) : 0;
+    int ok = logged == total && count == total && in_order && by_actor == events;
+    printf("\nLogged          : %ld events, %s\n", logged,
+           ok ? "all of them, in each thread's order" : "ERROR: events are missing or out of order!");
+
+    free(latencies);
+    free(last_target);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime, mkdir
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "../src/billing.h"
+
+// Run the billing engine on generated data with 1..8 threads, report the
+// time and check that every run wrote exactly the same file.
+// Build: gcc -O2 -o test/bench_billing test/bench_billing.c src/billing.c src/branches.c
+//        src/history.c src/maintenance.c src/classes.c src/member.c src/plans.c src/equipment.c
+//        src/table.c src/money.c src/subscriptions.c src/timer_wheel.c src/access.c src/loans.c
+//        src/autosave.c src/replication.c src/password.c src/username_filter.c src/hot_reload.c
+//        src/audit.c src/event_ring.c src/popularity.c src/batch_save.c src/shared_tables.c
+//        src/plan_catalog.c src/utils.c -lpthread
+// Usage: ./test/bench_billing [member_count]
+// Files are written to bench_tmp/, the real data/ folder is not touched.
+
+#define BENCH_PLANS 20
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static char *read_file(const char *path, long *size) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    *size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *data = malloc(*size > 0 ? *size : 1);
+    if (data && fread(data, 1, *size, f) != (size_t)*size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    return data;
+}
+
+int main(int argc, char *argv[]) {
+    int member_count = argc > 1 ? atoi(argv[1]) : 1000000;
+
+    Table plans, members;
+    plan_table_init(&plans);
+    member_table_init(&members);
+
+    for (int i = 0; i < BENCH_PLANS; i++) {
+        char name[50];
+        Plan plan;
+        snprintf(name, sizeof(name), "Plan %d", i + 1);
+        create_plan(&plan, i + 1, name, 30 * MONEY_SCALE + i * 2450, "Generated plan for benchmark");
+        plan_append(&plans, &plan);
+    }
+
+    if (!table_reserve(&members, member_count)) {
+        printf("Not enough memory for %d members.\n", member_count);
+        return 1;
+    }
+    for (int i = 0; i < member_count; i++) {
+        Member member = { 0 };
+        member.id_member = i + 1;
+        snprintf(member.username, sizeof(member.username), "user%d", i + 1);
+        snprintf(member.password, sizeof(member.password), "pass%d", i * 7919);
+        snprintf(member.name, sizeof(member.name), "Generated Member %d", i + 1);
+        // Some members without a plan, some on a deleted plan
+        member.id_current_plan = (i % 5 == 0) ? -1 : 1 + i % (BENCH_PLANS + 1);
+        member_append(&members, &member);
+    }
+
+    mkdir("bench_tmp", 0755);
+
+    printf("===== BILLING BENCHMARK =====\n\n");
+    printf("Members: %d, plans: %d\n\n", member_count, BENCH_PLANS);
+
+    char *reference = NULL;
+    long reference_size = 0;
+    int threads[] = { 1, 2, 4, 8 };
+
+    for (int t = 0; t < 4; t++) {
+        char path[64];
+        snprintf(path, sizeof(path), "bench_tmp/invoices_%d.txt", threads[t]);
+
+        BillingSummary summary;
+        double start = now_ms();
+        if (!billing_run(&members, &plans, "2025-01", path, threads[t], &summary)) {
+            printf("Billing run failed.\n");
+            return 1;
+        }
+        double ms = now_ms() - start;
+
+        long size;
+        char *data = read_file(path, &size);
+        const char *same = "reference";
+        if (!reference) {
+            reference = data;
+            reference_size = size;
+        } else {
+            same = (data && size == reference_size && memcmp(data, reference, size) == 0)
+                   ? "identical" : "DIFFERENT";
+            free(data);
+        }
+
+        char total[MONEY_MAX_TEXT];
+        money_format(summary.total, total);
+        printf("%d thread(s): %8.2f ms, %d invoices, %s DT, %s\n",
+               threads[t], ms, summary.invoices, total, same);
+    }
+
+    free(reference);
+    table_free(&plans);
+    table_free(&members);
+    printf("\nBenchmark completed.\n");
+    return 0;
+}
@@ -0,0 +1,197 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime, mkdir
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+#include "../src/branches.h"
+
+#define ROOT "bench_tmp/branches"
+#define LIST_FILE "bench_tmp/branches/branches.txt"
+#define INDEX_FILE "bench_tmp/branches/usernames.log"
+#define LOOKUPS 1000000
+
+// Write many branches with their own members files, then time loading them
+// all with 1 thread and with several (fan-out totals must match), build the
+// username index from the files, and time username checks and claims
+// against it compared with loading every branch to look for a name.
+// Build: gcc -O2 -o test/bench_branches test/bench_branches.c src/branches.c src/history.c
+//        src/maintenance.c src/classes.c src/member.c src/plans.c src/equipment.c src/table.c
+//        src/money.c src/subscriptions.c src/timer_wheel.c src/access.c src/loans.c src/autosave.c
+//        src/replication.c src/password.c src/username_filter.c src/hot_reload.c src/audit.c
+//        src/event_ring.c src/popularity.c src/batch_save.c src/shared_tables.c src/plan_catalog.c
+//        src/utils.c -lpthread
+// Usage: ./test/bench_branches [branches] [members_per_branch] [threads]
+// The files are written to bench_tmp/branches/, the real data/ folder is not touched.
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static atomic_llong total_members;
+static atomic_llong total_subscribed;
+
+static void count_members(const Branch *branch, int index, void *arg) {
+    (void)index;
+    (void)arg;
+    long long subscribed = 0;
+    for (int i = 0; i < branch->members.count; i++) {
+        if (table_is_live(&branch->members, i) && member_at(&branch->members, i)->id_current_plan != -1) {
+            subscribed++;
+        }
+    }
+    atomic_fetch_add(&total_members, branch->members.live_count);
+    atomic_fetch_add(&total_subscribed, subscribed);
+}
+
+// Baseline check of one username: load every branch and scan it
+static const char *wanted;
+static atomic_int found_anywhere;
+
+static void scan_for_username(const Branch *branch, int index, void *arg) {
+    (void)index;
+    (void)arg;
+    for (int i = 0; i < branch->members.count; i++) {
+        if (table_is_live(&branch->members, i) &&
+            strcmp(member_at(&branch->members, i)->username, wanted) == 0) {
+            atomic_store(&found_anywhere, 1);
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int branch_count = argc > 1 ? atoi(argv[1]) : 16;
+    int per_branch = argc > 2 ? atoi(argv[2]) : 50000;
+    int threads = argc > 3 ? atoi(argv[3]) : online_cpu_count(BRANCH_MAX_THREADS);
+    if (branch_count < 1 || branch_count > BRANCH_MAX || per_branch < 1 || threads < 1) {
+        printf("Usage: %s [branches] [members_per_branch] [threads]\n", argv[0]);
+        return 1;
+    }
+
+    mkdir("bench_tmp", 0755);
+    mkdir(ROOT, 0755);
+    remove(LIST_FILE);
+    remove(INDEX_FILE);
+
+    // Member usernames are "b<branch>_<n>", so all are unique
+    char names[BRANCH_MAX][BRANCH_NAME_SIZE];
+    long long expected_subscribed = 0;
+    for (int b = 0; b < branch_count; b++) {
+        snprintf(names[b], BRANCH_NAME_SIZE, "branch%d", b);
+        branch_create(ROOT, LIST_FILE, names[b]);
+
+        Table members;
+        member_table_init(&members);
+        table_reserve(&members, per_branch);
+        for (int i = 1; i <= per_branch; i++) {
+            Member member;
+            memset(&member, 0, sizeof(member));
+            member.id_member = i;
+            snprintf(member.username, sizeof(member.username), "b%d_%d", b, i);
+            snprintf(member.password, sizeof(member.password), "pw%d", i);
+            snprintf(member.name, sizeof(member.name), "Member %d of branch %d", i, b);
+            member.id_current_plan = (i + b) % 3 == 0 ? -1 : 1;
+            expected_subscribed += member.id_current_plan != -1;
+            member_append(&members, &member);
+        }
+        char path[256];
+        snprintf(path, sizeof(path), ROOT "/%.31s/members.txt", names[b]);
+        table_write(&members, path);
+        table_free(&members);
+    }
+
+    printf("===== BRANCHES BENCHMARK =====\n\n");
+    printf("Branches: %d, members per branch: %d\n\n", branch_count, per_branch);
+
+    int totals_ok = 1;
+    for (int t = 1; ; t *= 2) {
+        if (t > threads) {
+            t = threads;
+        }
+        atomic_store(&total_members, 0);
+        atomic_store(&total_subscribed, 0);
+        double start = now_ms();
+        branches_for_each(ROOT, (const char (*)[BRANCH_NAME_SIZE])names, branch_count, t, count_members, NULL);
+        double elapsed = now_ms() - start;
+        int ok = atomic_load(&total_members) == (long long)branch_count * per_branch &&
+                 atomic_load(&total_subscribed) == expected_subscribed;
+        totals_ok = totals_ok && ok;
+        printf("Load all branches, %2d thread(s): %8.2f ms  %s\n", t, elapsed, ok ? "totals ok" : "totals WRONG");
+        if (t == threads) {
+            break;
+        }
+    }
+
+    double start = now_ms();
+    int indexed = username_index_start(INDEX_FILE, ROOT, LIST_FILE);
+    double build_ms = now_ms() - start;
+    username_index_stop();
+    start = now_ms();
+    int reopened = username_index_start(INDEX_FILE, ROOT, LIST_FILE);
+    double open_ms = now_ms() - start;
+    printf("\nIndex build: %8.2f ms  (%d usernames)\n", build_ms, indexed);
+    printf("Index open : %8.2f ms  (replaying the log)\n", open_ms);
+
+    // Look up names that exist and names that do not
+    char username[50], branch[BRANCH_NAME_SIZE];
+    int member_id, hits = 0, wrong = 0;
+    unsigned int x = 12345u;
+    start = now_ms();
+    for (int i = 0; i < LOOKUPS; i++) {
+        x = x * 1103515245u + 12345u;
+        int b = (int)(x >> 8) % branch_count;
+        int n = 1 + (int)(x >> 4) % (per_branch * 2);
+        snprintf(username, sizeof(username), "b%d_%d", b, n);
+        int found = username_index_lookup(username, branch, sizeof(branch), &member_id);
+        hits += found;
+        if (found != (n <= per_branch) || (found && (member_id != n || strcmp(branch, names[b]) != 0))) {
+            wrong++;
+        }
+    }
+    double lookup_ms = now_ms() - start;
+    printf("Lookup     : %8.4f us per username  (%d found, %d wrong)\n",
+           lookup_ms * 1000.0 / LOOKUPS, hits, wrong);
+
+    // Baseline: answer one lookup by loading every branch
+    wanted = "nobody";
+    atomic_store(&found_anywhere, 0);
+    start = now_ms();
+    branches_for_each(ROOT, (const char (*)[BRANCH_NAME_SIZE])names, branch_count, threads,
+                      scan_for_username, NULL);
+    printf("Scan       : %8.2f ms per username  (loading every branch instead)\n", now_ms() - start);
+
+    // Claims: new names are taken once, names of any branch are refused
+    int claims = 10000, claimed = 0, refused = 0;
+    start = now_ms();
+    for (int i = 0; i < claims; i++) {
+        snprintf(username, sizeof(username), "new_%d", i);
+        claimed += username_index_claim(username, names[i % branch_count], per_branch + 1 + i);
+    }
+    double claim_ms = now_ms() - start;
+    for (int i = 0; i < claims; i++) {
+        snprintf(username, sizeof(username), "new_%d", i);
+        refused += !username_index_claim(username, names[(i + 1) % branch_count], 1);
+    }
+    refused += !username_index_claim("b0_1", names[branch_count - 1], 99);
+    printf("Claim      : %8.2f us per new username (file lock + append)\n", claim_ms * 1000.0 / claims);
+
+    // A released name can be taken again, also after reopening the log
+    username_index_release("b0_1");
+    int reclaimed = username_index_claim("b0_1", names[branch_count - 1], 99);
+    username_index_stop();
+    username_index_start(INDEX_FILE, ROOT, LIST_FILE);
+    int kept = username_index_lookup("b0_1", branch, sizeof(branch), &member_id) &&
+               strcmp(branch, names[branch_count - 1]) == 0 && member_id == 99 &&
+               username_index_lookup("new_7", branch, sizeof(branch), &member_id);
+    username_index_stop();
+
+    int index_ok = indexed == branch_count * per_branch && reopened == indexed && wrong == 0 &&
+                   claimed == claims && refused == claims + 1 && reclaimed && kept;
+    printf("\nFan-out totals : %s\n", totals_ok ? "match" : "DIFFER");
+    printf("Username index : %s (claimed %d, refused %d)\n", index_ok ? "ok" : "WRONG", claimed, refused);
+    return totals_ok && index_ok ? 0 : 1;
+}
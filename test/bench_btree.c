@@ -0,0 +1,182 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime, mkdir
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "../src/member_archive.h"
+
+#define ARCHIVE_FILE "bench_tmp/archive_members.idx"
+#define USERNAME_FILE "bench_tmp/archive_usernames.idx"
+#define MEMBERS_FILE_COPY "bench_tmp/archive_members.txt"
+#define LOOKUPS 100000
+#define SCANS 20
+
+// Archive many members in the disk B+trees, then time lookups by ID and by
+// username with page caches of several sizes (counting the pages read from
+// the file per lookup), compared with loading the members file into a table
+// and scanning it with find_member_by_username(). Every record found is
+// checked, and deletes and renames are checked after reopening the files.
+// Build: gcc -O2 -o test/bench_btree test/bench_btree.c src/member_archive.c src/btree.c
+//        src/branches.c src/history.c src/maintenance.c src/classes.c src/member.c src/plans.c
+//        src/equipment.c src/table.c src/money.c src/subscriptions.c src/timer_wheel.c src/access.c
+//        src/loans.c src/autosave.c src/replication.c src/password.c src/username_filter.c
+//        src/hot_reload.c src/audit.c src/event_ring.c src/popularity.c src/batch_save.c
+//        src/shared_tables.c src/plan_catalog.c src/utils.c -lpthread
+// Usage: ./test/bench_btree [members] [cache_pages]
+// The files are written to bench_tmp/, the real data/ folder is not touched.
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static void make_member(Member *member, int id) {
+    memset(member, 0, sizeof(*member));
+    member->id_member = id;
+    // Usernames do not sort like IDs, so the username tree is filled out of order
+    snprintf(member->username, sizeof(member->username), "user%08x", (unsigned)id * 2654435761u);
+    snprintf(member->password, sizeof(member->password), "pw%d", id);
+    snprintf(member->name, sizeof(member->name), "Member Number %d", id);
+    member->id_current_plan = id % 3 == 0 ? -1 : 1 + id % 3;
+}
+
+static long long file_size(const char *path) {
+    struct stat info;
+    return stat(path, &info) == 0 ? (long long)info.st_size : 0;
+}
+
+// Random lookups, half by ID and half by username, a quarter of them for
+// members that do not exist. Returns the number of wrong answers.
+static int run_lookups(MemberArchive *archive, int count, double *elapsed_ms) {
+    unsigned x = 777u;
+    int wrong = 0;
+    double start = now_ms();
+    for (int i = 0; i < LOOKUPS; i++) {
+        x = x * 1103515245u + 12345u;
+        int id = 1 + (int)((x >> 4) % (unsigned)(count + count / 3));
+        Member expected, found;
+        make_member(&expected, id);
+        int ok = i % 2 == 0 ? member_archive_find(archive, id, &found)
+                            : member_archive_find_by_username(archive, expected.username, &found);
+        if (ok != (id <= count) || (ok && memcmp(&found, &expected, sizeof(Member)) != 0)) {
+            wrong++;
+        }
+    }
+    *elapsed_ms = now_ms() - start;
+    return wrong;
+}
+
+int main(int argc, char *argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 200000;
+    int cache_pages = argc > 2 ? atoi(argv[2]) : 64;
+    if (count < 1 || cache_pages < 1) {
+        printf("Usage: %s [members] [cache_pages]\n", argv[0]);
+        return 1;
+    }
+    mkdir("bench_tmp", 0755);
+    remove(ARCHIVE_FILE);
+    remove(USERNAME_FILE);
+
+    printf("===== MEMBER ARCHIVE (B+TREE) BENCHMARK =====\n\n");
+    printf("Members: %d\n\n", count);
+
+    // Build
+    MemberArchive archive;
+    if (!member_archive_open(&archive, ARCHIVE_FILE, USERNAME_FILE, cache_pages)) {
+        printf("Cannot create the archive files.\n");
+        return 1;
+    }
+    double start = now_ms();
+    for (int id = 1; id <= count; id++) {
+        Member member;
+        make_member(&member, id);
+        member_archive_put(&archive, &member);
+    }
+    member_archive_close(&archive);
+    double build_ms = now_ms() - start;
+    printf("Build       : %8.0f ms  (%.0f members/s)\n", build_ms, count / (build_ms / 1000.0));
+    printf("Files       : %.1f MB by ID, %.1f MB by username\n", file_size(ARCHIVE_FILE) / 1e6,
+           file_size(USERNAME_FILE) / 1e6);
+
+    // Lookups with caches of several sizes, each opened cold
+    int sizes[3] = { BTREE_MIN_CACHE_PAGES, cache_pages, cache_pages * 16 };
+    int wrong = 0;
+    int heights[2] = { 0, 0 };
+    printf("\n");
+    for (int s = 0; s < 3; s++) {
+        member_archive_open(&archive, ARCHIVE_FILE, USERNAME_FILE, sizes[s]);
+        heights[0] = archive.by_id.height;
+        heights[1] = archive.by_username.height;
+        double elapsed;
+        wrong += run_lookups(&archive, count, &elapsed);
+        long long reads = archive.by_id.page_reads + archive.by_username.page_reads;
+        printf("Cache %5d pages (%6.1f MB): %6.2f us per lookup, %.2f pages read per lookup\n", sizes[s],
+               2.0 * sizes[s] * BTREE_PAGE_SIZE / 1e6, elapsed * 1000.0 / LOOKUPS, (double)reads / LOOKUPS);
+        member_archive_close(&archive);
+    }
+    printf("Tree heights: %d by ID, %d by username\n", heights[0], heights[1]);
+
+    // Baseline: the whole members file in memory, scanned by username
+    Table members;
+    member_table_init(&members);
+    table_reserve(&members, count);
+    for (int id = 1; id <= count; id++) {
+        Member member;
+        make_member(&member, id);
+        member_append(&members, &member);
+    }
+    table_write(&members, MEMBERS_FILE_COPY);
+    table_free(&members);
+    member_table_init(&members);
+    start = now_ms();
+    table_load(&members, MEMBERS_FILE_COPY);
+    double load_ms = now_ms() - start;
+    start = now_ms();
+    int scan_hits = 0;
+    for (int i = 0; i < SCANS; i++) {
+        Member expected;
+        make_member(&expected, 1 + (i * 7919) % count);
+        scan_hits += find_member_by_username(&members, expected.username) != -1;
+    }
+    double scan_ms = (now_ms() - start) / SCANS;
+    printf("\nIn memory   : load %.0f ms and %.1f MB, then %.0f us per username scan\n", load_ms,
+           (double)members.capacity * sizeof(Member) / 1e6, scan_ms * 1000.0);
+
+    // Deletes and renames survive reopening
+    member_archive_open(&archive, ARCHIVE_FILE, USERNAME_FILE, cache_pages);
+    int deleted = 0;
+    for (int id = 2; id <= count; id += 97) {
+        deleted += member_archive_remove(&archive, id);
+    }
+    Member renamed;
+    make_member(&renamed, 1);
+    char old_username[50];
+    strcpy(old_username, renamed.username);
+    strcpy(renamed.username, "renamed_member");
+    member_archive_put(&archive, &renamed);
+    member_archive_close(&archive);
+
+    member_archive_open(&archive, ARCHIVE_FILE, USERNAME_FILE, cache_pages);
+    Member found;
+    int gone = 0;
+    for (int id = 2; id <= count; id += 97) {
+        Member expected;
+        make_member(&expected, id);
+        gone += !member_archive_find(&archive, id, &found) &&
+                !member_archive_find_by_username(&archive, expected.username, &found);
+    }
+    int renamed_ok = member_archive_find_by_username(&archive, "renamed_member", &found) &&
+                     found.id_member == 1 && !member_archive_find_by_username(&archive, old_username, &found);
+    int count_ok = archive.by_id.count == count - deleted && archive.by_username.count == count - deleted;
+    member_archive_close(&archive);
+
+    printf("\nLookups        : %s\n", wrong == 0 ? "all correct" : "WRONG");
+    printf("Username scans : %s\n", scan_hits == SCANS ? "all found" : "WRONG");
+    printf("Deletes/rename : %s (%d deleted)\n", gone == deleted && renamed_ok && count_ok ? "ok" : "WRONG",
+           deleted);
+    table_free(&members);
+    return wrong == 0 && scan_hits == SCANS && gone == deleted && renamed_ok && count_ok ? 0 : 1;
+}
@@ -0,0 +1,189 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime, mkdir, chdir
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "../src/checkin.h"
+#include "../src/access.h"
+#include "../src/plan_catalog.h"
+
+// Latency is measured on one badge out of SAMPLE_EVERY
+#define SAMPLE_EVERY 64
+#define MAX_THREADS  64
+
+// Badge random members in and out from several threads at once and report
+// the access check rate, the event rate, the badge latency and the size of
+// the log written.
+// Build: gcc -O2 -o test/bench_checkin test/bench_checkin.c src/checkin.c src/event_ring.c
+//        src/branches.c src/history.c src/maintenance.c src/classes.c src/member.c src/plans.c
+//        src/equipment.c src/table.c src/money.c src/subscriptions.c src/timer_wheel.c src/access.c
+//        src/loans.c src/autosave.c src/replication.c src/password.c src/username_filter.c
+//        src/hot_reload.c src/audit.c src/popularity.c src/batch_save.c src/shared_tables.c
+//        src/plan_catalog.c src/utils.c -lpthread
+// Usage: ./test/bench_checkin [threads] [badges_per_thread] [members]
+// The log is written to bench_tmp/data/checkins.log, the real data/ folder is not touched.
+
+typedef struct {
+    int member_count;
+    int badges;
+    unsigned int seed;
+    long accepted;
+    double *latencies;
+    int samples;
+} Producer;
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static void *producer_main(void *arg) {
+    Producer *p = arg;
+    unsigned int x = p->seed;
+
+    for (int i = 0; i < p->badges; i++) {
+        x = x * 1103515245u + 12345u;
+        int member_id = 1 + (int)((x >> 8) % (unsigned int)p->member_count);
+        int type;
+
+        if (i % SAMPLE_EVERY == 0) {
+            double start = now_ms();
+            int result = checkin_badge(member_id, &type);
+            p->latencies[p->samples++] = (now_ms() - start) * 1000.0;
+            p->accepted += result == CHECKIN_OK;
+        } else {
+            p->accepted += checkin_badge(member_id, &type) == CHECKIN_OK;
+        }
+    }
+    return NULL;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char *argv[]) {
+    int threads = argc > 1 ? atoi(argv[1]) : 4;
+    int badges = argc > 2 ? atoi(argv[2]) : 1000000;
+    int member_count = argc > 3 ? atoi(argv[3]) : 100000;
+    if (threads < 1 || threads > MAX_THREADS || badges < 1 || member_count < 1) {
+        printf("Usage: %s [threads 1-%d] [badges_per_thread] [members]\n", argv[0], MAX_THREADS);
+        return 1;
+    }
+
+    Table plans, members;
+    plan_table_init(&plans);
+    member_table_init(&members);
+
+    Plan plan;
+    create_plan(&plan, 1, "Full Access", 70 * MONEY_SCALE, "Generated plan for benchmark");
+    plan_append(&plans, &plan);
+    plan_catalog_publish(&plans);
+
+    if (!table_reserve(&members, member_count)) {
+        printf("Not enough memory for %d members.\n", member_count);
+        return 1;
+    }
+
+    // One member in ten has no subscription, so some badges are refused
+    for (int i = 0; i < member_count; i++) {
+        Member member = { 0 };
+        member.id_member = i + 1;
+        snprintf(member.username, sizeof(member.username), "user%d", i + 1);
+        snprintf(member.password, sizeof(member.password), "pass");
+        snprintf(member.name, sizeof(member.name), "Generated Member %d", i + 1);
+        member.id_current_plan = (i % 10 == 0) ? -1 : 1;
+        member_append(&members, &member);
+    }
+
+    // Build the access statuses once, like the app does after loading
+    double sync_start = now_ms();
+    access_sync(&members);
+    double sync_ms = now_ms() - sync_start;
+
+    mkdir("bench_tmp", 0755);
+    if (chdir("bench_tmp") != 0) {
+        printf("Cannot enter bench_tmp/.\n");
+        return 1;
+    }
+    mkdir("data", 0755);
+    remove(CHECKINS_FILE);
+
+    printf("===== CHECK-IN BENCHMARK =====\n\n");
+    printf("Threads: %d, badges per thread: %d, members: %d\n\n", threads, badges, member_count);
+
+    // Validation alone: one status byte per check
+    unsigned int x = 12345u;
+    long allowed = 0;
+    int checks = 20000000;
+    double check_start = now_ms();
+    for (int i = 0; i < checks; i++) {
+        x = x * 1103515245u + 12345u;
+        allowed += access_allows(access_status(1 + (int)((x >> 8) % (unsigned int)member_count)),
+                                 PLAN_AREAS_ALL);
+    }
+    double check_ms = now_ms() - check_start;
+    printf("Access rebuild  : %.2f ms for %d members\n", sync_ms, member_count);
+    printf("Access checks   : %.0f checks/s (%ld allowed of %d)\n\n",
+           checks / (check_ms / 1000.0), allowed, checks);
+
+    if (!checkin_start()) {
+        return 1;
+    }
+
+    Producer producers[MAX_THREADS];
+    pthread_t ids[MAX_THREADS];
+    int per_thread_samples = badges / SAMPLE_EVERY + 1;
+    double *latencies = malloc(sizeof(double) * per_thread_samples * threads);
+    if (!latencies) {
+        printf("Not enough memory.\n");
+        return 1;
+    }
+
+    double start = now_ms();
+    for (int t = 0; t < threads; t++) {
+        producers[t] = (Producer){ member_count, badges, 7919u * (t + 1), 0,
+                                   latencies + (size_t)t * per_thread_samples, 0 };
+        pthread_create(&ids[t], NULL, producer_main, &producers[t]);
+    }
+    long accepted = 0;
+    int samples = 0;
+    for (int t = 0; t < threads; t++) {
+        pthread_join(ids[t], NULL);
+        accepted += producers[t].accepted;
+    }
+    double badge_ms = now_ms() - start;
+
+    checkin_stop();
+    double total_ms = now_ms() - start;
+
+    // Gather the samples next to each other to sort them
+    for (int t = 0; t < threads; t++) {
+        for (int i = 0; i < producers[t].samples; i++) {
+            latencies[samples++] = producers[t].latencies[i];
+        }
+    }
+    qsort(latencies, samples, sizeof(double), compare_doubles);
+
+    long events = (long)threads * badges;
+    struct stat log_stat;
+    long logged = stat(CHECKINS_FILE, &log_stat) == 0 ? (long)(log_stat.st_size / sizeof(CheckinRecord)) : 0;
+
+    printf("Badges          : %ld (%ld accepted)\n", events, accepted);
+    printf("Badge rate      : %.0f events/s\n", events / (badge_ms / 1000.0));
+    printf("Latency p50     : %.2f us\n", latencies[samples / 2]);
+    printf("Latency p99     : %.2f us\n", latencies[samples * 99 / 100]);
+    printf("Logged          : %ld events in %.1f ms (badging + draining)\n", logged, total_ms);
+    printf("Occupancy       : %d\n", checkin_occupancy());
+    printf("\n%s\n", logged == events ? "Every event was logged." : "ERROR: events are missing from the log!");
+
+    free(latencies);
+    table_free(&plans);
+    table_free(&members);
+    return logged == events ? 0 : 1;
+}
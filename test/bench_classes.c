@@ -0,0 +1,143 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../src/classes.h"
+#include "../src/plans.h"
+#include "../src/plan_catalog.h"
+
+#define MAX_CLASSES 2000
+
+// The rush when a week's schedule opens: every member tries to book a few
+// random classes, then some cancel and the waitlists move up. Checks that no
+// class has more seats taken than its capacity, and that the counts kept up
+// to date while booking match a full rebuild from the tables.
+// Build: gcc -O2 -o test/bench_classes test/bench_classes.c src/branches.c src/history.c
+//        src/maintenance.c src/classes.c src/member.c src/plans.c src/equipment.c src/table.c
+//        src/money.c src/subscriptions.c src/timer_wheel.c src/access.c src/loans.c src/autosave.c
+//        src/replication.c src/password.c src/username_filter.c src/hot_reload.c src/audit.c
+//        src/event_ring.c src/popularity.c src/batch_save.c src/shared_tables.c src/plan_catalog.c
+//        src/utils.c -lpthread
+// Usage: ./test/bench_classes [members] [classes] [tries_per_member]
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+int main(int argc, char *argv[]) {
+    int member_count = argc > 1 ? atoi(argv[1]) : 20000;
+    int class_count = argc > 2 ? atoi(argv[2]) : 200;
+    int tries = argc > 3 ? atoi(argv[3]) : 5;
+    if (member_count < 1 || class_count < 1 || class_count > MAX_CLASSES || tries < 1) {
+        printf("Usage: %s [members] [classes 1-%d] [tries_per_member]\n", argv[0], MAX_CLASSES);
+        return 1;
+    }
+
+    // One plan opening every area, so only capacity and overlaps refuse a booking
+    Table plans;
+    Plan plan;
+    plan_table_init(&plans);
+    create_plan(&plan, 1, "Full Access", 1000, "Every area");
+    plan_append(&plans, &plan);
+    plan_catalog_publish(&plans);
+
+    Table members;
+    member_table_init(&members);
+    for (int i = 1; i <= member_count; i++) {
+        Member member = {0};
+        member.id_member = i;
+        snprintf(member.username, sizeof(member.username), "member%d", i);
+        member.id_current_plan = 1;
+        member_append(&members, &member);
+    }
+
+    ClassSchedule schedule;
+    class_schedule_init(&schedule);
+    unsigned int x = 12345u;
+    for (int i = 0; i < class_count; i++) {
+        GymClass gym_class = {0};
+        snprintf(gym_class.name, sizeof(gym_class.name), "Class %d", i + 1);
+        gym_class.id_plan = 1;
+        x = x * 1103515245u + 12345u;
+        gym_class.weekday = (x >> 8) % 7;
+        gym_class.start_slot = 12 + (x >> 12) % 28;      // 06:00 to 19:30
+        gym_class.slot_count = 1 + (x >> 20) % 3;
+        gym_class.capacity = 10 + (x >> 24) % 21;
+        class_add(&schedule, &gym_class);
+    }
+
+    printf("===== CLASS BOOKING BENCHMARK =====\n\n");
+    printf("Members: %d, classes: %d, booking tries per member: %d\n\n",
+           member_count, class_count, tries);
+
+    long results[6] = {0};  // booked, waitlisted, then the errors by -result
+    double start = now_ms();
+    for (int t = 0; t < tries; t++) {
+        for (int i = 0; i < member_count; i++) {
+            x = x * 1103515245u + 12345u;
+            int class_id = 1 + (int)((x >> 8) % (unsigned int)class_count);
+            int result = class_book(&schedule, member_at(&members, i), class_id);
+            results[result >= 0 ? result : 1 - result]++;
+        }
+    }
+    double book_ms = now_ms() - start;
+    double attempts = (double)member_count * tries;
+    printf("Booking  : %8.2f ms  %12.0f bookings/s\n", book_ms, attempts / (book_ms / 1000.0));
+    printf("           %ld booked, %ld waitlisted, %ld already booked, %ld overlapping\n",
+           results[0], results[1], results[1 - CLASS_ALREADY_BOOKED], results[1 - CLASS_CONFLICT]);
+
+    // A third of the members cancel everything: their seats go to the waitlists
+    long promoted = 0;
+    start = now_ms();
+    for (int i = 0; i < member_count; i += 3) {
+        for (int c = 1; c <= class_count; c++) {
+            int promoted_member;
+            if (class_cancel(&schedule, i + 1, c, &promoted_member) && promoted_member != -1) {
+                promoted++;
+            }
+        }
+    }
+    double cancel_ms = now_ms() - start;
+    printf("Cancels  : %8.2f ms  (%ld waiting member(s) promoted)\n", cancel_ms, promoted);
+
+    int booked[MAX_CLASSES + 1], waiting[MAX_CLASSES + 1];
+    int over_capacity = 0, waiting_with_seats = 0;
+    for (int c = 1; c <= class_count; c++) {
+        const GymClass *gym_class = gym_class_find(&schedule.classes, c);
+        booked[c] = class_booked_count(&schedule, c);
+        waiting[c] = class_waiting_count(&schedule, c);
+        if (booked[c] > gym_class->capacity) {
+            over_capacity++;
+        }
+        if (waiting[c] > 0 && booked[c] < gym_class->capacity) {
+            waiting_with_seats++;
+        }
+    }
+
+    // Force a rebuild from the tables, as after loading them
+    table_touch(&schedule.bookings);
+    start = now_ms();
+    class_schedule_sync(&schedule);
+    double rebuild_ms = now_ms() - start;
+
+    int mismatches = 0;
+    for (int c = 1; c <= class_count; c++) {
+        if (class_booked_count(&schedule, c) != booked[c] ||
+            class_waiting_count(&schedule, c) != waiting[c]) {
+            mismatches++;
+        }
+    }
+    printf("Rebuild  : %8.2f ms  (%d booking(s))\n\n", rebuild_ms, schedule.bookings.live_count);
+
+    printf("Over capacity            : %d class(es)\n", over_capacity);
+    printf("Waiting with seats free  : %d class(es)\n", waiting_with_seats);
+    printf("Counts differ on rebuild : %d class(es)\n", mismatches);
+
+    class_schedule_free(&schedule);
+    table_free(&members);
+    table_free(&plans);
+    return over_capacity == 0 && waiting_with_seats == 0 && mismatches == 0 ? 0 : 1;
+}
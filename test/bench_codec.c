@@ -0,0 +1,64 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../src/member.h"
+
+// Compare the schema-generated member parser/formatter with sscanf/snprintf.
+// Build: gcc -O2 -o test/bench_codec test/bench_codec.c src/branches.c src/history.c
+//        src/maintenance.c src/classes.c src/member.c src/plans.c src/equipment.c src/table.c
+//        src/money.c src/subscriptions.c src/timer_wheel.c src/access.c src/loans.c src/autosave.c
+//        src/replication.c src/password.c src/username_filter.c src/hot_reload.c src/audit.c
+//        src/event_ring.c src/popularity.c src/batch_save.c src/shared_tables.c src/plan_catalog.c
+//        src/utils.c -lpthread
+// Usage: ./test/bench_codec [records]
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+int main(int argc, char *argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 1000000;
+    Member member = { 0 };
+    char line[512];
+    long checksum = 0;
+
+    printf("===== CODEC BENCHMARK =====\n\n");
+
+    double start = now_ms();
+    for (int i = 0; i < count; i++) {
+        member.id_member = i;
+        member.id_current_plan = i % 7 - 1;
+        snprintf(member.username, sizeof(member.username), "user%d", i & 1023);
+        snprintf(line, sizeof(line), "%d|%s|%s|%s|%d\n", member.id_member, member.username,
+                 "secret", "Generated Member", member.id_current_plan);
+        sscanf(line, "%d|%49[^|]|%49[^|]|%99[^|]|%d", &member.id_member, member.username,
+               member.password, member.name, &member.id_current_plan);
+        checksum += member.id_member;
+    }
+    double scanf_ms = now_ms() - start;
+
+    snprintf(member.password, sizeof(member.password), "secret");
+    snprintf(member.name, sizeof(member.name), "Generated Member");
+
+    start = now_ms();
+    for (int i = 0; i < count; i++) {
+        member.id_member = i;
+        member.id_current_plan = i % 7 - 1;
+        snprintf(member.username, sizeof(member.username), "user%d", i & 1023);
+        int length = member_codec.format(&member, line, sizeof(line));
+        line[length - 1] = '\0';
+        member_codec.parse(line, &member);
+        checksum -= member.id_member;
+    }
+    double schema_ms = now_ms() - start;
+
+    printf("Records: %d (format + parse each)\n\n", count);
+    printf("snprintf/sscanf : %8.2f ms\n", scanf_ms);
+    printf("schema codec    : %8.2f ms\n", schema_ms);
+    printf("\nChecksum: %ld (0 if both agree)\n", checksum);
+    return 0;
+}
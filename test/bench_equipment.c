@@ -0,0 +1,165 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "../src/loans.h"
+
+#define MAX_THREADS 64
+#define MAX_ITEMS   64
+
+// Many threads reserve and release units of the same few popular items.
+// Compares the lock-free stock counters with one mutex per item, and checks
+// that no item ever has more units out than its stock.
+// Build: gcc -O2 -o test/bench_equipment test/bench_equipment.c src/branches.c src/history.c
+//        src/maintenance.c src/classes.c src/member.c src/plans.c src/equipment.c src/table.c
+//        src/money.c src/subscriptions.c src/timer_wheel.c src/access.c src/loans.c src/autosave.c
+//        src/replication.c src/password.c src/username_filter.c src/hot_reload.c src/audit.c
+//        src/event_ring.c src/popularity.c src/batch_save.c src/shared_tables.c src/plan_catalog.c
+//        src/utils.c -lpthread
+// Usage: ./test/bench_equipment [threads] [operations_per_thread] [items] [units_per_item]
+
+typedef struct {
+    int operations;
+    int items;
+    int use_mutex;
+    unsigned int seed;
+    long taken;
+    long refused;
+} Worker;
+
+static int units_per_item;
+static atomic_int held[MAX_ITEMS + 1];     // units out right now, checked by the workers
+static atomic_long oversubscribed;
+
+// Mutex baseline: a plain counter per item behind a lock
+static pthread_mutex_t item_lock[MAX_ITEMS + 1];
+static int item_available[MAX_ITEMS + 1];
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static int reserve_locked(int id) {
+    pthread_mutex_lock(&item_lock[id]);
+    int ok = item_available[id] > 0;
+    if (ok) {
+        item_available[id]--;
+    }
+    pthread_mutex_unlock(&item_lock[id]);
+    return ok;
+}
+
+static void release_locked(int id) {
+    pthread_mutex_lock(&item_lock[id]);
+    item_available[id]++;
+    pthread_mutex_unlock(&item_lock[id]);
+}
+
+static void *worker_main(void *arg) {
+    Worker *w = arg;
+    unsigned int x = w->seed;
+
+    for (int i = 0; i < w->operations; i++) {
+        x = x * 1103515245u + 12345u;
+        int id = 1 + (int)((x >> 8) % (unsigned int)w->items);
+
+        int ok = w->use_mutex ? reserve_locked(id) : equipment_reserve(id);
+        if (!ok) {
+            w->refused++;
+            continue;
+        }
+
+        w->taken++;
+        if (atomic_fetch_add(&held[id], 1) + 1 > units_per_item) {
+            atomic_fetch_add(&oversubscribed, 1);
+        }
+        atomic_fetch_sub(&held[id], 1);
+
+        if (w->use_mutex) {
+            release_locked(id);
+        } else {
+            equipment_release(id);
+        }
+    }
+    return NULL;
+}
+
+static double run(int threads, int operations, int items, int use_mutex, long *taken, long *refused) {
+    Worker workers[MAX_THREADS];
+    pthread_t ids[MAX_THREADS];
+
+    *taken = 0;
+    *refused = 0;
+    double start = now_ms();
+    for (int t = 0; t < threads; t++) {
+        workers[t] = (Worker){ operations, items, use_mutex, 2654435761u * (t + 1), 0, 0 };
+        pthread_create(&ids[t], NULL, worker_main, &workers[t]);
+    }
+    for (int t = 0; t < threads; t++) {
+        pthread_join(ids[t], NULL);
+        *taken += workers[t].taken;
+        *refused += workers[t].refused;
+    }
+    return now_ms() - start;
+}
+
+int main(int argc, char *argv[]) {
+    int threads = argc > 1 ? atoi(argv[1]) : 8;
+    int operations = argc > 2 ? atoi(argv[2]) : 1000000;
+    int items = argc > 3 ? atoi(argv[3]) : 4;
+    units_per_item = argc > 4 ? atoi(argv[4]) : 3;
+    if (threads < 1 || threads > MAX_THREADS || items < 1 || items > MAX_ITEMS ||
+        operations < 1 || units_per_item < 1) {
+        printf("Usage: %s [threads 1-%d] [operations] [items 1-%d] [units]\n",
+               argv[0], MAX_THREADS, MAX_ITEMS);
+        return 1;
+    }
+
+    Table equipment, loans;
+    equipment_table_init(&equipment);
+    loan_table_init(&loans);
+    for (int i = 1; i <= items; i++) {
+        char name[50];
+        Equipment eq;
+        snprintf(name, sizeof(name), "Machine %d", i);
+        create_equipment(&eq, i, name, "Generated equipment for benchmark", units_per_item);
+        equipment_append(&equipment, &eq);
+        pthread_mutex_init(&item_lock[i], NULL);
+        item_available[i] = units_per_item;
+    }
+    equipment_stock_sync(&equipment, &loans);
+
+    printf("===== EQUIPMENT CONTENTION BENCHMARK =====\n\n");
+    printf("Threads: %d, operations per thread: %d, items: %d, units per item: %d\n\n",
+           threads, operations, items, units_per_item);
+
+    long taken, refused;
+    double total = (double)threads * operations;
+
+    double mutex_ms = run(threads, operations, items, 1, &taken, &refused);
+    printf("mutex per item  : %8.2f ms  %12.0f ops/s  (%ld taken, %ld refused)\n",
+           mutex_ms, total / (mutex_ms / 1000.0), taken, refused);
+
+    double atomic_ms = run(threads, operations, items, 0, &taken, &refused);
+    printf("atomic counters : %8.2f ms  %12.0f ops/s  (%ld taken, %ld refused)\n",
+           atomic_ms, total / (atomic_ms / 1000.0), taken, refused);
+
+    int restored = 1;
+    for (int i = 1; i <= items; i++) {
+        if (equipment_available(i) != units_per_item) {
+            restored = 0;
+        }
+    }
+
+    printf("\nOversubscribed  : %ld time(s)\n", atomic_load(&oversubscribed));
+    printf("Stock restored  : %s\n", restored ? "yes" : "NO");
+
+    table_free(&equipment);
+    table_free(&loans);
+    return atomic_load(&oversubscribed) == 0 && restored ? 0 : 1;
+}
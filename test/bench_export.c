@@ -0,0 +1,181 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime, mkdir, gmtime_r
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "../src/export.h"
+#include "../src/member.h"
+
+#define SECONDS_PER_DAY (24LL * 60 * 60)
+
+// Export a large members table to CSV and JSON Lines, compared with an
+// fprintf() loop writing the same CSV, then read the files back to check
+// the record count, that no password was written and that dates match
+// gmtime().
+// Build: gcc -O2 -o test/bench_export test/bench_export.c src/export.c src/branches.c src/history.c
+//        src/maintenance.c src/classes.c src/member.c src/plans.c src/equipment.c src/table.c
+//        src/money.c src/subscriptions.c src/timer_wheel.c src/access.c src/loans.c src/autosave.c
+//        src/replication.c src/password.c src/username_filter.c src/hot_reload.c src/audit.c
+//        src/event_ring.c src/popularity.c src/batch_save.c src/shared_tables.c src/plan_catalog.c
+//        src/utils.c -lpthread
+// Usage: ./test/bench_export [members]
+// The files are written to bench_tmp/, the real data/ folder is not touched.
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+// Baseline: the obvious fprintf() export with the same quoting rules
+static void export_with_fprintf(const Table *members, FILE *out) {
+    fprintf(out, "id_member,username,name,id_current_plan,subscription_start,subscription_end\n");
+    for (int i = 0; i < members->count; i++) {
+        if (!table_is_live(members, i)) {
+            continue;
+        }
+        const Member *m = member_at(members, i);
+        fprintf(out, "%d,%s,", m->id_member, m->username);
+        if (strpbrk(m->name, ",\"\r\n")) {
+            fputc('"', out);
+            for (const char *c = m->name; *c; c++) {
+                if (*c == '"') {
+                    fputc('"', out);
+                }
+                fputc(*c, out);
+            }
+            fputc('"', out);
+        } else {
+            fputs(m->name, out);
+        }
+        fprintf(out, ",%d,", m->id_current_plan);
+        long long times[2] = { m->subscription_start, m->subscription_end };
+        for (int t = 0; t < 2; t++) {
+            if (times[t] != 0) {
+                time_t when = (time_t)times[t];
+                struct tm tm;
+                gmtime_r(&when, &tm);
+                char text[32];
+                strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%SZ", &tm);
+                fputs(text, out);
+            }
+            fputc(t == 0 ? ',' : '\n', out);
+        }
+    }
+}
+
+// Count lines and look for the password marker
+static int check_file(const char *path, long long *lines) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return 0;
+    }
+    static char chunk[1 << 16];
+    size_t n;
+    int leaked = 0;
+    *lines = 0;
+    while ((n = fread(chunk, 1, sizeof(chunk) - 8, f)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            *lines += chunk[i] == '\n';
+            if (chunk[i] == 'S' && i + 6 <= n && memcmp(chunk + i, "SECRET", 6) == 0) {
+                leaked = 1;
+            }
+        }
+    }
+    fclose(f);
+    return !leaked;
+}
+
+static double export_to(const Table *members, const char *path, int format, ExportStats *stats) {
+    FILE *out = fopen(path, "wb");
+    setvbuf(out, NULL, _IONBF, 0);
+    double start = now_ms();
+    export_members(members, out, format, stats);
+    fclose(out);
+    return now_ms() - start;
+}
+
+int main(int argc, char *argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 1000000;
+    if (count < 1) {
+        printf("Usage: %s [members]\n", argv[0]);
+        return 1;
+    }
+    mkdir("bench_tmp", 0755);
+
+    Table members;
+    member_table_init(&members);
+    table_reserve(&members, count);
+    long long base = 1700000000LL;
+    for (int i = 1; i <= count; i++) {
+        Member member;
+        memset(&member, 0, sizeof(member));
+        member.id_member = i;
+        snprintf(member.username, sizeof(member.username), "member%d", i);
+        snprintf(member.password, sizeof(member.password), "SECRET%d", i);
+        if (i % 10 == 0) {
+            snprintf(member.name, sizeof(member.name), "Ben Salah, \"Sami\" %d", i);
+        } else {
+            snprintf(member.name, sizeof(member.name), "Member Number %d", i);
+        }
+        member.id_current_plan = i % 3 == 0 ? -1 : 1 + i % 3;
+        if (member.id_current_plan != -1) {
+            member.subscription_start = base + (long long)i * 7919 % (900 * SECONDS_PER_DAY);
+            member.subscription_end = member.subscription_start + 30 * SECONDS_PER_DAY;
+        }
+        member_append(&members, &member);
+    }
+
+    printf("===== EXPORT BENCHMARK =====\n\n");
+    printf("Members: %d\n\n", count);
+
+    FILE *out = fopen("bench_tmp/export_fprintf.csv", "wb");
+    double start = now_ms();
+    export_with_fprintf(&members, out);
+    fclose(out);
+    double baseline_ms = now_ms() - start;
+    struct stat info;
+    stat("bench_tmp/export_fprintf.csv", &info);
+    printf("fprintf CSV : %8.2f ms  %8.1f MB/s\n", baseline_ms, info.st_size / 1e6 / (baseline_ms / 1000.0));
+
+    ExportStats csv, json;
+    double csv_ms = export_to(&members, "bench_tmp/export_members.csv", EXPORT_CSV, &csv);
+    printf("Export CSV  : %8.2f ms  %8.1f MB/s  (%lld bytes)\n", csv_ms, csv.bytes / 1e6 / (csv_ms / 1000.0),
+           csv.bytes);
+    double json_ms = export_to(&members, "bench_tmp/export_members.jsonl", EXPORT_JSONL, &json);
+    printf("Export JSONL: %8.2f ms  %8.1f MB/s  (%lld bytes)\n", json_ms, json.bytes / 1e6 / (json_ms / 1000.0),
+           json.bytes);
+
+    // The CSV must match the fprintf one byte for byte
+    int same = 0;
+    FILE *a = fopen("bench_tmp/export_fprintf.csv", "rb");
+    FILE *b = fopen("bench_tmp/export_members.csv", "rb");
+    if (a && b) {
+        int ca, cb;
+        do {
+            ca = fgetc(a);
+            cb = fgetc(b);
+        } while (ca == cb && ca != EOF);
+        same = ca == cb;
+    }
+    if (a) {
+        fclose(a);
+    }
+    if (b) {
+        fclose(b);
+    }
+
+    long long csv_lines = 0, json_lines = 0;
+    int clean = check_file("bench_tmp/export_members.csv", &csv_lines) &&
+                check_file("bench_tmp/export_members.jsonl", &json_lines);
+    int counts_ok = csv.records == count && csv_lines == count + 1 && json_lines == count;
+
+    printf("\nSame as fprintf CSV: %s\n", same ? "yes" : "NO");
+    printf("Records            : %s\n", counts_ok ? "ok" : "WRONG");
+    printf("Passwords written  : %s\n", clean ? "none" : "YES");
+
+    table_free(&members);
+    return same && counts_ok && clean ? 0 : 1;
+}
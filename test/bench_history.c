@@ -0,0 +1,173 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime, mkdir
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "../src/history.h"
+
+#define SECONDS_PER_DAY (24LL * 60 * 60)
+#define SAMPLE_MEMBERS 200
+
+// Write a few years of subscription events for many members, then measure
+// the log size, reopening it, member timelines and the streaming churn
+// report, and check both against the events that were written.
+// Build: gcc -O2 -o test/bench_history test/bench_history.c src/branches.c src/history.c
+//        src/maintenance.c src/classes.c src/member.c src/plans.c src/equipment.c src/table.c
+//        src/money.c src/subscriptions.c src/timer_wheel.c src/access.c src/loans.c src/autosave.c
+//        src/replication.c src/password.c src/username_filter.c src/hot_reload.c src/audit.c
+//        src/event_ring.c src/popularity.c src/batch_save.c src/shared_tables.c src/plan_catalog.c
+//        src/utils.c -lpthread
+// Usage: ./test/bench_history [members] [months]
+// The log is written to bench_tmp/history.log, the real data/ folder is not touched.
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+int main(int argc, char *argv[]) {
+    int member_count = argc > 1 ? atoi(argv[1]) : 100000;
+    int months = argc > 2 ? atoi(argv[2]) : 24;
+    if (member_count < 1 || months < 1) {
+        printf("Usage: %s [members] [months]\n", argv[0]);
+        return 1;
+    }
+
+    const char *path = "bench_tmp/history.log";
+    mkdir("bench_tmp", 0755);
+    remove(path);
+
+    Table members;
+    member_table_init(&members);
+    if (history_start(path, &members) != 0) {
+        printf("Cannot create %s.\n", path);
+        return 1;
+    }
+
+    // Every member starts at some point, then each month renews, changes
+    // plan, lets the subscription end or comes back
+    HistoryEvent *written = malloc(sizeof(HistoryEvent) * (size_t)member_count * (months + 1));
+    int *plan = calloc(member_count + 1, sizeof(int));
+    unsigned char *state = calloc(member_count + 1, 1);   // 0 never, 1 subscribed, 2 ended
+    if (!written || !plan || !state) {
+        printf("Not enough memory.\n");
+        return 1;
+    }
+
+    long long expected[5] = {0};   // started, returned, renewed, changed, ended
+    long long count = 0;
+    long long start_time = time(NULL) - months * 30 * SECONDS_PER_DAY;
+    unsigned int x = 12345u;
+
+    double start = now_ms();
+    for (int m = 0; m < months; m++) {
+        for (int id = 1; id <= member_count; id++) {
+            x = x * 1103515245u + 12345u;
+            unsigned int roll = (x >> 8) % 100;
+            long long when = start_time + m * 30 * SECONDS_PER_DAY + (x >> 16) % (30 * SECONDS_PER_DAY);
+            HistoryEvent event = { when, id, HISTORY_SUBSCRIBE, 0 };
+
+            if (state[id] != 1) {
+                if (roll >= 20) {
+                    continue;  // Not this month
+                }
+                expected[state[id] == 0 ? 0 : 1]++;
+                event.plan_id = 1 + roll % 4;
+            } else if (roll < 70) {
+                expected[2]++;
+                event.plan_id = plan[id];
+            } else if (roll < 80) {
+                expected[3]++;
+                event.plan_id = 1 + (plan[id] % 4);
+            } else {
+                expected[4]++;
+                event.type = roll < 98 ? HISTORY_EXPIRE : HISTORY_DELETE;
+                event.plan_id = plan[id];
+            }
+
+            history_record(id, event.type, event.plan_id, event.time);
+            written[count++] = event;
+            state[id] = event.type == HISTORY_SUBSCRIBE ? 1 : 2;
+            plan[id] = event.plan_id;
+        }
+    }
+    double append_ms = now_ms() - start;
+    history_stop();
+
+    struct stat info;
+    stat(path, &info);
+
+    printf("===== SUBSCRIPTION HISTORY BENCHMARK =====\n\n");
+    printf("Members: %d, months: %d, events: %lld\n\n", member_count, months, count);
+    printf("Append   : %8.2f ms  %12.0f events/s\n", append_ms, count / (append_ms / 1000.0));
+    printf("Log size : %lld bytes, %.1f bytes/event (%d as a plain struct)\n",
+           (long long)info.st_size, (double)info.st_size / count, (int)sizeof(HistoryEvent));
+
+    start = now_ms();
+    history_start(path, &members);
+    printf("Reopen   : %8.2f ms  (index of each member's last record)\n", now_ms() - start);
+
+    // Timelines of a few members against what was written
+    HistoryEvent *timeline = malloc(sizeof(HistoryEvent) * (months + 1));
+    int wrong_timelines = 0;
+    double query_ms = 0;
+    for (int s = 0; s < SAMPLE_MEMBERS; s++) {
+        int id = 1 + (int)((2654435761u * (unsigned int)(s + 1)) % (unsigned int)member_count);
+
+        start = now_ms();
+        int found = history_timeline(id, timeline, months + 1);
+        query_ms += now_ms() - start;
+
+        int matched = 0;
+        for (long long i = 0; i < count; i++) {
+            if (written[i].member_id != id) {
+                continue;
+            }
+            if (matched >= found || timeline[matched].time != written[i].time ||
+                timeline[matched].type != written[i].type || timeline[matched].plan_id != written[i].plan_id) {
+                matched = -1;
+                break;
+            }
+            matched++;
+        }
+        if (matched != found) {
+            wrong_timelines++;
+        }
+    }
+    printf("Timeline : %8.4f ms per member\n", query_ms / SAMPLE_MEMBERS);
+
+    start = now_ms();
+    ChurnReport report;
+    int read = history_churn(path, &report);
+    double churn_ms = now_ms() - start;
+
+    long long totals[5] = {0};
+    for (int i = 0; read && i < report.count; i++) {
+        totals[0] += report.months[i].started;
+        totals[1] += report.months[i].returned;
+        totals[2] += report.months[i].renewed;
+        totals[3] += report.months[i].changed;
+        totals[4] += report.months[i].ended;
+    }
+    int churn_ok = read && report.events == count;
+    for (int i = 0; i < 5; i++) {
+        churn_ok = churn_ok && totals[i] == expected[i];
+    }
+    printf("Churn    : %8.2f ms  %12.0f events/s streamed (%d months)\n",
+           churn_ms, count / (churn_ms / 1000.0), report.count);
+
+    printf("\nTimelines wrong  : %d of %d\n", wrong_timelines, SAMPLE_MEMBERS);
+    printf("Churn totals     : %s (new %lld, back %lld, renew %lld, change %lld, ended %lld)\n",
+           churn_ok ? "match" : "DIFFER", totals[0], totals[1], totals[2], totals[3], totals[4]);
+
+    history_stop();
+    free(report.months);
+    free(timeline);
+    free(written);
+    free(plan);
+    free(state);
+    table_free(&members);
+    return wrong_timelines == 0 && churn_ok ? 0 : 1;
+}
@@ -0,0 +1,196 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime, nanosleep, mkdir
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "../src/hot_reload.h"
+#include "../src/equipment.h"
+#include "../src/plans.h"
+
+#define PLANS_FILE_COPY "bench_tmp/reload_plans.txt"
+#define EQUIPMENT_FILE_COPY "bench_tmp/reload_equipment.txt"
+#define ROUNDS 5
+#define WAIT_LIMIT_MS 5000
+
+// Fill a large equipment table, then let another "program" rewrite its file
+// with a few records changed. Times how long the watcher takes to notice,
+// read and compare the file, and how long applying the changes takes,
+// against reading the whole file again. Checks that the live table then
+// matches the file, and that an edit made in the app to a record the file
+// also changed is kept.
+// Build: gcc -O2 -o test/bench_hot_reload test/bench_hot_reload.c src/branches.c src/history.c
+//        src/maintenance.c src/classes.c src/member.c src/plans.c src/equipment.c src/table.c
+//        src/money.c src/subscriptions.c src/timer_wheel.c src/access.c src/loans.c src/autosave.c
+//        src/replication.c src/password.c src/username_filter.c src/hot_reload.c src/audit.c
+//        src/event_ring.c src/popularity.c src/batch_save.c src/shared_tables.c src/plan_catalog.c
+//        src/utils.c -lpthread
+// Usage: ./test/bench_hot_reload [records] [changed_per_round]
+// The files are written to bench_tmp/, the real data/ folder is not touched.
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static void sleep_ms(int ms) {
+    struct timespec ts = {ms / 1000, (ms % 1000) * 1000000L};
+    nanosleep(&ts, NULL);
+}
+
+static void make_equipment(Equipment *eq, int id) {
+    memset(eq, 0, sizeof(*eq));
+    eq->id_equipment = id;
+    snprintf(eq->name, sizeof(eq->name), "Machine %d", id);
+    snprintf(eq->description, sizeof(eq->description), "Equipment number %d of the gym", id);
+    eq->quantity = 1 + id % 20;
+}
+
+// Wait for the watcher to find the change, then apply it; returns the
+// records changed (0 if nothing came in time)
+static int wait_and_apply(double *apply_ms) {
+    double start = now_ms();
+    while (now_ms() - start < WAIT_LIMIT_MS) {
+        double before = now_ms();
+        int changed = hot_reload_apply();
+        if (changed > 0) {
+            *apply_ms = now_ms() - before;
+            return changed;
+        }
+        sleep_ms(1);
+    }
+    return 0;
+}
+
+// The live table holds the same records as the file
+static int matches_file(const Table *live, const char *path) {
+    Table file;
+    equipment_table_init(&file);
+    int same = table_load(&file, path) > 0 && live->live_count == file.live_count;
+    for (int i = 0; i < file.count && same; i++) {
+        if (!table_is_live(&file, i)) {
+            continue;
+        }
+        const Equipment *expected = equipment_at(&file, i);
+        const Equipment *found = equipment_find(live, expected->id_equipment);
+        same = found && memcmp(found, expected, sizeof(Equipment)) == 0;
+    }
+    table_free(&file);
+    return same;
+}
+
+int main(int argc, char *argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 200000;
+    int per_round = argc > 2 ? atoi(argv[2]) : 10;
+    if (count < 100 || per_round < 1 || per_round > count / 10) {
+        printf("Usage: %s [records >= 100] [changed_per_round <= records / 10]\n", argv[0]);
+        return 1;
+    }
+    mkdir("bench_tmp", 0755);
+
+    printf("===== HOT RELOAD BENCHMARK =====\n\n");
+    printf("Equipment records: %d, changed per round: %d (+1 added, 1 deleted)\n\n", count, per_round);
+
+    // The files another program will edit
+    Table plans, equipment, file;
+    plan_table_init(&plans);
+    Plan plan;
+    memset(&plan, 0, sizeof(plan));
+    plan.id_plan = 1;
+    snprintf(plan.name, sizeof(plan.name), "Basic");
+    snprintf(plan.description, sizeof(plan.description), "Gym access");
+    plan.areas = PLAN_AREAS_ALL;
+    plan_append(&plans, &plan);
+    table_write(&plans, PLANS_FILE_COPY);
+    table_free(&plans);
+
+    equipment_table_init(&file);
+    table_reserve(&file, count);
+    for (int id = 1; id <= count; id++) {
+        Equipment eq;
+        make_equipment(&eq, id);
+        equipment_append(&file, &eq);
+    }
+    table_write(&file, EQUIPMENT_FILE_COPY);
+
+    // The app's tables
+    plan_table_init(&plans);
+    table_load(&plans, PLANS_FILE_COPY);
+    equipment_table_init(&equipment);
+    double start = now_ms();
+    table_load(&equipment, EQUIPMENT_FILE_COPY);
+    double full_load_ms = now_ms() - start;
+
+    if (!hot_reload_start(&plans, &equipment)) {
+        printf("Watching files is not supported here.\n");
+        return 1;
+    }
+
+    // Rounds: a few records edited, one added and one deleted, file rewritten
+    double detect_total = 0, apply_total = 0, parse_total = 0;
+    int all_applied = 1, all_same = 1;
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int i = 0; i < per_round; i++) {
+            Equipment *eq = equipment_find(&file, 1 + (round * 7919 + i * 104729) % count);
+            if (eq) {
+                eq->quantity += 5;
+                snprintf(eq->description, sizeof(eq->description), "Repaired in round %d", round + 1);
+            }
+        }
+        Equipment added;
+        make_equipment(&added, table_next_id(&file));
+        equipment_append(&file, &added);
+        table_remove(&file, 2 + round);
+        table_write(&file, EQUIPMENT_FILE_COPY);
+
+        double written = now_ms();
+        double apply_ms = 0;
+        int changed = wait_and_apply(&apply_ms);
+        double detect_ms = now_ms() - written - apply_ms;
+
+        HotReloadStatus status;
+        hot_reload_status(&status);
+        all_applied = all_applied && changed >= per_round;
+        all_same = all_same && matches_file(&equipment, EQUIPMENT_FILE_COPY);
+        detect_total += detect_ms;
+        apply_total += apply_ms;
+        parse_total += status.last_parse_ms;
+        printf("Round %d     : %d records changed, noticed and compared after %6.1f ms (read %.1f ms), applied in %.3f ms\n",
+               round + 1, changed, detect_ms, status.last_parse_ms, apply_ms);
+    }
+    printf("\nAverage     : read and compare %.1f ms in the background, apply %.3f ms in the menu\n",
+           parse_total / ROUNDS, apply_total / ROUNDS);
+    printf("Full reload : %.1f ms to read the whole file again (%.0fx the apply)\n", full_load_ms,
+           apply_total > 0 ? full_load_ms / (apply_total / ROUNDS) : 0.0);
+    printf("Waiting     : %.1f ms on average, %d ms of it the settle time\n", detect_total / ROUNDS,
+           HOT_RELOAD_SETTLE_MS);
+
+    // Conflict: the app edits a record, the file changes the same one
+    int conflict_id = 50, other_id = 51;
+    Equipment *mine = equipment_find(&equipment, conflict_id);
+    snprintf(mine->name, sizeof(mine->name), "Edited in the app");
+    table_touch(&equipment);
+    Equipment kept = *mine;
+
+    snprintf(equipment_find(&file, conflict_id)->name, sizeof(kept.name), "Edited in the file");
+    equipment_find(&file, other_id)->quantity = 99;
+    table_write(&file, EQUIPMENT_FILE_COPY);
+    double apply_ms = 0;
+    int changed = wait_and_apply(&apply_ms);
+    HotReloadStatus status;
+    hot_reload_status(&status);
+    int conflict_kept = changed == 1 && status.conflicts == 1 &&
+                        memcmp(equipment_find(&equipment, conflict_id), &kept, sizeof(kept)) == 0 &&
+                        equipment_find(&equipment, other_id)->quantity == 99;
+
+    hot_reload_stop();
+    table_free(&file);
+    table_free(&equipment);
+    table_free(&plans);
+
+    printf("\nApplied     : %s\n", all_applied && all_same ? "live table matches the file" : "MISMATCH");
+    printf("Conflict    : %s\n", conflict_kept ? "edit made in the app kept, other change applied" : "WRONG");
+    return all_applied && all_same && conflict_kept ? 0 : 1;
+}
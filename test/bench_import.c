@@ -0,0 +1,192 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime, mkdir
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "../src/import.h"
+#include "../src/plan_catalog.h"
+#include "../src/password.h"
+#include "../src/utils.h"
+
+#define PLAN_COUNT 4
+
+// Write a large member CSV with repeated usernames, usernames already taken
+// and broken rows, import it with 1, 2, 4... threads into a table that
+// already holds members, and check every run gives the same members and
+// the expected number of rejected rows. The accepted rows carry a password
+// that is already a hash, so the runs time the parsing and not the hashing
+// (see bench_password).
+// Build: gcc -O2 -o test/bench_import test/bench_import.c src/import.c src/branches.c src/history.c
+//        src/maintenance.c src/classes.c src/member.c src/plans.c src/equipment.c src/table.c
+//        src/money.c src/subscriptions.c src/timer_wheel.c src/access.c src/loans.c src/autosave.c
+//        src/replication.c src/password.c src/username_filter.c src/hot_reload.c src/audit.c
+//        src/event_ring.c src/popularity.c src/batch_save.c src/shared_tables.c src/plan_catalog.c
+//        src/utils.c -lpthread
+// Usage: ./test/bench_import [rows] [existing_members] [max_threads]
+// The CSV is written to bench_tmp/, the real data/ folder is not touched.
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static void fill_existing(Table *members, int existing) {
+    member_table_init(members);
+    for (int i = 1; i <= existing; i++) {
+        Member member;
+        memset(&member, 0, sizeof(member));
+        member.id_member = i;
+        snprintf(member.username, sizeof(member.username), "old%d", i);
+        snprintf(member.password, sizeof(member.password), "pw%d", i);
+        snprintf(member.name, sizeof(member.name), "Existing Member %d", i);
+        member.id_current_plan = -1;
+        member_append(members, &member);
+    }
+}
+
+// Writes the CSV and returns how many rows should be rejected
+static int write_csv(const char *path, int rows, int existing, const char *hash) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        return -1;
+    }
+
+    fprintf(f, "name,username,password,plan_id\n");
+    int *good = malloc(sizeof(int) * rows);   // rows whose username was taken
+    int good_count = 0, bad = 0;
+    unsigned int x = 2463534242u;
+    for (int i = 1; i <= rows; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        int roll = x % 1000;
+
+        if (roll < 20 && good_count > 0) {
+            fprintf(f, "Again %d,user%d,pw,\n", i, good[(x >> 10) % good_count]);  // Earlier row
+            bad++;
+        } else if (roll < 30 && existing > 0) {
+            fprintf(f, "Taken %d,old%d,pw,1\n", i, 1 + (int)(x >> 10) % existing);
+            bad++;
+        } else if (roll < 34) {
+            fprintf(f, "Broken %d,\"user%d,pw\n", i, i);                            // Unbalanced quote
+            bad++;
+        } else if (roll < 37) {
+            fprintf(f, "Pipe|Name %d,user%d,pw,2\n", i, i);
+            bad++;
+        } else if (roll < 40) {
+            fprintf(f, "No Plan %d,user%d,pw,%d\n", i, i, PLAN_COUNT + 10);
+            bad++;
+        } else if (roll < 42) {
+            fprintf(f, ",user%d,pw\n", i);                                          // Empty name
+            bad++;
+        } else {
+            if (roll < 100) {
+                fprintf(f, "\"Smith, \"\"Jay\"\" %d\",user%d,\"%s\"\r\n", i, i, hash);   // Quoted, CRLF
+            } else if (roll < 600) {
+                fprintf(f, "Member Number %d,user%d,\"%s\",%d\n", i, i, hash, 1 + roll % PLAN_COUNT);
+            } else {
+                fprintf(f, "Member Number %d,user%d,\"%s\"\n", i, i, hash);
+            }
+            good[good_count++] = i;
+        }
+    }
+    fclose(f);
+    free(good);
+    return bad;
+}
+
+// Sum of the imported usernames, names and plans, to compare runs
+static unsigned long long table_checksum(const Table *members, int from) {
+    unsigned long long sum = 0;
+    for (int i = from; i < members->count; i++) {
+        const Member *member = member_at(members, i);
+        const char *texts[] = { member->username, member->name, member->password };
+        for (int t = 0; t < 3; t++) {
+            for (const char *c = texts[t]; *c; c++) {
+                sum = sum * 1099511628211ull + (unsigned char)*c;
+            }
+        }
+        sum = sum * 31 + (unsigned)member->id_member * 7u + (unsigned)member->id_current_plan;
+    }
+    return sum;
+}
+
+int main(int argc, char *argv[]) {
+    int rows = argc > 1 ? atoi(argv[1]) : 300000;
+    int existing = argc > 2 ? atoi(argv[2]) : 50000;
+    int max_threads = argc > 3 ? atoi(argv[3]) : online_cpu_count(IMPORT_MAX_THREADS);
+    if (rows < 1 || existing < 0 || max_threads < 1 || max_threads > IMPORT_MAX_THREADS) {
+        printf("Usage: %s [rows] [existing_members] [max_threads]\n", argv[0]);
+        return 1;
+    }
+
+    const char *csv_path = "bench_tmp/import.csv";
+    const char *rejects_path = "bench_tmp/import_rejects.csv";
+    mkdir("bench_tmp", 0755);
+
+    char hash[PASSWORD_HASH_SIZE];
+    password_hash("secret", hash, sizeof(hash));
+    int expected_bad = write_csv(csv_path, rows, existing, hash);
+    if (expected_bad < 0) {
+        printf("Cannot write %s.\n", csv_path);
+        return 1;
+    }
+    struct stat info;
+    stat(csv_path, &info);
+
+    Table plans;
+    plan_table_init(&plans);
+    for (int id = 1; id <= PLAN_COUNT; id++) {
+        Plan plan;
+        create_plan(&plan, id, "Plan", 1000 * id, "Bench plan");
+        plan_append(&plans, &plan);
+    }
+    plan_catalog_publish(&plans);
+
+    printf("===== BULK IMPORT BENCHMARK =====\n\n");
+    printf("Rows: %d (%lld bytes), existing members: %d, bad rows written: %d\n\n",
+           rows, (long long)info.st_size, existing, expected_bad);
+
+    unsigned long long first_sum = 0;
+    int all_ok = 1;
+    for (int threads = 1; ; threads *= 2) {
+        if (threads > max_threads) {
+            threads = max_threads;
+        }
+
+        Table members;
+        fill_existing(&members, existing);
+
+        ImportSummary summary;
+        double start = now_ms();
+        int read = import_members_csv(&members, csv_path, rejects_path, threads, &summary);
+        double elapsed = now_ms() - start;
+
+        unsigned long long sum = table_checksum(&members, existing);
+        if (threads == 1) {
+            first_sum = sum;
+        }
+        int ok = read && summary.rows == rows && summary.rejected == expected_bad &&
+                 summary.imported == rows - expected_bad && members.live_count == existing + summary.imported &&
+                 (summary.imported == 0 || (summary.first_id == existing + 1 &&
+                                            summary.last_id == existing + summary.imported)) &&
+                 sum == first_sum;
+        all_ok = all_ok && ok;
+
+        printf("%2d thread(s): %8.2f ms  %12.0f rows/s  imported %d, rejected %d  %s\n",
+               threads, elapsed, rows / (elapsed / 1000.0), summary.imported, summary.rejected,
+               ok ? "ok" : "WRONG");
+
+        table_free(&members);
+        if (threads == max_threads) {
+            break;
+        }
+    }
+
+    printf("\nRejected rows are listed in %s\n", rejects_path);
+    table_free(&plans);
+    return all_ok ? 0 : 1;
+}
@@ -0,0 +1,126 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../src/maintenance.h"
+
+#define SECONDS_PER_DAY (24LL * 60 * 60)
+
+// A large inventory where a few items are overdue: compares listing them from
+// the maintenance heap with scanning every item, checks both find the same
+// items, and times the heap updates done on each checkout and service.
+// Build: gcc -O2 -o test/bench_maintenance test/bench_maintenance.c src/branches.c src/history.c
+//        src/maintenance.c src/classes.c src/member.c src/plans.c src/equipment.c src/table.c
+//        src/money.c src/subscriptions.c src/timer_wheel.c src/access.c src/loans.c src/autosave.c
+//        src/replication.c src/password.c src/username_filter.c src/hot_reload.c src/audit.c
+//        src/event_ring.c src/popularity.c src/batch_save.c src/shared_tables.c src/plan_catalog.c
+//        src/utils.c -lpthread
+// Usage: ./test/bench_maintenance [items] [overdue_per_1000] [updates]
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+// Baseline: look at every item
+static int scan_due(const Table *equipment, long long until) {
+    int count = 0;
+    for (int i = 0; i < equipment->count; i++) {
+        if (table_is_live(equipment, i)) {
+            long long due = equipment_service_due(equipment_at(equipment, i));
+            if (due != 0 && due <= until) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+int main(int argc, char *argv[]) {
+    int items = argc > 1 ? atoi(argv[1]) : 1000000;
+    int overdue_rate = argc > 2 ? atoi(argv[2]) : 1;
+    int updates = argc > 3 ? atoi(argv[3]) : 1000000;
+    if (items < 1 || overdue_rate < 0 || overdue_rate > 1000 || updates < 0) {
+        printf("Usage: %s [items] [overdue_per_1000 0-1000] [updates]\n", argv[0]);
+        return 1;
+    }
+
+    long long now = time(NULL);
+    Table equipment;
+    equipment_table_init(&equipment);
+    unsigned int x = 12345u;
+    for (int i = 1; i <= items; i++) {
+        Equipment eq;
+        create_equipment(&eq, i, "Machine", "Generated equipment for benchmark", 5);
+        eq.service_days = 30;
+        eq.service_uses = 3;
+        x = x * 1103515245u + 12345u;
+        // Serviced within the last 29 days, except the few that are overdue
+        long long age = (x >> 8) % 1000 < (unsigned int)overdue_rate ? 31 : (x >> 12) % 29;
+        eq.last_service = now - age * SECONDS_PER_DAY;
+        equipment_append(&equipment, &eq);
+    }
+
+    printf("===== MAINTENANCE HEAP BENCHMARK =====\n\n");
+    printf("Items: %d, overdue per 1000: %d, updates: %d\n\n", items, overdue_rate, updates);
+
+    double start = now_ms();
+    maintenance_sync(&equipment);
+    printf("Build heap   : %8.2f ms  (%d scheduled)\n", now_ms() - start, maintenance_scheduled_count());
+
+    int rounds = 100;
+    int heap_count = 0, scan_count = 0;
+    start = now_ms();
+    for (int r = 0; r < rounds; r++) {
+        MaintenanceDue *due;
+        heap_count = maintenance_due_before(now, &due);
+        free(due);
+    }
+    double heap_ms = (now_ms() - start) / rounds;
+
+    start = now_ms();
+    for (int r = 0; r < rounds; r++) {
+        scan_count = scan_due(&equipment, now);
+    }
+    double scan_ms = (now_ms() - start) / rounds;
+
+    printf("Overdue list : %8.4f ms from the heap, %8.4f ms scanning (%d vs %d items)\n",
+           heap_ms, scan_ms, heap_count, scan_count);
+
+    // Checkouts and services, as done from the menus
+    start = now_ms();
+    for (int u = 0; u < updates; u++) {
+        x = x * 1103515245u + 12345u;
+        int id = 1 + (int)((x >> 8) % (unsigned int)items);
+        if ((x >> 4) % 8 == 0) {
+            maintenance_record_service(&equipment, id);
+        } else {
+            maintenance_record_use(&equipment, id);
+        }
+    }
+    double update_ms = now_ms() - start;
+    if (updates > 0) {
+        printf("Updates      : %8.2f ms  %12.0f updates/s\n", update_ms, updates / (update_ms / 1000.0));
+    }
+
+    // The heap kept up to date must list what a scan finds
+    MaintenanceDue *due;
+    long long until = now + 7 * SECONDS_PER_DAY;
+    heap_count = maintenance_due_before(until, &due);
+    scan_count = scan_due(&equipment, until);
+    int sorted = 1;
+    for (int i = 1; i < heap_count; i++) {
+        if (due[i - 1].due > due[i].due) {
+            sorted = 0;
+        }
+    }
+    free(due);
+
+    printf("\nDue within 7 days: %d from the heap, %d scanning, %s\n",
+           heap_count, scan_count, sorted ? "in due order" : "NOT SORTED");
+
+    table_free(&equipment);
+    return heap_count == scan_count && sorted ? 0 : 1;
+}
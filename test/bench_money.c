@@ -0,0 +1,89 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../src/money.h"
+
+// Compare the fixed-point money type with float prices: exactness of a
+// large sum, and parse/format speed against strtof/snprintf.
+// Build: gcc -O2 -o test/bench_money test/bench_money.c src/money.c src/utils.c
+// Usage: ./test/bench_money [amounts]
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+int main(int argc, char *argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 10000000;
+    const char *prices[] = { "49.900", "39.95", "70.00", "12.125" };
+
+    Money *amounts = malloc(sizeof(Money) * count);
+    if (!amounts) {
+        printf("Not enough memory for %d amounts.\n", count);
+        return 1;
+    }
+
+    printf("===== MONEY BENCHMARK =====\n\n");
+    printf("Amounts: %d\n\n", count);
+
+    // Sums
+    float float_total = 0;
+    for (int i = 0; i < count; i++) {
+        float price = strtof(prices[i & 3], NULL);
+        float_total += price;
+        money_parse(prices[i & 3], &amounts[i]);
+    }
+
+    double start = now_ms();
+    Money total = money_sum(amounts, count);
+    double sum_ms = now_ms() - start;
+
+    char text[MONEY_MAX_TEXT];
+    money_format(total, text);
+    printf("float sum       : %.3f\n", float_total);
+    printf("money_sum       : %s (%.2f ms)\n\n", text, sum_ms);
+
+    // Parse
+    start = now_ms();
+    float float_check = 0;
+    for (int i = 0; i < count; i++) {
+        float_check += strtof(prices[i & 3], NULL);
+    }
+    double strtof_ms = now_ms() - start;
+
+    start = now_ms();
+    Money money_check = 0;
+    for (int i = 0; i < count; i++) {
+        Money amount;
+        money_parse(prices[i & 3], &amount);
+        money_check += amount;
+    }
+    double parse_ms = now_ms() - start;
+
+    // Format
+    char buffer[64];
+    long length_check = 0;
+    start = now_ms();
+    for (int i = 0; i < count; i++) {
+        length_check += snprintf(buffer, sizeof(buffer), "%.2f", (float)(i % 100000) / 100.0f);
+    }
+    double snprintf_ms = now_ms() - start;
+
+    start = now_ms();
+    for (int i = 0; i < count; i++) {
+        length_check += money_format((Money)(i % 100000) * 10, buffer);
+    }
+    double format_ms = now_ms() - start;
+
+    printf("strtof          : %8.2f ms\n", strtof_ms);
+    printf("money_parse     : %8.2f ms\n", parse_ms);
+    printf("snprintf %%.2f   : %8.2f ms\n", snprintf_ms);
+    printf("money_format    : %8.2f ms\n", format_ms);
+    printf("\n(checks: %.0f %lld %ld)\n", float_check, money_check, length_check);
+
+    free(amounts);
+    return 0;
+}
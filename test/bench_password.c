@@ -0,0 +1,143 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <time.h>
+#include "../src/password.h"
+#include "../src/utils.h"
+
+#define USERS 16
+
+// Check scrypt against the test vectors of RFC 7914, then verify a burst of
+// logins (a quarter with a wrong password) on 1, 2, 4... hashing threads and
+// report logins per second, next to checking them one by one on the calling
+// thread. Every answer is checked.
+// Build: gcc -O2 -o test/bench_password test/bench_password.c src/branches.c src/history.c
+//        src/maintenance.c src/classes.c src/member.c src/plans.c src/equipment.c src/table.c
+//        src/money.c src/subscriptions.c src/timer_wheel.c src/access.c src/loans.c src/autosave.c
+//        src/replication.c src/password.c src/username_filter.c src/hot_reload.c src/audit.c
+//        src/event_ring.c src/popularity.c src/batch_save.c src/shared_tables.c src/plan_catalog.c
+//        src/utils.c -lpthread
+// Usage: ./test/bench_password [logins] [max_threads]
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+typedef struct {
+    const char *password;
+    const char *salt;
+    unsigned log_n, r, p;
+    const char *first_bytes;   // hex of the first 16 bytes of the 64-byte key
+} Vector;
+
+static int check_vectors() {
+    const Vector vectors[] = {
+        { "", "", 4, 1, 1, "77d6576238657b203b19ca42c18a0497" },
+        { "password", "NaCl", 10, 8, 16, "fdbabe1c9d3472007856e7190d01e9fe" },
+        { "pleaseletmein", "SodiumChloride", 14, 8, 1, "7023bdcb3afd7348461c06cd81fd38eb" },
+    };
+    int ok = 1;
+    for (size_t v = 0; v < sizeof(vectors) / sizeof(vectors[0]); v++) {
+        uint8_t key[64];
+        char hex[33];
+        const Vector *t = &vectors[v];
+        if (!scrypt((const uint8_t *)t->password, strlen(t->password), (const uint8_t *)t->salt, strlen(t->salt),
+                    t->log_n, t->r, t->p, key, sizeof(key))) {
+            ok = 0;
+            continue;
+        }
+        for (int i = 0; i < 16; i++) {
+            snprintf(hex + 2 * i, 3, "%02x", key[i]);
+        }
+        ok &= strcmp(hex, t->first_bytes) == 0;
+    }
+    return ok;
+}
+
+static atomic_int answered;
+static atomic_int wrong_answers;
+
+// Called on a hashing thread: arg is the answer expected
+static void login_done(PasswordRequest *request, void *arg) {
+    if (request->result != (int)(size_t)arg) {
+        atomic_fetch_add(&wrong_answers, 1);
+    }
+    atomic_fetch_add(&answered, 1);
+}
+
+static const char *typed_password(int login, char *out, size_t size) {
+    // Every fourth login gets the password wrong
+    snprintf(out, size, login % 4 == 3 ? "wrong%d" : "secret%d", login % USERS);
+    return out;
+}
+
+int main(int argc, char *argv[]) {
+    int logins = argc > 1 ? atoi(argv[1]) : 64;
+    int max_threads = argc > 2 ? atoi(argv[2]) : online_cpu_count(PASSWORD_MAX_WORKERS);
+    if (logins < 1 || max_threads < 1 || max_threads > PASSWORD_MAX_WORKERS) {
+        printf("Usage: %s [logins] [max_threads]\n", argv[0]);
+        return 1;
+    }
+
+    printf("===== PASSWORD HASHING BENCHMARK =====\n\n");
+    printf("scrypt ln=%d r=%d p=%d: %.0f MB per hash\n", PASSWORD_LOG_N, PASSWORD_R, PASSWORD_P,
+           128.0 * PASSWORD_R * (1 << PASSWORD_LOG_N) / (1 << 20));
+    int vectors_ok = check_vectors();
+    printf("RFC 7914 test vectors: %s\n\n", vectors_ok ? "ok" : "WRONG");
+
+    // Stored hashes of the users
+    char hashes[USERS][PASSWORD_HASH_SIZE];
+    double start = now_ms();
+    for (int u = 0; u < USERS; u++) {
+        char password[32];
+        snprintf(password, sizeof(password), "secret%d", u);
+        password_hash(password, hashes[u], sizeof(hashes[u]));
+    }
+    printf("Hash      : %.1f ms each\n", (now_ms() - start) / USERS);
+
+    // Baseline: one login after the other on this thread
+    int wrong = 0;
+    start = now_ms();
+    for (int i = 0; i < logins; i++) {
+        char password[32];
+        wrong += password_verify(typed_password(i, password, sizeof(password)), hashes[i % USERS]) != (i % 4 != 3);
+    }
+    double serial_ms = now_ms() - start;
+    printf("Inline    : %8.1f logins/s\n\n", logins / (serial_ms / 1000.0));
+
+    // The same logins queued at once on the hashing threads
+    PasswordRequest *requests = malloc(sizeof(PasswordRequest) * logins);
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        password_pool_start(threads);
+        atomic_store(&answered, 0);
+        atomic_store(&wrong_answers, 0);
+        start = now_ms();
+        for (int i = 0; i < logins; i++) {
+            char password[32];
+            password_verify_async(&requests[i], typed_password(i, password, sizeof(password)), hashes[i % USERS],
+                                  login_done, (void *)(size_t)(i % 4 != 3));
+        }
+        password_pool_stop();  // Returns once every queued login was answered
+        double elapsed = now_ms() - start;
+        wrong += atomic_load(&wrong_answers) + (logins - atomic_load(&answered));
+        printf("%2d thread(s): %8.1f logins/s  (%.0f ms per login on average)\n", threads,
+               logins / (elapsed / 1000.0), elapsed / logins);
+        if (threads < max_threads && threads * 2 > max_threads) {
+            threads = max_threads / 2;  // Finish with max_threads itself
+        }
+    }
+    free(requests);
+
+    // Plain text values from before hashing still work, and are flagged
+    int legacy_ok = password_verify("nour", "nour") && !password_verify("nour", "noUr") &&
+                    password_needs_rehash("nour") && !password_needs_rehash(hashes[0]);
+
+    printf("\nAnswers     : %s\n", wrong == 0 ? "all correct" : "WRONG");
+    printf("Plain text  : %s\n", legacy_ok ? "ok" : "WRONG");
+    return vectors_ok && wrong == 0 && legacy_ok ? 0 : 1;
+}
@@ -0,0 +1,234 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime, mkdir, chdir
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "../src/popularity.h"
+#include "../src/history.h"
+
+#define CHECKS  10
+#define QUERIES 1000000
+#define SCANS   20
+#define MAX_PLANS 1000
+
+// Give members random plans (a few plans much more popular than the rest),
+// then change subscriptions one at a time while the clock moves on over ten
+// days. Times each tracked change and each top-K query against counting
+// every member's plan, and checks the top plans by subscribers and by new
+// subscriptions in the last day and week against counting from scratch.
+// Build: gcc -O2 -o test/bench_popularity test/bench_popularity.c src/branches.c src/history.c
+//        src/maintenance.c src/classes.c src/member.c src/plans.c src/equipment.c src/table.c
+//        src/money.c src/subscriptions.c src/timer_wheel.c src/access.c src/loans.c src/autosave.c
+//        src/replication.c src/password.c src/username_filter.c src/hot_reload.c src/audit.c
+//        src/event_ring.c src/popularity.c src/batch_save.c src/shared_tables.c src/plan_catalog.c
+//        src/utils.c -lpthread
+// Usage: ./test/bench_popularity [members] [changes] [plans]
+// Runs in bench_tmp/ without a history file, the real data/ folder is not touched.
+
+typedef struct {
+    int plan_id;
+    long long time;
+} Subscription;
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static unsigned int rng = 2463534242u;
+
+static unsigned int next_random() {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+// Plan 1 is picked most, then 2...: squaring a uniform draw favours low IDs
+static int random_plan(int plans) {
+    double u = (next_random() % 1000000) / 1000000.0;
+    return 1 + (int)(u * u * plans);
+}
+
+static int compare_desc(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (y > x) - (y < x);
+}
+
+// The top K must hold the K highest counts, each with its plan's true count
+static int same_top(const PlanCount *top, int found, const int *counts, int plans) {
+    int sorted[MAX_PLANS + 1];
+    memcpy(sorted, counts, sizeof(int) * (plans + 1));
+    qsort(sorted, plans + 1, sizeof(int), compare_desc);
+    int expected = 0;
+    while (expected < POPULARITY_TOP_K && sorted[expected] > 0) {
+        expected++;
+    }
+    if (found != expected) {
+        return 0;
+    }
+    for (int i = 0; i < found; i++) {
+        if (top[i].count != sorted[i] || counts[top[i].plan_id] != top[i].count) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Subscribers per plan, counted from every member
+static void count_members(const Table *members, int *counts, int plans) {
+    memset(counts, 0, sizeof(int) * (plans + 1));
+    for (int i = 0; i < members->count; i++) {
+        if (table_is_live(members, i)) {
+            int plan_id = member_at(members, i)->id_current_plan;
+            if (plan_id > 0 && plan_id <= plans) {
+                counts[plan_id]++;
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 500000;
+    int changes = argc > 2 ? atoi(argv[2]) : 1000000;
+    int plans = argc > 3 ? atoi(argv[3]) : 50;
+    if (count < 1 || changes < CHECKS || plans < 1 || plans > MAX_PLANS) {
+        printf("Usage: %s [members] [changes >= %d] [plans 1-%d]\n", argv[0], CHECKS, MAX_PLANS);
+        return 1;
+    }
+
+    mkdir("bench_tmp", 0755);
+    if (chdir("bench_tmp") != 0) {
+        printf("Cannot enter bench_tmp/.\n");
+        return 1;
+    }
+    remove(HISTORY_FILE);
+
+    printf("===== PLAN POPULARITY BENCHMARK =====\n\n");
+    printf("Members: %d, changes: %d, plans: %d\n\n", count, changes, plans);
+
+    Table members;
+    member_table_init(&members);
+    table_reserve(&members, count);
+    for (int id = 1; id <= count; id++) {
+        Member member;
+        memset(&member, 0, sizeof(member));
+        member.id_member = id;
+        snprintf(member.username, sizeof(member.username), "member.%d", id);
+        member.id_current_plan = id % 4 == 0 ? -1 : random_plan(plans);
+        member_append(&members, &member);
+    }
+
+    Subscription *made = malloc(sizeof(Subscription) * changes);
+    int *counts = malloc(sizeof(int) * (plans + 1));
+    if (!made || !counts) {
+        printf("Not enough memory.\n");
+        return 1;
+    }
+
+    // Counting all members, as the admin view would without the tracker
+    double start = now_ms();
+    PlanCount top[POPULARITY_TOP_K];
+    for (int i = 0; i < SCANS; i++) {
+        count_members(&members, counts, plans);
+    }
+    double scan_ms = (now_ms() - start) / SCANS;
+
+    start = now_ms();
+    popularity_sync(&members);
+    double build_ms = now_ms() - start;
+
+    // The clock starts at a whole hour and moves on ten days in all
+    long long clock = 1700000000LL / 3600 * 3600;
+    long long step_ms = 10LL * 24 * 3600 * 1000 / changes;
+    popularity_top(POPULARITY_WEEK, clock, top, POPULARITY_TOP_K);
+
+    int made_count = 0, all_match = 1;
+    double track_ms = 0;
+    long long elapsed_ms = 0;
+    for (int check = 0; check < CHECKS; check++) {
+        int batch = changes / CHECKS;
+        start = now_ms();
+        for (int i = 0; i < batch; i++) {
+            elapsed_ms += step_ms;
+            long long now = clock + elapsed_ms / 1000;
+            int id = 1 + (int)(next_random() % (unsigned int)count);
+            Member *member = member_find(&members, id);
+
+            // Three changes in four are subscriptions (new, renewed or another plan)
+            if (next_random() % 4 == 0) {
+                member->id_current_plan = -1;
+                table_touch(&members);
+                popularity_track(&members, id);
+            } else {
+                int plan_id = random_plan(plans);
+                member->id_current_plan = plan_id;
+                table_touch(&members);
+                popularity_track(&members, id);
+                popularity_record_subscription(plan_id, now);
+                made[made_count].plan_id = plan_id;
+                made[made_count].time = now;
+                made_count++;
+            }
+        }
+        track_ms += now_ms() - start;
+
+        // Against counting from scratch
+        long long now = clock + elapsed_ms / 1000;
+        popularity_sync(&members);
+        count_members(&members, counts, plans);
+        int found = popularity_top(POPULARITY_CURRENT, now, top, POPULARITY_TOP_K);
+        all_match = all_match && same_top(top, found, counts, plans);
+
+        long long hour = now / 3600;
+        int windows[2] = { POPULARITY_DAY_HOURS, POPULARITY_WEEK_HOURS };
+        for (int w = 0; w < 2; w++) {
+            memset(counts, 0, sizeof(int) * (plans + 1));
+            for (int i = 0; i < made_count; i++) {
+                if (made[i].time / 3600 > hour - windows[w]) {
+                    counts[made[i].plan_id]++;
+                }
+            }
+            found = popularity_top(w == 0 ? POPULARITY_DAY : POPULARITY_WEEK, now, top, POPULARITY_TOP_K);
+            all_match = all_match && same_top(top, found, counts, plans);
+        }
+    }
+
+    // Queries of each ranking
+    long long now = clock + elapsed_ms / 1000;
+    long total = 0;
+    start = now_ms();
+    for (int i = 0; i < QUERIES; i++) {
+        total += popularity_top(i % POPULARITY_RANKINGS, now, top, POPULARITY_TOP_K);
+    }
+    double query_ns = (now_ms() - start) * 1e6 / QUERIES;
+
+    printf("Full count      : %8.2f ms per pass over all members\n", scan_ms);
+    printf("First build     : %8.2f ms (once, at the first use)\n", build_ms);
+    printf("Tracked change  : %8.0f ns per subscribe / unsubscribe (windows moved on included)\n",
+           track_ms * 1e6 / changes);
+    printf("Top %d query     : %8.0f ns (%.0fx faster than a full count)\n", POPULARITY_TOP_K, query_ns,
+           scan_ms * 1e6 / query_ns);
+    printf("\nTop plans now   :");
+    int found = popularity_top(POPULARITY_CURRENT, now, top, POPULARITY_TOP_K);
+    for (int i = 0; i < found; i++) {
+        printf(" %d (%d)", top[i].plan_id, top[i].count);
+    }
+    printf("\nTop plans, week :");
+    found = popularity_top(POPULARITY_WEEK, now, top, POPULARITY_TOP_K);
+    for (int i = 0; i < found; i++) {
+        printf(" %d (%d)", top[i].plan_id, top[i].count);
+    }
+    printf("\n\nExact           : %s\n", all_match && total > 0 ? "top plans match a count from scratch at every check"
+                                                                 : "MISMATCH");
+
+    popularity_free();
+    table_free(&members);
+    free(made);
+    free(counts);
+    return all_match && total > 0 ? 0 : 1;
+}
@@ -0,0 +1,217 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime, mkdir
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "../src/replication.h"
+#include "../src/autosave.h"
+#include "../src/member.h"
+#include "../src/plans.h"
+#include "../src/equipment.h"
+
+#define SOCKET_PATH "bench_tmp/replication.sock"
+#define WAIT_MS 30000
+
+// Run a primary and a standby in one process over a local socket: time the
+// first snapshot, the round trip of single changes (publish until the
+// standby applied and acknowledged it), and bursts of changes, then stop
+// the standby and check its tables match the primary's record by record.
+// Build: gcc -O2 -o test/bench_replication test/bench_replication.c src/branches.c src/history.c
+//        src/maintenance.c src/classes.c src/member.c src/plans.c src/equipment.c src/table.c
+//        src/money.c src/subscriptions.c src/timer_wheel.c src/access.c src/loans.c src/autosave.c
+//        src/replication.c src/password.c src/username_filter.c src/hot_reload.c src/audit.c
+//        src/event_ring.c src/popularity.c src/batch_save.c src/shared_tables.c src/plan_catalog.c
+//        src/utils.c -lpthread
+// Usage: ./test/bench_replication [members] [changes]
+// The files are written to bench_tmp/, the real data/ folder is not touched.
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static unsigned int seed = 12345u;
+
+static int random_below(int n) {
+    seed = seed * 1103515245u + 12345u;
+    return (int)((seed >> 8) % (unsigned)n);
+}
+
+static void add_member(Table *members, int id) {
+    Member member;
+    memset(&member, 0, sizeof(member));
+    member.id_member = id;
+    snprintf(member.username, sizeof(member.username), "member%d", id);
+    snprintf(member.password, sizeof(member.password), "pw%d", id);
+    snprintf(member.name, sizeof(member.name), "Member Number %d", id);
+    member.id_current_plan = id % 3 == 0 ? -1 : 1 + id % 3;
+    member_append(members, &member);
+}
+
+// One change like the app makes: subscribe, sign up or delete a member
+static void change_members(Table *members) {
+    int kind = random_below(10);
+    if (kind < 7) {
+        Member *m = member_find(members, 1 + random_below(table_next_id(members) - 1));
+        if (m) {
+            m->id_current_plan = 1 + random_below(3);
+            m->subscription_start = 1700000000LL + random_below(1000000);
+            m->subscription_end = m->subscription_start + SUBSCRIPTION_DAYS * 24LL * 60 * 60;
+            table_touch_record(members, m->id_member);
+        }
+    } else if (kind < 9) {
+        add_member(members, table_next_id(members));
+    } else {
+        table_remove(members, 1 + random_below(table_next_id(members) - 1));
+    }
+}
+
+// Same live records, compared in their data file format
+static int same_tables(const Table *a, const Table *b) {
+    if (a->live_count != b->live_count) {
+        return 0;
+    }
+    char line_a[1024], line_b[1024];
+    for (int i = 0; i < a->count; i++) {
+        if (!table_is_live(a, i)) {
+            continue;
+        }
+        const void *record = table_at(a, i);
+        int id;
+        memcpy(&id, (const char *)record + a->id_offset, sizeof(int));
+        const void *other = table_find(b, id);
+        if (!other) {
+            return 0;
+        }
+        int length = a->codec->format(record, line_a, sizeof(line_a));
+        if (b->codec->format(other, line_b, sizeof(line_b)) != length || memcmp(line_a, line_b, length) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void print_lag(const char *label, const ReplicationStatus *s) {
+    printf("%s: last %.3f ms, average %.3f ms, max %.3f ms\n", label, s->last_lag_ms, s->avg_lag_ms,
+           s->max_lag_ms);
+}
+
+int main(int argc, char *argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 20000;
+    int changes = argc > 2 ? atoi(argv[2]) : 1000;
+    if (count < 1 || changes < 1) {
+        printf("Usage: %s [members] [changes]\n", argv[0]);
+        return 1;
+    }
+    mkdir("bench_tmp", 0755);
+
+    Table plans, equipment, members;
+    plan_table_init(&plans);
+    equipment_table_init(&equipment);
+    member_table_init(&members);
+    for (int i = 1; i <= 3; i++) {
+        Plan plan;
+        memset(&plan, 0, sizeof(plan));
+        plan.id_plan = i;
+        snprintf(plan.name, sizeof(plan.name), "Plan %d", i);
+        snprintf(plan.description, sizeof(plan.description), "Areas of plan %d", i);
+        plan_append(&plans, &plan);
+    }
+    table_reserve(&members, count);
+    for (int i = 1; i <= count; i++) {
+        add_member(&members, i);
+    }
+
+    // The standby starts empty and saves to its own files
+    Table standby_plans, standby_equipment, standby_members;
+    plan_table_init(&standby_plans);
+    equipment_table_init(&standby_equipment);
+    member_table_init(&standby_members);
+    strcpy(standby_plans.path, "bench_tmp/standby_plans.txt");
+    strcpy(standby_equipment.path, "bench_tmp/standby_equipment.txt");
+    strcpy(standby_members.path, "bench_tmp/standby_members.txt");
+
+    printf("===== REPLICATION BENCHMARK =====\n\n");
+    printf("Members: %d, changes: %d\n\n", count, changes);
+
+    autosave_start();
+    if (!replication_start_primary(SOCKET_PATH, &plans, &equipment, &members) ||
+        !replication_start_standby(SOCKET_PATH, &standby_plans, &standby_equipment, &standby_members)) {
+        return 1;
+    }
+
+    // Snapshot: wait until the standby is connected and applied it
+    double start = now_ms();
+    ReplicationStatus status;
+    do {
+        replication_status(REPLICATION_PRIMARY, &status);
+    } while (status.last_seq == 0 && now_ms() - start < WAIT_MS);
+    int flushed = replication_flush(WAIT_MS);
+    replication_status(REPLICATION_PRIMARY, &status);
+    printf("Snapshot   : %8.2f ms  (%lld records, %lld bytes)\n", now_ms() - start, status.records,
+           status.bytes);
+
+    // One change at a time, each waited for
+    int single = changes < 200 ? changes : 200;
+    double publish_ms = 0;
+    start = now_ms();
+    for (int i = 0; i < single; i++) {
+        change_members(&members);
+        double before = now_ms();
+        replication_publish(&members);
+        publish_ms += now_ms() - before;
+        flushed = replication_flush(WAIT_MS) && flushed;
+    }
+    double single_ms = now_ms() - start;
+    printf("Round trip : %8.3f ms per change  (publish %.3f ms of it, %d members)\n",
+           single_ms / single, publish_ms / single, members.live_count);
+
+    // Bursts: many changes, one publish per change, one wait at the end
+    replication_status(REPLICATION_PRIMARY, &status);
+    long long records_before = status.records;
+    start = now_ms();
+    for (int i = 0; i < changes; i++) {
+        change_members(&members);
+        replication_publish(&members);
+    }
+    flushed = replication_flush(WAIT_MS) && flushed;
+    double burst_ms = now_ms() - start;
+    replication_status(REPLICATION_PRIMARY, &status);
+    printf("Burst      : %8.2f ms for %d changes  (%.0f changes/s, %lld record lines)\n", burst_ms, changes,
+           changes / (burst_ms / 1000.0), status.records - records_before);
+
+    ReplicationStatus applied;
+    replication_status(REPLICATION_STANDBY, &applied);
+    printf("\n");
+    print_lag("Primary lag (until acknowledged)", &status);
+    print_lag("Standby lag (until applied)     ", &applied);
+
+    // Promote the standby: its tables must match the primary's
+    replication_stop_standby();
+    replication_stop_primary();
+    autosave_stop();
+    int same = same_tables(&plans, &standby_plans) && same_tables(&equipment, &standby_equipment) &&
+               same_tables(&members, &standby_members);
+
+    // And so must what it saved
+    Table saved;
+    member_table_init(&saved);
+    table_load(&saved, "bench_tmp/standby_members.txt");
+    int saved_same = same_tables(&members, &saved);
+
+    printf("\nAll acknowledged : %s\n", flushed ? "yes" : "NO");
+    printf("Standby tables   : %s\n", same ? "same as primary" : "DIFFER");
+    printf("Standby files    : %s\n", saved_same ? "same as primary" : "DIFFER");
+
+    table_free(&saved);
+    table_free(&plans);
+    table_free(&equipment);
+    table_free(&members);
+    table_free(&standby_plans);
+    table_free(&standby_equipment);
+    table_free(&standby_members);
+    return flushed && same && saved_same ? 0 : 1;
+}
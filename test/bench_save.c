@@ -0,0 +1,119 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime, mkdir, chdir
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "../src/batch_save.h"
+#include "../src/plans.h"
+#include "../src/equipment.h"
+#include "../src/member.h"
+
+#define BENCH_PLANS     100
+#define BENCH_EQUIPMENT 100
+
+// Compare the synchronous save path with the io_uring batch on generated data.
+// Build: gcc -O2 -o test/bench_save test/bench_save.c src/branches.c src/history.c
+//        src/maintenance.c src/classes.c src/member.c src/plans.c src/equipment.c src/table.c
+//        src/money.c src/subscriptions.c src/timer_wheel.c src/access.c src/loans.c src/autosave.c
+//        src/replication.c src/password.c src/username_filter.c src/hot_reload.c src/audit.c
+//        src/event_ring.c src/popularity.c src/batch_save.c src/shared_tables.c src/plan_catalog.c
+//        src/utils.c -lpthread
+// Usage: ./test/bench_save [member_count] [rounds]
+// Files are written to bench_tmp/data/, the real data/ folder is not touched.
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static double run_rounds(int backend, int rounds, Table *tables[], int count) {
+    if (batch_save_set_backend(backend) != backend) {
+        return -1;
+    }
+
+    double start = now_ms();
+    for (int r = 0; r < rounds; r++) {
+        int failed = batch_save_tables(tables, count);
+        if (failed != 0) {
+            printf("Save failed (tables %d)\n", failed);
+            return -1;
+        }
+    }
+    return (now_ms() - start) / rounds;
+}
+
+int main(int argc, char *argv[]) {
+    int member_count = argc > 1 ? atoi(argv[1]) : 200000;
+    int rounds = argc > 2 ? atoi(argv[2]) : 5;
+
+    Table plans, equipment, members;
+    plan_table_init(&plans);
+    equipment_table_init(&equipment);
+    member_table_init(&members);
+
+    if (!table_reserve(&members, member_count)) {
+        printf("Not enough memory for %d members.\n", member_count);
+        return 1;
+    }
+
+    printf("===== SAVE BENCHMARK =====\n\n");
+
+    // Generate a full plan and equipment list and a large member table
+    for (int i = 0; i < BENCH_PLANS; i++) {
+        char name[50];
+        Plan plan;
+        snprintf(name, sizeof(name), "Plan %d", i + 1);
+        create_plan(&plan, i + 1, name, (30 + i) * MONEY_SCALE, "Generated plan for benchmark");
+        plan_append(&plans, &plan);
+    }
+    for (int i = 0; i < BENCH_EQUIPMENT; i++) {
+        char name[50];
+        Equipment eq;
+        snprintf(name, sizeof(name), "Machine %d", i + 1);
+        create_equipment(&eq, i + 1, name, "Generated equipment for benchmark", 5 + i % 20);
+        equipment_append(&equipment, &eq);
+    }
+    for (int i = 0; i < member_count; i++) {
+        Member member = { 0 };
+        member.id_member = i + 1;
+        snprintf(member.username, sizeof(member.username), "user%d", i + 1);
+        snprintf(member.password, sizeof(member.password), "pass%d", i * 7919);
+        snprintf(member.name, sizeof(member.name), "Generated Member %d", i + 1);
+        member.id_current_plan = (i % 5 == 0) ? -1 : 1 + i % BENCH_PLANS;
+        member_append(&members, &member);
+    }
+
+    snprintf(plans.path, sizeof(plans.path), "%s", PLANS_FILE);
+    snprintf(equipment.path, sizeof(equipment.path), "%s", EQUIPMENT_FILE);
+    snprintf(members.path, sizeof(members.path), "%s", MEMBERS_FILE);
+    Table *tables[] = { &plans, &equipment, &members };
+
+    mkdir("bench_tmp", 0755);
+    if (chdir("bench_tmp") != 0) {
+        printf("Cannot enter bench_tmp/.\n");
+        return 1;
+    }
+    mkdir("data", 0755);
+
+    printf("Members: %d, plans: %d, equipment: %d, rounds: %d\n\n",
+           member_count, BENCH_PLANS, BENCH_EQUIPMENT, rounds);
+
+    double sync_ms = run_rounds(BATCH_BACKEND_SYNC, rounds, tables, 3);
+    printf("synchronous : %8.2f ms per full save\n", sync_ms);
+
+    double uring_ms = run_rounds(BATCH_BACKEND_IO_URING, rounds, tables, 3);
+    if (uring_ms < 0) {
+        printf("io_uring    : unavailable on this system\n");
+    } else {
+        printf("io_uring    : %8.2f ms per full save\n", uring_ms);
+    }
+
+    table_free(&plans);
+    table_free(&equipment);
+    table_free(&members);
+    printf("\nBenchmark completed.\n");
+    return 0;
+}
@@ -0,0 +1,180 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime, mkdir
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "../src/username_filter.h"
+#include "../src/utils.h"
+
+#define MEMBERS_FILE_COPY "bench_tmp/filter_members.txt"
+#define CHECKS 1000000
+#define SCANS 50
+
+// Fill a member table, then time username availability checks for new
+// names with the cuckoo filter against searching the table, count the
+// filter's wrong "maybe" answers, check that no taken username is ever
+// reported free (also after deletes and signups), and that the filter
+// saved on exit is used at the next start only while the members file is
+// unchanged.
+// Build: gcc -O2 -o test/bench_username_filter test/bench_username_filter.c src/branches.c
+//        src/history.c src/maintenance.c src/classes.c src/member.c src/plans.c src/equipment.c
+//        src/table.c src/money.c src/subscriptions.c src/timer_wheel.c src/access.c src/loans.c
+//        src/autosave.c src/replication.c src/password.c src/username_filter.c src/hot_reload.c
+//        src/audit.c src/event_ring.c src/popularity.c src/batch_save.c src/shared_tables.c
+//        src/plan_catalog.c src/utils.c -lpthread
+// Usage: ./test/bench_username_filter [members]
+// The files are written to bench_tmp/, the real data/ folder is not touched.
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static void make_member(Member *member, int id) {
+    memset(member, 0, sizeof(*member));
+    member->id_member = id;
+    snprintf(member->username, sizeof(member->username), "member.%d", id);
+    snprintf(member->password, sizeof(member->password), "pw%d", id);
+    snprintf(member->name, sizeof(member->name), "Member Number %d", id);
+    member->id_current_plan = -1;
+}
+
+// Every live username must be reported as maybe taken
+static int missed_usernames(const Table *members) {
+    int missed = 0;
+    for (int i = 0; i < members->count; i++) {
+        if (table_is_live(members, i) && !username_filter_may_contain(members, member_at(members, i)->username)) {
+            missed++;
+        }
+    }
+    return missed;
+}
+
+static void load_table(Table *members) {
+    member_table_init(members);
+    table_load(members, MEMBERS_FILE_COPY);
+}
+
+int main(int argc, char *argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 500000;
+    if (count < 1) {
+        printf("Usage: %s [members]\n", argv[0]);
+        return 1;
+    }
+    mkdir("bench_tmp", 0755);
+
+    printf("===== USERNAME FILTER BENCHMARK =====\n\n");
+    printf("Members: %d\n\n", count);
+
+    Table members;
+    member_table_init(&members);
+    table_reserve(&members, count);
+    for (int id = 1; id <= count; id++) {
+        Member member;
+        make_member(&member, id);
+        member_append(&members, &member);
+    }
+    table_write(&members, MEMBERS_FILE_COPY);
+    table_free(&members);
+
+    // First start: no saved filter, built from the table
+    char filter_file[] = "bench_tmp/filter_members.filter";
+    remove(filter_file);
+    load_table(&members);
+    double start = now_ms();
+    username_filter_load(&members);
+    double build_ms = now_ms() - start;
+    UsernameFilterStats stats;
+    username_filter_stats(&stats);
+    printf("Build       : %8.1f ms  (%d buckets, %.1f MB, %.0f%% full)\n", build_ms, stats.buckets,
+           stats.buckets * USERNAME_FILTER_SLOTS * 2.0 / 1e6,
+           100.0 * stats.count / ((double)stats.buckets * USERNAME_FILTER_SLOTS));
+
+    // New usernames: the filter, and a search of the table
+    int maybe = 0;
+    start = now_ms();
+    for (int i = 0; i < CHECKS; i++) {
+        char username[50];
+        snprintf(username, sizeof(username), "newcomer.%d", i);
+        maybe += username_filter_may_contain(&members, username);
+    }
+    double filter_ns = (now_ms() - start) * 1e6 / CHECKS;
+    start = now_ms();
+    int found = 0;
+    for (int i = 0; i < SCANS; i++) {
+        char username[50];
+        snprintf(username, sizeof(username), "newcomer.%d", i);
+        found += find_member_by_username(&members, username) != -1;
+    }
+    double scan_ns = (now_ms() - start) * 1e6 / SCANS;
+    printf("New names   : %8.0f ns per check with the filter, %.0f ns per table search (%.0fx)\n", filter_ns,
+           scan_ns, scan_ns / filter_ns);
+    printf("False maybe : %d of %d (1 in %.0f)\n", maybe, CHECKS, maybe > 0 ? (double)CHECKS / maybe : 0.0);
+
+    int missed = missed_usernames(&members);
+
+    // Deletes and signups, tracked one at a time
+    int deleted = 0, still_reported = 0;
+    for (int id = 3; id <= count; id += 10) {
+        Member member = *member_find(&members, id);
+        table_remove(&members, id);
+        username_filter_track(&members, member.username, 0);
+        deleted++;
+        still_reported += username_filter_may_contain(&members, member.username);
+    }
+    for (int i = 0; i < count / 5; i++) {
+        Member member;
+        make_member(&member, count + 1 + i);
+        member_append(&members, &member);
+        username_filter_track(&members, member.username, 1);
+    }
+    missed += missed_usernames(&members);
+    username_filter_stats(&stats);
+    int rebuilds_before = stats.rebuilds;
+    printf("Deleted     : %d, still reported as maybe taken: %d\n", deleted, still_reported);
+    printf("Rebuilds    : %d (1 at start; more only if the filter filled up)\n", rebuilds_before);
+
+    // Exit: save the members file (as autosave does), then the filter
+    table_write(&members, MEMBERS_FILE_COPY);
+    members.saved_version = members.version;
+    start = now_ms();
+    int saved = username_filter_save(&members);
+    double save_ms = now_ms() - start;
+    username_filter_free();
+    table_free(&members);
+
+    // Next start: the saved filter is used
+    load_table(&members);
+    start = now_ms();
+    username_filter_load(&members);
+    double load_ms = now_ms() - start;
+    username_filter_stats(&stats);
+    int reused = stats.loaded;
+    missed += missed_usernames(&members);
+    printf("Saved filter: written in %.1f ms, read back in %.1f ms (%s)\n", save_ms, load_ms,
+           saved && reused ? "used" : "NOT USED");
+    username_filter_free();
+    table_free(&members);
+
+    // The members file changed after the filter was saved: rebuilt, not used
+    load_table(&members);
+    Member extra;
+    make_member(&extra, 2 * count + 7);
+    member_append(&members, &extra);
+    table_write(&members, MEMBERS_FILE_COPY);
+    table_free(&members);
+    load_table(&members);
+    username_filter_load(&members);
+    username_filter_stats(&stats);
+    int stale_rejected = !stats.loaded && username_filter_may_contain(&members, extra.username);
+    missed += missed_usernames(&members);
+    username_filter_free();
+    table_free(&members);
+
+    printf("\nTaken names : %s\n", missed == 0 ? "never reported free" : "MISSED");
+    printf("Stale filter: %s\n", stale_rejected ? "rebuilt" : "WRONG");
+    return missed == 0 && found == 0 && saved && reused && stale_rejected ? 0 : 1;
+}
@@ -1,29 +1,55 @@
 #include <stdio.h>
 #include "../src/member.h"
 #include "../src/plans.h"
+#include "../src/plan_catalog.h"
+#include "../src/loans.h"
+#include "../src/classes.h"
 #include "../src/utils.h"
 
-void test_member_menu(Member members[], int *count);
+void test_member_menu(Table *members, Table *equipment, Table *loans,
+                      ClassSchedule *schedule);
 
 int main() {
-    Member members[MAX_MEMBERS];
-    int member_count = 0;
+    Table members;
+    member_table_init(&members);
     
     printf("===== MEMBER SYSTEM TEST PROGRAM =====\n\n");
     
     // Load existing members and plans
-    member_count = load_members_from_file(members);
+    load_members_from_file(&members);
     
-    test_member_menu(members, &member_count);
+    Table plans;
+    plan_table_init(&plans);
+    load_plans_from_file(&plans);
+    plan_catalog_publish(&plans);
+    
+    Table equipment, loans;
+    equipment_table_init(&equipment);
+    loan_table_init(&loans);
+    load_equipment_from_file(&equipment);
+    load_loans_from_file(&loans);
+    equipment_stock_sync(&equipment, &loans);
+    
+    ClassSchedule schedule;
+    class_schedule_init(&schedule);
+    load_classes_from_file(&schedule);
+    
+    test_member_menu(&members, &equipment, &loans, &schedule);
     
     // Save members before exit
-    save_members_to_file(members, member_count);
+    save_members_to_file(&members);
+    table_free(&members);
+    table_free(&plans);
+    table_free(&equipment);
+    table_free(&loans);
+    class_schedule_free(&schedule);
     
     printf("\nTest completed. Goodbye!\n");
     return 0;
 }
 
-void test_member_menu(Member members[], int *count) {
+void test_member_menu(Table *members, Table *equipment, Table *loans,
+                      ClassSchedule *schedule) {
     int choice;
     
     do {
@@ -38,17 +64,17 @@ void test_member_menu(Member members[], int *count) {
         
         switch (choice) {
             case 1:
-                if (create_member_account(members, count)) {
-                    printf("\nAccount created! Total members: %d\n", *count);
+                if (create_member_account(members)) {
+                    printf("\nAccount created! Total members: %d\n", members->live_count);
                 }
                 pause_screen();
                 break;
                 
             case 2: {
-                int member_id = member_login(members, *count);
-                if (member_id != -1) {
+                int member_slot = member_login(members);
+                if (member_slot != -1) {
                     pause_screen();
-                    display_member_menu(member_id, members, *count);
+                    display_member_menu(member_slot, members, equipment, loans, schedule);
                 } else {
                     pause_screen();
                 }
@@ -57,15 +83,19 @@ void test_member_menu(Member members[], int *count) {
             
             case 3:
                 printf("\n--- All Members (Debug) ---\n");
-                if (*count == 0) {
+                if (members->live_count == 0) {
                     printf("No members registered.\n");
                 } else {
-                    for (int i = 0; i < *count; i++) {
+                    for (int i = 0; i < members->count; i++) {
+                        if (!table_is_live(members, i)) {
+                            continue;
+                        }
+                        Member *member = member_at(members, i);
                         printf("ID: %d | Username: %s | Name: %s | Plan: %d\n",
-                               members[i].id_member,
-                               members[i].username,
-                               members[i].name,
-                               members[i].id_current_plan);
+                               member->id_member,
+                               member->username,
+                               member->name,
+                               member->id_current_plan);
                     }
                 }
                 pause_screen();
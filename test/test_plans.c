@@ -2,27 +2,28 @@
 #include "../src/plans.h"
 #include "../src/utils.h"
 
-void test_menu(Plan plans[], int *count);
+void test_menu(Table *plans);
 
 int main() {
-    Plan plans[MAX_PLANS];
-    int plan_count = 0;
+    Table plans;
+    plan_table_init(&plans);
     
     printf("===== PLAN MANAGEMENT TEST PROGRAM =====\n\n");
     
     // Load existing plans from file
-    plan_count = load_plans_from_file(plans);
+    load_plans_from_file(&plans);
     
-    test_menu(plans, &plan_count);
+    test_menu(&plans);
     
     // Save plans before exit
-    save_plans_to_file(plans, plan_count);
+    save_plans_to_file(&plans);
+    table_free(&plans);
     
     printf("\nTest completed. Goodbye!\n");
     return 0;
 }
 
-void test_menu(Plan plans[], int *count) {
+void test_menu(Table *plans) {
     int choice;
     
     do {
@@ -39,35 +40,35 @@ void test_menu(Plan plans[], int *count) {
         
         switch (choice) {
             case 1:
-                add_plan_interactive(plans, count);
+                add_plan_interactive(plans);
                 pause_screen();
                 break;
                 
             case 2:
-                display_plans(plans, *count);
+                display_plans(plans);
                 pause_screen();
                 break;
                 
             case 3: {
-                display_plans(plans, *count);
+                display_plans(plans);
                 printf("\nEnter Plan ID to modify: ");
                 int id = get_int_input();
-                modify_plan(plans, *count, id);
+                modify_plan(plans, id);
                 pause_screen();
                 break;
             }
             
             case 4: {
-                display_plans(plans, *count);
+                display_plans(plans);
                 printf("\nEnter Plan ID to delete: ");
                 int id = get_int_input();
-                delete_plan(plans, count, id);
+                delete_plan(plans, id);
                 pause_screen();
                 break;
             }
             
             case 5:
-                save_plans_to_file(plans, *count);
+                save_plans_to_file(plans);
                 pause_screen();
                 break;
                 
@@ -2,13 +2,14 @@
 #include "../src/plans.h"
 
 int main() {
-    Plan plans[MAX_PLANS];
-    int plan_count;
+    Table plans;
+    plan_table_init(&plans);
     
     printf("===== QUICK PLAN VIEWER =====\n");
     
-    plan_count = load_plans_from_file(plans);
-    display_plans(plans, plan_count);
+    load_plans_from_file(&plans);
+    display_plans(&plans);
     
+    table_free(&plans);
     return 0;
 }